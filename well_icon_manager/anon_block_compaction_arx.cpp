@@ -0,0 +1,197 @@
+#include "anon_block_compaction_arx.h"
+#include <adslib.h>
+#include <aced.h>
+#include <acedCmdNF.h>
+#include <dbapserv.h>
+#include <dbdynblk.h>
+#include <dbents.h>
+#include <dbmain.h>
+#include <dbsymtb.h>
+#include <dbtrans.h>
+#include "anon_block_index.h"
+#include "class_ancestry_arx.h"
+#include "dynblock_sweep_arx.h"
+#include "handle_index_arx.h"
+
+
+static std::string handleTextOf(AcDbObjectId objectId)
+{
+    char text[handleTextSize];
+    return std::string(text, formatHandle(handleOf(objectId), text));
+}
+
+// The block references in every block table record of the database.
+static void collectBlockReferences(AcDbDatabase* pDb, std::vector<AcDbObjectId>& referenceIds)
+{
+    AcDbBlockTable* pBlockTable;
+    if (pDb->getSymbolTable(pBlockTable, AcDb::kForRead) != Acad::eOk) {
+        return;
+    }
+    AcDbBlockTableIterator* pBlockTableIterator;
+    if (pBlockTable->newIterator(pBlockTableIterator) != Acad::eOk) {
+        pBlockTable->close();
+        return;
+    }
+    for (; !pBlockTableIterator->done(); pBlockTableIterator->step()) {
+        AcDbBlockTableRecord* pBlockTableRecord;
+        if (pBlockTableIterator->getRecord(pBlockTableRecord, AcDb::kForRead) != Acad::eOk) {
+            continue;
+        }
+        AcDbBlockTableRecordIterator* pBlockTableRecordIterator;
+        if (pBlockTableRecord->newIterator(pBlockTableRecordIterator) == Acad::eOk) {
+            for (; !pBlockTableRecordIterator->done(); pBlockTableRecordIterator->step()) {
+                AcDbObjectId entityId;
+                if (pBlockTableRecordIterator->getEntityId(entityId) == Acad::eOk
+                    && sessionClassAncestry().isKindOf(entityId.objectClass(), AcDbBlockReference::desc())) {
+                    referenceIds.push_back(entityId);
+                }
+            }
+            delete pBlockTableRecordIterator;
+        }
+        pBlockTableRecord->close();
+    }
+    delete pBlockTableIterator;
+    pBlockTable->close();
+}
+
+// The key of a dynamic block reference drawn by an anonymous block (see
+// AnonymousBlockIndex::makeKey()), read through AcDbDynBlockReference.
+// False for any other reference.
+static bool dynamicReferenceKey(AcDbObjectId referenceId, std::string& key, AcDbObjectId& anonymousBlockId)
+{
+    AcDbDynBlockReference reference(referenceId);
+    anonymousBlockId = reference.anonymousBlockTableRecord();
+    if (!reference.isDynamicBlock() || anonymousBlockId.isNull()) {
+        return false;
+    }
+    AcDbDynBlockReferencePropertyArray properties;
+    reference.getBlockProperties(properties);
+    std::vector<AnonymousBlockPropertyValue> values(properties.length());
+    for (int i = 0; i < properties.length(); i++) {
+        values[i].name = acharToUtf8(properties.at(i).propertyName().kwszPtr());
+        values[i].value = encodeEvalVariant(properties.at(i).value());
+    }
+    key = AnonymousBlockIndex::makeKey(handleTextOf(reference.dynamicBlockTableRecord()), values);
+    return true;
+}
+
+// Remaps the references and erases the anonymous blocks left unused, all
+// in one transaction, which is aborted (leaving the drawing as it was) if
+// any reference cannot be remapped.  Returns false then.
+static bool applyCompaction(AcDbDatabase* pDb, const AnonymousBlockCompaction& plan, DrawingHandleIndex& objects, size_t& purged)
+{
+    purged = 0;
+    AcTransaction* pTransaction = acdbTransactionManager->startTransaction();
+    for (const auto& remap : plan.remaps) {
+        AcDbObject* pObject;
+        if (pTransaction->getObject(pObject, objects.find(remap.first), AcDb::kForWrite) != Acad::eOk
+            || AcDbBlockReference::cast(pObject) == NULL
+            || AcDbBlockReference::cast(pObject)->setBlockTableRecord(objects.find(remap.second)) != Acad::eOk) {
+            acdbTransactionManager->abortTransaction();
+            return false;
+        }
+    }
+
+    // purge() leaves only the candidates that nothing refers to any more.
+    AcDbObjectIdArray purgeable;
+    for (const std::string& block : plan.purgeable) {
+        purgeable.append(objects.find(block));
+    }
+    if (!purgeable.isEmpty() && pDb->purge(purgeable) == Acad::eOk) {
+        for (int i = 0; i < purgeable.length(); i++) {
+            AcDbObject* pBlock;
+            if (pTransaction->getObject(pBlock, purgeable.at(i), AcDb::kForWrite) == Acad::eOk && pBlock->erase() == Acad::eOk) {
+                purged++;
+            }
+        }
+    }
+    acdbTransactionManager->endTransaction();
+    return true;
+}
+
+void compactAnonymousBlocks()
+{
+    // a report unless asked otherwise: the remap is only checked against
+    // the real dynamic references once it is done.
+    AcString option;
+    acedInitGet(0, _T("Report Apply"));
+    int status = acedGetKword(_T("\nWELLCOMPACT [Report/Apply] <Report>: "), option);
+    if (status != RTNORM && status != RTNONE) {
+        return;
+    }
+    bool apply = status == RTNORM && option == _T("Apply");
+
+    AcDbDatabase* pDb = acdbHostApplicationServices()->workingDatabase();
+    std::vector<AcDbObjectId> referenceIds;
+    collectBlockReferences(pDb, referenceIds);
+
+    std::vector<AnonymousBlockUse> uses;
+    DrawingHandleIndex objects(pDb);
+    objects.reserve(2 * referenceIds.size());
+    std::unordered_map<std::string, std::string> contentsOfBlock;
+    for (AcDbObjectId referenceId : referenceIds) {
+        AnonymousBlockUse use;
+        AcDbObjectId anonymousBlockId;
+        if (!dynamicReferenceKey(referenceId, use.key, anonymousBlockId)) {
+            continue;
+        }
+        use.reference = handleTextOf(referenceId);
+        use.anonymousBlock = handleTextOf(anonymousBlockId);
+        objects.add(referenceId);
+        objects.add(anonymousBlockId);
+        // the contents include the ATTDEF entities, so references are only
+        // remapped onto blocks with the same attribute definitions.
+        auto contents = contentsOfBlock.emplace(use.anonymousBlock, std::string());
+        if (contents.second && !encodeBlockContents(anonymousBlockId, contents.first->second)) {
+            // contents that cannot be read never match anything.
+            contents.first->second = "unreadable " + use.anonymousBlock;
+        }
+        uses.push_back(use);
+    }
+
+    AnonymousBlockCompaction plan = planAnonymousBlockCompaction(uses, contentsOfBlock);
+
+    acutPrintf(_T("\n%d dynamic block references use %d anonymous blocks; %d are needed.\n"),
+        (int)uses.size(), (int)plan.anonymousBlocksBefore, (int)plan.anonymousBlocksAfter);
+    acutPrintf(_T("Entity data of the anonymous blocks: %I64u bytes before, %I64u after (the drawing file shrinks by about the difference on its next save).\n"),
+        (unsigned long long)plan.contentBytesBefore, (unsigned long long)plan.contentBytesAfter);
+    if (plan.conflicts > 0) {
+        acutPrintf(_T("%d anonymous blocks differ from others with the same property values and are left alone.\n"), (int)plan.conflicts);
+    }
+    if (!apply || plan.remaps.empty()) {
+        if (!plan.remaps.empty()) {
+            acutPrintf(_T("Run WELLCOMPACT with the Apply option to remap %d references and purge up to %d anonymous blocks.\n"),
+                (int)plan.remaps.size(), (int)plan.purgeable.size());
+        }
+        return;
+    }
+
+    // one UNDO Back returns to the drawing as it was before the remap.
+    acedCommandS(RTSTR, _T("_.UNDO"), RTSTR, _T("_Mark"), RTNONE);
+    size_t purged;
+    if (!applyCompaction(pDb, plan, objects, purged)) {
+        acutPrintf(_T("Unable to remap a reference; nothing was changed.\n"));
+        return;
+    }
+
+    // every remapped reference must still read as the same dynamic block in
+    // the same state, now drawn by the block it was remapped onto.
+    std::unordered_map<std::string, const AnonymousBlockUse*> useOfReference;
+    for (const AnonymousBlockUse& use : uses) {
+        useOfReference.emplace(use.reference, &use);
+    }
+    size_t mismatches = 0;
+    for (const auto& remap : plan.remaps) {
+        std::string key;
+        AcDbObjectId anonymousBlockId;
+        if (!dynamicReferenceKey(objects.find(remap.first), key, anonymousBlockId)
+            || key != useOfReference[remap.first]->key
+            || anonymousBlockId != objects.find(remap.second)) {
+            mismatches++;
+        }
+    }
+    acutPrintf(_T("Remapped %d references and purged %d anonymous blocks.\n"), (int)plan.remaps.size(), (int)purged);
+    if (mismatches > 0) {
+        acutPrintf(_T("%d remapped references no longer read as the same dynamic block state; UNDO Back restores the drawing.\n"), (int)mismatches);
+    }
+}
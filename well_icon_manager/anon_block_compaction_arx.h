@@ -0,0 +1,13 @@
+#pragma once
+
+// The WELLCOMPACT command: remaps the dynamic block references of the
+// working drawing onto one anonymous block per (dynamic block, property
+// values, contents) and purges the anonymous blocks left unused (see
+// anon_block_index.h).  Only available inside AutoCAD.
+//
+// By default the command only reports what it would do.  With the Apply
+// option it sets an UNDO mark, remaps and purges in one transaction, and
+// then reads every remapped reference back through AcDbDynBlockReference
+// to check that it is still the same dynamic block in the same state.
+
+void compactAnonymousBlocks();
@@ -0,0 +1,102 @@
+#include "anon_block_index.h"
+#include <algorithm>
+#include <unordered_set>
+
+static void appendLengthPrefixed(std::string& out, std::string_view text)
+{
+    // a length prefix keeps keys unambiguous whatever bytes the parts hold.
+    out += std::to_string(text.size());
+    out += ':';
+    out.append(text.data(), text.size());
+}
+
+
+AnonymousBlockIndex::AnonymousBlockIndex()
+{
+    conflictCount = 0;
+}
+
+std::string AnonymousBlockIndex::makeKey(std::string_view dynamicBlock, std::vector<AnonymousBlockPropertyValue> values)
+{
+    std::sort(values.begin(), values.end(), [](const AnonymousBlockPropertyValue& a, const AnonymousBlockPropertyValue& b) {
+        return a.name != b.name ? a.name < b.name : a.value < b.value;
+    });
+    std::string key;
+    appendLengthPrefixed(key, dynamicBlock);
+    for (const AnonymousBlockPropertyValue& value : values) {
+        appendLengthPrefixed(key, value.name);
+        appendLengthPrefixed(key, value.value);
+    }
+    return key;
+}
+
+const std::string& AnonymousBlockIndex::findOrAdd(const std::string& key, const std::string& anonymousBlock, const std::string& contents)
+{
+    std::vector<Entry>& entries = entriesOfKey[key];
+    for (const Entry& entry : entries) {
+        if (entry.contents == contents) {
+            return entry.anonymousBlock;
+        }
+    }
+    if (!entries.empty()) {
+        conflictCount++;
+    }
+    entries.push_back(Entry{ anonymousBlock, contents });
+    return entries.back().anonymousBlock;
+}
+
+const std::string* AnonymousBlockIndex::find(const std::string& key, const std::string& contents) const
+{
+    auto found = entriesOfKey.find(key);
+    if (found != entriesOfKey.end()) {
+        for (const Entry& entry : found->second) {
+            if (entry.contents == contents) {
+                return &entry.anonymousBlock;
+            }
+        }
+    }
+    return NULL;
+}
+
+
+AnonymousBlockCompaction planAnonymousBlockCompaction(const std::vector<AnonymousBlockUse>& uses, const std::unordered_map<std::string, std::string>& contentsOfBlock)
+{
+    AnonymousBlockCompaction plan;
+    plan.contentBytesBefore = 0;
+    plan.contentBytesAfter = 0;
+
+    static const std::string noContents;
+    auto contentsOf = [&](const std::string& block) -> const std::string& {
+        auto found = contentsOfBlock.find(block);
+        return found == contentsOfBlock.end() ? noContents : found->second;
+    };
+
+    AnonymousBlockIndex index;
+    std::unordered_set<std::string> blocksBefore;
+    std::unordered_set<std::string> blocksAfter;
+    for (const AnonymousBlockUse& use : uses) {
+        const std::string& contents = contentsOf(use.anonymousBlock);
+        if (blocksBefore.insert(use.anonymousBlock).second) {
+            plan.contentBytesBefore += contents.size();
+        }
+        std::string kept = index.findOrAdd(use.key, use.anonymousBlock, contents);
+        if (kept != use.anonymousBlock) {
+            plan.remaps.emplace_back(use.reference, kept);
+        }
+        if (blocksAfter.insert(kept).second) {
+            plan.contentBytesAfter += contentsOf(kept).size();
+        }
+    }
+
+    // in order of first use, so that the plan does not depend on hashing.
+    std::unordered_set<std::string> listed;
+    for (const AnonymousBlockUse& use : uses) {
+        if (blocksAfter.count(use.anonymousBlock) == 0 && listed.insert(use.anonymousBlock).second) {
+            plan.purgeable.push_back(use.anonymousBlock);
+        }
+    }
+    plan.anonymousBlocksBefore = blocksBefore.size();
+    plan.anonymousBlocksAfter = blocksAfter.size();
+    plan.conflicts = index.conflicts();
+    return plan;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+// Deduplication of the anonymous (*U) block records that draw dynamic block
+// references.
+//
+// AutoCAD gives a dynamic block reference its own anonymous block as soon
+// as its properties differ from the definition's, so a drawing with many
+// well icons in the same few states ends up with many identical *U
+// records.  AnonymousBlockIndex keys anonymous blocks by their dynamic block
+// and canonical property-value vector, and hands back the record already
+// indexed for a key instead of a new one -- provided the contents of the
+// two really are identical, which is checked rather than assumed.
+//
+// Blocks and references are named by their handles; see
+// anon_block_compaction_arx.h for the command that gathers them and applies
+// a compaction plan.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct AnonymousBlockPropertyValue {
+    std::string name;
+    std::string value; // canonical, e.g. encoded with encodeResbufChain()
+};
+
+class AnonymousBlockIndex {
+    private:
+        struct Entry {
+            std::string anonymousBlock;
+            std::string contents;
+        };
+
+        std::unordered_map<std::string, std::vector<Entry>> entriesOfKey; // more than one only if contents differ
+        size_t conflictCount;
+
+    public:
+        AnonymousBlockIndex();
+
+        // The key of a dynamic block in a given state.  The property values
+        // may be given in any order.
+        static std::string makeKey(std::string_view dynamicBlock, std::vector<AnonymousBlockPropertyValue> values);
+
+        // Returns the anonymous block indexed under key with the given
+        // contents, or indexes anonymousBlock and returns it.  The returned
+        // reference is valid until the next findOrAdd().
+        const std::string& findOrAdd(const std::string& key, const std::string& anonymousBlock, const std::string& contents);
+        // NULL if nothing with these contents is indexed under key.
+        const std::string* find(const std::string& key, const std::string& contents) const;
+
+        size_t keyCount() const { return entriesOfKey.size(); }
+        // How often a key came with contents other than those indexed for
+        // it -- the property values do not capture everything then.
+        size_t conflicts() const { return conflictCount; }
+};
+
+struct AnonymousBlockUse {
+    std::string reference;      // the block reference
+    std::string anonymousBlock; // the *U record drawing it
+    std::string key;            // AnonymousBlockIndex::makeKey()
+};
+
+struct AnonymousBlockCompaction {
+    std::vector<std::pair<std::string, std::string>> remaps; // reference, anonymous block to draw it with instead
+    std::vector<std::string> purgeable;                      // anonymous blocks no reference uses afterwards
+    size_t anonymousBlocksBefore;
+    size_t anonymousBlocksAfter;
+    uint64_t contentBytesBefore; // sizes of the contents of the anonymous blocks
+    uint64_t contentBytesAfter;
+    size_t conflicts;
+};
+
+// Plans the remapping of every reference to the first-indexed anonymous
+// block with the same key and contents.  contentsOfBlock maps every
+// anonymous block in uses to its contents.
+AnonymousBlockCompaction planAnonymousBlockCompaction(const std::vector<AnonymousBlockUse>& uses, const std::unordered_map<std::string, std::string>& contentsOfBlock);
@@ -0,0 +1,142 @@
+// Allocation of heap resbuf chains.  Inside AutoCAD, the values are allocated
+// with the ObjectARX allocator; elsewhere this file also provides the
+// stand-in acutNewRb/acutRelRb.
+
+#include "arx_host.h"
+#include <string.h>
+
+#ifdef _WIN32
+
+#include <Windows.h>
+#include <acutmem.h>
+
+ACHAR* resbufNewString(const ACHAR* text, size_t length)
+{
+    ACHAR* pString = NULL;
+    if (acutNewString(pString, (Adesk::Int32)(length + 1)) != Acad::eOk) {
+        return NULL;
+    }
+    memcpy(pString, text, length * sizeof(ACHAR));
+    pString[length] = 0;
+    return pString;
+}
+
+char* resbufNewBinary(const char* bytes, size_t length)
+{
+    char* pBuffer = NULL;
+    if (acutNewBuffer(pBuffer, length > 0 ? length : 1) != Acad::eOk) {
+        return NULL;
+    }
+    memcpy(pBuffer, bytes, length);
+    return pBuffer;
+}
+
+std::string acharToUtf8(const ACHAR* text)
+{
+    int length = WideCharToMultiByte(CP_UTF8, 0, text, -1, NULL, 0, NULL, NULL);
+    if (length <= 1) {
+        return std::string();
+    }
+    std::string utf8((size_t)length, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, text, -1, &utf8[0], length, NULL, NULL);
+    utf8.resize((size_t)length - 1);
+    return utf8;
+}
+
+#else
+
+#include <stdlib.h>
+#include <atomic>
+
+static std::atomic<size_t> nodesAllocated(0);
+static std::atomic<size_t> nodesReleased(0);
+static std::atomic<size_t> payloadsAllocated(0);
+static std::atomic<size_t> payloadsReleased(0);
+
+struct resbuf* acutNewRb(int v)
+{
+    struct resbuf* rb = (struct resbuf*)calloc(1, sizeof(struct resbuf));
+    if (rb != NULL) {
+        rb->restype = (short)v;
+        nodesAllocated++;
+    }
+    return rb;
+}
+
+int acutRelRb(struct resbuf* rb)
+{
+    while (rb != NULL) {
+        struct resbuf* next = rb->rbnext;
+        if (resbufHoldsString(rb->restype) && rb->resval.rstring != NULL) {
+            free(rb->resval.rstring);
+            payloadsReleased++;
+        } else if (resbufHoldsBinary(rb->restype) && rb->resval.rbinary.buf != NULL) {
+            free(rb->resval.rbinary.buf);
+            payloadsReleased++;
+        }
+        free(rb);
+        nodesReleased++;
+        rb = next;
+    }
+    return RTNORM;
+}
+
+ArxHostAllocationCounts arxHostAllocationCounts()
+{
+    ArxHostAllocationCounts counts;
+    counts.nodesAllocated = nodesAllocated;
+    counts.nodesReleased = nodesReleased;
+    counts.payloadsAllocated = payloadsAllocated;
+    counts.payloadsReleased = payloadsReleased;
+    return counts;
+}
+
+ACHAR* resbufNewString(const ACHAR* text, size_t length)
+{
+    ACHAR* pString = (ACHAR*)malloc((length + 1) * sizeof(ACHAR));
+    if (pString == NULL) {
+        return NULL;
+    }
+    memcpy(pString, text, length * sizeof(ACHAR));
+    pString[length] = 0;
+    payloadsAllocated++;
+    return pString;
+}
+
+char* resbufNewBinary(const char* bytes, size_t length)
+{
+    char* pBuffer = (char*)malloc(length > 0 ? length : 1);
+    if (pBuffer == NULL) {
+        return NULL;
+    }
+    memcpy(pBuffer, bytes, length);
+    payloadsAllocated++;
+    return pBuffer;
+}
+
+std::string acharToUtf8(const ACHAR* text)
+{
+    // wchar_t holds whole code points here.
+    std::string utf8;
+    for (const ACHAR* p = text; *p != 0; p++) {
+        unsigned long c = (unsigned long)*p;
+        if (c < 0x80) {
+            utf8 += (char)c;
+        } else if (c < 0x800) {
+            utf8 += (char)(0xC0 | (c >> 6));
+            utf8 += (char)(0x80 | (c & 0x3F));
+        } else if (c < 0x10000) {
+            utf8 += (char)(0xE0 | (c >> 12));
+            utf8 += (char)(0x80 | ((c >> 6) & 0x3F));
+            utf8 += (char)(0x80 | (c & 0x3F));
+        } else {
+            utf8 += (char)(0xF0 | (c >> 18));
+            utf8 += (char)(0x80 | ((c >> 12) & 0x3F));
+            utf8 += (char)(0x80 | ((c >> 6) & 0x3F));
+            utf8 += (char)(0x80 | (c & 0x3F));
+        }
+    }
+    return utf8;
+}
+
+#endif
@@ -0,0 +1,100 @@
+#pragma once
+
+// The small part of the ADS API (resbuf chains) that the portable code of
+// this app is written against.  Inside AutoCAD this is simply the real
+// ObjectARX declarations.  Elsewhere a stand-in with the same layout and
+// semantics is provided (see arx_host.cpp), so that the portable code can be
+// built, exercised and benchmarked on Linux.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <adscodes.h>
+#include "dxftype.h"
+
+#ifdef _WIN32
+
+#include <adslib.h>
+
+#else
+
+typedef wchar_t ACHAR;
+typedef double ads_real;
+typedef ads_real ads_point[3];
+typedef int64_t ads_name[2];
+
+struct ads_binary {
+    short clen;
+    char* buf;
+};
+
+union ads_u_val {
+    ads_real rreal;
+    ads_real rpoint[3];
+    short rint;
+    ACHAR* rstring;
+    int64_t rlname[2];
+    int64_t mnLongPtr;
+    int32_t rlong;
+    int64_t mnInt64;
+    struct ads_binary rbinary;
+    unsigned char ihandle[8];
+};
+
+struct resbuf {
+    struct resbuf* rbnext;
+    short restype;
+    union ads_u_val resval;
+};
+
+// Allocates one zeroed node of the given type.
+struct resbuf* acutNewRb(int v);
+// Releases a whole chain, including the strings and binary chunks it owns.
+int acutRelRb(struct resbuf* rb);
+
+// Running totals of the stand-in's allocations, for benchmarks.
+struct ArxHostAllocationCounts {
+    size_t nodesAllocated;
+    size_t nodesReleased;
+    size_t payloadsAllocated; // strings and binary chunks
+    size_t payloadsReleased;
+};
+ArxHostAllocationCounts arxHostAllocationCounts();
+
+#endif
+
+// Copies of a string and of a binary chunk, allocated the way acutRelRb()
+// expects the values of a heap chain to be allocated (acutNewString() and
+// acutNewBuffer() inside AutoCAD).  Return NULL if out of memory.
+ACHAR* resbufNewString(const ACHAR* text, size_t length);
+char* resbufNewBinary(const char* bytes, size_t length);
+
+// The UTF-8 form of a NUL-terminated ACHAR string (class and property names,
+// handles).
+std::string acharToUtf8(const ACHAR* text);
+
+// Whether a node with this restype keeps its value in resval.rstring, which
+// acutRelRb() releases together with the node.  restype is either a DXF
+// group code or one of the RT* codes.
+inline bool resbufHoldsString(short restype)
+{
+    if (restype == RTSTR) {
+        return true;
+    }
+    if (restype >= RTNONE || restype == 1004) {
+        return false;
+    }
+    int inxdata;
+    return dxftype(restype, ET_NORM, &inxdata) == RTSTR
+        || (restype >= 100 && restype <= 109)
+        || (restype >= 300 && restype <= 309)
+        || (restype >= 410 && restype <= 419)
+        || (restype >= 430 && restype <= 439)
+        || (restype >= 470 && restype <= 479);
+}
+
+// Whether a node with this restype keeps its value in resval.rbinary.
+inline bool resbufHoldsBinary(short restype)
+{
+    return restype == 1004 || (restype >= 310 && restype <= 319);
+}
@@ -0,0 +1,68 @@
+#include "class_ancestry.h"
+#include <algorithm>
+
+
+ClassAncestryTable::ClassAncestryTable()
+{
+    wordsPerClass = 1;
+}
+
+void ClassAncestryTable::clear()
+{
+    index.clear();
+    classes.clear();
+    chains.clear();
+    wordsPerClass = 1;
+    bits.clear();
+}
+
+void ClassAncestryTable::widen(size_t words)
+{
+    std::vector<uint64_t> wider(classes.size() * words, 0);
+    for (size_t id = 0; id < classes.size(); id++) {
+        std::copy(bits.begin() + id * wordsPerClass, bits.begin() + (id + 1) * wordsPerClass, wider.begin() + id * words);
+    }
+    bits.swap(wider);
+    wordsPerClass = words;
+}
+
+uint32_t ClassAncestryTable::add(const void* key, uint32_t parent, std::string_view name)
+{
+    bool added;
+    uint32_t id = index.findOrAdd((uint64_t)(uintptr_t)key, added);
+    if (!added) {
+        return id;
+    }
+    if (id >= 64 * wordsPerClass) {
+        widen(2 * wordsPerClass);
+    }
+
+    ClassInfo info;
+    info.key = key;
+    info.parent = parent;
+    info.depth = parent == npos ? 0 : classes[parent].depth + 1;
+    info.chainOffset = (uint32_t)chains.size();
+    if (parent != npos) {
+        size_t parentChain = classes[parent].chainOffset;
+        for (uint32_t d = 0; d < info.depth; d++) {
+            chains.push_back(chains[parentChain + d]);
+        }
+    }
+    chains.push_back(id);
+    info.name = name;
+    info.ancestry = info.name;
+    if (parent != npos) {
+        info.ancestry += ", ";
+        info.ancestry += classes[parent].ancestry;
+    }
+    classes.push_back(std::move(info));
+
+    // the row of the class is its parent's with its own bit added.
+    bits.resize(classes.size() * wordsPerClass, 0);
+    uint64_t* pRow = &bits[id * wordsPerClass];
+    if (parent != npos) {
+        std::copy(bits.begin() + parent * wordsPerClass, bits.begin() + (parent + 1) * wordsPerClass, pRow);
+    }
+    pRow[id / 64] |= 1ull << (id % 64);
+    return id;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+// The ancestries of runtime classes, worked out once per class instead of
+// by walking the parent chain for every object.
+//
+// Each class gets a dense id in the order it is added, parents before
+// children.  For each class the table keeps a row of bits, one per class,
+// set for the class itself and each of its ancestors.  So "is X a kind of
+// Y" is a single bit test.  The ancestry text ("AcDbEvalExpr, AcDbObject,
+// AcGiDrawable, AcRxObject", as EvalGraphNode::ancestry holds it) is built
+// once per class and shared after that.
+//
+// Classes are known by an opaque pointer (an AcRxClass* inside AutoCAD,
+// see class_ancestry_arx.h), looked up with a HandleIndex
+// (handle_index.h), which takes any 64-bit key.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "handle_index.h"
+
+class ClassAncestryTable {
+    private:
+        struct ClassInfo {
+            const void* key;
+            uint32_t parent;
+            uint32_t depth;       // 0 for a root
+            uint32_t chainOffset; // in chains: the root first, the class last
+            std::string name;
+            std::string ancestry;
+        };
+
+        HandleIndex index; // key -> class id
+        std::vector<ClassInfo> classes;
+        std::vector<uint32_t> chains;
+        size_t wordsPerClass;
+        std::vector<uint64_t> bits; // class-major
+
+        void widen(size_t words);
+
+    public:
+        static const uint32_t npos = 0xFFFFFFFF;
+
+        ClassAncestryTable();
+
+        void clear();
+
+        // The id of the class, or npos if it has not been added.
+        uint32_t find(const void* key) const {
+            return index.find((uint64_t)(uintptr_t)key);
+        }
+        // Adds a class.  Its parent (npos for a root) must be in the table
+        // already.  Adding a class again returns the id it already has.
+        uint32_t add(const void* key, uint32_t parent, std::string_view name);
+
+        size_t classCount() const { return classes.size(); }
+        const void* key(uint32_t id) const { return classes[id].key; }
+        const std::string& name(uint32_t id) const { return classes[id].name; }
+        uint32_t parent(uint32_t id) const { return classes[id].parent; }
+        uint32_t depth(uint32_t id) const { return classes[id].depth; }
+        // The ancestor at a depth from 0 (the root) to depth(id) (the class
+        // itself).
+        uint32_t ancestorAt(uint32_t id, uint32_t ancestorDepth) const { return chains[classes[id].chainOffset + ancestorDepth]; }
+        // The names from the class up to the root, separated by ", ".
+        const std::string& ancestry(uint32_t id) const { return classes[id].ancestry; }
+
+        // Whether ancestor is the class or one of its ancestors.
+        bool isKindOf(uint32_t id, uint32_t ancestor) const {
+            return ancestor < 64 * wordsPerClass && ((bits[id * wordsPerClass + ancestor / 64] >> (ancestor % 64)) & 1) != 0;
+        }
+};
@@ -0,0 +1,49 @@
+#include "class_ancestry_arx.h"
+#include "arx_host.h"
+
+
+uint32_t RxClassAncestry::idOf(AcRxClass* pClass)
+{
+    if (pClass == NULL) {
+        return ClassAncestryTable::npos;
+    }
+    uint32_t id = classes.find(pClass);
+    if (id != ClassAncestryTable::npos) {
+        return id;
+    }
+    // the new classes up to the first known one (or the root), then added
+    // from the top down, parents before children.
+    AcRxClass* newClasses[64];
+    size_t newCount = 0;
+    uint32_t parent = ClassAncestryTable::npos;
+    for (AcRxClass* pAncestor = pClass; pAncestor != NULL; pAncestor = pAncestor->myParent()) {
+        parent = classes.find(pAncestor);
+        if (parent != ClassAncestryTable::npos) {
+            break;
+        }
+        if (newCount == sizeof(newClasses) / sizeof(newClasses[0])) {
+            // deeper than any hierarchy AutoCAD has; cut off at the root.
+            break;
+        }
+        newClasses[newCount++] = pAncestor;
+    }
+    while (newCount > 0) {
+        AcRxClass* pNewClass = newClasses[--newCount];
+        parent = classes.add(pNewClass, parent, acharToUtf8(pNewClass->name()));
+    }
+    return parent;
+}
+
+bool RxClassAncestry::isKindOf(AcRxClass* pClass, AcRxClass* pAncestor)
+{
+    uint32_t id = idOf(pClass);
+    // an ancestor that is not known yet cannot be one of a known class.
+    uint32_t ancestor = classes.find(pAncestor);
+    return id != ClassAncestryTable::npos && ancestor != ClassAncestryTable::npos && classes.isKindOf(id, ancestor);
+}
+
+RxClassAncestry& sessionClassAncestry()
+{
+    static RxClassAncestry ancestry;
+    return ancestry;
+}
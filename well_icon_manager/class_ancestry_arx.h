@@ -0,0 +1,37 @@
+#pragma once
+
+// A ClassAncestryTable (see class_ancestry.h) over AcRxClass, filled as
+// classes are asked about.  Only available inside AutoCAD.
+
+#include <string>
+#include <rxobject.h>
+#include "class_ancestry.h"
+
+class RxClassAncestry {
+    private:
+        ClassAncestryTable classes;
+
+    public:
+        // The id of the class, adding it and those of its ancestors that are
+        // new; npos for NULL.  Only a class seen for the first time walks
+        // the parent chain, and only up to the first ancestor already known.
+        uint32_t idOf(AcRxClass* pClass);
+
+        // As pClass->isDerivedFrom(pAncestor), with a single bit test once
+        // pClass is known.  False if pClass is NULL.
+        bool isKindOf(AcRxClass* pClass, AcRxClass* pAncestor);
+        bool isKindOf(const AcRxObject* pObject, AcRxClass* pAncestor) { return isKindOf(pObject->isA(), pAncestor); }
+
+        // The UTF-8 name of the class, and the names up to AcRxObject
+        // separated by ", ".  pClass must not be NULL.
+        const std::string& name(AcRxClass* pClass) { return classes.name(idOf(pClass)); }
+        const std::string& ancestry(AcRxClass* pClass) { return classes.ancestry(idOf(pClass)); }
+
+        const ClassAncestryTable& table() const { return classes; }
+        void clear() { classes.clear(); }
+};
+
+// The ancestries of the session, shared by all commands.  It is to be
+// cleared when the application is unloaded: the classes of other
+// applications may be gone by the time it is loaded again.
+RxClassAncestry& sessionClassAncestry();
@@ -0,0 +1,343 @@
+// classbench: ClassAncestryTable (see class_ancestry.h) on synthetic class
+// hierarchies, against walking the parent chain as AcRxClass::myParent()
+// would.
+//
+// A hierarchy has two roots; every other class has a random parent among
+// the classes before it, down to a depth limit.  The classes are known to
+// the table by their addresses, as AcRxClass* are.
+//
+//   check    300 classes at most 12 deep, added parents first in their own
+//            order and in a shuffled one.  When the table holds 64, 65, 129,
+//            257 and 300 classes, that is before the rows are first widened
+//            past 64 bits and after each widening, isKindOf() must agree with the parent walk for every pair
+//            of classes, and ancestry(), depth(), parent() and ancestorAt()
+//            with the walk for every class.  Adding a class again must give
+//            its id back, and a class that was never added must not be
+//            found.  Both orders must give the same answers, and a cleared
+//            table must answer as an empty one
+//   time     --nodes objects, each of a random class of 40 at depth up to 7
+//            (and of 300 at depth up to 12): isKindOf() including the lookup
+//            of the class against the parent walk, and ancestry() against
+//            building the text by the walk, in ns per object, each repeated
+//            for at least 50 ms
+//
+// This is a standalone program; it does not link against ObjectARX:
+//
+//     g++ -std=c++17 -O2 classbench.cpp class_ancestry.cpp handle_index.cpp -o classbench
+//
+// usage: classbench [--step check|time] [--nodes <n>]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "class_ancestry.h"
+
+
+// What the table sees of an AcRxClass.
+struct SyntheticClass {
+    const SyntheticClass* pParent;
+    std::string name;
+    uint32_t depth;
+};
+
+typedef std::vector<std::unique_ptr<SyntheticClass>> SyntheticHierarchy;
+
+static SyntheticHierarchy makeHierarchy(size_t classCount, uint32_t maxDepth, unsigned seed)
+{
+    std::mt19937 random(seed);
+    SyntheticHierarchy classes;
+    for (size_t i = 0; i < classCount; i++) {
+        std::unique_ptr<SyntheticClass> pClass(new SyntheticClass);
+        pClass->pParent = NULL;
+        pClass->depth = 0;
+        if (i >= 2) {
+            const SyntheticClass* pParent;
+            do {
+                pParent = classes[random() % i].get();
+            } while (pParent->depth >= maxDepth);
+            pClass->pParent = pParent;
+            pClass->depth = pParent->depth + 1;
+        }
+        pClass->name = i == 0 ? "AcRxObject" : i == 1 ? "AcGiDrawable" : "AcDbClass" + std::to_string(i);
+        classes.push_back(std::move(pClass));
+    }
+    return classes;
+}
+
+static bool isKindOfByWalk(const SyntheticClass* pClass, const SyntheticClass* pAncestor)
+{
+    for (; pClass != NULL; pClass = pClass->pParent) {
+        if (pClass == pAncestor) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static std::string ancestryByWalk(const SyntheticClass* pClass)
+{
+    std::string ancestry = pClass->name;
+    for (pClass = pClass->pParent; pClass != NULL; pClass = pClass->pParent) {
+        ancestry += ", ";
+        ancestry += pClass->name;
+    }
+    return ancestry;
+}
+
+// Adds the class, its ancestors first, as RxClassAncestry does.
+static uint32_t addClass(ClassAncestryTable& table, const SyntheticClass* pClass)
+{
+    uint32_t id = table.find(pClass);
+    if (id != ClassAncestryTable::npos) {
+        return id;
+    }
+    uint32_t parent = pClass->pParent == NULL ? ClassAncestryTable::npos : addClass(table, pClass->pParent);
+    return table.add(pClass, parent, pClass->name);
+}
+
+// Checks every class in the table, and every pair of them, against the
+// parent walk.
+static bool checkTable(const ClassAncestryTable& table, const char* order)
+{
+    size_t classCount = table.classCount();
+    for (uint32_t id = 0; id < classCount; id++) {
+        const SyntheticClass* pClass = (const SyntheticClass*)table.key(id);
+        uint32_t parent = pClass->pParent == NULL ? ClassAncestryTable::npos : table.find(pClass->pParent);
+        if (table.find(pClass) != id || table.name(id) != pClass->name || table.depth(id) != pClass->depth || table.parent(id) != parent) {
+            fprintf(stderr, "classbench: %s, %zu classes: %s is not kept as it was added\n", order, classCount, pClass->name.c_str());
+            return false;
+        }
+        if (table.ancestry(id) != ancestryByWalk(pClass)) {
+            fprintf(stderr, "classbench: %s, %zu classes: the ancestry of %s is \"%s\"\n", order, classCount, pClass->name.c_str(), table.ancestry(id).c_str());
+            return false;
+        }
+        const SyntheticClass* pAncestor = pClass;
+        for (uint32_t d = pClass->depth + 1; d-- > 0; pAncestor = pAncestor->pParent) {
+            if (table.key(table.ancestorAt(id, d)) != pAncestor) {
+                fprintf(stderr, "classbench: %s, %zu classes: the ancestor of %s at depth %u is wrong\n", order, classCount, pClass->name.c_str(), d);
+                return false;
+            }
+        }
+        for (uint32_t ancestor = 0; ancestor < classCount; ancestor++) {
+            const SyntheticClass* pOther = (const SyntheticClass*)table.key(ancestor);
+            if (table.isKindOf(id, ancestor) != isKindOfByWalk(pClass, pOther)) {
+                fprintf(stderr, "classbench: %s, %zu classes: isKindOf(%s, %s) is %d\n", order, classCount,
+                    pClass->name.c_str(), pOther->name.c_str(), (int)table.isKindOf(id, ancestor));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool runChecks(size_t)
+{
+    const size_t classCount = 300;
+    SyntheticHierarchy classes = makeHierarchy(classCount, 12, 25);
+    // a class that is never added.
+    SyntheticClass stranger = { classes[0].get(), "AcDbStranger", 1 };
+
+    std::vector<const SyntheticClass*> shuffled;
+    for (const auto& pClass : classes) {
+        shuffled.push_back(pClass.get());
+    }
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(26));
+
+    static const size_t checkedCounts[] = { 64, 65, 129, 257, 300 };
+    ClassAncestryTable tables[2];
+    const char* const orders[2] = { "in order", "shuffled" };
+    for (int o = 0; o < 2; o++) {
+        ClassAncestryTable& table = tables[o];
+        size_t checked = 0;
+        for (size_t i = 0; i < classCount; i++) {
+            const SyntheticClass* pClass = o == 0 ? classes[i].get() : shuffled[i];
+            uint32_t id = addClass(table, pClass);
+            if (table.add(pClass, table.parent(id), pClass->name) != id) {
+                fprintf(stderr, "classbench: %s: adding %s again gives it a new id\n", orders[o], pClass->name.c_str());
+                return false;
+            }
+            // the shuffled order adds ancestors ahead of their turn, so the
+            // counts are checked once reached.
+            while (checked < sizeof(checkedCounts) / sizeof(checkedCounts[0]) && table.classCount() >= checkedCounts[checked]) {
+                if (!checkTable(table, orders[o])) {
+                    return false;
+                }
+                checked++;
+            }
+        }
+        if (table.classCount() != classCount || table.find(&stranger) != ClassAncestryTable::npos) {
+            fprintf(stderr, "classbench: %s: %zu classes, or a class that was never added is found\n", orders[o], table.classCount());
+            return false;
+        }
+    }
+
+    // the same answers whatever the ids.
+    for (const auto& pClass : classes) {
+        for (const auto& pOther : classes) {
+            bool inOrder = tables[0].isKindOf(tables[0].find(pClass.get()), tables[0].find(pOther.get()));
+            bool inShuffle = tables[1].isKindOf(tables[1].find(pClass.get()), tables[1].find(pOther.get()));
+            if (inOrder != inShuffle) {
+                fprintf(stderr, "classbench: isKindOf(%s, %s) depends on the order of adding\n", pClass->name.c_str(), pOther->name.c_str());
+                return false;
+            }
+        }
+    }
+
+    // cleared, then filled again with a few classes: nothing of the wide
+    // rows is left.
+    ClassAncestryTable& table = tables[0];
+    table.clear();
+    if (table.classCount() != 0 || table.find(classes[0].get()) != ClassAncestryTable::npos) {
+        fprintf(stderr, "classbench: the table is not empty after clear()\n");
+        return false;
+    }
+    for (size_t i = classCount - 10; i < classCount; i++) {
+        addClass(table, classes[i].get());
+    }
+    if (!checkTable(table, "after clear()") || table.isKindOf(0, 200)) {
+        return false;
+    }
+
+    uint32_t maxDepth = 0;
+    for (const auto& pClass : classes) {
+        maxDepth = std::max(maxDepth, pClass->depth);
+    }
+    printf("%zu classes to depth %u: isKindOf() agrees with the parent walk for every pair at 64 to 300 classes, in order and shuffled\n",
+        classCount, maxDepth);
+    return true;
+}
+
+
+typedef std::chrono::steady_clock Clock;
+
+// Runs step at least once and until 50 ms have passed, and returns the time
+// per run in seconds.
+static double secondsPerRun(const std::function<void()>& step)
+{
+    size_t repetitions = 0;
+    Clock::time_point startTime = Clock::now();
+    double seconds;
+    do {
+        step();
+        repetitions++;
+        seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    } while (seconds < 0.05);
+    return seconds / repetitions;
+}
+
+static bool timeLookups(size_t nodeCount)
+{
+    struct Hierarchy {
+        size_t classCount;
+        uint32_t maxDepth;
+    };
+    static const Hierarchy hierarchies[] = { { 40, 7 }, { 300, 12 } };
+    printf("%-8s %-6s %12s %12s %14s %14s\n", "classes", "limit", "isKindOf ns", "walk ns", "ancestry ns", "rebuild ns");
+    for (const Hierarchy& hierarchy : hierarchies) {
+        SyntheticHierarchy classes = makeHierarchy(hierarchy.classCount, hierarchy.maxDepth, 25);
+        ClassAncestryTable table;
+        for (const auto& pClass : classes) {
+            addClass(table, pClass.get());
+        }
+        // the class of each object, and the class asked about: the parent
+        // of a random class, so that about half the tests succeed.
+        std::mt19937 random(27);
+        std::vector<const SyntheticClass*> nodes(nodeCount);
+        for (const SyntheticClass*& pClass : nodes) {
+            pClass = classes[random() % classes.size()].get();
+        }
+        const SyntheticClass* pAsked = classes[classes.size() - 1]->pParent;
+        uint32_t asked = table.find(pAsked);
+
+        size_t kinds = 0;
+        size_t walkedKinds = 0;
+        double kindSeconds = secondsPerRun([&]() {
+            kinds = 0;
+            for (const SyntheticClass* pClass : nodes) {
+                kinds += table.isKindOf(table.find(pClass), asked);
+            }
+        });
+        double walkSeconds = secondsPerRun([&]() {
+            walkedKinds = 0;
+            for (const SyntheticClass* pClass : nodes) {
+                walkedKinds += isKindOfByWalk(pClass, pAsked);
+            }
+        });
+        size_t length = 0;
+        size_t rebuiltLength = 0;
+        double ancestrySeconds = secondsPerRun([&]() {
+            length = 0;
+            for (const SyntheticClass* pClass : nodes) {
+                length += table.ancestry(table.find(pClass)).size();
+            }
+        });
+        double rebuildSeconds = secondsPerRun([&]() {
+            rebuiltLength = 0;
+            for (const SyntheticClass* pClass : nodes) {
+                rebuiltLength += ancestryByWalk(pClass).size();
+            }
+        });
+        if (kinds != walkedKinds || length != rebuiltLength) {
+            fprintf(stderr, "classbench: %zu classes: the table and the walk disagree\n", hierarchy.classCount);
+            return false;
+        }
+        printf("%-8zu %-6u %12.1f %12.1f %14.1f %14.1f\n", hierarchy.classCount, hierarchy.maxDepth,
+            kindSeconds * 1.0e9 / nodeCount, walkSeconds * 1.0e9 / nodeCount,
+            ancestrySeconds * 1.0e9 / nodeCount, rebuildSeconds * 1.0e9 / nodeCount);
+        fflush(stdout);
+    }
+    return true;
+}
+
+struct Step {
+    const char* name;
+    bool (*run)(size_t nodeCount);
+};
+
+static const Step steps[] = {
+    { "check", runChecks },
+    { "time", timeLookups },
+};
+
+int main(int argc, char** argv)
+{
+    const char* stepName = NULL;
+    size_t nodeCount = 1000000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--step") == 0 && i + 1 < argc) {
+            stepName = argv[++i];
+        } else if (strcmp(argv[i], "--nodes") == 0 && i + 1 < argc) {
+            nodeCount = (size_t)atol(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: classbench [--step check|time] [--nodes <n>]\n");
+            return 2;
+        }
+    }
+    if (nodeCount == 0) {
+        fprintf(stderr, "classbench: --nodes must be at least 1\n");
+        return 2;
+    }
+
+    bool found = false;
+    for (const Step& step : steps) {
+        if (stepName != NULL && strcmp(stepName, step.name) != 0) {
+            continue;
+        }
+        found = true;
+        if (!step.run(nodeCount)) {
+            return 1;
+        }
+    }
+    if (!found) {
+        fprintf(stderr, "classbench: unknown step %s\n", stepName);
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,277 @@
+// compactbench: planAnonymousBlockCompaction() (see anon_block_index.h) on
+// synthetic drawings.
+//
+//   check    5000 references to 3 dynamic blocks in 12 states each, every
+//            reference drawn by an anonymous block of its own, the property
+//            values listed in either order.  The last reference's block has
+//            contents other than those of its state, as if a property did
+//            not capture everything.  The plan must keep the first block of
+//            each of the 36 states and that one (37 in all), remap the
+//            other 4963 references each to a block of its own key with
+//            identical contents, list those 4963 blocks as purgeable in
+//            order of first use, report the one conflict, and total the
+//            contents before and after exactly
+//   time     plans for --max-references references in the same drawing, and
+//            for a tenth and a hundredth of that, each repeated for at least
+//            50 ms
+//
+// This is a standalone program; it does not link against ObjectARX:
+//
+//     g++ -std=c++17 -O2 compactbench.cpp anon_block_index.cpp -o compactbench
+//
+// usage: compactbench [--step check|time] [--max-references <n>]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "anon_block_index.h"
+
+
+static const size_t dynamicBlockCount = 3;
+static const size_t stateCount = 12;
+
+struct SyntheticDrawing {
+    std::vector<AnonymousBlockUse> uses;
+    std::unordered_map<std::string, std::string> contentsOfBlock;
+};
+
+static std::string stateContents(size_t dynamicBlock, size_t state)
+{
+    // as encodeBlockContents() would give them: a few hundred bytes of
+    // entity data, different for every state.
+    std::string contents = "block " + std::to_string(dynamicBlock) + " state " + std::to_string(state) + ";";
+    contents.resize(600 + 10 * state + dynamicBlock, (char)('a' + state));
+    return contents;
+}
+
+// Reference r is of dynamic block r % 3 in state (r / 3) % 12, drawn by
+// anonymous block "*U<r>".  With conflict, the last reference's block has
+// one byte more than its state's contents.
+static SyntheticDrawing makeDrawing(size_t referenceCount, bool conflict)
+{
+    SyntheticDrawing drawing;
+    for (size_t r = 0; r < referenceCount; r++) {
+        size_t dynamicBlock = r % dynamicBlockCount;
+        size_t state = (r / dynamicBlockCount) % stateCount;
+        std::vector<AnonymousBlockPropertyValue> values = {
+            { "Visibility", "state " + std::to_string(state) },
+            { "Distance1", std::to_string(state % 4) },
+        };
+        if (r % 2 == 1) {
+            std::swap(values[0], values[1]);
+        }
+        AnonymousBlockUse use;
+        use.reference = std::to_string(0x4000 + r);
+        use.anonymousBlock = "*U" + std::to_string(r);
+        use.key = AnonymousBlockIndex::makeKey("WELL" + std::to_string(dynamicBlock), values);
+        std::string contents = stateContents(dynamicBlock, state);
+        if (conflict && r + 1 == referenceCount) {
+            contents += '!';
+        }
+        drawing.contentsOfBlock[use.anonymousBlock] = contents;
+        drawing.uses.push_back(use);
+    }
+    return drawing;
+}
+
+static bool expectCount(const char* what, uint64_t count, uint64_t expected)
+{
+    if (count != expected) {
+        fprintf(stderr, "compactbench: %s: %llu, expected %llu\n", what, (unsigned long long)count, (unsigned long long)expected);
+        return false;
+    }
+    return true;
+}
+
+static bool checkKeys()
+{
+    std::string key = AnonymousBlockIndex::makeKey("WELL", { { "a", "1" }, { "b", "2" } });
+    if (AnonymousBlockIndex::makeKey("WELL", { { "b", "2" }, { "a", "1" } }) != key) {
+        fprintf(stderr, "compactbench: the key depends on the order of the property values\n");
+        return false;
+    }
+    // the parts are length-prefixed, so moving a separator changes the key.
+    if (AnonymousBlockIndex::makeKey("WELL", { { "a:1", "" } }) == AnonymousBlockIndex::makeKey("WELL", { { "a", "1" } })) {
+        fprintf(stderr, "compactbench: keys of different property values are equal\n");
+        return false;
+    }
+    return true;
+}
+
+static bool runChecks(size_t)
+{
+    if (!checkKeys()) {
+        return false;
+    }
+    const size_t referenceCount = 5000;
+    const size_t keyCount = dynamicBlockCount * stateCount;
+    SyntheticDrawing drawing = makeDrawing(referenceCount, true);
+    AnonymousBlockCompaction plan = planAnonymousBlockCompaction(drawing.uses, drawing.contentsOfBlock);
+
+    // what the plan should come to, worked out from the drawing directly.
+    uint64_t bytesBefore = 0;
+    for (const auto& block : drawing.contentsOfBlock) {
+        bytesBefore += block.second.size();
+    }
+    uint64_t bytesAfter = drawing.contentsOfBlock["*U" + std::to_string(referenceCount - 1)].size();
+    for (size_t r = 0; r < keyCount; r++) {
+        bytesAfter += drawing.contentsOfBlock["*U" + std::to_string(r)].size();
+    }
+    bool passed = expectCount("anonymous blocks before", plan.anonymousBlocksBefore, referenceCount)
+        && expectCount("anonymous blocks after", plan.anonymousBlocksAfter, keyCount + 1)
+        && expectCount("remaps", plan.remaps.size(), referenceCount - keyCount - 1)
+        && expectCount("purgeable", plan.purgeable.size(), referenceCount - keyCount - 1)
+        && expectCount("conflicts", plan.conflicts, 1)
+        && expectCount("content bytes before", plan.contentBytesBefore, bytesBefore)
+        && expectCount("content bytes after", plan.contentBytesAfter, bytesAfter);
+    if (!passed) {
+        return false;
+    }
+
+    std::unordered_map<std::string, const AnonymousBlockUse*> useOfReference;
+    for (const AnonymousBlockUse& use : drawing.uses) {
+        useOfReference[use.reference] = &use;
+    }
+    std::unordered_map<std::string, std::string> keyOfBlock;
+    for (const AnonymousBlockUse& use : drawing.uses) {
+        keyOfBlock[use.anonymousBlock] = use.key;
+    }
+    // every reference drawn, after the remaps, by a kept block of its key
+    // with the contents it had.
+    std::unordered_set<std::string> kept;
+    std::unordered_set<std::string> remapped;
+    for (const auto& remap : plan.remaps) {
+        const AnonymousBlockUse& use = *useOfReference[remap.first];
+        if (keyOfBlock[remap.second] != use.key || drawing.contentsOfBlock[remap.second] != drawing.contentsOfBlock[use.anonymousBlock]) {
+            fprintf(stderr, "compactbench: reference %s is remapped to %s, which draws something else\n", remap.first.c_str(), remap.second.c_str());
+            return false;
+        }
+        remapped.insert(remap.first);
+    }
+    for (const AnonymousBlockUse& use : drawing.uses) {
+        if (remapped.count(use.reference) == 0) {
+            kept.insert(use.anonymousBlock);
+        }
+    }
+    for (const auto& remap : plan.remaps) {
+        if (kept.count(remap.second) == 0) {
+            fprintf(stderr, "compactbench: %s is remapped to %s, which is not kept\n", remap.first.c_str(), remap.second.c_str());
+            return false;
+        }
+    }
+    if (!expectCount("kept anonymous blocks", kept.size(), keyCount + 1)) {
+        return false;
+    }
+    if (kept.count("*U" + std::to_string(referenceCount - 1)) == 0) {
+        fprintf(stderr, "compactbench: the conflicting anonymous block is not kept\n");
+        return false;
+    }
+    for (size_t r = 0; r < keyCount; r++) {
+        if (kept.count("*U" + std::to_string(r)) == 0) {
+            fprintf(stderr, "compactbench: *U%zu, the first anonymous block of its state, is not kept\n", r);
+            return false;
+        }
+    }
+    // the others purgeable, in order of first use.
+    size_t p = 0;
+    for (const AnonymousBlockUse& use : drawing.uses) {
+        if (kept.count(use.anonymousBlock) == 0 && (p >= plan.purgeable.size() || plan.purgeable[p++] != use.anonymousBlock)) {
+            fprintf(stderr, "compactbench: the purgeable blocks differ from the unused ones at %zu\n", p);
+            return false;
+        }
+    }
+
+    printf("%zu references: %zu anonymous blocks kept, %zu remaps, %zu purgeable, %zu conflict, %.1f KB -> %.1f KB\n",
+        referenceCount, plan.anonymousBlocksAfter, plan.remaps.size(), plan.purgeable.size(), plan.conflicts,
+        plan.contentBytesBefore / 1024.0, plan.contentBytesAfter / 1024.0);
+
+    // without the conflict, one block per state.
+    drawing = makeDrawing(referenceCount, false);
+    plan = planAnonymousBlockCompaction(drawing.uses, drawing.contentsOfBlock);
+    return expectCount("anonymous blocks after, without the conflict", plan.anonymousBlocksAfter, keyCount)
+        && expectCount("conflicts, without the conflict", plan.conflicts, 0);
+}
+
+
+typedef std::chrono::steady_clock Clock;
+
+// Runs step at least once and until 50 ms have passed, and returns the time
+// per run in seconds.
+static double secondsPerRun(const std::function<void()>& step)
+{
+    size_t repetitions = 0;
+    Clock::time_point startTime = Clock::now();
+    double seconds;
+    do {
+        step();
+        repetitions++;
+        seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    } while (seconds < 0.05);
+    return seconds / repetitions;
+}
+
+static bool timePlans(size_t maxReferenceCount)
+{
+    printf("%-10s %10s %10s %12s\n", "references", "remaps", "plan ms", "ns/reference");
+    for (size_t referenceCount = maxReferenceCount / 100; referenceCount <= maxReferenceCount; referenceCount *= 10) {
+        if (referenceCount == 0) {
+            continue;
+        }
+        SyntheticDrawing drawing = makeDrawing(referenceCount, true);
+        size_t remapCount = 0;
+        double seconds = secondsPerRun([&]() {
+            remapCount = planAnonymousBlockCompaction(drawing.uses, drawing.contentsOfBlock).remaps.size();
+        });
+        printf("%-10zu %10zu %10.2f %12.1f\n", referenceCount, remapCount, seconds * 1.0e3, seconds * 1.0e9 / referenceCount);
+        fflush(stdout);
+    }
+    return true;
+}
+
+struct Step {
+    const char* name;
+    bool (*run)(size_t maxReferenceCount);
+};
+
+static const Step steps[] = {
+    { "check", runChecks },
+    { "time", timePlans },
+};
+
+int main(int argc, char** argv)
+{
+    const char* stepName = NULL;
+    size_t maxReferenceCount = 50000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--step") == 0 && i + 1 < argc) {
+            stepName = argv[++i];
+        } else if (strcmp(argv[i], "--max-references") == 0 && i + 1 < argc) {
+            maxReferenceCount = (size_t)atol(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: compactbench [--step check|time] [--max-references <n>]\n");
+            return 2;
+        }
+    }
+
+    bool found = false;
+    for (const Step& step : steps) {
+        if (stepName != NULL && strcmp(stepName, step.name) != 0) {
+            continue;
+        }
+        found = true;
+        if (!step.run(maxReferenceCount)) {
+            return 1;
+        }
+    }
+    if (!found) {
+        fprintf(stderr, "compactbench: unknown step %s\n", stepName);
+        return 2;
+    }
+    return 0;
+}
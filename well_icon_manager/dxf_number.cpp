@@ -0,0 +1,206 @@
+#include "dxf_number.h"
+#include <stdint.h>
+#include <string.h>
+
+// SSSE3 is not part of the x64 baseline, so the vector path is only built
+// when the compiler is told it may use it (-mssse3 or later with gcc/clang,
+// /arch:AVX or later with MSVC).
+#if defined(__SSSE3__) || defined(__AVX__)
+#define DXF_NUMBER_SIMD 1
+#include <tmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+
+// Every power of ten up to 10^22 is exactly representable as a double.
+static const double exactPowersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+static const int maxExactPowerOfTen = 22;
+// ... as is every integer up to 2^53.
+static const uint64_t maxExactMantissa = (uint64_t)1 << 53;
+
+// Parses the optional exponent that follows the mantissa, which must extend
+// to the end of the text.
+static bool parseExponent(const char* p, const char* pEnd, int& exponent)
+{
+    exponent = 0;
+    if (p == pEnd) {
+        return true;
+    }
+    if (*p != 'e' && *p != 'E') {
+        return false;
+    }
+    p++;
+    bool negative = false;
+    if (p < pEnd && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+    if (p == pEnd || pEnd - p > 4) {
+        return false;
+    }
+    for (; p < pEnd; p++) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        exponent = exponent * 10 + (*p - '0');
+    }
+    if (negative) {
+        exponent = -exponent;
+    }
+    return true;
+}
+
+// Clinger's fast path: with both operands exact, one multiplication or
+// division gives the correctly rounded result.
+static bool scaleExactly(uint64_t mantissa, int exponent10, bool negative, double& result)
+{
+    if (mantissa > maxExactMantissa || exponent10 < -maxExactPowerOfTen || exponent10 > maxExactPowerOfTen) {
+        return false;
+    }
+    double value = (double)mantissa;
+    if (exponent10 < 0) {
+        value /= exactPowersOfTen[-exponent10];
+    } else {
+        value *= exactPowersOfTen[exponent10];
+    }
+    result = negative ? -value : value;
+    return true;
+}
+
+static bool parseDecimalScalar(const char* p, const char* pEnd, bool negative, double& result)
+{
+    uint64_t mantissa = 0;
+    int digitCount = 0;
+    int fractionDigitCount = 0;
+    bool seenDot = false;
+    for (; p < pEnd; p++) {
+        char c = *p;
+        if (c >= '0' && c <= '9') {
+            if (digitCount == 19) {
+                return false; // would overflow 64 bits
+            }
+            mantissa = mantissa * 10 + (uint64_t)(c - '0');
+            digitCount++;
+            fractionDigitCount += seenDot;
+        } else if (c == '.' && !seenDot) {
+            seenDot = true;
+        } else {
+            break;
+        }
+    }
+    int exponent;
+    if (digitCount == 0 || !parseExponent(p, pEnd, exponent)) {
+        return false;
+    }
+    return scaleExactly(mantissa, exponent - fractionDigitCount, negative, result);
+}
+
+#ifdef DXF_NUMBER_SIMD
+
+namespace {
+    struct ShuffleTables {
+        // removeDot[d] moves lanes [0, d) up by one lane, dropping the dot
+        // in lane d; removeDot[16] leaves the vector as it is.
+        unsigned char removeDot[17][16];
+        // alignRight[e] moves lanes [0, e) to the top of the vector.
+        unsigned char alignRight[17][16];
+
+        ShuffleTables() {
+            for (int position = 0; position <= 16; position++) {
+                for (int lane = 0; lane < 16; lane++) {
+                    if (position == 16 || lane > position) {
+                        removeDot[position][lane] = (unsigned char)lane;
+                    } else {
+                        removeDot[position][lane] = (lane == 0) ? 0x80 : (unsigned char)(lane - 1);
+                    }
+                    int shift = 16 - position;
+                    alignRight[position][lane] = (lane >= shift) ? (unsigned char)(lane - shift) : 0x80;
+                }
+            }
+        }
+    };
+    const ShuffleTables shuffleTables;
+}
+
+static int lowestSetBit(unsigned bits)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return (int)index;
+#else
+    return __builtin_ctz(bits);
+#endif
+}
+
+// Handles texts of at most 16 characters (mantissa and exponent together).
+static bool parseDecimalSimd(const char* p, size_t length, bool negative, double& result)
+{
+    // Reading a whole 16-byte vector is safe as long as it does not run into
+    // the next page, even when the text itself is shorter; otherwise copy.
+    __m128i text;
+    if (((uintptr_t)p & 4095) <= 4096 - 16) {
+        text = _mm_loadu_si128((const __m128i*)p);
+    } else {
+        alignas(16) char padded[16] = {};
+        memcpy(padded, p, length);
+        text = _mm_load_si128((const __m128i*)padded);
+    }
+
+    unsigned validLanes = (1u << length) - 1;
+    __m128i isDigit = _mm_and_si128(
+        _mm_cmpgt_epi8(text, _mm_set1_epi8('0' - 1)),
+        _mm_cmplt_epi8(text, _mm_set1_epi8('9' + 1))
+    );
+    unsigned digitLanes = (unsigned)_mm_movemask_epi8(isDigit) & validLanes;
+    unsigned dotLanes = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(text, _mm_set1_epi8('.'))) & validLanes;
+    unsigned firstDotLane = dotLanes & (0u - dotLanes);
+
+    // the mantissa ends at the first lane that is neither a digit nor the first dot.
+    unsigned stopLanes = (validLanes & ~digitLanes & ~firstDotLane) | (1u << length);
+    int mantissaEnd = lowestSetBit(stopLanes);
+    int dotPosition = (firstDotLane != 0) ? lowestSetBit(firstDotLane) : 16;
+    bool hasDot = dotPosition < mantissaEnd;
+    int digitCount = mantissaEnd - (hasDot ? 1 : 0);
+
+    int exponent;
+    if (digitCount == 0 || !parseExponent(p + mantissaEnd, p + length, exponent)) {
+        return false;
+    }
+
+    // digit values, with the dot removed and the last digit in lane 15.
+    __m128i digits = _mm_and_si128(_mm_sub_epi8(text, _mm_set1_epi8('0')), isDigit);
+    digits = _mm_shuffle_epi8(digits, _mm_loadu_si128((const __m128i*)shuffleTables.removeDot[hasDot ? dotPosition : 16]));
+    digits = _mm_shuffle_epi8(digits, _mm_loadu_si128((const __m128i*)shuffleTables.alignRight[mantissaEnd]));
+
+    // combine neighbouring digits: 16 x 1 -> 8 x 2 -> 4 x 4 -> 2 x 8 digits.
+    __m128i pairs = _mm_maddubs_epi16(digits, _mm_set1_epi16(0x010A));
+    __m128i quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00010064));
+    quads = _mm_packs_epi32(quads, quads);
+    __m128i octets = _mm_madd_epi16(quads, _mm_set1_epi32(0x00012710));
+    uint64_t high = (uint32_t)_mm_cvtsi128_si32(octets);
+    uint64_t low = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(octets, 4));
+    uint64_t mantissa = high * 100000000 + low;
+
+    int fractionDigitCount = hasDot ? mantissaEnd - dotPosition - 1 : 0;
+    return scaleExactly(mantissa, exponent - fractionDigitCount, negative, result);
+}
+
+#endif
+
+bool parseDecimalFast(std::string_view text, bool negative, double& result)
+{
+    const char* p = text.data();
+    const char* pEnd = p + text.size();
+#ifdef DXF_NUMBER_SIMD
+    if (pEnd - p <= 16) {
+        return parseDecimalSimd(p, (size_t)(pEnd - p), negative, result);
+    }
+#endif
+    return parseDecimalScalar(p, pEnd, negative, result);
+}
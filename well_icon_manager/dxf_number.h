@@ -0,0 +1,21 @@
+#pragma once
+
+// Fast path for converting the decimal text of DXF real groups to doubles.
+//
+// Most coordinates in a DXF file are short plain decimals ("1234.5678",
+// "-0.25", "1.5E+02").  For those, the significant digits are gathered into
+// a 64-bit integer (16 characters at a time with SSSE3 where the compiler
+// targets it, otherwise with a scalar loop) and scaled by an exact power of
+// ten in a single IEEE operation, which is correctly rounded (Clinger's fast
+// path).  The result is therefore bit-for-bit what strtod would produce.
+
+#include <string_view>
+
+// Converts text, the digits of the number after its sign, which the caller
+// has stripped (together with any surrounding blanks) and passes as
+// negative.  Returns false, without touching result, if the text is not a
+// plain decimal that the fast path can convert exactly -- more than 16
+// significant characters, a large exponent, "inf", hex floats, invalid
+// text (including a second sign), etc.  Callers fall back to
+// std::from_chars in that case.
+bool parseDecimalFast(std::string_view text, bool negative, double& result);
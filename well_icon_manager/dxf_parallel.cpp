@@ -0,0 +1,171 @@
+#include "dxf_parallel.h"
+#include <string.h>
+#include <algorithm>
+#include <functional>
+#include "dxf_reader.h"
+
+
+static std::string_view trimmedLine(std::string_view text, size_t lineStart, size_t& nextLineStart)
+{
+    const char* pLine = text.data() + lineStart;
+    const char* pNewline = (const char*)memchr(pLine, '\n', text.size() - lineStart);
+    size_t lineEnd = (pNewline == NULL) ? text.size() : (size_t)(pNewline - text.data());
+    nextLineStart = (pNewline == NULL) ? text.size() : lineEnd + 1;
+    std::string_view line = text.substr(lineStart, lineEnd - lineStart);
+    while (!line.empty() && (line.front() == ' ' || line.front() == '\t')) { line.remove_prefix(1); }
+    while (!line.empty() && (line.back() == ' ' || line.back() == '\t' || line.back() == '\r')) { line.remove_suffix(1); }
+    return line;
+}
+
+// Start of the first line at or after position.
+static size_t lineStartAtOrAfter(std::string_view text, size_t position)
+{
+    if (position == 0 || position >= text.size() || text[position - 1] == '\n') {
+        return std::min(position, text.size());
+    }
+    const char* pNewline = (const char*)memchr(text.data() + position, '\n', text.size() - position);
+    return (pNewline == NULL) ? text.size() : (size_t)(pNewline - text.data()) + 1;
+}
+
+// Start of the line before the line that starts at lineStart, or npos.
+static size_t previousLineStart(std::string_view text, size_t lineStart)
+{
+    if (lineStart == 0) {
+        return std::string_view::npos;
+    }
+    // text[lineStart - 1] is the newline that ends the previous line.
+    size_t newline = (lineStart >= 2) ? text.rfind('\n', lineStart - 2) : std::string_view::npos;
+    return (newline == std::string_view::npos) ? 0 : newline + 1;
+}
+
+// Finds the next line (starting the search at from) that holds a group 0
+// whose value is objectType, e.g. "SECTION", and returns the start of its
+// "0" line, or npos.  A value line equal to objectType can only be preceded
+// by a line "0" if that line is the group code: a value "0" is always
+// followed by a (numeric) group code line.
+static size_t findGroupZero(std::string_view text, size_t from, std::string_view objectType)
+{
+    std::boyer_moore_horspool_searcher<const char*> searcher(objectType.data(), objectType.data() + objectType.size());
+    const char* pEnd = text.data() + text.size();
+    for (const char* pFound = std::search(text.data() + from, pEnd, searcher); pFound != pEnd; pFound = std::search(pFound + 1, pEnd, searcher)) {
+        size_t position = (size_t)(pFound - text.data());
+        if (position > 0 && text[position - 1] != '\n') {
+            continue;
+        }
+        size_t nextLineStart;
+        if (trimmedLine(text, position, nextLineStart) != objectType) {
+            continue;
+        }
+        size_t codeLineStart = previousLineStart(text, position);
+        if (codeLineStart != std::string_view::npos && trimmedLine(text, codeLineStart, nextLineStart) == "0") {
+            return codeLineStart;
+        }
+    }
+    return std::string_view::npos;
+}
+
+// Finds where the bodies of the BLOCKS and ENTITIES sections begin (the line
+// after the section name), or npos.  Only the sections in front of ENTITIES
+// are searched; the end of a section is found later, while splitting, so
+// that the ENTITIES section itself is never scanned from end to end.
+static void findSectionBodies(std::string_view text, size_t& blocksBegin, size_t& entitiesBegin, size_t& entitiesStart)
+{
+    blocksBegin = std::string_view::npos;
+    entitiesBegin = std::string_view::npos;
+    entitiesStart = std::string_view::npos;
+    size_t searchFrom = 0;
+    size_t sectionStart;
+    while ((sectionStart = findGroupZero(text, searchFrom, "SECTION")) != std::string_view::npos) {
+        size_t lineStart;
+        trimmedLine(text, sectionStart, lineStart);      // 0
+        trimmedLine(text, lineStart, lineStart);         // SECTION
+        std::string_view code = trimmedLine(text, lineStart, lineStart);
+        std::string_view sectionName = trimmedLine(text, lineStart, lineStart);
+        if (code == "2" && sectionName == "BLOCKS") {
+            blocksBegin = lineStart;
+        } else if (code == "2" && sectionName == "ENTITIES") {
+            entitiesBegin = lineStart;
+            entitiesStart = sectionStart;
+            return;
+        }
+        searchFrom = lineStart;
+    }
+}
+
+// Finds the first line in [from, limit) where group 0 starts an entity,
+// i.e. a line "0" followed by a line that is not a number.  Returns npos if
+// there is none; if the section ends (ENDSEC) first, limit is moved back to
+// the end of the section.
+static size_t findEntityStart(std::string_view text, size_t from, size_t& limit)
+{
+    size_t lineStart = lineStartAtOrAfter(text, from);
+    while (lineStart < limit) {
+        size_t valueLineStart;
+        if (trimmedLine(text, lineStart, valueLineStart) == "0" && valueLineStart < text.size()) {
+            size_t afterValue;
+            std::string_view value = trimmedLine(text, valueLineStart, afterValue);
+            if (value == "ENDSEC" || value == "EOF") {
+                limit = lineStart;
+                return std::string_view::npos;
+            }
+            if (!value.empty() && !(value[0] >= '0' && value[0] <= '9') && value[0] != '-' && value[0] != '+') {
+                return lineStart;
+            }
+        }
+        lineStart = valueLineStart;
+    }
+    return std::string_view::npos;
+}
+
+std::vector<std::string_view> splitDxfIntoChunks(std::string_view text, size_t chunkCount)
+{
+    std::vector<size_t> splitPoints;
+    if (chunkCount > 1 && text.substr(0, binaryDxfSentinel.size()) != binaryDxfSentinel) {
+        struct Span { size_t begin; size_t end; };
+        std::vector<Span> spans;
+        size_t blocksBegin, entitiesBegin, entitiesStart;
+        findSectionBodies(text, blocksBegin, entitiesBegin, entitiesStart);
+        if (blocksBegin != std::string_view::npos) {
+            // BLOCKS ends before ENTITIES starts, if it comes first as usual.
+            size_t blocksEnd = (entitiesStart != std::string_view::npos && entitiesStart > blocksBegin) ? entitiesStart : text.size();
+            spans.push_back(Span{ blocksBegin, blocksEnd });
+        }
+        if (entitiesBegin != std::string_view::npos) {
+            spans.push_back(Span{ entitiesBegin, text.size() });
+        }
+
+        size_t totalSize = 0;
+        for (const Span& span : spans) { totalSize += span.end - span.begin; }
+
+        // spread the split points evenly over the bytes of both sections.
+        // (Their sizes are overestimated until the ENDSEC is come across, so
+        // a large section after them results in fewer chunks, not wrong ones.)
+        size_t spanIndex = 0;
+        size_t sizeBeforeSpan = 0;
+        for (size_t k = 1; k < chunkCount && totalSize > 0; k++) {
+            size_t target = totalSize * k / chunkCount;
+            while (spanIndex < spans.size() && target >= sizeBeforeSpan + (spans[spanIndex].end - spans[spanIndex].begin)) {
+                sizeBeforeSpan += spans[spanIndex].end - spans[spanIndex].begin;
+                spanIndex++;
+            }
+            if (spanIndex == spans.size()) {
+                break;
+            }
+            Span& span = spans[spanIndex];
+            size_t from = std::max(span.begin + (target - sizeBeforeSpan), splitPoints.empty() ? 0 : splitPoints.back() + 1);
+            size_t splitPoint = findEntityStart(text, from, span.end);
+            if (splitPoint != std::string_view::npos && splitPoint > 0) {
+                splitPoints.push_back(splitPoint);
+            }
+        }
+    }
+
+    std::vector<std::string_view> chunks;
+    size_t chunkStart = 0;
+    for (size_t splitPoint : splitPoints) {
+        chunks.push_back(text.substr(chunkStart, splitPoint - chunkStart));
+        chunkStart = splitPoint;
+    }
+    chunks.push_back(text.substr(chunkStart));
+    return chunks;
+}
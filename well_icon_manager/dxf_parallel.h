@@ -0,0 +1,53 @@
+#pragma once
+
+// Parallel ingestion of large ASCII DXF files.
+//
+// A site plan keeps nearly all of its bulk in the ENTITIES and BLOCKS
+// sections.  splitDxfIntoChunks() cuts the file into consecutive pieces at
+// lines where group 0 starts an entity; since DxfReader's state (the ET_*
+// context and point folding) never reaches across a group 0, every piece can
+// be read by its own DxfReader.  parseDxfChunksInParallel() then runs one
+// piece per task on a set of worker threads and returns the results in
+// document order.
+//
+// Binary DXF cannot be split this way (a group code cannot be recognized
+// without reading from the start), so binary files are returned as a
+// single chunk.
+
+#include <stddef.h>
+#include <atomic>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Splits text into about chunkCount consecutive pieces that together cover
+// the whole text, in document order.  Split points are only placed inside
+// the ENTITIES and BLOCKS sections, each at the start of a group 0 line.
+std::vector<std::string_view> splitDxfIntoChunks(std::string_view text, size_t chunkCount);
+
+// Calls parseChunk(chunk) for every chunk on threadCount worker threads and
+// returns the results in the order of the chunks.  Chunks are handed out one
+// at a time, so splitting into a few more chunks than threads evens out the
+// load.  parseChunk must be safe to call concurrently.
+template <typename Result, typename ParseChunk>
+std::vector<Result> parseDxfChunksInParallel(const std::vector<std::string_view>& chunks, unsigned threadCount, ParseChunk parseChunk)
+{
+    std::vector<Result> results(chunks.size());
+    std::atomic<size_t> nextChunk(0);
+    auto work = [&]() {
+        for (size_t i = nextChunk++; i < chunks.size(); i = nextChunk++) {
+            results[i] = parseChunk(chunks[i]);
+        }
+    };
+
+    if (threadCount < 1) { threadCount = 1; }
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < threadCount && i < chunks.size(); i++) {
+        workers.emplace_back(work);
+    }
+    work(); // the calling thread is the first worker.
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    return results;
+}
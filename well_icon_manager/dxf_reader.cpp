@@ -0,0 +1,294 @@
+#include "dxf_reader.h"
+#include "dxf_number.h"
+#include <stdint.h>
+#include <string.h>
+#include <charconv>
+
+
+static std::string_view trimBlanks(std::string_view text)
+{
+    size_t first = 0;
+    size_t last = text.size();
+    while (first < last && (text[first] == ' ' || text[first] == '\t' || text[first] == '\r')) { first++; }
+    while (last > first && (text[last - 1] == ' ' || text[last - 1] == '\t' || text[last - 1] == '\r')) { last--; }
+    return text.substr(first, last - first);
+}
+
+bool parseDxfReal(std::string_view text, double& result)
+{
+    text = trimBlanks(text);
+    // the sign is taken off here, and only here: neither the fast path nor
+    // from_chars is given one, so "+-5" is not a number.
+    bool negative = false;
+    if (!text.empty() && (text[0] == '-' || text[0] == '+')) {
+        negative = (text[0] == '-');
+        text.remove_prefix(1);
+    }
+    if (text.empty() || text[0] == '-' || text[0] == '+') { return false; }
+    if (parseDecimalFast(text, negative, result)) {
+        return true;
+    }
+    double magnitude;
+    std::from_chars_result parsed = std::from_chars(text.data(), text.data() + text.size(), magnitude);
+    if (parsed.ec != std::errc() || parsed.ptr != text.data() + text.size()) {
+        return false;
+    }
+    result = negative ? -magnitude : magnitude;
+    return true;
+}
+
+bool parseDxfInteger(std::string_view text, long long& result)
+{
+    text = trimBlanks(text);
+    // from_chars takes a minus sign, but not a plus sign, nor a sign after it.
+    if (!text.empty() && text[0] == '+') {
+        text.remove_prefix(1);
+        if (!text.empty() && text[0] == '-') { return false; }
+    }
+    if (text.empty()) { return false; }
+    std::from_chars_result parsed = std::from_chars(text.data(), text.data() + text.size(), result);
+    return parsed.ec == std::errc() && parsed.ptr == text.data() + text.size();
+}
+
+short dxfEtypeOfObject(std::string_view objectType)
+{
+    objectType = trimBlanks(objectType);
+    if (objectType == "TABLE")  { return ET_TBL; }
+    if (objectType == "VPORT")  { return ET_VPORT; }
+    if (objectType == "LTYPE")  { return ET_LTYPE; }
+    if (objectType == "LAYER")  { return ET_LAYER; }
+    if (objectType == "STYLE")  { return ET_STYLE; }
+    if (objectType == "VIEW")   { return ET_VIEW; }
+    if (objectType == "UCS")    { return ET_UCS; }
+    if (objectType == "BLOCK")  { return ET_BLOCK; }
+    return ET_NORM;
+}
+
+
+DxfValueKind dxfValueKind(short groupCode)
+{
+    if (groupCode >= 10 && groupCode <= 59)     { return kDxfDouble; }
+    if (groupCode >= 60 && groupCode <= 79)     { return kDxfInt16; }
+    if (groupCode >= 90 && groupCode <= 99)     { return kDxfInt32; }
+    if (groupCode >= 110 && groupCode <= 149)   { return kDxfDouble; }
+    if (groupCode >= 160 && groupCode <= 169)   { return kDxfInt64; }
+    if (groupCode >= 170 && groupCode <= 179)   { return kDxfInt16; }
+    if (groupCode >= 210 && groupCode <= 239)   { return kDxfDouble; }
+    if (groupCode >= 270 && groupCode <= 289)   { return kDxfInt16; }
+    if (groupCode >= 290 && groupCode <= 299)   { return kDxfBoolean; }
+    if (groupCode >= 310 && groupCode <= 319)   { return kDxfBinaryChunk; }
+    if (groupCode >= 370 && groupCode <= 389)   { return kDxfInt16; }
+    if (groupCode >= 400 && groupCode <= 409)   { return kDxfInt16; }
+    if (groupCode >= 420 && groupCode <= 429)   { return kDxfInt32; }
+    if (groupCode >= 440 && groupCode <= 459)   { return kDxfInt32; }
+    if (groupCode >= 460 && groupCode <= 469)   { return kDxfDouble; }
+    if (groupCode == 1004)                      { return kDxfBinaryChunk; }
+    if (groupCode >= 1010 && groupCode <= 1059) { return kDxfDouble; }
+    if (groupCode >= 1060 && groupCode <= 1070) { return kDxfInt16; }
+    if (groupCode == 1071)                      { return kDxfInt32; }
+    return kDxfString;
+}
+
+// Little-endian load of size bytes; binary DXF is little-endian regardless
+// of the host.
+static uint64_t loadLittleEndian(const char* pBytes, size_t size)
+{
+    uint64_t result = 0;
+    for (size_t i = 0; i < size; i++) {
+        result |= (uint64_t)(unsigned char)pBytes[i] << (8 * i);
+    }
+    return result;
+}
+
+bool DxfRecord::real(int index, double& result) const
+{
+    if (index < 0 || index >= valueCount) {
+        return false;
+    }
+    if (format == kAsciiDxf) {
+        return parseDxfReal(values[index], result);
+    }
+    if (dxfValueKind((short)(groupCode + 10 * index)) != kDxfDouble || values[index].size() != sizeof(double)) {
+        return false;
+    }
+    uint64_t bits = loadLittleEndian(values[index].data(), sizeof(double));
+    memcpy(&result, &bits, sizeof(double));
+    return true;
+}
+
+bool DxfRecord::integer(long long& result) const
+{
+    if (format == kAsciiDxf) {
+        return parseDxfInteger(values[0], result);
+    }
+    size_t size = values[0].size();
+    uint64_t bits = loadLittleEndian(values[0].data(), size);
+    switch (dxfValueKind(groupCode)) {
+    case kDxfBoolean: if (size != 1) { return false; } result = (long long)bits;            break;
+    case kDxfInt16:   if (size != 2) { return false; } result = (int16_t)(uint16_t)bits;    break;
+    case kDxfInt32:   if (size != 4) { return false; } result = (int32_t)(uint32_t)bits;    break;
+    case kDxfInt64:   if (size != 8) { return false; } result = (long long)(int64_t)bits;  break;
+    default:          return false;
+    }
+    return true;
+}
+
+
+DxfReader::DxfReader(std::string_view data) :
+    pBegin(data.data()),
+    pEnd(data.data() + data.size()),
+    pCursor(data.data()),
+    inputFormat(kAsciiDxf),
+    lineNumber(0),
+    etype(ET_NORM),
+    errorMessage(NULL)
+{
+    if (data.substr(0, binaryDxfSentinel.size()) == binaryDxfSentinel) {
+        inputFormat = kBinaryDxf;
+        pCursor += binaryDxfSentinel.size();
+    }
+}
+
+void DxfReader::fail(const char* message)
+{
+    errorMessage = message;
+    pCursor = pEnd;
+}
+
+bool DxfReader::readLine(std::string_view& line)
+{
+    if (pCursor >= pEnd) {
+        return false;
+    }
+    const char* pNewline = (const char*)memchr(pCursor, '\n', (size_t)(pEnd - pCursor));
+    const char* pLineEnd = (pNewline == NULL) ? pEnd : pNewline;
+    line = std::string_view(pCursor, (size_t)(pLineEnd - pCursor));
+    if (!line.empty() && line.back() == '\r') { line.remove_suffix(1); }
+    pCursor = (pNewline == NULL) ? pEnd : pNewline + 1;
+    lineNumber++;
+    return true;
+}
+
+bool DxfReader::readAsciiPair(short& groupCode, std::string_view& value)
+{
+    std::string_view codeLine;
+    if (!readLine(codeLine)) {
+        return false;
+    }
+    codeLine = trimBlanks(codeLine);
+    if (codeLine.empty() && pCursor >= pEnd) {
+        // trailing blank line at the very end of the file.
+        return false;
+    }
+    long long code;
+    if (!parseDxfInteger(codeLine, code) || code < -32768 || code > 32767) {
+        fail("invalid group code");
+        return false;
+    }
+    if (!readLine(value)) {
+        fail("group code without a value");
+        return false;
+    }
+    groupCode = (short)code;
+    return true;
+}
+
+bool DxfReader::readBinaryPair(short& groupCode, std::string_view& value)
+{
+    if (pCursor >= pEnd) {
+        return false;
+    }
+    if (pEnd - pCursor < 2) {
+        fail("truncated group code");
+        return false;
+    }
+    groupCode = (short)(uint16_t)loadLittleEndian(pCursor, 2);
+    pCursor += 2;
+
+    size_t available = (size_t)(pEnd - pCursor);
+    size_t size;
+    size_t skip = 0; // bytes between the value and the next group
+    switch (dxfValueKind(groupCode)) {
+    case kDxfDouble:  size = 8; break;
+    case kDxfInt16:   size = 2; break;
+    case kDxfInt32:   size = 4; break;
+    case kDxfInt64:   size = 8; break;
+    case kDxfBoolean: size = 1; break;
+    case kDxfBinaryChunk:
+        if (available < 1) {
+            fail("truncated binary chunk");
+            return false;
+        }
+        size = (unsigned char)*pCursor;
+        pCursor++;
+        available--;
+        break;
+    default: {
+        const char* pTerminator = (const char*)memchr(pCursor, '\0', available);
+        if (pTerminator == NULL) {
+            fail("unterminated string");
+            return false;
+        }
+        size = (size_t)(pTerminator - pCursor);
+        skip = 1;
+        break;
+    }
+    }
+    if (size > available) {
+        fail("truncated value");
+        return false;
+    }
+    value = std::string_view(pCursor, size);
+    pCursor += size + skip;
+    return true;
+}
+
+bool DxfReader::readPair(short& groupCode, std::string_view& value)
+{
+    return inputFormat == kBinaryDxf ? readBinaryPair(groupCode, value) : readAsciiPair(groupCode, value);
+}
+
+bool DxfReader::next(DxfRecord& record)
+{
+    short groupCode;
+    std::string_view value;
+    if (!readPair(groupCode, value)) {
+        return false;
+    }
+    if (groupCode == 0) {
+        etype = dxfEtypeOfObject(value);
+    }
+
+    record.groupCode = groupCode;
+    record.etype = etype;
+    record.format = inputFormat;
+    record.resultTypeCode = dxftype(groupCode, etype, &record.inxdata);
+    record.valueCount = 1;
+    record.values[0] = value;
+
+    if (record.resultTypeCode == RTPOINT || record.resultTypeCode == RT3DPOINT) {
+        // fold the following Y (and Z) groups into this record.
+        int dimensions = (record.resultTypeCode == RTPOINT) ? 2 : 3;
+        for (int i = 1; i < dimensions; i++) {
+            const char* pMark = pCursor;
+            size_t markLineNumber = lineNumber;
+            short coordinateGroupCode;
+            std::string_view coordinateValue;
+            if (!readPair(coordinateGroupCode, coordinateValue) || coordinateGroupCode != groupCode + 10 * i) {
+                // not a coordinate of this point; leave it (or the error) for the next call.
+                pCursor = pMark;
+                lineNumber = markLineNumber;
+                errorMessage = NULL;
+                break;
+            }
+            record.values[i] = coordinateValue;
+            record.valueCount++;
+        }
+    }
+
+    if (groupCode == 0 && trimBlanks(value) == "EOF") {
+        // anything after the EOF marker is not part of the drawing.
+        pCursor = pEnd;
+    }
+    return true;
+}
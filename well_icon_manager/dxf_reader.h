@@ -0,0 +1,103 @@
+#pragma once
+
+// Streaming reader for ASCII and binary DXF files.  The reader works directly
+// on the bytes of a (typically memory-mapped, see mapped_file.h) file and
+// yields one record at a time; values are views into the input, nothing is
+// copied.
+//
+// Records are typed with dxftype(), and the X/Y/Z groups of a point (10, 20,
+// 30, or 1010, 1020, 1030, ...) are folded into a single record, so the
+// stream has the same shape as the resbuf chain that acdbEntGet() would
+// return for the same data.
+
+#include <stddef.h>
+#include <string_view>
+#include "dxftype.h"
+
+enum DxfFormat {
+    kAsciiDxf,
+    kBinaryDxf
+};
+
+// Every binary DXF file starts with these 22 bytes.
+constexpr std::string_view binaryDxfSentinel("AutoCAD Binary DXF\r\n\x1a\0", 22);
+
+// How the value of a group is stored in a binary DXF file.  This is finer
+// grained than dxftype(), which does not type many of the newer group codes.
+enum DxfValueKind {
+    kDxfString,      // NUL-terminated text
+    kDxfDouble,      // 8-byte IEEE double
+    kDxfInt16,
+    kDxfInt32,
+    kDxfInt64,
+    kDxfBoolean,     // 1 byte
+    kDxfBinaryChunk  // 1 length byte followed by that many bytes (hex text in ASCII files)
+};
+
+DxfValueKind dxfValueKind(short groupCode);
+
+struct DxfRecord {
+    short groupCode;
+    short resultTypeCode; // dxftype(groupCode, etype) in the current context
+    short etype;          // the ET_* context the record was classified in
+    int inxdata;
+    DxfFormat format;     // how the values are encoded
+
+    // For RTPOINT and RT3DPOINT records, the coordinate values (valueCount is
+    // 2 or 3; a 3d point whose Z group is absent has a valueCount of 2).
+    // For every other record, values[0] is the value and valueCount is 1.
+    // In a binary file, numeric values are views of their raw little-endian
+    // bytes; use real() and integer() to read them in either format.
+    int valueCount;
+    std::string_view values[3];
+
+    std::string_view value() const { return values[0]; }
+
+    // Numeric value of values[index].  Return false if the value is not of
+    // the requested kind.
+    bool real(int index, double& result) const;
+    bool integer(long long& result) const;
+};
+
+// Numeric conversion of ASCII group values.  Leading and trailing blanks are
+// ignored.  Return false if the text is not a number of the requested kind.
+bool parseDxfReal(std::string_view text, double& result);
+bool parseDxfInteger(std::string_view text, long long& result);
+
+// Maps the group 0 value that starts an object (e.g. "VPORT") to the ET_*
+// context its groups are classified in.
+short dxfEtypeOfObject(std::string_view objectType);
+
+class DxfReader {
+    private:
+        const char* pBegin;
+        const char* pEnd;
+        const char* pCursor;
+        DxfFormat inputFormat;
+        size_t lineNumber;
+        short etype;
+        const char* errorMessage;
+
+        bool readLine(std::string_view& line);
+        bool readAsciiPair(short& groupCode, std::string_view& value);
+        bool readBinaryPair(short& groupCode, std::string_view& value);
+        bool readPair(short& groupCode, std::string_view& value);
+        void fail(const char* message);
+
+    public:
+        // The format is detected from the first bytes of data; the binary
+        // sentinel, if present, is skipped.
+        explicit DxfReader(std::string_view data);
+
+        // Reads the next record.  Returns false at the end of the input, or
+        // if the input is malformed (in which case failed() is true).
+        bool next(DxfRecord& record);
+
+        DxfFormat format() const { return inputFormat; }
+        bool failed() const { return errorMessage != NULL; }
+        const char* error() const { return errorMessage; }
+        // 1-based number of the last line consumed (ASCII files only).
+        size_t line() const { return lineNumber; }
+        // byte offset of the next unread group.
+        size_t offset() const { return (size_t)(pCursor - pBegin); }
+};
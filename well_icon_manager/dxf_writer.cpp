@@ -0,0 +1,198 @@
+#include "dxf_writer.h"
+#include <stdint.h>
+#include <string.h>
+#include <charconv>
+#include <string>
+
+
+static void storeLittleEndian(char* pBytes, uint64_t value, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        pBytes[i] = (char)(value >> (8 * i));
+    }
+}
+
+static size_t integerWidth(DxfValueKind kind)
+{
+    switch (kind) {
+    case kDxfBoolean: return 1;
+    case kDxfInt16:   return 2;
+    case kDxfInt32:   return 4;
+    case kDxfInt64:   return 8;
+    default:          return 0;
+    }
+}
+
+static bool isIntegerKind(DxfValueKind kind)
+{
+    return integerWidth(kind) != 0;
+}
+
+static int hexDigitValue(char c)
+{
+    if (c >= '0' && c <= '9') { return c - '0'; }
+    if (c >= 'A' && c <= 'F') { return c - 'A' + 10; }
+    if (c >= 'a' && c <= 'f') { return c - 'a' + 10; }
+    return -1;
+}
+
+
+DxfWriter::DxfWriter(FILE* out, DxfFormat format) : out(out), outputFormat(format)
+{
+    if (outputFormat == kBinaryDxf) {
+        fwrite(binaryDxfSentinel.data(), 1, binaryDxfSentinel.size(), out);
+    }
+}
+
+void DxfWriter::writeGroupCode(short groupCode)
+{
+    if (outputFormat == kBinaryDxf) {
+        char bytes[2];
+        storeLittleEndian(bytes, (uint16_t)groupCode, 2);
+        fwrite(bytes, 1, 2, out);
+    } else {
+        // AutoCAD right-aligns group codes in a field of three.
+        char digits[8];
+        std::to_chars_result formatted = std::to_chars(digits, digits + sizeof(digits), groupCode);
+        size_t length = (size_t)(formatted.ptr - digits);
+        char text[12] = "   ";
+        size_t padding = length < 3 ? 3 - length : 0;
+        memcpy(text + padding, digits, length);
+        memcpy(text + padding + length, "\r\n", 2);
+        fwrite(text, 1, padding + length + 2, out);
+    }
+}
+
+void DxfWriter::writeAsciiValue(std::string_view text)
+{
+    fwrite(text.data(), 1, text.size(), out);
+    fwrite("\r\n", 1, 2, out);
+}
+
+void DxfWriter::writeString(short groupCode, std::string_view text)
+{
+    writeGroupCode(groupCode);
+    if (outputFormat == kBinaryDxf) {
+        fwrite(text.data(), 1, text.size(), out);
+        fputc('\0', out);
+    } else {
+        writeAsciiValue(text);
+    }
+}
+
+void DxfWriter::writeReal(short groupCode, double value)
+{
+    writeGroupCode(groupCode);
+    if (outputFormat == kBinaryDxf) {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(double));
+        char bytes[8];
+        storeLittleEndian(bytes, bits, 8);
+        fwrite(bytes, 1, 8, out);
+    } else {
+        // shortest text that reads back as exactly the same double.
+        char text[32];
+        std::to_chars_result formatted = std::to_chars(text, text + sizeof(text), value);
+        writeAsciiValue(std::string_view(text, (size_t)(formatted.ptr - text)));
+    }
+}
+
+void DxfWriter::writeInteger(short groupCode, long long value)
+{
+    writeGroupCode(groupCode);
+    if (outputFormat == kBinaryDxf) {
+        size_t width = integerWidth(dxfValueKind(groupCode));
+        char bytes[8];
+        storeLittleEndian(bytes, (uint64_t)value, width);
+        fwrite(bytes, 1, width, out);
+    } else {
+        char text[24];
+        std::to_chars_result formatted = std::to_chars(text, text + sizeof(text), value);
+        writeAsciiValue(std::string_view(text, (size_t)(formatted.ptr - text)));
+    }
+}
+
+void DxfWriter::writeBinaryChunk(short groupCode, std::string_view bytes)
+{
+    do {
+        std::string_view piece = bytes.substr(0, 255);
+        bytes.remove_prefix(piece.size());
+        writeGroupCode(groupCode);
+        if (outputFormat == kBinaryDxf) {
+            fputc((int)piece.size(), out);
+            fwrite(piece.data(), 1, piece.size(), out);
+        } else {
+            static const char hexDigits[] = "0123456789ABCDEF";
+            char text[2 * 255];
+            for (size_t i = 0; i < piece.size(); i++) {
+                text[2 * i] = hexDigits[(unsigned char)piece[i] >> 4];
+                text[2 * i + 1] = hexDigits[(unsigned char)piece[i] & 0xF];
+            }
+            writeAsciiValue(std::string_view(text, 2 * piece.size()));
+        }
+    } while (!bytes.empty());
+}
+
+bool DxfWriter::writeRecord(const DxfRecord& record)
+{
+    DxfValueKind kind = dxfValueKind(record.groupCode);
+
+    if (record.format == outputFormat) {
+        // same encoding on both sides: copy the values through untouched.
+        for (int i = 0; i < record.valueCount; i++) {
+            short groupCode = (short)(record.groupCode + 10 * i);
+            writeGroupCode(groupCode);
+            if (outputFormat == kAsciiDxf) {
+                writeAsciiValue(record.values[i]);
+                continue;
+            }
+            if (kind == kDxfBinaryChunk) {
+                fputc((int)record.values[i].size(), out);
+            }
+            fwrite(record.values[i].data(), 1, record.values[i].size(), out);
+            if (kind == kDxfString) {
+                fputc('\0', out);
+            }
+        }
+        return true;
+    }
+
+    // convert every value before writing any of them.
+    if (kind == kDxfDouble) {
+        double coordinates[3];
+        for (int i = 0; i < record.valueCount; i++) {
+            if (!record.real(i, coordinates[i])) {
+                return false;
+            }
+        }
+        for (int i = 0; i < record.valueCount; i++) {
+            writeReal((short)(record.groupCode + 10 * i), coordinates[i]);
+        }
+    } else if (isIntegerKind(kind)) {
+        long long integer;
+        if (!record.integer(integer)) {
+            return false;
+        }
+        writeInteger(record.groupCode, integer);
+    } else if (kind == kDxfBinaryChunk && record.format == kAsciiDxf) {
+        std::string_view text = record.value();
+        if (text.size() % 2 != 0) {
+            return false;
+        }
+        std::string bytes(text.size() / 2, '\0');
+        for (size_t i = 0; i < bytes.size(); i++) {
+            int high = hexDigitValue(text[2 * i]);
+            int low = hexDigitValue(text[2 * i + 1]);
+            if (high < 0 || low < 0) {
+                return false;
+            }
+            bytes[i] = (char)(high << 4 | low);
+        }
+        writeBinaryChunk(record.groupCode, bytes);
+    } else if (kind == kDxfBinaryChunk) {
+        writeBinaryChunk(record.groupCode, record.value());
+    } else {
+        writeString(record.groupCode, record.value());
+    }
+    return true;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+// Writer for ASCII and binary DXF files, the counterpart of DxfReader.
+// Records read from a file of either format can be written back in either
+// format; values are converted only when the formats differ.
+
+#include <stdio.h>
+#include <string_view>
+#include "dxf_reader.h"
+
+class DxfWriter {
+    private:
+        FILE* out;
+        DxfFormat outputFormat;
+
+        void writeGroupCode(short groupCode);
+        void writeAsciiValue(std::string_view text);
+
+    public:
+        // For binary output, the sentinel is written immediately.
+        DxfWriter(FILE* out, DxfFormat format);
+
+        DxfFormat format() const { return outputFormat; }
+
+        void writeString(short groupCode, std::string_view text);
+        void writeReal(short groupCode, double value);
+        // The value is stored in the width dxfValueKind(groupCode) calls for.
+        void writeInteger(short groupCode, long long value);
+        // Chunks longer than 255 bytes are split over several groups.
+        void writeBinaryChunk(short groupCode, std::string_view bytes);
+
+        // Writes a record, unfolding points into their X, Y and Z groups.
+        // Returns false (having written nothing) if a value cannot be
+        // converted to the output format.
+        bool writeRecord(const DxfRecord& record);
+};
@@ -0,0 +1,289 @@
+// dxfbench: micro-benchmarks of the group-code and value conversions that
+// the DXF reader does for every record.
+//
+//   dxftype  dxftype() (the lookup table) and classifyGroupCodes() (the
+//            table, a whole run of codes at once) against
+//            dxftypeBranchChain() (the original branch chain), per group
+//            code.  Each code is classified 4096 times in a row, which is
+//            the best case for the branch chain: its branches are always
+//            predicted.  The "mixed" line classifies the codes of the table
+//            in a random order, as they come in a drawing.  All three forms
+//            are checked to agree on every code of every ET_* context, and
+//            the batch form on every short, in and out of the table.
+//   reals    parseDxfReal() against strtod() and std::from_chars() on 100k
+//            numbers written the ways DXF files write them: fixed-point
+//            coordinates of 0 to 10 decimals, with and without a sign,
+//            exponents, and long values that take from_chars.  Every result
+//            is checked to be bit-for-bit that of strtod(), and texts such
+//            as "+-5" to be rejected.
+//
+// Each measurement is repeated for at least 20 ms; the times are per
+// conversion.
+//
+// This is a standalone program; it does not link against ObjectARX:
+//
+//     g++ -std=c++17 -O2 -msse4.2 -I ObjectARX_for_AutoCAD_2021_Win_64bit/inc dxfbench.cpp dxf_reader.cpp dxf_number.cpp -o dxfbench
+//
+// usage: dxfbench [--step dxftype|reals] [--each-code]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "dxf_reader.h"
+
+
+typedef std::chrono::steady_clock Clock;
+
+// keeps the results of the timed loops alive.
+static volatile long long sink;
+
+// Runs step (which converts count items) until 20 ms have passed, and
+// returns the time per item in ns.
+template <typename Step>
+static double nanosecondsPerItem(size_t count, Step step)
+{
+    size_t repetitions = 0;
+    Clock::time_point startTime = Clock::now();
+    double seconds;
+    do {
+        sink = sink + step();
+        repetitions++;
+        seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    } while (seconds < 0.02);
+    return seconds * 1.0e9 / repetitions / (count > 0 ? count : 1);
+}
+
+static long long classifyWithTable(const std::vector<short>& codes, short etype)
+{
+    long long sum = 0;
+    int inxdata;
+    for (short code : codes) {
+        sum += dxftype(code, etype, &inxdata);
+    }
+    return sum;
+}
+
+static long long classifyWithBranchChain(const std::vector<short>& codes, short etype)
+{
+    long long sum = 0;
+    for (short code : codes) {
+        sum += dxftypeBranchChain(code, etype);
+    }
+    return sum;
+}
+
+static long long classifyAsBatch(const std::vector<short>& codes, short etype, std::vector<short>& resultTypeCodes)
+{
+    // the results are in memory, so the last one keeps them all alive.
+    classifyGroupCodes(codes.data(), codes.size(), etype, resultTypeCodes.data());
+    return resultTypeCodes.back();
+}
+
+static void printTimes(const char* label, const std::vector<short>& codes, short etype)
+{
+    std::vector<short> resultTypeCodes(codes.size());
+    double table = nanosecondsPerItem(codes.size(), [&]() { return classifyWithTable(codes, etype); });
+    double batch = nanosecondsPerItem(codes.size(), [&]() { return classifyAsBatch(codes, etype, resultTypeCodes); });
+    double branchChain = nanosecondsPerItem(codes.size(), [&]() { return classifyWithBranchChain(codes, etype); });
+    printf("%-12s %10.2f %10.2f %10.2f %8.2fx\n", label, table, batch, branchChain, branchChain / table);
+}
+
+static bool benchmarkDxftype(bool eachCode)
+{
+    for (short etype = ET_NORM; etype <= ET_BLOCK; etype++) {
+        for (int code = dxftypeTable::firstGroupCode - 10; code <= dxftypeTable::lastGroupCode + 10; code++) {
+            int inxdata;
+            if (dxftype((short)code, etype, &inxdata) != dxftypeBranchChain((short)code, etype)) {
+                fprintf(stderr, "dxfbench: dxftype(%d, %d) differs from the branch chain\n", code, (int)etype);
+                return false;
+            }
+        }
+        // the batch form, on every short: the codes past either end of the
+        // table take the branch chain.
+        std::vector<short> allCodes;
+        for (int code = -32768; code <= 32767; code++) {
+            allCodes.push_back((short)code);
+        }
+        std::vector<short> resultTypeCodes(allCodes.size());
+        classifyGroupCodes(allCodes.data(), allCodes.size(), etype, resultTypeCodes.data());
+        for (size_t i = 0; i < allCodes.size(); i++) {
+            if (resultTypeCodes[i] != dxftypeBranchChain(allCodes[i], etype)) {
+                fprintf(stderr, "dxfbench: classifyGroupCodes() gives %d for (%d, %d), the branch chain %d\n",
+                    (int)resultTypeCodes[i], (int)allCodes[i], (int)etype, (int)dxftypeBranchChain(allCodes[i], etype));
+                return false;
+            }
+        }
+    }
+
+    // the ranges that the branch chain tells apart.
+    static const struct { short first, last; } ranges[] = {
+        { -5, -1 }, { 0, 9 }, { 10, 19 }, { 20, 49 }, { 50, 59 }, { 60, 79 }, { 80, 209 },
+        { 210, 239 }, { 240, 998 }, { 999, 999 }, { 1000, 1070 }, { 1071, 1071 },
+    };
+    const size_t runLength = 4096;
+    short etype = ET_NORM;
+    printf("%-12s %10s %10s %10s %9s\n", "codes", "table ns", "batch ns", "chain ns", "speedup");
+    std::vector<short> codes;
+    char label[32];
+    for (const auto& range : ranges) {
+        if (!eachCode) {
+            // the first code of the range stands for all of it.
+            codes.assign(runLength, range.first);
+            snprintf(label, sizeof(label), range.first == range.last ? "%d" : "%d..%d", range.first, range.last);
+            printTimes(label, codes, etype);
+            continue;
+        }
+        for (int code = range.first; code <= range.last; code++) {
+            codes.assign(runLength, (short)code);
+            snprintf(label, sizeof(label), "%d", code);
+            printTimes(label, codes, etype);
+        }
+    }
+
+    codes.clear();
+    for (int i = 0; i < 4; i++) {
+        for (int code = dxftypeTable::firstGroupCode; code <= dxftypeTable::lastGroupCode; code++) {
+            codes.push_back((short)code);
+        }
+    }
+    std::shuffle(codes.begin(), codes.end(), std::mt19937(1));
+    printTimes("mixed", codes, etype);
+    return true;
+}
+
+// Numbers as DXF files write them.
+static std::vector<std::string> makeRealTexts(size_t count)
+{
+    std::mt19937 random(4);
+    std::uniform_real_distribution<double> coordinate(-100000.0, 100000.0);
+    std::vector<std::string> texts;
+    char text[64];
+    for (size_t i = 0; i < count; i++) {
+        double value = coordinate(random);
+        switch (random() % 8) {
+        case 0:
+            snprintf(text, sizeof(text), "%.1E", value); // 1.5E+02
+            break;
+        case 1:
+            snprintf(text, sizeof(text), "%.17g", value); // too long for the fast path
+            break;
+        case 2:
+            snprintf(text, sizeof(text), "%+.*f", (int)(random() % 11), value);
+            break;
+        default:
+            snprintf(text, sizeof(text), "%.*f", (int)(random() % 11), value);
+            break;
+        }
+        texts.push_back(text);
+    }
+    return texts;
+}
+
+static bool benchmarkReals(bool)
+{
+    static const char* const rejected[] = { "+-5", "-+5", "++5", "--5", "+", "-", "- 5", "+-1.5E+02", "+-inf" };
+    for (const char* text : rejected) {
+        double result;
+        if (parseDxfReal(text, result)) {
+            fprintf(stderr, "dxfbench: parseDxfReal(\"%s\") accepted %g\n", text, result);
+            return false;
+        }
+    }
+    std::vector<std::string> texts = makeRealTexts(100000);
+    texts.push_back("+5");
+    texts.push_back(" -0.0 ");
+    for (const std::string& text : texts) {
+        double result = 0.0;
+        double expected = strtod(text.c_str(), NULL);
+        if (!parseDxfReal(text, result)) {
+            fprintf(stderr, "dxfbench: parseDxfReal(\"%s\") failed\n", text.c_str());
+            return false;
+        }
+        if (memcmp(&result, &expected, sizeof(result)) != 0) {
+            fprintf(stderr, "dxfbench: parseDxfReal(\"%s\") is %.17g, strtod() gives %.17g\n", text.c_str(), result, expected);
+            return false;
+        }
+    }
+    texts.resize(texts.size() - 2);
+
+    double parsed = nanosecondsPerItem(texts.size(), [&]() {
+        double sum = 0.0;
+        double result;
+        for (const std::string& text : texts) {
+            sum += parseDxfReal(text, result) ? result : 0.0;
+        }
+        return (long long)sum;
+    });
+    double strtodTime = nanosecondsPerItem(texts.size(), [&]() {
+        double sum = 0.0;
+        for (const std::string& text : texts) {
+            sum += strtod(text.c_str(), NULL);
+        }
+        return (long long)sum;
+    });
+    double fromCharsTime = nanosecondsPerItem(texts.size(), [&]() {
+        double sum = 0.0;
+        double result;
+        for (const std::string& text : texts) {
+            // from_chars does not take the plus sign.
+            const char* p = text.data() + (text[0] == '+');
+            if (std::from_chars(p, text.data() + text.size(), result).ec == std::errc()) {
+                sum += result;
+            }
+        }
+        return (long long)sum;
+    });
+    printf("%-14s %10s %9s\n", "parser", "ns/value", "relative");
+    printf("%-14s %10.1f %8.2fx\n", "parseDxfReal", parsed, 1.0);
+    printf("%-14s %10.1f %8.2fx\n", "strtod", strtodTime, strtodTime / parsed);
+    printf("%-14s %10.1f %8.2fx\n", "from_chars", fromCharsTime, fromCharsTime / parsed);
+    return true;
+}
+
+struct Step {
+    const char* name;
+    bool (*run)(bool eachCode);
+};
+
+static const Step steps[] = {
+    { "dxftype", benchmarkDxftype },
+    { "reals", benchmarkReals },
+};
+
+int main(int argc, char** argv)
+{
+    const char* stepName = NULL;
+    bool eachCode = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--step") == 0 && i + 1 < argc) {
+            stepName = argv[++i];
+        } else if (strcmp(argv[i], "--each-code") == 0) {
+            eachCode = true;
+        } else {
+            fprintf(stderr, "usage: dxfbench [--step dxftype|reals] [--each-code]\n");
+            return 2;
+        }
+    }
+
+    bool found = false;
+    for (const Step& step : steps) {
+        if (stepName != NULL && strcmp(stepName, step.name) != 0) {
+            continue;
+        }
+        found = true;
+        if (!step.run(eachCode)) {
+            return 1;
+        }
+    }
+    if (!found) {
+        fprintf(stderr, "dxfbench: unknown step %s\n", stepName);
+        return 2;
+    }
+    return 0;
+}
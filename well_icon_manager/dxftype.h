@@ -0,0 +1,176 @@
+#pragma once
+
+// Classification of AutoCAD DXF group codes into the resbuf result type
+// codes (RTREAL, RTSTR, ...).  This header depends only on adscodes.h, so it
+// can be used both inside the arx and in headless tools built on Linux.
+
+#include <stddef.h>
+#include <adscodes.h>
+
+
+#define ET_NORM 1 // Normal entity
+#define ET_TBL  2 // Table
+#define ET_VPORT  3 // Table numbers
+#define ET_LTYPE  4
+#define ET_LAYER  5
+#define ET_STYLE  6
+#define ET_VIEW   7
+#define ET_UCS    8
+#define ET_BLOCK  9
+
+// This is the original branch-chain form of dxftype() (see below).  It is
+// kept as the single source of truth: the lookup table that dxftype() uses
+// is generated from it at compile time, and dxftype() falls back to it for
+// group codes outside of the table.
+//
+constexpr short dxftypeBranchChain(short grpcode, short etype)
+{
+    short rbtype = RTNONE;
+    if (grpcode >= 1000) {  // Extended data (XDATA) groups
+        if (grpcode == 1071)
+            rbtype = RTLONG; // Special XDATA case
+        else
+            grpcode %= 1000; // All other XDATA groups match.
+    } // regular DXF code ranges
+    if (grpcode <= 49) {
+        if (grpcode >= 20) // 20 to 49
+            rbtype = RTREAL;
+        else if (grpcode >= 10) { // 10 to 19
+            if (etype == ET_VIEW) // Special table cases
+                rbtype = RTPOINT;
+            else if (etype == ET_VPORT && grpcode <= 15)
+                rbtype = RTPOINT;
+            else // Normal point
+                rbtype = RT3DPOINT; // 10: start point, 11: endpoint
+        }
+        else if (grpcode >= 0) // 0 to 9
+            rbtype = RTSTR; // Group 1004 in XDATA is binary
+        else if (grpcode >= -2)
+            // -1 = start of normal entity -2 = sequence end, etc.
+            rbtype = RTENAME;
+        else if (grpcode == -3)
+            rbtype = RTSHORT; // Extended data (XDATA) sentinel
+    }
+    else {
+        if (grpcode <= 59) // 50 to 59
+            rbtype = RTANG; // double
+        else if (grpcode <= 79) // 60 to 79
+            rbtype = RTSHORT;
+        else if (grpcode < 210)
+            ;
+        else if (grpcode <= 239) // 210 to 239
+            rbtype = RT3DPOINT;
+        else if (grpcode == 999) // Comment
+            rbtype = RTSTR;
+    }
+    return rbtype;
+}
+
+namespace dxftypeTable {
+    // The table covers every group code that can appear in entity data and
+    // XDATA (-5 through 1071).
+    constexpr short firstGroupCode = -5;
+    constexpr short lastGroupCode = 1071;
+    constexpr int groupCodeCount = lastGroupCode - firstGroupCode + 1;
+
+    // Only ET_VPORT and ET_VIEW classify differently from a normal entity, so
+    // every ET_* context maps onto one of three rows.
+    constexpr int rowCount = 3;
+    constexpr unsigned char rowOfEtype[ET_BLOCK + 1] = {
+        0, // (unused)
+        0, // ET_NORM
+        0, // ET_TBL
+        1, // ET_VPORT
+        0, // ET_LTYPE
+        0, // ET_LAYER
+        0, // ET_STYLE
+        2, // ET_VIEW
+        0, // ET_UCS
+        0, // ET_BLOCK
+    };
+    constexpr short etypeOfRow[rowCount] = { ET_NORM, ET_VPORT, ET_VIEW };
+
+    struct Table {
+        short resultTypeCodes[rowCount][groupCodeCount];
+    };
+
+    constexpr Table build() {
+        Table table = {};
+        for (int row = 0; row < rowCount; row++) {
+            for (int i = 0; i < groupCodeCount; i++) {
+                table.resultTypeCodes[row][i] = dxftypeBranchChain((short)(firstGroupCode + i), etypeOfRow[row]);
+            }
+        }
+        return table;
+    }
+
+    inline constexpr Table table = build();
+
+    inline const short* rowFor(short etype) {
+        return table.resultTypeCodes[(etype >= 0 && etype <= ET_BLOCK) ? rowOfEtype[etype] : 0];
+    }
+}
+
+// Get basic C-language type from AutoCAD DXF group code (RTREAL,
+// RTANG are doubles, RTPOINT double[2], RT3DPOINT double[3],
+// RTENAME long[2]). The etype argument is one of the ET_
+// definitions.
+//
+// Returns RTNONE if grpcode isn't one of the known group codes.
+// Also, sets "inxdata" argument to TRUE if DXF group is in XDATA.
+//
+inline short dxftype(short grpcode, short etype, int* inxdata)
+{
+    *inxdata = (grpcode >= 1000);
+    if (grpcode >= dxftypeTable::firstGroupCode && grpcode <= dxftypeTable::lastGroupCode) {
+        return dxftypeTable::rowFor(etype)[grpcode - dxftypeTable::firstGroupCode];
+    }
+    return dxftypeBranchChain(grpcode, etype);
+}
+
+// Classifies count group codes at once, writing the result type code of
+// groupCodes[i] to resultTypeCodes[i].  Equivalent to calling dxftype() on
+// each code, but the table row for etype is looked up only once.
+//
+inline void classifyGroupCodes(const short* groupCodes, size_t count, short etype, short* resultTypeCodes)
+{
+    const short* row = dxftypeTable::rowFor(etype);
+    for (size_t i = 0; i < count; i++) {
+        short grpcode = groupCodes[i];
+        // unsigned compare folds both range checks into one.
+        unsigned short offset = (unsigned short)(grpcode - dxftypeTable::firstGroupCode);
+        resultTypeCodes[i] = offset < dxftypeTable::groupCodeCount
+            ? row[offset]
+            : dxftypeBranchChain(grpcode, etype);
+    }
+}
+
+// Name of a resbuf result type code, e.g. "RTREAL".  Returns NULL for codes
+// that are not one of the RT* constants.
+//
+inline const char* resultTypeCodeName(short resultTypeCode)
+{
+    switch (resultTypeCode) {
+        case RTNONE       : return "RTNONE";
+        case RTREAL       : return "RTREAL";
+        case RTPOINT      : return "RTPOINT";
+        case RTSHORT      : return "RTSHORT";
+        case RTANG        : return "RTANG";
+        case RTSTR        : return "RTSTR";
+        case RTENAME      : return "RTENAME";
+        case RTPICKS      : return "RTPICKS";
+        case RTORINT      : return "RTORINT";
+        case RT3DPOINT    : return "RT3DPOINT";
+        case RTLONG       : return "RTLONG";
+        case RTVOID       : return "RTVOID";
+        case RTLB         : return "RTLB";
+        case RTLE         : return "RTLE";
+        case RTDOTE       : return "RTDOTE";
+        case RTNIL        : return "RTNIL";
+        case RTDXF0       : return "RTDXF0";
+        case RTT          : return "RTT";
+        case RTRESBUF     : return "RTRESBUF";
+        case RTMODELESS   : return "RTMODELESS";
+        default           : return NULL;
+    }
+}
@@ -0,0 +1,160 @@
+#include "dynblock_sweep.h"
+
+
+DynBlockSweep::DynBlockSweep()
+{
+    errorMessage = NULL;
+    evaluations = 0;
+    descriptions = 0;
+    valuesSet = 0;
+    memoized = 0;
+}
+
+size_t DynBlockSweep::addProperty(const std::string& name, const std::vector<std::string>& values)
+{
+    properties.push_back(DynBlockSweepProperty{ name, values });
+    targetValues.push_back(0);
+    outcomeOfCombination.clear();
+    return properties.size() - 1;
+}
+
+void DynBlockSweep::addValue(size_t property, const std::string& value)
+{
+    // combinations are numbered in mixed radix, so a new value changes the
+    // numbers; renumber what is memoized.
+    std::unordered_map<uint64_t, uint32_t> renumbered;
+    renumbered.reserve(outcomeOfCombination.size());
+    for (const auto& memo : outcomeOfCombination) {
+        uint64_t rest = memo.first;
+        uint64_t combination = 0;
+        uint64_t scale = 1;
+        for (size_t p = 0; p < properties.size(); p++) {
+            uint64_t radix = properties[p].values.size();
+            combination += (rest % radix) * scale;
+            rest /= radix;
+            scale *= radix + (p == property ? 1 : 0);
+        }
+        renumbered.emplace(combination, memo.second);
+    }
+    outcomeOfCombination.swap(renumbered);
+    properties[property].values.push_back(value);
+}
+
+uint64_t DynBlockSweep::combinationCount() const
+{
+    uint64_t count = 1;
+    for (const DynBlockSweepProperty& property : properties) {
+        count *= property.values.size();
+        if (count > maxCombinations) {
+            return 0;
+        }
+    }
+    return count;
+}
+
+bool DynBlockSweep::run(DynBlockSweepTarget& target)
+{
+    errorMessage = NULL;
+    uint64_t count = combinationCount();
+    if (count == 0) {
+        errorMessage = "too many combinations";
+        for (const DynBlockSweepProperty& property : properties) {
+            if (property.values.empty()) {
+                errorMessage = "a property has no values";
+            }
+        }
+        return false;
+    }
+
+    size_t propertyCount = properties.size();
+    std::vector<uint32_t> values(propertyCount, 0); // of the combination visited
+    std::vector<int> directions(propertyCount, 1);
+    std::vector<uint64_t> scales(propertyCount);
+    uint64_t scale = 1;
+    for (size_t p = 0; p < propertyCount; p++) {
+        scales[p] = scale;
+        scale *= properties[p].values.size();
+    }
+    uint64_t combination = 0;
+    std::string key;
+    std::string description;
+
+    while (true) {
+        if (outcomeOfCombination.count(combination) != 0) {
+            memoized++;
+        }
+        else {
+            for (size_t p = 0; p < propertyCount; p++) {
+                if (targetValues[p] != values[p]) {
+                    if (!target.setValue(p, values[p])) {
+                        errorMessage = "failed to set a value";
+                        return false;
+                    }
+                    targetValues[p] = values[p];
+                    valuesSet++;
+                }
+            }
+            key.clear();
+            evaluations++;
+            if (!target.evaluate(key)) {
+                errorMessage = "failed to evaluate a combination";
+                return false;
+            }
+            auto knownKey = outcomeOfKey.find(key);
+            uint32_t outcome;
+            if (knownKey != outcomeOfKey.end()) {
+                outcome = knownKey->second;
+            }
+            else {
+                description.clear();
+                descriptions++;
+                if (!target.describeOutcome(description)) {
+                    errorMessage = "failed to describe an outcome";
+                    return false;
+                }
+                auto inserted = outcomeOfDescription.emplace(description, (uint32_t)outcomeDescriptions.size());
+                if (inserted.second) {
+                    outcomeDescriptions.push_back(&inserted.first->first);
+                }
+                outcome = inserted.first->second;
+                outcomeOfKey.emplace(key, outcome);
+            }
+            outcomeOfCombination.emplace(combination, outcome);
+        }
+
+        // the next combination in reflected Gray code order: step the first
+        // property that can move in its direction, and turn around all
+        // properties before it.
+        size_t p = 0;
+        for (; p < propertyCount; p++) {
+            int64_t next = (int64_t)values[p] + directions[p];
+            if (next >= 0 && next < (int64_t)properties[p].values.size()) {
+                break;
+            }
+            directions[p] = -directions[p];
+        }
+        if (p == propertyCount) {
+            return true;
+        }
+        values[p] += directions[p];
+        combination += directions[p] > 0 ? scales[p] : 0 - scales[p];
+    }
+}
+
+uint32_t DynBlockSweep::outcomeOf(const std::vector<uint32_t>& values) const
+{
+    if (values.size() != properties.size()) {
+        return npos;
+    }
+    uint64_t combination = 0;
+    uint64_t scale = 1;
+    for (size_t p = 0; p < properties.size(); p++) {
+        if (values[p] >= properties[p].values.size()) {
+            return npos;
+        }
+        combination += values[p] * scale;
+        scale *= properties[p].values.size();
+    }
+    auto found = outcomeOfCombination.find(combination);
+    return found == outcomeOfCombination.end() ? npos : found->second;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+// Sweeps of the parameters of a dynamic block reference: every combination
+// of the allowed values of its properties (visibility states, lookup and
+// list values, ...) is set and evaluated once, and the resulting geometry
+// ("outcome") recorded, so that e.g. all variants of a well icon can be
+// pre-rendered.
+//
+// The engine is portable; it drives a DynBlockSweepTarget, which does the
+// actual setting and evaluating -- an AcDbDynBlockReference inside AutoCAD
+// (dynblock_sweep_arx.h), or a stand-in elsewhere (dynblock_sweep_standin.h).
+//
+// The combinations are visited in reflected Gray code order, so that
+// consecutive combinations differ in one property, and a value is only set
+// on the target once a combination actually has to be evaluated.
+// Combinations are memoized by their value vector, so repeated sweeps (e.g.
+// after adding a value) only evaluate what is new.  Outcomes are shared:
+// combinations whose evaluation yields an outcome key seen before (the same
+// anonymous block) reuse that outcome without describing it again, and
+// different keys whose descriptions are identical get the same outcome
+// index.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class DynBlockSweepTarget {
+    public:
+        virtual ~DynBlockSweepTarget() {}
+
+        // Sets a property to its value-th allowed value (in the order given
+        // to DynBlockSweep::addProperty()).
+        virtual bool setValue(size_t property, uint32_t value) = 0;
+        // Evaluates the current values; key identifies the result cheaply
+        // (e.g. the handle of the anonymous block that draws it).
+        virtual bool evaluate(std::string& key) = 0;
+        // Describes the result of the last evaluate() canonically (e.g. the
+        // encoded data of its entities); only called for keys not seen
+        // before.
+        virtual bool describeOutcome(std::string& description) = 0;
+};
+
+struct DynBlockSweepProperty {
+    std::string name;
+    std::vector<std::string> values; // labels of the allowed values
+};
+
+class DynBlockSweep {
+    private:
+        std::vector<DynBlockSweepProperty> properties;
+        std::unordered_map<std::string, uint32_t> outcomeOfKey;
+        std::unordered_map<std::string, uint32_t> outcomeOfDescription;
+        std::vector<const std::string*> outcomeDescriptions; // keys of outcomeOfDescription
+        std::unordered_map<uint64_t, uint32_t> outcomeOfCombination;
+        std::vector<uint32_t> targetValues; // the value indexes last set on the target
+        const char* errorMessage;
+
+    public:
+        static const uint32_t npos = 0xFFFFFFFF;
+
+        // Sweeps beyond this many combinations are refused.
+        static const uint64_t maxCombinations = 1ull << 32;
+
+        // Counters, over all run()s.
+        size_t evaluations;     // target.evaluate() calls
+        size_t descriptions;    // target.describeOutcome() calls
+        size_t valuesSet;       // target.setValue() calls
+        size_t memoized;        // combinations skipped because they were evaluated before
+
+        DynBlockSweep();
+
+        // Returns the index of the property.  Adding properties discards
+        // everything memoized.
+        size_t addProperty(const std::string& name, const std::vector<std::string>& values);
+        // Adds a value to a property, keeping what is memoized.
+        void addValue(size_t property, const std::string& value);
+        const std::vector<DynBlockSweepProperty>& sweptProperties() const { return properties; }
+
+        // 0 if there are more than maxCombinations.
+        uint64_t combinationCount() const;
+
+        // Evaluates every combination not evaluated before.  The sweep
+        // assumes it is the only one setting values on the target, and that
+        // they are the first of every property before its first run().
+        // Returns false if the sweep is too large or the target fails; the
+        // combinations evaluated until then are kept.
+        bool run(DynBlockSweepTarget& target);
+        const char* error() const { return errorMessage; }
+
+        // The outcome of a combination of value indexes (one per property),
+        // or npos if it has not been evaluated.
+        uint32_t outcomeOf(const std::vector<uint32_t>& values) const;
+        size_t outcomeCount() const { return outcomeDescriptions.size(); }
+        const std::string& outcomeDescription(uint32_t outcome) const { return *outcomeDescriptions[outcome]; }
+};
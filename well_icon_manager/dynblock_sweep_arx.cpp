@@ -0,0 +1,197 @@
+#include "dynblock_sweep_arx.h"
+#include <tchar.h>
+#include <adslib.h>
+#include <aced.h>
+#include <dbents.h>
+#include <dbmain.h>
+#include <dbsymtb.h>
+#include "class_ancestry_arx.h"
+#include "handle_index_arx.h"
+#include "resbuf_snapshot.h"
+
+
+std::string encodeEvalVariant(const AcDbEvalVariant& value)
+{
+    resbuf single = value;
+    single.rbnext = NULL;
+    std::string encoded;
+    encodeResbufChain(&single, false, encoded);
+    return encoded;
+}
+
+bool encodeBlockContents(AcDbObjectId blockId, std::string& out)
+{
+    AcDbBlockTableRecord* blockP;
+    if (acdbOpenObject(blockP, blockId, AcDb::kForRead) != Acad::eOk) {
+        return false;
+    }
+    AcDbBlockTableRecordIterator* iteratorP;
+    if (blockP->newIterator(iteratorP) != Acad::eOk) {
+        blockP->close();
+        return false;
+    }
+    for (; !iteratorP->done(); iteratorP->step()) {
+        AcDbObjectId entityId;
+        ads_name eName;
+        if (iteratorP->getEntityId(entityId) != Acad::eOk || acdbGetAdsName(eName, entityId) != Acad::eOk) {
+            continue;
+        }
+        resbuf* pData = acdbEntGet(eName);
+        // the handle differs between otherwise identical anonymous blocks.
+        resbuf** ppLink = &pData;
+        while (*ppLink != NULL) {
+            if ((*ppLink)->restype == 5) {
+                resbuf* pHandle = *ppLink;
+                *ppLink = pHandle->rbnext;
+                pHandle->rbnext = NULL;
+                acutRelRb(pHandle);
+                break;
+            }
+            ppLink = &(*ppLink)->rbnext;
+        }
+        encodeResbufChain(pData, false, out);
+        acutRelRb(pData);
+    }
+    delete iteratorP;
+    blockP->close();
+    return true;
+}
+
+
+DynBlockReferenceTarget::DynBlockReferenceTarget(AcDbObjectId blockReferenceId)
+    : reference(blockReferenceId)
+{
+}
+
+void DynBlockReferenceTarget::addPropertiesTo(DynBlockSweep& sweep)
+{
+    AcDbDynBlockReferencePropertyArray allProperties;
+    reference.getBlockProperties(allProperties);
+    for (int i = 0; i < allProperties.length(); i++) {
+        AcDbDynBlockReferenceProperty& property = allProperties.at(i);
+        AcDbEvalVariantArray values;
+        if (property.readOnly() || property.getAllowedValues(values) != Acad::eOk || values.isEmpty()) {
+            continue;
+        }
+        // the current value goes first.
+        AcDbEvalVariant current = property.value();
+        for (int k = 0; k < values.length(); k++) {
+            if (values.at(k) == current) {
+                values.removeAt(k);
+                break;
+            }
+        }
+        values.insertAt(0, current);
+
+        std::vector<std::string> labels(values.length());
+        for (int k = 0; k < values.length(); k++) {
+            labels[k] = encodeEvalVariant(values.at(k));
+        }
+        properties.append(property);
+        allowedValues.push_back(values);
+        sweep.addProperty(acharToUtf8(property.propertyName().kwszPtr()), labels);
+    }
+}
+
+bool DynBlockReferenceTarget::setValue(size_t property, uint32_t value)
+{
+    return properties.at((int)property).setValue(allowedValues[property].at((int)value)) == Acad::eOk;
+}
+
+bool DynBlockReferenceTarget::restoreValues()
+{
+    bool restored = true;
+    for (int i = 0; i < properties.length(); i++) {
+        restored = properties.at(i).setValue(allowedValues[i].at(0)) == Acad::eOk && restored;
+    }
+    return restored;
+}
+
+bool DynBlockReferenceTarget::evaluate(std::string& key)
+{
+    AcDbObjectId anonymousBlockId = reference.anonymousBlockTableRecord();
+    if (anonymousBlockId.isNull()) {
+        key.clear();
+        return true;
+    }
+    char text[handleTextSize];
+    key.assign(text, formatHandle(handleOf(anonymousBlockId), text));
+    return true;
+}
+
+bool DynBlockReferenceTarget::describeOutcome(std::string& description)
+{
+    AcDbObjectId blockId = reference.anonymousBlockTableRecord();
+    if (blockId.isNull()) {
+        blockId = reference.dynamicBlockTableRecord();
+    }
+    return encodeBlockContents(blockId, description);
+}
+
+
+// Sweeps of more combinations than this are refused: each one is an
+// evaluation of the block, and an anonymous block if it is new.
+static const uint64_t maxInteractiveCombinations = 10000;
+
+void sweepWellIcon()
+{
+    ads_name name;
+    ads_point point;
+    if (acedEntSel(_T("\nSelect a dynamic block reference: "), name, point) != RTNORM) {
+        return;
+    }
+    AcDbObjectId referenceId;
+    if (acdbGetObjectId(referenceId, name) != Acad::eOk
+        || !sessionClassAncestry().isKindOf(referenceId.objectClass(), AcDbBlockReference::desc())
+        || !AcDbDynBlockReference(referenceId).isDynamicBlock()) {
+        acutPrintf(_T("\nThe selected entity is not a dynamic block reference.\n"));
+        return;
+    }
+
+    DynBlockReferenceTarget target(referenceId);
+    DynBlockSweep sweep;
+    target.addPropertiesTo(sweep);
+    const std::vector<DynBlockSweepProperty>& properties = sweep.sweptProperties();
+    if (properties.empty()) {
+        acutPrintf(_T("\nThe reference has no writable property with a list of values.\n"));
+        return;
+    }
+    uint64_t combinationCount = sweep.combinationCount();
+    if (combinationCount == 0 || combinationCount > maxInteractiveCombinations) {
+        acutPrintf(_T("\nThe %d properties have too many combinations to sweep.\n"), (int)properties.size());
+        return;
+    }
+
+    bool swept = sweep.run(target);
+    bool restored = target.restoreValues();
+    if (!swept) {
+        acutPrintf(_T("\nThe sweep failed: %hs.\n"), sweep.error());
+    }
+    for (size_t p = 0; p < properties.size(); p++) {
+        acutPrintf(_T("\n%s: %d values"), target.propertyName(p).kwszPtr(), (int)properties[p].values.size());
+    }
+
+    // the number of combinations of each outcome, in mixed-radix order.
+    std::vector<size_t> combinationsOfOutcome(sweep.outcomeCount(), 0);
+    std::vector<uint32_t> values(properties.size(), 0);
+    for (uint64_t combination = 0; combination < combinationCount; combination++) {
+        uint64_t rest = combination;
+        for (size_t p = 0; p < properties.size(); p++) {
+            values[p] = (uint32_t)(rest % properties[p].values.size());
+            rest /= properties[p].values.size();
+        }
+        uint32_t outcome = sweep.outcomeOf(values);
+        if (outcome != DynBlockSweep::npos) {
+            combinationsOfOutcome[outcome]++;
+        }
+    }
+    acutPrintf(_T("\n%d combinations, %d evaluated, %d anonymous blocks described, %d distinct outcomes.\n"),
+        (int)combinationCount, (int)sweep.evaluations, (int)sweep.descriptions, (int)sweep.outcomeCount());
+    for (size_t outcome = 0; outcome < combinationsOfOutcome.size() && outcome < 50; outcome++) {
+        acutPrintf(_T("\toutcome %d: %d combinations, %d bytes of entity data\n"),
+            (int)outcome, (int)combinationsOfOutcome[outcome], (int)sweep.outcomeDescription((uint32_t)outcome).size());
+    }
+    if (!restored) {
+        acutPrintf(_T("Unable to restore the property values of the reference.\n"));
+    }
+}
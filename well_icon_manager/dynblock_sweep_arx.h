@@ -0,0 +1,51 @@
+#pragma once
+
+// DynBlockSweep (see dynblock_sweep.h) over the properties of an
+// AcDbDynBlockReference, and the WELLSWEEP command, which runs one on a
+// selected reference.  Only available inside AutoCAD.
+
+#include <vector>
+#include <dbdynblk.h>
+#include <dbeval.h>
+#include "dynblock_sweep.h"
+
+// The canonical encoding of a property value: as a single resbuf, with
+// encodeResbufChain().
+std::string encodeEvalVariant(const AcDbEvalVariant& value);
+
+// Appends the acdbEntGet() data of the entities of a block, without entity
+// names and handles, so that blocks with the same contents encode the same.
+bool encodeBlockContents(AcDbObjectId blockId, std::string& out);
+
+class DynBlockReferenceTarget : public DynBlockSweepTarget {
+    private:
+        AcDbDynBlockReference reference;
+        AcDbDynBlockReferencePropertyArray properties; // the swept ones
+        std::vector<AcDbEvalVariantArray> allowedValues;
+
+    public:
+        explicit DynBlockReferenceTarget(AcDbObjectId blockReferenceId);
+
+        // Adds every writable property of the reference that has a list of
+        // allowed values to sweep, each with its current value first, so
+        // that the reference already is at the sweep's first combination.
+        // Properties with a continuous range (e.g. most stretch distances)
+        // are left at their current values.
+        void addPropertiesTo(DynBlockSweep& sweep);
+        // Sets the swept properties back to the values they had when they
+        // were added.
+        bool restoreValues();
+        AcString propertyName(size_t property) const { return properties.at((int)property).propertyName(); }
+
+        bool setValue(size_t property, uint32_t value) override;
+        // The key is the handle of the anonymous block that draws the
+        // reference, or "" if it is drawn by the dynamic block itself.
+        bool evaluate(std::string& key) override;
+        // The contents of that block, see encodeBlockContents().
+        bool describeOutcome(std::string& description) override;
+};
+
+// The WELLSWEEP command: sweeps every combination of the listed property
+// values of a selected dynamic block reference, reports how many distinct
+// outcomes (anonymous block contents) they have, and restores the values.
+void sweepWellIcon();
@@ -0,0 +1,39 @@
+#include "dynblock_sweep_standin.h"
+
+
+StandInDynBlockTarget::StandInDynBlockTarget(size_t propertyCount, StandInDynBlockGeometry geometryOf, bool shareAnonymousBlocks)
+    : values(propertyCount, 0), geometryOf(geometryOf)
+{
+    this->shareAnonymousBlocks = shareAnonymousBlocks;
+    anonymousBlockCount = 0;
+}
+
+bool StandInDynBlockTarget::setValue(size_t property, uint32_t value)
+{
+    if (property >= values.size()) {
+        return false;
+    }
+    values[property] = value;
+    return true;
+}
+
+bool StandInDynBlockTarget::evaluate(std::string& key)
+{
+    geometry = geometryOf(values);
+    if (shareAnonymousBlocks) {
+        auto found = anonymousBlockOfGeometry.find(geometry);
+        if (found != anonymousBlockOfGeometry.end()) {
+            key = found->second;
+            return true;
+        }
+    }
+    key = "*U" + std::to_string(++anonymousBlockCount);
+    anonymousBlockOfGeometry[geometry] = key;
+    return true;
+}
+
+bool StandInDynBlockTarget::describeOutcome(std::string& description)
+{
+    description = geometry;
+    return true;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+// A stand-in dynamic block reference for DynBlockSweep (see
+// dynblock_sweep.h), for running sweeps outside of AutoCAD.
+//
+// The geometry of a combination of values comes from a caller-supplied
+// function.  Like AutoCAD, the stand-in draws every evaluated combination
+// with an anonymous block, which it reuses for geometry it has drawn before
+// only if shareAnonymousBlocks is set.
+
+#include <functional>
+#include <map>
+#include "dynblock_sweep.h"
+
+typedef std::function<std::string(const std::vector<uint32_t>& values)> StandInDynBlockGeometry;
+
+class StandInDynBlockTarget : public DynBlockSweepTarget {
+    private:
+        std::vector<uint32_t> values;
+        StandInDynBlockGeometry geometryOf;
+        bool shareAnonymousBlocks;
+        std::map<std::string, std::string> anonymousBlockOfGeometry;
+        unsigned anonymousBlockCount;
+        std::string geometry; // of the last evaluate()
+
+    public:
+        StandInDynBlockTarget(size_t propertyCount, StandInDynBlockGeometry geometryOf, bool shareAnonymousBlocks);
+
+        const std::vector<uint32_t>& currentValues() const { return values; }
+        unsigned anonymousBlocksCreated() const { return anonymousBlockCount; }
+
+        bool setValue(size_t property, uint32_t value) override;
+        bool evaluate(std::string& key) override;
+        bool describeOutcome(std::string& description) override;
+};
@@ -0,0 +1,130 @@
+#include "eval_graph.h"
+#include <algorithm>
+
+
+// Out-degrees up to this are sorted by insertion.
+static const size_t insertionSortLimit = 32;
+
+void mergeDuplicateEdges(std::vector<EvalEdgeInfo>& edges, size_t first)
+{
+    // the out-degree of most nodes is small, where an insertion sort beats
+    // std::sort; a hub node with thousands of edges must not be quadratic.
+    if (edges.size() - first > insertionSortLimit) {
+        std::sort(edges.begin() + first, edges.end(), [](const EvalEdgeInfo& edge, const EvalEdgeInfo& other) { return edge.to < other.to; });
+    }
+    else {
+        for (size_t i = first + 1; i < edges.size(); i++) {
+            EvalEdgeInfo edge = edges[i];
+            size_t j = i;
+            for (; j > first && edges[j - 1].to > edge.to; j--) {
+                edges[j] = edges[j - 1];
+            }
+            edges[j] = edge;
+        }
+    }
+    size_t kept = first;
+    for (size_t i = first; i < edges.size(); i++) {
+        if (kept > first && edges[kept - 1].to == edges[i].to) {
+            edges[kept - 1].flags |= edges[i].flags;
+        }
+        else {
+            edges[kept++] = edges[i];
+        }
+    }
+    edges.resize(kept);
+}
+
+
+uint32_t EvalGraph::indexOf(EvalNodeId id) const
+{
+    auto found = std::lower_bound(nodes.begin(), nodes.end(), id, [](const EvalGraphNode& node, EvalNodeId id) { return node.id < id; });
+    return (found != nodes.end() && found->id == id) ? (uint32_t)(found - nodes.begin()) : npos;
+}
+
+
+EvalGraphBuilder::EvalGraphBuilder()
+{
+    errorMessage = NULL;
+}
+
+EvalGraphNode& EvalGraphBuilder::addNode(EvalNodeId id)
+{
+    nodes.emplace_back();
+    nodes.back().id = id;
+    return nodes.back();
+}
+
+void EvalGraphBuilder::addEdge(EvalNodeId from, EvalNodeId to, uint8_t flags)
+{
+    pendingEdges.push_back(EvalEdgeInfo{ from, to, flags });
+}
+
+void EvalGraphBuilder::addEdges(const std::vector<EvalEdgeInfo>& edges)
+{
+    pendingEdges.insert(pendingEdges.end(), edges.begin(), edges.end());
+}
+
+bool EvalGraphBuilder::build(EvalGraph& graph)
+{
+    graph = EvalGraph();
+    errorMessage = NULL;
+    std::sort(nodes.begin(), nodes.end(), [](const EvalGraphNode& a, const EvalGraphNode& b) { return a.id < b.id; });
+    for (size_t i = 1; i < nodes.size(); i++) {
+        if (nodes[i].id == nodes[i - 1].id) {
+            errorMessage = "a node id occurs twice";
+        }
+    }
+    graph.nodes.swap(nodes);
+    nodes.clear();
+
+    uint32_t nodeCount = graph.nodeCount();
+    graph.edges.reserve(pendingEdges.size());
+    for (const EvalEdgeInfo& pending : pendingEdges) {
+        uint32_t from = graph.indexOf(pending.from);
+        uint32_t to = graph.indexOf(pending.to);
+        if (from == EvalGraph::npos || to == EvalGraph::npos) {
+            errorMessage = "an edge refers to a node that is not in the graph";
+            break;
+        }
+        graph.edges.push_back(EvalGraphEdge{ from, to, pending.flags });
+    }
+    pendingEdges.clear();
+    if (errorMessage != NULL) {
+        graph = EvalGraph();
+        return false;
+    }
+
+    // outgoing: the edges themselves, sorted by source, without duplicates.
+    std::sort(graph.edges.begin(), graph.edges.end(), [](const EvalGraphEdge& a, const EvalGraphEdge& b) {
+        return a.from != b.from ? a.from < b.from : a.to < b.to;
+    });
+    size_t kept = 0;
+    for (size_t i = 0; i < graph.edges.size(); i++) {
+        if (kept > 0 && graph.edges[kept - 1].from == graph.edges[i].from && graph.edges[kept - 1].to == graph.edges[i].to) {
+            graph.edges[kept - 1].flags |= graph.edges[i].flags;
+        }
+        else {
+            graph.edges[kept++] = graph.edges[i];
+        }
+    }
+    graph.edges.resize(kept);
+    graph.outgoingOffsets.assign(nodeCount + 1, 0);
+    graph.incomingOffsets.assign(nodeCount + 1, 0);
+    for (const EvalGraphEdge& edge : graph.edges) {
+        graph.outgoingOffsets[edge.from + 1]++;
+        graph.incomingOffsets[edge.to + 1]++;
+    }
+    for (uint32_t i = 0; i < nodeCount; i++) {
+        graph.outgoingOffsets[i + 1] += graph.outgoingOffsets[i];
+        graph.incomingOffsets[i + 1] += graph.incomingOffsets[i];
+    }
+
+    // incoming: a counting sort of the edge indexes by destination, which
+    // keeps them ordered by source within each destination.
+    graph.incomingEdges.resize(graph.edges.size());
+    std::vector<uint32_t> filled(graph.incomingOffsets.begin(), graph.incomingOffsets.end() - 1);
+    for (uint32_t e = 0; e < graph.edgeCount(); e++) {
+        graph.incomingEdges[filled[graph.edges[e].to]++] = e;
+    }
+    return true;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+// Portable in-memory model of an AcDbEvalGraph (the parameter/action graph
+// of a dynamic block).
+//
+// The graph is extracted once (see eval_graph_arx.h, and
+// eval_graph_standin.h for builds outside of AutoCAD), after which every
+// analysis runs on this model without going back to the database.  Nodes
+// are numbered densely by ascending node id; the edges are kept in
+// compressed sparse row form, both by source (outgoing) and by destination
+// (incoming).
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+typedef uint32_t EvalNodeId; // AcDbEvalNodeId
+
+const uint8_t kEvalEdgeInvertible = 1;
+const uint8_t kEvalEdgeSuppressed = 2;
+
+struct EvalGraphNode {
+    EvalNodeId id;
+    std::string className; // of the node's AcDbEvalExpr, e.g. "AcDbBlockVisibilityParameter"
+    std::string handle;    // hexadecimal
+    std::string ancestry;  // the class names from className up to AcRxObject, separated by ", "
+    std::string data;      // the node's acdbEntGet() data, see encodeResbufChain()
+};
+
+struct EvalGraphEdge {
+    uint32_t from; // node indexes
+    uint32_t to;
+    uint8_t flags; // kEvalEdge*
+
+    bool isInvertible() const { return (flags & kEvalEdgeInvertible) != 0; }
+    bool isSuppressed() const { return (flags & kEvalEdgeSuppressed) != 0; }
+};
+
+// An edge as the eval graph itself reports it, by node ids.
+struct EvalEdgeInfo {
+    EvalNodeId from;
+    EvalNodeId to;
+    uint8_t flags; // kEvalEdge*
+};
+
+// Merges the duplicates among edges[first ..], which all have the same
+// source: each (from, to) pair is kept once, with the flags of its
+// duplicates or-ed together, ordered by destination.
+void mergeDuplicateEdges(std::vector<EvalEdgeInfo>& edges, size_t first);
+
+class EvalGraph {
+    private:
+        std::vector<EvalGraphNode> nodes;      // by ascending id
+        std::vector<EvalGraphEdge> edges;      // by from, then to
+        std::vector<uint32_t> outgoingOffsets; // the outgoing edges of node i are edges[outgoingOffsets[i] .. outgoingOffsets[i + 1])
+        std::vector<uint32_t> incomingOffsets;
+        std::vector<uint32_t> incomingEdges;   // edge indexes, by to, then from
+
+        friend class EvalGraphBuilder;
+        friend class EvalGraphFileView; // see eval_graph_file.h
+
+    public:
+        static constexpr uint32_t npos = 0xFFFFFFFF;
+
+        uint32_t nodeCount() const { return (uint32_t)nodes.size(); }
+        uint32_t edgeCount() const { return (uint32_t)edges.size(); }
+        const EvalGraphNode& node(uint32_t index) const { return nodes[index]; }
+        const EvalGraphEdge& edge(uint32_t index) const { return edges[index]; }
+
+        // Index of the node with the given id, or npos.
+        uint32_t indexOf(EvalNodeId id) const;
+
+        // Edge indexes of the outgoing edges of a node.
+        uint32_t outgoingBegin(uint32_t node) const { return outgoingOffsets[node]; }
+        uint32_t outgoingEnd(uint32_t node) const { return outgoingOffsets[node + 1]; }
+        uint32_t outDegree(uint32_t node) const { return outgoingEnd(node) - outgoingBegin(node); }
+
+        // The incoming edges of a node are incomingEdge(p) for p in
+        // [incomingBegin(node), incomingEnd(node)).
+        uint32_t incomingBegin(uint32_t node) const { return incomingOffsets[node]; }
+        uint32_t incomingEnd(uint32_t node) const { return incomingOffsets[node + 1]; }
+        uint32_t incomingEdge(uint32_t position) const { return incomingEdges[position]; }
+        uint32_t inDegree(uint32_t node) const { return incomingEnd(node) - incomingBegin(node); }
+};
+
+// Collects nodes and edges, in any order, and lays them out as an EvalGraph.
+class EvalGraphBuilder {
+    private:
+        std::vector<EvalGraphNode> nodes;
+        std::vector<EvalEdgeInfo> pendingEdges;
+        const char* errorMessage;
+
+    public:
+        EvalGraphBuilder();
+
+        // Adds a node; the returned record (valid until the next addNode())
+        // is to be filled in by the caller.
+        EvalGraphNode& addNode(EvalNodeId id);
+        void addEdge(EvalNodeId from, EvalNodeId to, uint8_t flags);
+        void addEdges(const std::vector<EvalEdgeInfo>& edges);
+
+        // Moves everything added so far into graph, leaving the builder
+        // empty.  Duplicate edges are merged as by mergeDuplicateEdges().
+        // Returns false (and leaves graph empty) if a node id was added
+        // twice or an edge refers to a node that was not added.
+        bool build(EvalGraph& graph);
+        const char* error() const { return errorMessage; }
+};
@@ -0,0 +1,130 @@
+#include "eval_graph_arx.h"
+#include <tchar.h>
+#include <adslib.h>
+#include <dbdict.h>
+#include <dbmain.h>
+#include <dbsymtb.h>
+#include "class_ancestry_arx.h"
+#include "handle_index_arx.h"
+#include "resbuf_snapshot.h"
+
+
+AcDbObject* EvalGraphNodeHost::open(EvalNodeId nodeId, bool& opened)
+{
+    AcDbObject* nodeP = NULL;
+    opened = evalGraphP->getNode(nodeId, AcDb::kForRead, &nodeP) == Acad::eOk;
+    return opened ? nodeP : NULL;
+}
+
+
+// getOutgoingEdges() allocates the infos it appends; the caller owns them.
+static void deleteEdgeInfos(AcDbEvalEdgeInfoArray& edgeInfos)
+{
+    for (int k = 0; k < edgeInfos.length(); k++) {
+        delete edgeInfos.at(k);
+    }
+    edgeInfos.setLogicalLength(0);
+}
+
+bool collectEvalGraphEdges(AcDbEvalGraph* evalGraphP, const AcDbEvalNodeIdArray& nodeIds, EvalNodeCache& nodeCache, std::vector<EvalEdgeInfo>& edges)
+{
+    AcDbEvalEdgeInfoArray nodeEdges; // reused: getOutgoingEdges() appends to it.
+    for (int i = 0; i < nodeIds.length(); i++) {
+        AcDbEvalNodeId nodeId = nodeIds.at(i);
+        if (nodeCache.open(nodeId) == NULL) {
+            return false;
+        }
+        bool collected = evalGraphP->getOutgoingEdges(nodeId, nodeEdges) == Acad::eOk;
+        size_t first = edges.size();
+        for (int k = 0; collected && k < nodeEdges.length(); k++) {
+            const AcDbEvalEdgeInfo* edgeP = nodeEdges.at(k);
+            if (nodeCache.open(edgeP->to()) == NULL) {
+                collected = false;
+                continue;
+            }
+            edges.push_back(EvalEdgeInfo{ edgeP->from(), edgeP->to(),
+                (uint8_t)((edgeP->isInvertible() ? kEvalEdgeInvertible : 0) | (edgeP->isSuppressed() ? kEvalEdgeSuppressed : 0)) });
+        }
+        deleteEdgeInfos(nodeEdges);
+        if (!collected) {
+            return false;
+        }
+        mergeDuplicateEdges(edges, first);
+    }
+    return true;
+}
+
+bool collectEvalGraphEdges(AcDbEvalGraph* evalGraphP, std::vector<EvalEdgeInfo>& edges)
+{
+    AcDbEvalNodeIdArray nodeIds;
+    if (evalGraphP->getAllNodes(nodeIds) != Acad::eOk) {
+        return false;
+    }
+    EvalNodeCache nodeCache(evalGraphP);
+    return collectEvalGraphEdges(evalGraphP, nodeIds, nodeCache, edges);
+}
+
+
+bool extractEvalGraph(AcDbEvalGraph* evalGraphP, EvalGraph& graph)
+{
+    graph = EvalGraph();
+    AcDbEvalNodeIdArray nodeIds;
+    if (evalGraphP->getAllNodes(nodeIds) != Acad::eOk) {
+        return false;
+    }
+
+    EvalNodeCache nodeCache(evalGraphP);
+    EvalGraphBuilder builder;
+    for (int i = 0; i < nodeIds.length(); i++) {
+        AcDbEvalNodeId nodeId = nodeIds.at(i);
+        AcDbObject* nodeP = nodeCache.open(nodeId);
+        if (nodeP == NULL) {
+            return false;
+        }
+        EvalGraphNode& node = builder.addNode(nodeId);
+        // the names are worked out once per class, not once per node.
+        node.className = sessionClassAncestry().name(nodeP->isA());
+        node.ancestry = sessionClassAncestry().ancestry(nodeP->isA());
+        char handleText[handleTextSize];
+        node.handle.assign(handleText, formatHandle(handleOf(nodeP->objectId()), handleText));
+
+        ads_name eNameOfTheNode;
+        acdbGetAdsName(eNameOfTheNode, nodeP->objectId());
+        resbuf* pNodeData = acdbEntGet(eNameOfTheNode);
+        encodeResbufChain(pNodeData, true, node.data);
+        acutRelRb(pNodeData);
+    }
+
+    std::vector<EvalEdgeInfo> edges;
+    if (!collectEvalGraphEdges(evalGraphP, nodeIds, nodeCache, edges)) {
+        return false;
+    }
+    builder.addEdges(edges);
+    return builder.build(graph);
+}
+
+bool extractBlockEvalGraph(AcDbObjectId blockTableRecordId, EvalGraph& graph)
+{
+    graph = EvalGraph();
+    AcDbBlockTableRecord* pBlockTableRecord;
+    if (acdbOpenObject(pBlockTableRecord, blockTableRecordId, AcDb::kForRead) != Acad::eOk) {
+        return false;
+    }
+    AcDbObjectId extensionDictionaryId = pBlockTableRecord->extensionDictionary();
+    pBlockTableRecord->close();
+
+    AcDbDictionary* pExtensionDictionary;
+    if (extensionDictionaryId.isNull() || acdbOpenObject(pExtensionDictionary, extensionDictionaryId, AcDb::kForRead) != Acad::eOk) {
+        return false;
+    }
+    AcDbObjectId evalGraphId;
+    Acad::ErrorStatus errorStatus = pExtensionDictionary->getAt(_T("ACAD_ENHANCEDBLOCK"), evalGraphId);
+    pExtensionDictionary->close();
+    AcDbObject* pObject;
+    if (errorStatus != Acad::eOk || acdbOpenObject(pObject, evalGraphId, AcDb::kForRead) != Acad::eOk) {
+        return false;
+    }
+    bool extracted = sessionClassAncestry().isKindOf(pObject, AcDbEvalGraph::desc()) && extractEvalGraph((AcDbEvalGraph*)pObject, graph);
+    pObject->close();
+    return extracted;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+// Extraction of the EvalGraph model (see eval_graph.h) from an AcDbEvalGraph.
+// Only available inside AutoCAD; see eval_graph_standin.h elsewhere.
+
+#include <vector>
+#include <dbeval.h>
+#include "eval_graph.h"
+#include "open_object_cache.h"
+
+// Opens the nodes of one eval graph through AcDbEvalGraph::getNode().
+class EvalGraphNodeHost {
+    private:
+        AcDbEvalGraph* evalGraphP;
+
+    public:
+        typedef EvalNodeId Id;
+        typedef EvalNodeId Key;
+        typedef AcDbObject Object;
+
+        explicit EvalGraphNodeHost(AcDbEvalGraph* evalGraphP) : evalGraphP(evalGraphP) {}
+
+        Key keyOf(EvalNodeId nodeId) const { return nodeId; }
+        AcDbObject* open(EvalNodeId nodeId, bool& opened);
+        void close(AcDbObject* nodeP) { nodeP->close(); }
+};
+
+// Opens the nodes of one eval graph for read, each at most once; they stay
+// open until the cache is destroyed (see open_object_cache.h).
+class EvalNodeCache : public OpenObjectCache<EvalGraphNodeHost> {
+    public:
+        explicit EvalNodeCache(AcDbEvalGraph* evalGraphP) : OpenObjectCache<EvalGraphNodeHost>(EvalGraphNodeHost(evalGraphP)) {}
+};
+
+// Appends every edge of the graph to edges, in one pass over the nodes:
+// grouped by source in the order of nodeIds, duplicates merged (see
+// mergeDuplicateEdges()).  The endpoints are opened through nodeCache, so
+// that each node is opened at most once however many edges it has.  Returns
+// false if an endpoint cannot be opened.
+bool collectEvalGraphEdges(AcDbEvalGraph* evalGraphP, const AcDbEvalNodeIdArray& nodeIds, EvalNodeCache& nodeCache, std::vector<EvalEdgeInfo>& edges);
+bool collectEvalGraphEdges(AcDbEvalGraph* evalGraphP, std::vector<EvalEdgeInfo>& edges);
+
+// Reads all nodes and edges of evalGraphP, opening each node once for read.
+// Returns false if the nodes cannot be listed or opened, or the graph is
+// inconsistent; graph is then empty.
+bool extractEvalGraph(AcDbEvalGraph* evalGraphP, EvalGraph& graph);
+// As above, for the eval graph of a dynamic block definition (the
+// ACAD_ENHANCEDBLOCK entry of its extension dictionary).  False if the
+// block has none.
+bool extractBlockEvalGraph(AcDbObjectId blockTableRecordId, EvalGraph& graph);
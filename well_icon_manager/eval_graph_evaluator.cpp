@@ -0,0 +1,173 @@
+#include "eval_graph_evaluator.h"
+#include <algorithm>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static unsigned lowestSetBit(uint32_t bits)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return (unsigned)index;
+#else
+    return (unsigned)__builtin_ctz(bits);
+#endif
+}
+
+
+std::vector<uint32_t> topologicalOrder(const EvalGraph& graph)
+{
+    uint32_t nodeCount = graph.nodeCount();
+    std::vector<uint32_t> pendingInputs(nodeCount, 0);
+    for (uint32_t e = 0; e < graph.edgeCount(); e++) {
+        if (!graph.edge(e).isSuppressed()) {
+            pendingInputs[graph.edge(e).to]++;
+        }
+    }
+
+    // a min-heap of the ready nodes, so that the order does not depend on
+    // anything but the graph.
+    std::vector<uint32_t> ready;
+    for (uint32_t v = 0; v < nodeCount; v++) {
+        if (pendingInputs[v] == 0) {
+            ready.push_back(v);
+        }
+    }
+    std::make_heap(ready.begin(), ready.end(), std::greater<uint32_t>());
+
+    std::vector<uint32_t> order;
+    order.reserve(nodeCount);
+    while (!ready.empty()) {
+        std::pop_heap(ready.begin(), ready.end(), std::greater<uint32_t>());
+        uint32_t v = ready.back();
+        ready.pop_back();
+        order.push_back(v);
+        for (uint32_t e = graph.outgoingBegin(v); e < graph.outgoingEnd(v); e++) {
+            const EvalGraphEdge& edge = graph.edge(e);
+            if (!edge.isSuppressed() && --pendingInputs[edge.to] == 0) {
+                ready.push_back(edge.to);
+                std::push_heap(ready.begin(), ready.end(), std::greater<uint32_t>());
+            }
+        }
+    }
+    return order;
+}
+
+std::vector<uint32_t> topologicalLevels(const EvalGraph& graph)
+{
+    std::vector<uint32_t> levels(graph.nodeCount(), EvalGraph::npos);
+    for (uint32_t v : topologicalOrder(graph)) {
+        uint32_t level = 0;
+        for (uint32_t p = graph.incomingBegin(v); p < graph.incomingEnd(v); p++) {
+            const EvalGraphEdge& edge = graph.edge(graph.incomingEdge(p));
+            if (!edge.isSuppressed() && levels[edge.from] + 1 > level) {
+                level = levels[edge.from] + 1;
+            }
+        }
+        levels[v] = level;
+    }
+    return levels;
+}
+
+
+EvalGraphEvaluator::EvalGraphEvaluator(const EvalGraph& graph, EvalNodeFunction function)
+    : graph(graph), function(function)
+{
+    order = topologicalOrder(graph);
+    rank.assign(graph.nodeCount(), EvalGraph::npos);
+    for (uint32_t i = 0; i < order.size(); i++) {
+        rank[order[i]] = i;
+    }
+    nodeValues.assign(graph.nodeCount(), 0.0);
+    dirtyRanks.assign((order.size() + 31) / 32, 0);
+    firstDirtyWord = dirtyRanks.size();
+    evaluationCount = 0;
+}
+
+void EvalGraphEvaluator::evaluate()
+{
+    std::fill(dirtyRanks.begin(), dirtyRanks.end(), 0);
+    firstDirtyWord = dirtyRanks.size();
+    for (uint32_t v : order) {
+        nodeValues[v] = function(graph, v, nodeValues.data());
+    }
+    evaluationCount += order.size();
+}
+
+void EvalGraphEvaluator::markDirty(uint32_t node)
+{
+    queue(node);
+}
+
+size_t EvalGraphEvaluator::update()
+{
+    // nodes are taken in order of rank, i.e. topologically, so every input
+    // of a node is final by the time the node is evaluated.  Anything
+    // queued meanwhile ranks after the node being evaluated, so the scan
+    // never has to go back, and no node is evaluated twice.
+    size_t evaluated = 0;
+    for (size_t w = firstDirtyWord; w < dirtyRanks.size(); w++) {
+        while (dirtyRanks[w] != 0) {
+            uint32_t bits = dirtyRanks[w];
+            dirtyRanks[w] = bits & (bits - 1);
+            uint32_t v = order[w * 32 + lowestSetBit(bits)];
+
+            double newValue = function(graph, v, nodeValues.data());
+            evaluated++;
+            if (newValue == nodeValues[v]) {
+                continue;
+            }
+            nodeValues[v] = newValue;
+            for (uint32_t e = graph.outgoingBegin(v); e < graph.outgoingEnd(v); e++) {
+                if (!graph.edge(e).isSuppressed()) {
+                    queue(graph.edge(e).to);
+                }
+            }
+        }
+    }
+    firstDirtyWord = dirtyRanks.size();
+    evaluationCount += evaluated;
+    return evaluated;
+}
+
+
+LevelParallelEvaluator::LevelParallelEvaluator(const EvalGraph& graph, EvalNodeFunction function)
+    : graph(graph), function(function)
+{
+    std::vector<uint32_t> levels = topologicalLevels(graph);
+    uint32_t count = 0;
+    for (uint32_t level : levels) {
+        if (level != EvalGraph::npos && level + 1 > count) {
+            count = level + 1;
+        }
+    }
+    levelOffsets.assign(count + 1, 0);
+    for (uint32_t level : levels) {
+        if (level != EvalGraph::npos) {
+            levelOffsets[level + 1]++;
+        }
+    }
+    for (uint32_t l = 0; l < count; l++) {
+        levelOffsets[l + 1] += levelOffsets[l];
+    }
+    levelNodes.resize(levelOffsets[count]);
+    std::vector<uint32_t> filled(levelOffsets.begin(), levelOffsets.end() - 1);
+    for (uint32_t v = 0; v < graph.nodeCount(); v++) {
+        if (levels[v] != EvalGraph::npos) {
+            levelNodes[filled[levels[v]]++] = v;
+        }
+    }
+    nodeValues.assign(graph.nodeCount(), 0.0);
+}
+
+void LevelParallelEvaluator::evaluate(WorkStealingPool& pool, size_t serialBelow)
+{
+    double* values = nodeValues.data();
+    for (uint32_t l = 0; l < levelCount(); l++) {
+        const uint32_t* nodes = levelNodes.data() + levelOffsets[l];
+        pool.parallelFor(levelSize(l), [&](size_t i) {
+            values[nodes[i]] = function(graph, nodes[i], values);
+        }, serialBelow);
+    }
+}
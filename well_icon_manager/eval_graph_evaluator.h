@@ -0,0 +1,104 @@
+#pragma once
+
+// Evaluation of an EvalGraph (see eval_graph.h), for what-if analysis of
+// dynamic blocks outside of AcDbEvalGraph::evaluate().
+//
+// Each node has a value, computed by a caller-supplied function from the
+// values of the nodes it has incoming edges from (and from whatever
+// parameters of its own the caller keeps).  Suppressed edges are not
+// followed.  After a full evaluate(), changing the parameters of a few
+// nodes and calling markDirty() on them lets update() re-evaluate just the
+// nodes downstream of them, in topological order, and stop propagating
+// wherever a value comes out unchanged.
+
+#include <functional>
+#include <vector>
+#include "eval_graph.h"
+#include "work_stealing_pool.h"
+
+// Computes the value of a node; values holds the current value of every
+// node, indexed like the graph's nodes.
+typedef std::function<double(const EvalGraph& graph, uint32_t node, const double* values)> EvalNodeFunction;
+
+// The nodes of a graph in topological order of its non-suppressed edges
+// (Kahn's algorithm, ties broken by node index).  Nodes on a cycle, and
+// downstream of one, are left out.
+std::vector<uint32_t> topologicalOrder(const EvalGraph& graph);
+
+// The level of a node is 0 if it has no inputs, else one more than the
+// highest level among its inputs; the nodes of one level are independent of
+// each other.  Nodes left out of topologicalOrder() get EvalGraph::npos.
+std::vector<uint32_t> topologicalLevels(const EvalGraph& graph);
+
+class EvalGraphEvaluator {
+    private:
+        const EvalGraph& graph;
+        EvalNodeFunction function;
+        std::vector<uint32_t> order;
+        std::vector<uint32_t> rank;     // position of each node in order; EvalGraph::npos if not in it
+        std::vector<double> nodeValues;
+        std::vector<uint32_t> dirtyRanks; // a bitmap over the ranks of the queued nodes
+        size_t firstDirtyWord;            // the words of dirtyRanks before it are all 0
+        size_t evaluationCount;
+
+        void queue(uint32_t node) {
+            uint32_t rankOfNode = rank[node];
+            if (rankOfNode != EvalGraph::npos) {
+                dirtyRanks[rankOfNode / 32] |= 1u << (rankOfNode % 32);
+                firstDirtyWord = rankOfNode / 32 < firstDirtyWord ? rankOfNode / 32 : firstDirtyWord;
+            }
+        }
+
+    public:
+        // The graph must outlive the evaluator.  All values start at 0.
+        EvalGraphEvaluator(const EvalGraph& graph, EvalNodeFunction function);
+
+        // False if some nodes are on (or downstream of) a cycle; they are
+        // never evaluated.
+        bool isAcyclic() const { return order.size() == graph.nodeCount(); }
+        const std::vector<uint32_t>& evaluationOrder() const { return order; }
+
+        // Evaluates every node, discarding any pending dirty nodes.
+        void evaluate();
+
+        // Queues a node whose parameters changed for update().
+        void markDirty(uint32_t node);
+        // Re-evaluates the dirty nodes and, where their value changed, the
+        // nodes downstream of them; each node at most once.  Returns the
+        // number of nodes evaluated.
+        size_t update();
+
+        double value(uint32_t node) const { return nodeValues[node]; }
+        const std::vector<double>& values() const { return nodeValues; }
+        // Node evaluations since construction.
+        size_t evaluations() const { return evaluationCount; }
+};
+
+// Evaluates a whole graph level by level (see topologicalLevels()), the
+// nodes of each level concurrently on a WorkStealingPool.  Each node only
+// reads values of lower levels, which are final by then, so with a function
+// that depends on nothing but its arguments the values are identical to
+// those of EvalGraphEvaluator::evaluate(), whatever the thread count.
+class LevelParallelEvaluator {
+    private:
+        const EvalGraph& graph;
+        EvalNodeFunction function;
+        std::vector<uint32_t> levelOffsets; // the nodes of level l are levelNodes[levelOffsets[l] .. levelOffsets[l + 1])
+        std::vector<uint32_t> levelNodes;
+        std::vector<double> nodeValues;
+
+    public:
+        // The graph must outlive the evaluator.  All values start at 0.
+        LevelParallelEvaluator(const EvalGraph& graph, EvalNodeFunction function);
+
+        uint32_t levelCount() const { return (uint32_t)levelOffsets.size() - 1; }
+        uint32_t levelSize(uint32_t level) const { return levelOffsets[level + 1] - levelOffsets[level]; }
+        bool isAcyclic() const { return levelNodes.size() == graph.nodeCount(); }
+
+        // Levels with fewer than serialBelow nodes are evaluated on the
+        // calling thread; waking the pool costs more than they do.
+        void evaluate(WorkStealingPool& pool, size_t serialBelow = 64);
+
+        double value(uint32_t node) const { return nodeValues[node]; }
+        const std::vector<double>& values() const { return nodeValues; }
+};
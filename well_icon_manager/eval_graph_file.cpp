@@ -0,0 +1,249 @@
+#include "eval_graph_file.h"
+#include <unordered_map>
+
+
+static const size_t headerSize = 32;
+static const size_t nodeRecordSize = 36; // 9 uint32s
+
+static void putUint32(std::string& out, uint32_t value)
+{
+    char bytes[4];
+    memcpy(bytes, &value, 4);
+    out.append(bytes, 4);
+}
+
+static size_t padded(size_t size)
+{
+    return (size + 3) & ~(size_t)3;
+}
+
+void encodeEvalGraph(const EvalGraph& graph, std::string& out)
+{
+    uint32_t nodeCount = graph.nodeCount();
+    uint32_t edgeCount = graph.edgeCount();
+
+    std::string strings;
+    std::unordered_map<std::string_view, uint32_t> pooled;
+    std::string nodeRecords;
+    nodeRecords.reserve(nodeRecordSize * nodeCount);
+    for (uint32_t i = 0; i < nodeCount; i++) {
+        const EvalGraphNode& node = graph.node(i);
+        putUint32(nodeRecords, node.id);
+        // class names and ancestries repeat from node to node; handles and
+        // data hardly ever do, and are not worth looking up.
+        for (const std::string* pField : { &node.className, &node.handle, &node.ancestry, &node.data }) {
+            uint32_t offset = (uint32_t)strings.size();
+            if (pField == &node.className || pField == &node.ancestry) {
+                offset = pooled.emplace(*pField, offset).first->second;
+            }
+            if (offset == strings.size()) {
+                strings += *pField;
+            }
+            putUint32(nodeRecords, offset);
+            putUint32(nodeRecords, (uint32_t)pField->size());
+        }
+    }
+
+    out.reserve(out.size() + headerSize + nodeRecords.size() + 13 * (size_t)edgeCount + 8 * ((size_t)nodeCount + 1) + strings.size());
+    out += evalGraphFileMagic;
+    putUint32(out, evalGraphFileVersion);
+    putUint32(out, 0);
+    putUint32(out, nodeCount);
+    putUint32(out, edgeCount);
+    putUint32(out, (uint32_t)strings.size());
+    putUint32(out, 0);
+    out += nodeRecords;
+    for (uint32_t e = 0; e < edgeCount; e++) {
+        putUint32(out, graph.edge(e).from);
+        putUint32(out, graph.edge(e).to);
+    }
+    for (uint32_t e = 0; e < edgeCount; e++) {
+        out += (char)graph.edge(e).flags;
+    }
+    out.append(padded(edgeCount) - edgeCount, '\0');
+    for (uint32_t i = 0; i <= nodeCount; i++) {
+        putUint32(out, i < nodeCount ? graph.outgoingBegin(i) : edgeCount);
+    }
+    for (uint32_t i = 0; i <= nodeCount; i++) {
+        putUint32(out, i < nodeCount ? graph.incomingBegin(i) : edgeCount);
+    }
+    for (uint32_t p = 0; p < edgeCount; p++) {
+        putUint32(out, graph.incomingEdge(p));
+    }
+    out += strings;
+}
+
+bool writeEvalGraph(FILE* out, const EvalGraph& graph)
+{
+    std::string encoded;
+    encodeEvalGraph(graph, encoded);
+    return fwrite(encoded.data(), 1, encoded.size(), out) == encoded.size();
+}
+
+
+static void putDotString(std::string& out, std::string_view text)
+{
+    out += '"';
+    for (char c : text) {
+        if (c == '\n') {
+            out += "\\n";
+            continue;
+        }
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    out += '"';
+}
+
+void writeEvalGraphDot(const EvalGraph& graph, std::string& out)
+{
+    out += "digraph evalgraph {\n\tnode [shape=box, fontname=\"Helvetica\"];\n";
+    for (uint32_t i = 0; i < graph.nodeCount(); i++) {
+        const EvalGraphNode& node = graph.node(i);
+        out += "\tn" + std::to_string(node.id) + " [label=";
+        putDotString(out, std::to_string(node.id) + "\n" + node.className + "\n" + node.handle);
+        out += ", tooltip=";
+        putDotString(out, node.ancestry);
+        out += "];\n";
+    }
+    for (uint32_t e = 0; e < graph.edgeCount(); e++) {
+        const EvalGraphEdge& edge = graph.edge(e);
+        out += "\tn" + std::to_string(graph.node(edge.from).id) + " -> n" + std::to_string(graph.node(edge.to).id);
+        if (edge.isInvertible() && edge.isSuppressed()) {
+            out += " [dir=both, style=dashed]";
+        }
+        else if (edge.isInvertible()) {
+            out += " [dir=both]";
+        }
+        else if (edge.isSuppressed()) {
+            out += " [style=dashed]";
+        }
+        out += ";\n";
+    }
+    out += "}\n";
+}
+
+
+EvalGraphFileView::EvalGraphFileView()
+{
+    pData = pNodes = pEdges = pOutgoingOffsets = pIncomingOffsets = pIncomingEdges = pStrings = NULL;
+    pFlags = NULL;
+    nodeTotal = edgeTotal = stringPoolSize = 0;
+    errorMessage = NULL;
+}
+
+bool EvalGraphFileView::fail(const char* message)
+{
+    errorMessage = message;
+    nodeTotal = edgeTotal = stringPoolSize = 0;
+    return false;
+}
+
+bool EvalGraphFileView::open(std::string_view data)
+{
+    errorMessage = NULL;
+    if (data.substr(0, evalGraphFileMagic.size()) != evalGraphFileMagic) {
+        return fail("not an eval graph file");
+    }
+    if (data.size() < headerSize) {
+        return fail("truncated eval graph header");
+    }
+    pData = data.data();
+    if (read(pData, 2) != evalGraphFileVersion) {
+        return fail("unsupported eval graph file version");
+    }
+    nodeTotal = read(pData, 4);
+    edgeTotal = read(pData, 5);
+    stringPoolSize = read(pData, 6);
+
+    // the sizes are at most 32 bits each, so none of this overflows.
+    unsigned long long nodesEnd = headerSize + (unsigned long long)nodeRecordSize * nodeTotal;
+    unsigned long long edgesEnd = nodesEnd + 8ULL * edgeTotal;
+    unsigned long long flagsEnd = edgesEnd + padded(edgeTotal);
+    unsigned long long outgoingOffsetsEnd = flagsEnd + 4ULL * ((unsigned long long)nodeTotal + 1);
+    unsigned long long incomingOffsetsEnd = outgoingOffsetsEnd + 4ULL * ((unsigned long long)nodeTotal + 1);
+    unsigned long long incomingEdgesEnd = incomingOffsetsEnd + 4ULL * edgeTotal;
+    if (incomingEdgesEnd + stringPoolSize != data.size()) {
+        return fail("the size of the eval graph file does not match its header");
+    }
+    pNodes = pData + headerSize;
+    pEdges = pData + nodesEnd;
+    pFlags = (const unsigned char*)pData + edgesEnd;
+    pOutgoingOffsets = pData + flagsEnd;
+    pIncomingOffsets = pData + outgoingOffsetsEnd;
+    pIncomingEdges = pData + incomingOffsetsEnd;
+    pStrings = pData + incomingEdgesEnd;
+
+    for (uint32_t i = 0; i < nodeTotal; i++) {
+        if (i > 0 && nodeId(i) <= nodeId(i - 1)) {
+            return fail("the node ids are not ascending");
+        }
+        for (int field = 0; field < 4; field++) {
+            size_t record = 9 * (size_t)i + 1 + 2 * field;
+            if ((unsigned long long)read(pNodes, record) + read(pNodes, record + 1) > stringPoolSize) {
+                return fail("a node string is outside of the string pool");
+            }
+        }
+    }
+
+    // the outgoing edges of each node, by ascending destination.
+    if (outgoingBegin(0) != 0 || read(pOutgoingOffsets, nodeTotal) != edgeTotal) {
+        return fail("malformed outgoing offsets");
+    }
+    for (uint32_t i = 0; i < nodeTotal; i++) {
+        if (outgoingEnd(i) < outgoingBegin(i) || outgoingEnd(i) > edgeTotal) {
+            return fail("malformed outgoing offsets");
+        }
+        for (uint32_t e = outgoingBegin(i); e < outgoingEnd(i); e++) {
+            if (edgeFrom(e) != i || edgeTo(e) >= nodeTotal || (e > outgoingBegin(i) && edgeTo(e) <= edgeTo(e - 1))) {
+                return fail("the edges do not match the outgoing offsets");
+            }
+        }
+    }
+
+    // the incoming edges of each node, by ascending source.  Since the edges
+    // are distinct, this makes incomingEdges a permutation of the edges.
+    if (incomingBegin(0) != 0 || read(pIncomingOffsets, nodeTotal) != edgeTotal) {
+        return fail("malformed incoming offsets");
+    }
+    for (uint32_t i = 0; i < nodeTotal; i++) {
+        if (incomingEnd(i) < incomingBegin(i) || incomingEnd(i) > edgeTotal) {
+            return fail("malformed incoming offsets");
+        }
+        for (uint32_t p = incomingBegin(i); p < incomingEnd(i); p++) {
+            uint32_t e = incomingEdge(p);
+            if (e >= edgeTotal || edgeTo(e) != i || (p > incomingBegin(i) && edgeFrom(e) <= edgeFrom(incomingEdge(p - 1)))) {
+                return fail("the edges do not match the incoming offsets");
+            }
+        }
+    }
+    return true;
+}
+
+void EvalGraphFileView::load(EvalGraph& graph) const
+{
+    graph = EvalGraph();
+    graph.nodes.resize(nodeTotal);
+    for (uint32_t i = 0; i < nodeTotal; i++) {
+        EvalGraphNode& node = graph.nodes[i];
+        node.id = nodeId(i);
+        node.className = className(i);
+        node.handle = handle(i);
+        node.ancestry = ancestry(i);
+        node.data = data(i);
+    }
+    graph.edges.resize(edgeTotal);
+    for (uint32_t e = 0; e < edgeTotal; e++) {
+        graph.edges[e] = EvalGraphEdge{ edgeFrom(e), edgeTo(e), edgeFlags(e) };
+    }
+    graph.outgoingOffsets.resize((size_t)nodeTotal + 1);
+    graph.incomingOffsets.resize((size_t)nodeTotal + 1);
+    graph.incomingEdges.resize(edgeTotal);
+    memcpy(graph.outgoingOffsets.data(), pOutgoingOffsets, 4 * ((size_t)nodeTotal + 1));
+    memcpy(graph.incomingOffsets.data(), pIncomingOffsets, 4 * ((size_t)nodeTotal + 1));
+    if (edgeTotal > 0) {
+        memcpy(graph.incomingEdges.data(), pIncomingEdges, 4 * (size_t)edgeTotal);
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+// Exporting an EvalGraph (see eval_graph.h) for offline analysis: to a
+// compact binary file that is used in place once mapped (see mapped_file.h),
+// and to GraphViz DOT.
+//
+// Format, version 1.  Every integer is a little-endian uint32 (the byte
+// order of both the Windows and the Linux hosts), and every section starts
+// at a multiple of 4 bytes, so that nothing has to be parsed to use a file:
+//
+//   header   := magic "EVALGRF\x1a" (8 bytes), version, flags (0),
+//               node count, edge count, string pool size, reserved (0)
+//   nodes    := per node: id, then an (offset, length) pair into the string
+//               pool for each of className, handle, ancestry and data
+//   edges    := per edge: from, to (node indexes)
+//   flags    := per edge: one byte of kEvalEdge*, padded with zeros to a
+//               multiple of 4 bytes
+//   outgoing := node count + 1 offsets, as in the EvalGraph
+//   incoming := node count + 1 offsets, as in the EvalGraph
+//   incomingEdges := edge count indexes, as in the EvalGraph
+//   strings  := the string pool; equal class names and ancestries are
+//               stored once
+//
+// Nodes, edges and the CSR arrays are laid out exactly as in the EvalGraph
+// they were written from, so loading one is a copy of each array.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <string_view>
+#include "eval_graph.h"
+
+constexpr std::string_view evalGraphFileMagic("EVALGRF\x1a", 8);
+const uint32_t evalGraphFileVersion = 1;
+
+// Appends the binary form of a graph to out.
+void encodeEvalGraph(const EvalGraph& graph, std::string& out);
+
+// Returns false if the file cannot be written.
+bool writeEvalGraph(FILE* out, const EvalGraph& graph);
+
+// Appends a GraphViz digraph of the graph to out: a node per graph node,
+// labelled with its id, class and handle (the tooltip is its ancestry);
+// invertible edges point both ways and suppressed ones are dashed.
+void writeEvalGraphDot(const EvalGraph& graph, std::string& out);
+
+// Reads the binary form of a graph in place, typically from a mapped file.
+// open() checks the whole file, so that the accessors need not; nothing is
+// copied, and the strings are views into data.
+class EvalGraphFileView {
+    private:
+        const char* pData;
+        const char* pNodes;
+        const char* pEdges;
+        const unsigned char* pFlags;
+        const char* pOutgoingOffsets;
+        const char* pIncomingOffsets;
+        const char* pIncomingEdges;
+        const char* pStrings;
+        uint32_t nodeTotal;
+        uint32_t edgeTotal;
+        uint32_t stringPoolSize;
+        const char* errorMessage;
+
+        static uint32_t read(const char* p, size_t index) {
+            uint32_t value;
+            memcpy(&value, p + 4 * index, 4);
+            return value;
+        }
+        std::string_view string(uint32_t node, int field) const {
+            return std::string_view(pStrings + read(pNodes, 9 * (size_t)node + 1 + 2 * field), read(pNodes, 9 * (size_t)node + 2 + 2 * field));
+        }
+        bool fail(const char* message);
+
+    public:
+        EvalGraphFileView();
+
+        // Returns false (error() tells why) if data is not a well-formed
+        // graph file.
+        bool open(std::string_view data);
+        const char* error() const { return errorMessage; }
+
+        uint32_t nodeCount() const { return nodeTotal; }
+        uint32_t edgeCount() const { return edgeTotal; }
+
+        EvalNodeId nodeId(uint32_t node) const { return read(pNodes, 9 * (size_t)node); }
+        std::string_view className(uint32_t node) const { return string(node, 0); }
+        std::string_view handle(uint32_t node) const { return string(node, 1); }
+        std::string_view ancestry(uint32_t node) const { return string(node, 2); }
+        std::string_view data(uint32_t node) const { return string(node, 3); }
+
+        uint32_t edgeFrom(uint32_t edge) const { return read(pEdges, 2 * (size_t)edge); }
+        uint32_t edgeTo(uint32_t edge) const { return read(pEdges, 2 * (size_t)edge + 1); }
+        uint8_t edgeFlags(uint32_t edge) const { return pFlags[edge]; }
+
+        uint32_t outgoingBegin(uint32_t node) const { return read(pOutgoingOffsets, node); }
+        uint32_t outgoingEnd(uint32_t node) const { return read(pOutgoingOffsets, (size_t)node + 1); }
+        uint32_t incomingBegin(uint32_t node) const { return read(pIncomingOffsets, node); }
+        uint32_t incomingEnd(uint32_t node) const { return read(pIncomingOffsets, (size_t)node + 1); }
+        uint32_t incomingEdge(uint32_t position) const { return read(pIncomingEdges, position); }
+
+        // Copies the graph out of the file.  The view must be open.
+        void load(EvalGraph& graph) const;
+};
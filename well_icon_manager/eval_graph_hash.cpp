@@ -0,0 +1,140 @@
+#include "eval_graph_hash.h"
+#include <algorithm>
+#include <unordered_map>
+
+static uint64_t mixBits(uint64_t x)
+{
+    // the splitmix64 finalizer.
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return x;
+}
+
+static uint64_t combine(uint64_t hash, uint64_t value)
+{
+    return mixBits(hash + 0x9E3779B97F4A7C15ull + mixBits(value));
+}
+
+static uint64_t hashString(const std::string& text)
+{
+    uint64_t hash = 0xCBF29CE484222325ull; // FNV-1a
+    for (unsigned char c : text) {
+        hash = (hash ^ c) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+// A round can only tell apart nodes whose neighbourhoods differ within one
+// more edge, so a chain of n nodes takes n / 2 rounds to settle.  The
+// graphs of real blocks settle in a handful; the cap keeps long chains from
+// taking quadratic time, at the price of not telling apart nodes that only
+// differ farther away than this.
+static const uint32_t maxRefinementRounds = 32;
+
+static size_t distinctCount(std::vector<uint64_t> values)
+{
+    std::sort(values.begin(), values.end());
+    return (size_t)(std::unique(values.begin(), values.end()) - values.begin());
+}
+
+std::vector<uint64_t> canonicalNodeLabels(const EvalGraph& graph)
+{
+    uint32_t nodeCount = graph.nodeCount();
+    std::vector<uint64_t> labels(nodeCount);
+    for (uint32_t v = 0; v < nodeCount; v++) {
+        labels[v] = hashString(graph.node(v).className);
+    }
+
+    // every round refines the grouping of the nodes by label; once a round
+    // leaves the number of groups unchanged, further rounds will as well,
+    // and once every node is in a group of its own there is nothing left to
+    // refine.  The first round always runs: until it has, the labels are
+    // only the class names, and say nothing about the edges.
+    std::vector<uint64_t> nextLabels(nodeCount);
+    std::vector<uint64_t> neighbours;
+    size_t groupCount = distinctCount(labels);
+    for (uint32_t round = 0; round < maxRefinementRounds && (round == 0 || groupCount < nodeCount); round++) {
+        for (uint32_t v = 0; v < nodeCount; v++) {
+            neighbours.clear();
+            for (uint32_t e = graph.outgoingBegin(v); e < graph.outgoingEnd(v); e++) {
+                const EvalGraphEdge& edge = graph.edge(e);
+                neighbours.push_back(combine(combine(1, edge.flags), labels[edge.to]));
+            }
+            for (uint32_t p = graph.incomingBegin(v); p < graph.incomingEnd(v); p++) {
+                const EvalGraphEdge& edge = graph.edge(graph.incomingEdge(p));
+                neighbours.push_back(combine(combine(2, edge.flags), labels[edge.from]));
+            }
+            std::sort(neighbours.begin(), neighbours.end());
+            uint64_t label = labels[v];
+            for (uint64_t neighbour : neighbours) {
+                label = combine(label, neighbour);
+            }
+            nextLabels[v] = label;
+        }
+        labels.swap(nextLabels);
+        size_t nextGroupCount = distinctCount(labels);
+        if (nextGroupCount == groupCount) {
+            break;
+        }
+        groupCount = nextGroupCount;
+    }
+    return labels;
+}
+
+uint64_t canonicalEvalGraphHash(const EvalGraph& graph)
+{
+    std::vector<uint64_t> labels = canonicalNodeLabels(graph);
+    // each edge as (label of from, label of to, flags), so that its
+    // direction and flags enter the hash however far refinement went.
+    std::vector<uint64_t> edges(graph.edgeCount());
+    for (uint32_t e = 0; e < graph.edgeCount(); e++) {
+        const EvalGraphEdge& edge = graph.edge(e);
+        edges[e] = combine(combine(combine(3, labels[edge.from]), labels[edge.to]), edge.flags);
+    }
+    std::sort(labels.begin(), labels.end());
+    std::sort(edges.begin(), edges.end());
+    uint64_t hash = combine(graph.nodeCount(), graph.edgeCount());
+    for (uint64_t label : labels) {
+        hash = combine(hash, label);
+    }
+    for (uint64_t edge : edges) {
+        hash = combine(hash, edge);
+    }
+    return hash;
+}
+
+std::vector<std::vector<size_t>> groupByCanonicalHash(const std::vector<const EvalGraph*>& graphs)
+{
+    std::vector<std::vector<size_t>> groups;
+    std::unordered_map<uint64_t, size_t> groupOfHash;
+    groupOfHash.reserve(graphs.size());
+    for (size_t i = 0; i < graphs.size(); i++) {
+        auto inserted = groupOfHash.emplace(canonicalEvalGraphHash(*graphs[i]), groups.size());
+        if (inserted.second) {
+            groups.emplace_back();
+        }
+        groups[inserted.first->second].push_back(i);
+    }
+    return groups;
+}
+
+bool mayBeSubgraphOf(const EvalGraph& graph, const EvalGraph& of)
+{
+    if (graph.nodeCount() > of.nodeCount() || graph.edgeCount() > of.edgeCount()) {
+        return false;
+    }
+    std::unordered_map<std::string, int64_t> classCounts;
+    for (uint32_t v = 0; v < of.nodeCount(); v++) {
+        classCounts[of.node(v).className]++;
+    }
+    for (uint32_t v = 0; v < graph.nodeCount(); v++) {
+        auto found = classCounts.find(graph.node(v).className);
+        if (found == classCounts.end() || --found->second < 0) {
+            return false;
+        }
+    }
+    return true;
+}
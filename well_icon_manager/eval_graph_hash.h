@@ -0,0 +1,37 @@
+#pragma once
+
+// Canonical structural hashing of EvalGraph models (see eval_graph.h), to
+// group block definitions whose eval graphs have the same shape without
+// calling AcDbEvalGraph::equals() on every pair.
+//
+// The hash is Weisfeiler-Lehman style: every node starts out labelled with
+// (a hash of) its class name, and is then relabelled, round after round,
+// with its own label together with the sorted labels and edge flags of its
+// outgoing and incoming neighbours, for at least one round and until a
+// round no longer splits any group of equally labelled nodes (or for at
+// most 32 rounds, see eval_graph_hash.cpp).  The graph hash combines the
+// sorted final labels and the sorted (from label, to label, flags) triples
+// of the edges.  Node ids, handles and node data do not enter into it, so
+// graphs that are the same up to renumbering hash the same; graphs with
+// different hashes are certainly different, while equal hashes still have
+// to be confirmed with an exact comparison.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "eval_graph.h"
+
+uint64_t canonicalEvalGraphHash(const EvalGraph& graph);
+
+// The final Weisfeiler-Lehman label of every node; nodes with different
+// labels cannot correspond to each other in any isomorphism.
+std::vector<uint64_t> canonicalNodeLabels(const EvalGraph& graph);
+
+// Groups graphs by canonical hash, in one pass.  Each group lists indexes
+// into graphs, ascending; the groups are in order of their first member.
+std::vector<std::vector<size_t>> groupByCanonicalHash(const std::vector<const EvalGraph*>& graphs);
+
+// A cheap necessary condition for graph being (isomorphic to) a subgraph of
+// of: it has no more nodes or edges, and for every class name no more nodes
+// of that class.  False means isSubgraphOf() need not be asked.
+bool mayBeSubgraphOf(const EvalGraph& graph, const EvalGraph& of);
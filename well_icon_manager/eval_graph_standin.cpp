@@ -0,0 +1,103 @@
+#include "eval_graph_standin.h"
+#include "resbuf_snapshot.h"
+
+
+void StandInEvalGraph::addNode(EvalNodeId id, const std::string& className, const std::string& handle, const resbuf* pData)
+{
+    StandInEvalNode& node = nodes[id];
+    node.className = className;
+    node.handle = handle;
+    node.data.clear();
+    encodeResbufChain(pData, true, node.data);
+}
+
+bool StandInEvalGraph::addEdge(EvalNodeId from, EvalNodeId to, uint8_t flags)
+{
+    auto found = nodes.find(from);
+    if (found == nodes.end()) {
+        return false;
+    }
+    found->second.outgoingEdges.emplace_back(from, to, flags);
+    return true;
+}
+
+bool StandInEvalGraph::getAllNodes(std::vector<EvalNodeId>& nodeIds) const
+{
+    nodeIds.clear();
+    nodeIds.reserve(nodes.size());
+    for (const auto& node : nodes) {
+        nodeIds.push_back(node.first);
+    }
+    return true;
+}
+
+const StandInEvalNode* StandInEvalGraph::getNode(EvalNodeId id) const
+{
+    auto found = nodes.find(id);
+    return found == nodes.end() ? NULL : &found->second;
+}
+
+bool StandInEvalGraph::getOutgoingEdges(EvalNodeId id, std::vector<StandInEvalEdgeInfo>& edges) const
+{
+    const StandInEvalNode* pNode = getNode(id);
+    if (pNode == NULL) {
+        return false;
+    }
+    edges.insert(edges.end(), pNode->outgoingEdges.begin(), pNode->outgoingEdges.end());
+    return true;
+}
+
+
+bool collectEvalGraphEdges(const StandInEvalGraph& source, std::vector<EvalEdgeInfo>& edges)
+{
+    std::vector<EvalNodeId> nodeIds;
+    if (!source.getAllNodes(nodeIds)) {
+        return false;
+    }
+    std::vector<StandInEvalEdgeInfo> nodeEdges; // reused: getOutgoingEdges() appends to it.
+    for (EvalNodeId nodeId : nodeIds) {
+        nodeEdges.clear();
+        if (!source.getOutgoingEdges(nodeId, nodeEdges)) {
+            return false;
+        }
+        size_t first = edges.size();
+        for (const StandInEvalEdgeInfo& edge : nodeEdges) {
+            if (source.getNode(edge.to()) == NULL) {
+                return false;
+            }
+            edges.push_back(EvalEdgeInfo{ edge.from(), edge.to(),
+                (uint8_t)((edge.isInvertible() ? kEvalEdgeInvertible : 0) | (edge.isSuppressed() ? kEvalEdgeSuppressed : 0)) });
+        }
+        mergeDuplicateEdges(edges, first);
+    }
+    return true;
+}
+
+bool extractEvalGraph(const StandInEvalGraph& source, EvalGraph& graph)
+{
+    graph = EvalGraph();
+    std::vector<EvalNodeId> nodeIds;
+    if (!source.getAllNodes(nodeIds)) {
+        return false;
+    }
+
+    EvalGraphBuilder builder;
+    for (EvalNodeId nodeId : nodeIds) {
+        const StandInEvalNode* pSourceNode = source.getNode(nodeId);
+        if (pSourceNode == NULL) {
+            return false;
+        }
+        EvalGraphNode& node = builder.addNode(nodeId);
+        node.className = pSourceNode->className;
+        node.handle = pSourceNode->handle;
+        node.ancestry = pSourceNode->ancestry;
+        node.data = pSourceNode->data;
+    }
+
+    std::vector<EvalEdgeInfo> edges;
+    if (!collectEvalGraphEdges(source, edges)) {
+        return false;
+    }
+    builder.addEdges(edges);
+    return builder.build(graph);
+}
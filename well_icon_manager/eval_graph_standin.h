@@ -0,0 +1,62 @@
+#pragma once
+
+// A stand-in for AcDbEvalGraph, for building and analysing EvalGraph models
+// (see eval_graph.h) outside of AutoCAD.  It answers the same queries
+// (getAllNodes, getNode, getOutgoingEdges), so that the stand-in extractor
+// walks it the way eval_graph_arx.cpp walks a real graph.
+
+#include <map>
+#include <string>
+#include <vector>
+#include "arx_host.h"
+#include "eval_graph.h"
+
+class StandInEvalEdgeInfo {
+    private:
+        EvalNodeId fromId;
+        EvalNodeId toId;
+        uint8_t flags;
+
+    public:
+        StandInEvalEdgeInfo(EvalNodeId fromId, EvalNodeId toId, uint8_t flags) {
+            this->fromId = fromId;
+            this->toId = toId;
+            this->flags = flags;
+        }
+
+        EvalNodeId from() const { return fromId; }
+        EvalNodeId to() const { return toId; }
+        bool isInvertible() const { return (flags & kEvalEdgeInvertible) != 0; }
+        bool isSuppressed() const { return (flags & kEvalEdgeSuppressed) != 0; }
+};
+
+struct StandInEvalNode {
+    std::string className;
+    std::string handle;
+    std::string ancestry;
+    std::string data; // encoded, see encodeResbufChain()
+    std::vector<StandInEvalEdgeInfo> outgoingEdges;
+};
+
+class StandInEvalGraph {
+    private:
+        std::map<EvalNodeId, StandInEvalNode> nodes;
+
+    public:
+        // pData is encoded with entity names kept; it stays owned by the caller.
+        // Adding a node id again replaces the node, but not its edges.
+        void addNode(EvalNodeId id, const std::string& className, const std::string& handle, const resbuf* pData = NULL);
+        // Returns false if from is not a node.
+        bool addEdge(EvalNodeId from, EvalNodeId to, uint8_t flags = 0);
+
+        bool getAllNodes(std::vector<EvalNodeId>& nodeIds) const;
+        const StandInEvalNode* getNode(EvalNodeId id) const;
+        // Appends the outgoing edges of a node to edges, as AcDbEvalGraph does.
+        bool getOutgoingEdges(EvalNodeId id, std::vector<StandInEvalEdgeInfo>& edges) const;
+};
+
+// Appends every edge of source to edges; see eval_graph_arx.h.
+bool collectEvalGraphEdges(const StandInEvalGraph& source, std::vector<EvalEdgeInfo>& edges);
+
+// Reads all nodes and edges of source; see eval_graph_arx.h.
+bool extractEvalGraph(const StandInEvalGraph& source, EvalGraph& graph);
@@ -0,0 +1,451 @@
+// evalgraphbench: how the eval-graph code scales, measured on synthetic
+// graphs of 10 to 100k nodes.
+//
+// The graphs are built in a StandInEvalGraph (see eval_graph_standin.h), in
+// the shapes AcDbEvalGraph takes:
+//
+//   chain    each node drives the next
+//   fan      one node drives all of the others
+//   diamond  a chain of diamonds: a node drives two, which both drive the
+//            top of the next diamond
+//   block    dynamic block features: a parameter drives one to three
+//            actions, each action drives the parameter's grips, some
+//            parameters are driven by an action of an earlier feature, and a
+//            visibility parameter drives every 16th parameter; a few
+//            action-to-grip edges are suppressed
+//
+// Every node carries acdbEntGet()-like data.  For each graph, each step is
+// repeated for at least 50 ms and timed:
+//
+//   extract      StandInEvalGraph to EvalGraph (see extractEvalGraph())
+//   toposort     topologicalOrder()
+//   evaluate     EvalGraphEvaluator::evaluate() of the whole graph
+//   parallel     with --threads, LevelParallelEvaluator::evaluate() of the
+//                whole graph on a WorkStealingPool of that many threads (0
+//                for one per core); its values must be bit-for-bit those of
+//                the serial evaluate().  The note gives the number of levels
+//   update       markDirty() of the node in the middle of the evaluation
+//                order, then update(); the note gives the number of nodes
+//                re-evaluated
+//   hash         canonicalEvalGraphHash()
+//   encode       encodeEvalGraph()
+//   load         EvalGraphFileView::open() and load() of the encoding
+//
+// and reported per node of the graph, with the most heap memory that the
+// step had allocated at any one time (counted by the operator new of this
+// program, the worker threads of --threads included).  The peak resident
+// size of the whole run is reported at the end.
+//
+// Before that, canonicalEvalGraphHash() is checked on small graphs: sets of
+// graphs that are not isomorphic but have the same class names (with every
+// class distinct, with repeated classes, and differing only in edge
+// direction or flags) must hash apart, and each graph must hash the same
+// with its nodes added in the opposite order.
+//
+// This is a standalone program; it does not link against ObjectARX:
+//
+//     g++ -std=c++17 -O2 -I ObjectARX_for_AutoCAD_2021_Win_64bit/inc evalgraphbench.cpp eval_graph.cpp eval_graph_standin.cpp eval_graph_evaluator.cpp eval_graph_hash.cpp eval_graph_file.cpp work_stealing_pool.cpp resbuf_snapshot.cpp resbuf_arena.cpp arx_host.cpp dxf_reader.cpp dxf_number.cpp -pthread -o evalgraphbench
+//
+// usage: evalgraphbench [--shape chain|fan|diamond|block] [--max-nodes <n>] [--threads <n>]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include "eval_graph.h"
+#include "eval_graph_evaluator.h"
+#include "eval_graph_file.h"
+#include "eval_graph_hash.h"
+#include "eval_graph_standin.h"
+#include "work_stealing_pool.h"
+
+
+// Heap accounting.  Each block is prefixed with its size, so that delete
+// knows how much is released.  The workers of the pool allocate (and free
+// their thread states) too, so the counters are atomic.
+static std::atomic<size_t> liveBytes(0);
+static std::atomic<size_t> peakBytes(0);
+static const size_t blockPrefix = 16; // keeps the alignment malloc() gives
+
+void* operator new(size_t size)
+{
+    char* pBlock = (char*)malloc(size + blockPrefix);
+    if (pBlock == NULL) {
+        throw std::bad_alloc();
+    }
+    memcpy(pBlock, &size, sizeof(size));
+    size_t live = liveBytes += size;
+    size_t peak = peakBytes;
+    while (live > peak && !peakBytes.compare_exchange_weak(peak, live)) {
+    }
+    return pBlock + blockPrefix;
+}
+
+void operator delete(void* p) noexcept
+{
+    if (p == NULL) {
+        return;
+    }
+    char* pBlock = (char*)p - blockPrefix;
+    size_t size;
+    memcpy(&size, pBlock, sizeof(size));
+    liveBytes -= size;
+    free(pBlock);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    operator delete(p);
+}
+
+
+// Builds graphs node by node, giving each node its data: the same chain for
+// every node, with the node's id in it.
+class GraphGenerator {
+    private:
+        StandInEvalGraph& graph;
+        resbuf* pData;
+        EvalNodeId nextId;
+
+    public:
+        explicit GraphGenerator(StandInEvalGraph& graph) : graph(graph), nextId(1) {
+            static const ACHAR name[] = L"BLOCKLINEARPARAMETER";
+            static const ACHAR label[] = L"Distance1";
+            pData = acutNewRb(0);
+            pData->resval.rstring = resbufNewString(name, sizeof(name) / sizeof(name[0]) - 1);
+            resbuf* pTail = pData;
+            pTail = pTail->rbnext = acutNewRb(90);
+            pTail = pTail->rbnext = acutNewRb(1010);
+            pTail->resval.rpoint[0] = 12.5;
+            pTail->resval.rpoint[1] = -3.25;
+            pTail = pTail->rbnext = acutNewRb(40);
+            pTail->resval.rreal = 30.0;
+            pTail = pTail->rbnext = acutNewRb(300);
+            pTail->resval.rstring = resbufNewString(label, sizeof(label) / sizeof(label[0]) - 1);
+            pTail = pTail->rbnext = acutNewRb(70);
+            pTail->resval.rint = 3;
+        }
+        ~GraphGenerator() {
+            acutRelRb(pData);
+        }
+
+        EvalNodeId add(const char* className) {
+            EvalNodeId id = nextId++;
+            char handle[17];
+            snprintf(handle, sizeof(handle), "%X", 0x2A0u + id);
+            pData->rbnext->resval.rlong = (int)id;
+            graph.addNode(id, className, handle, pData);
+            return id;
+        }
+        EvalNodeId count() const { return nextId - 1; }
+};
+
+static void makeChain(StandInEvalGraph& graph, uint32_t nodeCount)
+{
+    GraphGenerator generator(graph);
+    EvalNodeId last = generator.add("AcDbBlockLinearParameter");
+    while (generator.count() < nodeCount) {
+        EvalNodeId next = generator.add(generator.count() % 2 == 1 ? "AcDbBlockStretchAction" : "AcDbBlockLinearParameter");
+        graph.addEdge(last, next);
+        last = next;
+    }
+}
+
+static void makeFan(StandInEvalGraph& graph, uint32_t nodeCount)
+{
+    GraphGenerator generator(graph);
+    EvalNodeId root = generator.add("AcDbBlockVisibilityParameter");
+    while (generator.count() < nodeCount) {
+        graph.addEdge(root, generator.add("AcDbBlockMoveAction"));
+    }
+}
+
+static void makeDiamonds(StandInEvalGraph& graph, uint32_t nodeCount)
+{
+    GraphGenerator generator(graph);
+    EvalNodeId top = generator.add("AcDbBlockPointParameter");
+    while (generator.count() < nodeCount) {
+        EvalNodeId left = generator.add("AcDbBlockMoveAction");
+        graph.addEdge(top, left);
+        if (generator.count() == nodeCount) {
+            break;
+        }
+        EvalNodeId right = generator.add("AcDbBlockStretchAction");
+        graph.addEdge(top, right);
+        if (generator.count() == nodeCount) {
+            break;
+        }
+        top = generator.add("AcDbBlockPointParameter");
+        graph.addEdge(left, top);
+        graph.addEdge(right, top);
+    }
+}
+
+static void makeBlockFeatures(StandInEvalGraph& graph, uint32_t nodeCount)
+{
+    static const char* const parameterClasses[] = { "AcDbBlockLinearParameter", "AcDbBlockPointParameter", "AcDbBlockRotationParameter", "AcDbBlockFlipParameter" };
+    static const char* const actionClasses[] = { "AcDbBlockStretchAction", "AcDbBlockMoveAction", "AcDbBlockRotateAction", "AcDbBlockFlipAction" };
+    static const char* const gripClasses[] = { "AcDbBlockLinearGrip", "AcDbBlockXYGrip", "AcDbBlockRotationGrip", "AcDbBlockFlipGrip" };
+    std::mt19937 random(20);
+    GraphGenerator generator(graph);
+    EvalNodeId visibility = generator.add("AcDbBlockVisibilityParameter");
+    std::vector<EvalNodeId> actions; // of all features so far
+    uint32_t featureCount = 0;
+    uint32_t edgeCount = 0;
+    while (generator.count() < nodeCount) {
+        int kind = (int)(random() % 4);
+        EvalNodeId parameter = generator.add(parameterClasses[kind]);
+        if (featureCount++ % 16 == 0) {
+            graph.addEdge(visibility, parameter);
+        }
+        if (!actions.empty() && random() % 4 == 0) {
+            graph.addEdge(actions[random() % actions.size()], parameter);
+        }
+        std::vector<EvalNodeId> grips;
+        for (int i = 0; i < 2 && generator.count() < nodeCount; i++) {
+            grips.push_back(generator.add(gripClasses[kind]));
+        }
+        int actionCount = 1 + (int)(random() % 3);
+        for (int i = 0; i < actionCount && generator.count() < nodeCount; i++) {
+            EvalNodeId action = generator.add(actionClasses[(kind + i) % 4]);
+            actions.push_back(action);
+            graph.addEdge(parameter, action);
+            for (EvalNodeId grip : grips) {
+                graph.addEdge(action, grip, ++edgeCount % 10 == 0 ? kEvalEdgeSuppressed : 0);
+            }
+        }
+    }
+}
+
+struct Shape {
+    const char* name;
+    void (*make)(StandInEvalGraph& graph, uint32_t nodeCount);
+};
+
+static const Shape shapes[] = {
+    { "chain", makeChain },
+    { "fan", makeFan },
+    { "diamond", makeDiamonds },
+    { "block", makeBlockFeatures },
+};
+
+
+struct SmallEdge {
+    int from;
+    int to; // indexes into the class names
+    uint8_t flags;
+};
+
+// A graph with a node per letter of classes (of class "AcDbBlock" and the
+// letter), added first to last or, if reversed, last to first, with other
+// ids and handles.
+static EvalGraph makeSmallGraph(const char* classes, const std::vector<SmallEdge>& edges, bool reversed)
+{
+    StandInEvalGraph source;
+    EvalNodeId count = (EvalNodeId)strlen(classes);
+    auto idOf = [&](int i) { return reversed ? 100 + count - (EvalNodeId)i : 1 + (EvalNodeId)i; };
+    for (EvalNodeId n = 0; n < count; n++) {
+        int i = reversed ? (int)(count - 1 - n) : (int)n;
+        source.addNode(idOf(i), std::string("AcDbBlock") + classes[i], std::to_string(idOf(i)));
+    }
+    for (const SmallEdge& edge : edges) {
+        source.addEdge(idOf(edge.from), idOf(edge.to), edge.flags);
+    }
+    EvalGraph graph;
+    extractEvalGraph(source, graph);
+    return graph;
+}
+
+static bool checkHashes()
+{
+    struct SmallGraph {
+        const char* classes;
+        std::vector<SmallEdge> edges;
+    };
+    // each set holds graphs that are pairwise not isomorphic.
+    const std::vector<std::vector<SmallGraph>> sets = {
+        { { "ABC", { { 0, 1, 0 } } }, { "ABC", { { 0, 2, 0 } } }, { "ABC", { { 1, 0, 0 } } } },
+        { { "AB", { { 0, 1, 0 } } }, { "AB", { { 0, 1, kEvalEdgeSuppressed } } }, { "AB", { { 0, 1, kEvalEdgeInvertible } } } },
+        { { "PPM", { { 0, 1, 0 }, { 1, 2, 0 } } }, { "PPM", { { 0, 2, 0 }, { 2, 1, 0 } } }, { "PPM", { { 0, 2, 0 }, { 1, 2, 0 } } } },
+        { { "PPPP", { { 0, 1, 0 }, { 1, 2, 0 }, { 2, 3, 0 } } }, { "PPPP", { { 0, 1, 0 }, { 0, 2, 0 }, { 0, 3, 0 } } }, { "PPPP", { { 1, 0, 0 }, { 2, 0, 0 }, { 3, 0, 0 } } } },
+    };
+    for (size_t s = 0; s < sets.size(); s++) {
+        std::vector<uint64_t> hashes;
+        for (const SmallGraph& small : sets[s]) {
+            uint64_t hash = canonicalEvalGraphHash(makeSmallGraph(small.classes, small.edges, false));
+            if (canonicalEvalGraphHash(makeSmallGraph(small.classes, small.edges, true)) != hash) {
+                fprintf(stderr, "evalgraphbench: a graph of set %zu hashes differently with its nodes reversed\n", s + 1);
+                return false;
+            }
+            for (size_t i = 0; i < hashes.size(); i++) {
+                if (hashes[i] == hash) {
+                    fprintf(stderr, "evalgraphbench: graphs %zu and %zu of set %zu are not isomorphic but hash the same (%016llx)\n",
+                        i + 1, hashes.size() + 1, s + 1, (unsigned long long)hash);
+                    return false;
+                }
+            }
+            hashes.push_back(hash);
+        }
+    }
+    return true;
+}
+
+
+typedef std::chrono::steady_clock Clock;
+
+// Runs step at least once and until 50 ms have passed, and prints its time
+// per node and its peak heap use.
+static void measure(const char* shapeName, const EvalGraph& graph, const char* stepName, const std::function<void()>& step, const std::string& note = std::string())
+{
+    size_t baseBytes = liveBytes;
+    peakBytes = liveBytes.load();
+    size_t repetitions = 0;
+    Clock::time_point startTime = Clock::now();
+    double seconds;
+    do {
+        step();
+        repetitions++;
+        seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    } while (seconds < 0.05);
+    printf("%-8s %7u %7u  %-9s %8zu %10.1f %10.1f  %s\n",
+        shapeName, graph.nodeCount(), graph.edgeCount(), stepName, repetitions,
+        seconds * 1.0e9 / repetitions / (graph.nodeCount() > 0 ? graph.nodeCount() : 1),
+        (peakBytes - baseBytes) / 1024.0, note.c_str());
+    fflush(stdout);
+}
+
+// pPool is NULL unless --threads was given.
+static void benchmark(const Shape& shape, uint32_t nodeCount, WorkStealingPool* pPool)
+{
+    StandInEvalGraph source;
+    shape.make(source, nodeCount);
+
+    EvalGraph graph;
+    if (!extractEvalGraph(source, graph)) {
+        fprintf(stderr, "evalgraphbench: %s: extraction failed\n", shape.name);
+        exit(1);
+    }
+    measure(shape.name, graph, "extract", [&]() {
+        EvalGraph extracted;
+        extractEvalGraph(source, extracted);
+    });
+
+    measure(shape.name, graph, "toposort", [&]() {
+        topologicalOrder(graph);
+    });
+
+    // the value of a node is a parameter of its own plus half of each input.
+    std::vector<double> parameters(graph.nodeCount(), 1.0);
+    EvalNodeFunction function = [&](const EvalGraph& graph, uint32_t node, const double* values) {
+        double value = parameters[node];
+        for (uint32_t p = graph.incomingBegin(node); p < graph.incomingEnd(node); p++) {
+            const EvalGraphEdge& edge = graph.edge(graph.incomingEdge(p));
+            value += edge.isSuppressed() ? 0.0 : 0.5 * values[edge.from];
+        }
+        return value;
+    };
+    EvalGraphEvaluator evaluator(graph, function);
+    measure(shape.name, graph, "evaluate", [&]() {
+        evaluator.evaluate();
+    });
+
+    if (pPool != NULL) {
+        LevelParallelEvaluator parallelEvaluator(graph, function);
+        evaluator.evaluate();
+        parallelEvaluator.evaluate(*pPool);
+        if (graph.nodeCount() > 0 && memcmp(parallelEvaluator.values().data(), evaluator.values().data(), graph.nodeCount() * sizeof(double)) != 0) {
+            fprintf(stderr, "evalgraphbench: %s: the level-parallel values differ from the serial ones\n", shape.name);
+            exit(1);
+        }
+        measure(shape.name, graph, "parallel", [&]() {
+            parallelEvaluator.evaluate(*pPool);
+        }, std::to_string(parallelEvaluator.levelCount()) + " levels on " + std::to_string(pPool->threadCount()) + " threads");
+    }
+
+    const std::vector<uint32_t>& order = evaluator.evaluationOrder();
+    uint32_t changedNode = order.empty() ? 0 : order[order.size() / 2];
+    evaluator.evaluate();
+    // every change propagates, so each update re-evaluates as many nodes as the first.
+    parameters[changedNode] += 1.0;
+    evaluator.markDirty(changedNode);
+    size_t updated = graph.nodeCount() > 0 ? evaluator.update() : 0;
+    measure(shape.name, graph, "update", [&]() {
+        parameters[changedNode] += 1.0;
+        evaluator.markDirty(changedNode);
+        evaluator.update();
+    }, std::to_string(updated) + " nodes re-evaluated");
+
+    measure(shape.name, graph, "hash", [&]() {
+        canonicalEvalGraphHash(graph);
+    });
+
+    std::string encoded;
+    encodeEvalGraph(graph, encoded);
+    measure(shape.name, graph, "encode", [&]() {
+        encoded.clear();
+        encodeEvalGraph(graph, encoded);
+    }, std::to_string(encoded.size()) + " bytes");
+
+    measure(shape.name, graph, "load", [&]() {
+        EvalGraphFileView view;
+        EvalGraph loaded;
+        if (view.open(encoded)) {
+            view.load(loaded);
+        }
+    });
+}
+
+int main(int argc, char** argv)
+{
+    const char* shapeName = NULL;
+    uint32_t maxNodeCount = 100000;
+    const char* threadCount = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--shape") == 0 && i + 1 < argc) {
+            shapeName = argv[++i];
+        } else if (strcmp(argv[i], "--max-nodes") == 0 && i + 1 < argc) {
+            maxNodeCount = (uint32_t)atol(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threadCount = argv[++i];
+        } else {
+            fprintf(stderr, "usage: evalgraphbench [--shape chain|fan|diamond|block] [--max-nodes <n>] [--threads <n>]\n");
+            return 2;
+        }
+    }
+
+    if (!checkHashes()) {
+        return 1;
+    }
+    std::unique_ptr<WorkStealingPool> pool;
+    if (threadCount != NULL) {
+        pool.reset(new WorkStealingPool((unsigned)atol(threadCount)));
+    }
+    printf("%-8s %7s %7s  %-9s %8s %10s %10s  %s\n", "shape", "nodes", "edges", "step", "reps", "ns/node", "peak KB", "note");
+    bool found = false;
+    for (const Shape& shape : shapes) {
+        if (shapeName != NULL && strcmp(shapeName, shape.name) != 0) {
+            continue;
+        }
+        found = true;
+        for (uint32_t nodeCount = 10; nodeCount <= maxNodeCount; nodeCount *= 10) {
+            benchmark(shape, nodeCount, pool.get());
+        }
+    }
+    if (!found) {
+        fprintf(stderr, "evalgraphbench: unknown shape %s\n", shapeName);
+        return 2;
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("peak resident size: %.1f MB\n", usage.ru_maxrss / 1024.0);
+    return 0;
+}
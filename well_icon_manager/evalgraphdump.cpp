@@ -0,0 +1,175 @@
+// evalgraphdump: headless analysis of the eval graphs that the arx exports
+// next to each drawing (see eval_graph_file.h).
+//
+// Prints the nodes and edges of each graph file, in the same terms as the arx
+// prints them inside AutoCAD, together with the canonical hash of the graph
+// (see eval_graph_hash.h), so that the graphs of different drawings can be
+// compared.  With --dot, the graphs are printed as GraphViz digraphs instead.
+// With --count, nothing is printed per graph: every file is mapped, checked,
+// loaded and grouped by canonical hash, and the time each of those steps
+// takes over all of the files is reported, along with the number of distinct
+// graphs -- which makes --count a load-time benchmark for batches of
+// thousands of graphs.  The groups are then prefiltered for containment: for
+// every ordered pair of distinct graphs, mayBeSubgraphOf() tells whether the
+// first may be part of the second, and the number of pairs that would still
+// need an exact subgraph test is reported.
+//
+// This is a standalone program; it does not link against ObjectARX:
+//
+//     g++ -std=c++17 -O2 evalgraphdump.cpp eval_graph.cpp eval_graph_file.cpp eval_graph_hash.cpp mapped_file.cpp -o evalgraphdump
+//
+// usage: evalgraphdump [--dot | --count] <file.evalgraph>...
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "eval_graph.h"
+#include "eval_graph_file.h"
+#include "eval_graph_hash.h"
+#include "mapped_file.h"
+
+
+typedef std::chrono::steady_clock Clock;
+
+static double secondsSince(Clock::time_point startTime)
+{
+    return std::chrono::duration<double>(Clock::now() - startTime).count();
+}
+
+static void printGraph(FILE* out, const char* path, const EvalGraph& graph)
+{
+    fprintf(out, "%s: %u nodes, %u edges, canonical hash %016llx\n", path, graph.nodeCount(), graph.edgeCount(), (unsigned long long)canonicalEvalGraphHash(graph));
+    for (uint32_t i = 0; i < graph.nodeCount(); i++) {
+        const EvalGraphNode& node = graph.node(i);
+        fprintf(out, "\tnode %u (%s (%s)), whose nodeId is %u and whose class ancestry is %s, %zu bytes of data\n",
+            i, node.className.c_str(), node.handle.c_str(), node.id, node.ancestry.c_str(), node.data.size());
+    }
+    for (uint32_t e = 0; e < graph.edgeCount(); e++) {
+        const EvalGraphEdge& edge = graph.edge(e);
+        const EvalGraphNode& fromNode = graph.node(edge.from);
+        const EvalGraphNode& toNode = graph.node(edge.to);
+        fprintf(out, "\t%u (%s (%s)) --> %u (%s (%s))%s%s\n",
+            fromNode.id, fromNode.className.c_str(), fromNode.handle.c_str(),
+            toNode.id, toNode.className.c_str(), toNode.handle.c_str(),
+            (edge.isInvertible() ? " invertible" : ""), (edge.isSuppressed() ? " suppressed" : ""));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool dot = false;
+    bool countOnly = false;
+    std::vector<const char*> paths;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--dot") == 0) {
+            dot = true;
+        } else if (strcmp(argv[i], "--count") == 0) {
+            countOnly = true;
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty() || (dot && countOnly)) {
+        fprintf(stderr, "usage: evalgraphdump [--dot | --count] <file.evalgraph>...\n");
+        return 2;
+    }
+
+    static char outputBuffer[1 << 16];
+    setvbuf(stdout, outputBuffer, _IOFBF, sizeof(outputBuffer));
+
+    if (countOnly) {
+        // each step runs over all of the files before the next one starts, so
+        // that each is timed on its own.
+        std::vector<MappedFile> files(paths.size());
+        std::vector<EvalGraphFileView> views(paths.size());
+        size_t byteCount = 0;
+        Clock::time_point startTime = Clock::now();
+        for (size_t i = 0; i < paths.size(); i++) {
+            if (!files[i].open(paths[i])) {
+                fprintf(stderr, "evalgraphdump: unable to open %s\n", paths[i]);
+                return 1;
+            }
+            byteCount += files[i].size();
+        }
+        double mapSeconds = secondsSince(startTime);
+
+        startTime = Clock::now();
+        size_t nodeCount = 0;
+        size_t edgeCount = 0;
+        for (size_t i = 0; i < paths.size(); i++) {
+            if (!views[i].open(files[i].view())) {
+                fprintf(stderr, "evalgraphdump: %s: %s\n", paths[i], views[i].error());
+                return 1;
+            }
+            nodeCount += views[i].nodeCount();
+            edgeCount += views[i].edgeCount();
+        }
+        double checkSeconds = secondsSince(startTime);
+
+        startTime = Clock::now();
+        std::vector<EvalGraph> graphs(paths.size());
+        for (size_t i = 0; i < paths.size(); i++) {
+            views[i].load(graphs[i]);
+        }
+        double loadSeconds = secondsSince(startTime);
+
+        startTime = Clock::now();
+        std::vector<const EvalGraph*> graphPointers;
+        for (const EvalGraph& graph : graphs) {
+            graphPointers.push_back(&graph);
+        }
+        std::vector<std::vector<size_t>> groups = groupByCanonicalHash(graphPointers);
+        double hashSeconds = secondsSince(startTime);
+        size_t largestGroup = 0;
+        for (const std::vector<size_t>& group : groups) {
+            largestGroup = group.size() > largestGroup ? group.size() : largestGroup;
+        }
+
+        // the first graph of each group stands for all of it.
+        startTime = Clock::now();
+        size_t candidatePairs = 0;
+        for (size_t g = 0; g < groups.size(); g++) {
+            for (size_t h = 0; h < groups.size(); h++) {
+                if (g != h && mayBeSubgraphOf(graphs[groups[g][0]], graphs[groups[h][0]])) {
+                    candidatePairs++;
+                }
+            }
+        }
+        double prefilterSeconds = secondsSince(startTime);
+
+        double perNode = 1.0e9 / (nodeCount > 0 ? nodeCount : 1);
+        size_t pairCount = groups.size() * (groups.size() - (groups.empty() ? 0 : 1));
+        fprintf(stderr, "%zu graphs, %zu nodes, %zu edges, %zu bytes; %zu distinct graphs, up to %zu alike\n",
+            paths.size(), nodeCount, edgeCount, byteCount, groups.size(), largestGroup);
+        fprintf(stderr, "%zu of the %zu ordered pairs of distinct graphs pass the subgraph prefilter\n", candidatePairs, pairCount);
+        fprintf(stderr, "map:   %.3f s\ncheck: %.3f s (%.1f ns/node)\nload:  %.3f s (%.1f ns/node)\nhash:  %.3f s (%.1f ns/node)\nprefilter: %.3f s\n",
+            mapSeconds, checkSeconds, checkSeconds * perNode, loadSeconds, loadSeconds * perNode, hashSeconds, hashSeconds * perNode, prefilterSeconds);
+        return 0;
+    }
+
+    for (const char* path : paths) {
+        MappedFile file;
+        EvalGraphFileView view;
+        if (!file.open(path)) {
+            fprintf(stderr, "evalgraphdump: unable to open %s\n", path);
+            return 1;
+        }
+        if (!view.open(file.view())) {
+            fprintf(stderr, "evalgraphdump: %s: %s\n", path, view.error());
+            return 1;
+        }
+        EvalGraph graph;
+        view.load(graph);
+        if (dot) {
+            std::string text;
+            writeEvalGraphDot(graph, text);
+            fwrite(text.data(), 1, text.size(), stdout);
+        } else {
+            printGraph(stdout, path, graph);
+        }
+    }
+    fflush(stdout);
+    return 0;
+}
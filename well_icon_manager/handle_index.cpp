@@ -0,0 +1,199 @@
+#include "handle_index.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define HANDLE_INDEX_SSE2 1
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+template <typename Char>
+static size_t formatHandleDigits(uint64_t handle, Char (&text)[handleTextSize])
+{
+    static const char digits[] = "0123456789ABCDEF";
+    // the digits are written from the back, then moved to the front.
+    Char reversed[handleTextSize - 1];
+    size_t length = 0;
+    do {
+        reversed[length++] = (Char)digits[handle & 0xF];
+        handle >>= 4;
+    } while (handle != 0);
+    for (size_t i = 0; i < length; i++) {
+        text[i] = reversed[length - 1 - i];
+    }
+    text[length] = 0;
+    return length;
+}
+
+size_t formatHandle(uint64_t handle, char (&text)[handleTextSize])
+{
+    return formatHandleDigits(handle, text);
+}
+
+size_t formatHandle(uint64_t handle, wchar_t (&text)[handleTextSize])
+{
+    return formatHandleDigits(handle, text);
+}
+
+bool parseHandle(std::string_view text, uint64_t& handle)
+{
+    if (text.empty() || text.size() > handleTextSize - 1) {
+        return false;
+    }
+    uint64_t value = 0;
+    for (char c : text) {
+        unsigned digit;
+        if (c >= '0' && c <= '9') {
+            digit = (unsigned)(c - '0');
+        } else if (c >= 'A' && c <= 'F') {
+            digit = (unsigned)(c - 'A' + 10);
+        } else if (c >= 'a' && c <= 'f') {
+            digit = (unsigned)(c - 'a' + 10);
+        } else {
+            return false;
+        }
+        value = value << 4 | digit;
+    }
+    handle = value;
+    return true;
+}
+
+
+#ifdef HANDLE_INDEX_SSE2
+const bool HandleIndex::simdProbe = true;
+#else
+const bool HandleIndex::simdProbe = false;
+#endif
+
+static uint64_t mixBits(uint64_t x)
+{
+    // the splitmix64 finalizer; handles are mostly consecutive, so all of
+    // their bits have to be mixed into the group and the control byte.
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return x;
+}
+
+// One bit per byte of the group equal to value.
+static unsigned matchingBytes(const uint8_t* pGroup, uint8_t value)
+{
+#ifdef HANDLE_INDEX_SSE2
+    __m128i group = _mm_loadu_si128((const __m128i*)pGroup);
+    return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)value)));
+#else
+    unsigned mask = 0;
+    for (unsigned i = 0; i < 16; i++) {
+        mask |= (unsigned)(pGroup[i] == value) << i;
+    }
+    return mask;
+#endif
+}
+
+static unsigned lowestBit(unsigned mask)
+{
+#ifdef _MSC_VER
+    unsigned long bit;
+    _BitScanForward(&bit, mask);
+    return (unsigned)bit;
+#else
+    return (unsigned)__builtin_ctz(mask);
+#endif
+}
+
+HandleIndex::HandleIndex()
+{
+    groupMask = 0;
+}
+
+void HandleIndex::clear()
+{
+    control.clear();
+    slots.clear();
+    entries.clear();
+    groupMask = 0;
+}
+
+void HandleIndex::reserve(size_t count)
+{
+    // at most 7 of every 8 slots are used.
+    size_t groupCount = 1;
+    while (groupCount * groupSize * 7 / 8 < count) {
+        groupCount *= 2;
+    }
+    if (groupCount * groupSize > control.size()) {
+        rehash(groupCount);
+    }
+    entries.reserve(count);
+}
+
+void HandleIndex::rehash(size_t groupCount)
+{
+    control.assign(groupCount * groupSize, (uint8_t)emptyControl);
+    slots.assign(groupCount * groupSize, Slot{ 0, 0 });
+    groupMask = groupCount - 1;
+    for (uint32_t entry = 0; entry < entries.size(); entry++) {
+        uint64_t hash = mixBits(entries[entry]);
+        bool found;
+        size_t slot = probe(entries[entry], hash, found);
+        control[slot] = (uint8_t)(hash & 0x7F);
+        slots[slot] = Slot{ entries[entry], entry };
+    }
+}
+
+size_t HandleIndex::probe(uint64_t handle, uint64_t hash, bool& found) const
+{
+    // the groups are probed in triangular steps, which visit every group
+    // when there is a power of two of them; there always is an empty slot.
+    uint8_t tag = (uint8_t)(hash & 0x7F);
+    size_t group = (size_t)(hash >> 7) & groupMask;
+    for (size_t step = 1; ; step++) {
+        size_t first = group * groupSize;
+        for (unsigned matches = matchingBytes(&control[first], tag); matches != 0; matches &= matches - 1) {
+            size_t slot = first + lowestBit(matches);
+            if (slots[slot].handle == handle) {
+                found = true;
+                return slot;
+            }
+        }
+        unsigned empties = matchingBytes(&control[first], emptyControl);
+        if (empties != 0) {
+            found = false;
+            return first + lowestBit(empties);
+        }
+        group = (group + step) & groupMask;
+    }
+}
+
+uint32_t HandleIndex::find(uint64_t handle) const
+{
+    if (control.empty()) {
+        return npos;
+    }
+    bool found;
+    size_t slot = probe(handle, mixBits(handle), found);
+    return found ? slots[slot].entry : npos;
+}
+
+uint32_t HandleIndex::findOrAdd(uint64_t handle, bool& added)
+{
+    if ((entries.size() + 1) * 8 > control.size() * 7) {
+        rehash(control.empty() ? 1 : 2 * (groupMask + 1));
+    }
+    uint64_t hash = mixBits(handle);
+    bool found;
+    size_t slot = probe(handle, hash, found);
+    added = !found;
+    if (found) {
+        return slots[slot].entry;
+    }
+    uint32_t entry = (uint32_t)entries.size();
+    control[slot] = (uint8_t)(hash & 0x7F);
+    slots[slot] = Slot{ handle, entry };
+    entries.push_back(handle);
+    return entry;
+}
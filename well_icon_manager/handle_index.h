@@ -0,0 +1,87 @@
+#pragma once
+
+// Handles as 64-bit values rather than text: an index from handle to a
+// dense entry number, and hex formatting into fixed buffers.
+//
+// HandleIndex is an open-addressing hash table in the manner of Abseil's
+// SwissTable.  Its slots come in groups of 16.  Each slot has a control
+// byte holding 7 bits of the handle's hash, or emptyControl.  A lookup
+// compares the 16 control bytes of a group with one SSE2 comparison, and
+// only compares handles where the bytes match.  So a lookup mostly touches
+// one 16-byte group and one slot, whether or not the handle is there.
+// Entries are numbered in the order they are added, so that callers keep
+// what they know of an entry in arrays of their own (see
+// handle_index_arx.h for object ids and classes).
+//
+// Handles are formatted as AcDbHandle::getIntoAsciiBuffer() formats them
+// (upper-case hex digits, no leading zeros), into a buffer on the stack.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string_view>
+#include <vector>
+
+// Big enough for the hex digits of any handle and the terminating NUL.
+const size_t handleTextSize = 17;
+
+// Returns the number of digits written, not counting the NUL.
+size_t formatHandle(uint64_t handle, char (&text)[handleTextSize]);
+size_t formatHandle(uint64_t handle, wchar_t (&text)[handleTextSize]);
+// False unless text is 1 to 16 hex digits of either case.
+bool parseHandle(std::string_view text, uint64_t& handle);
+
+// A handle formatted for printing, without a heap allocation, e.g.
+// acutPrintf(_T("%s"), HandleText(handle).c_str()).
+class HandleText {
+    private:
+        wchar_t text[handleTextSize];
+        size_t textLength;
+
+    public:
+        explicit HandleText(uint64_t handle) { textLength = formatHandle(handle, text); }
+
+        const wchar_t* c_str() const { return text; }
+        size_t length() const { return textLength; }
+};
+
+class HandleIndex {
+    private:
+        static const size_t groupSize = 16;
+
+        struct Slot {
+            uint64_t handle;
+            uint32_t entry;
+        };
+
+        std::vector<uint8_t> control;  // per slot
+        std::vector<Slot> slots;
+        std::vector<uint64_t> entries; // the handle of every entry
+        size_t groupMask;              // the number of groups - 1
+
+        void rehash(size_t groupCount);
+        // The slot holding handle, or the empty slot to put it in.
+        size_t probe(uint64_t handle, uint64_t hash, bool& found) const;
+
+    public:
+        static const uint32_t npos = 0xFFFFFFFF;
+        static const uint8_t emptyControl = 0x80;
+
+        // Whether probes compare control bytes with SSE2 rather than one by
+        // one.
+        static const bool simdProbe;
+
+        HandleIndex();
+
+        void clear();
+        // Makes room for count entries without growing the table.
+        void reserve(size_t count);
+
+        // The entry of handle, or npos if it has not been added.
+        uint32_t find(uint64_t handle) const;
+        // Returns the entry of handle, added as entry count() if it is new.
+        uint32_t findOrAdd(uint64_t handle, bool& added);
+
+        size_t count() const { return entries.size(); }
+        uint64_t handle(uint32_t entry) const { return entries[entry]; }
+        size_t slotCount() const { return control.size(); }
+};
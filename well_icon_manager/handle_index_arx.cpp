@@ -0,0 +1,63 @@
+#include "handle_index_arx.h"
+#include <dbhandle.h>
+
+
+DrawingHandleIndex::DrawingHandleIndex(AcDbDatabase* pDb)
+    : pDb(pDb)
+{
+}
+
+void DrawingHandleIndex::reserve(size_t count)
+{
+    index.reserve(count);
+    ids.reserve(count);
+    classes.reserve(count);
+}
+
+uint32_t DrawingHandleIndex::addEntry(uint64_t handle, AcDbObjectId id)
+{
+    bool added;
+    uint32_t entry = index.findOrAdd(handle, added);
+    if (added) {
+        ids.push_back(id);
+        // the class is known to the id, without opening the object.
+        classes.push_back(id.isNull() ? NULL : id.objectClass());
+    }
+    return entry;
+}
+
+void DrawingHandleIndex::add(AcDbObjectId id)
+{
+    if (!id.isNull()) {
+        addEntry(handleOf(id), id);
+    }
+}
+
+uint32_t DrawingHandleIndex::entryOf(uint64_t handle)
+{
+    uint32_t entry = index.find(handle);
+    if (entry == HandleIndex::npos) {
+        AcDbObjectId id;
+        if (pDb->getAcDbObjectId(id, false, AcDbHandle((Adesk::UInt64)handle)) != Acad::eOk) {
+            id = AcDbObjectId::kNull;
+        }
+        entry = addEntry(handle, id);
+    }
+    return entry;
+}
+
+AcDbObjectId DrawingHandleIndex::find(uint64_t handle)
+{
+    return ids[entryOf(handle)];
+}
+
+AcDbObjectId DrawingHandleIndex::find(std::string_view handleText)
+{
+    uint64_t handle;
+    return parseHandle(handleText, handle) ? find(handle) : AcDbObjectId::kNull;
+}
+
+AcRxClass* DrawingHandleIndex::classOf(uint64_t handle)
+{
+    return classes[entryOf(handle)];
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+// A HandleIndex (see handle_index.h) over the objects of a drawing: from
+// handle to object id and class, without a query of the database for
+// handles seen before.  Only available inside AutoCAD.
+
+#include <vector>
+#include <dbmain.h>
+#include "handle_index.h"
+
+class DrawingHandleIndex {
+    private:
+        AcDbDatabase* pDb;
+        HandleIndex index;
+        std::vector<AcDbObjectId> ids;   // per entry; kNull for handles not in the drawing
+        std::vector<AcRxClass*> classes; // per entry
+
+        uint32_t addEntry(uint64_t handle, AcDbObjectId id);
+        uint32_t entryOf(uint64_t handle);
+
+    public:
+        explicit DrawingHandleIndex(AcDbDatabase* pDb);
+
+        void reserve(size_t count);
+        // Indexes an object the caller already has the id of.
+        void add(AcDbObjectId id);
+
+        // Looks a handle up in the database the first time it is asked for
+        // (and remembers if it is not there); kNull if it is not.
+        AcDbObjectId find(uint64_t handle);
+        // As above, for the text of a handle as formatHandle() writes it.
+        AcDbObjectId find(std::string_view handleText);
+        // The class of the object; NULL if it is not in the drawing.
+        AcRxClass* classOf(uint64_t handle);
+
+        size_t count() const { return index.count(); }
+};
+
+inline uint64_t handleOf(AcDbObjectId id)
+{
+    return (Adesk::UInt64)id.handle();
+}
@@ -0,0 +1,347 @@
+// handlebench: HandleIndex and the handle formatting of handle_index.h,
+// against std::unordered_map and snprintf(), on 50k and 1M handles, both
+// consecutive (as a drawing hands them out) and random.
+//
+//   check    every handle is added to an empty index, so that it grows
+//            through every rehash, and to one reserved for all of them,
+//            whose slots must then not change.  Both must number the
+//            handles as a std::unordered_map does; adding a handle again
+//            must give its entry back; every handle must be found, and as
+//            many that were never added must not be; clear() must empty the
+//            index.  formatHandle() must write what snprintf("%llX") does,
+//            narrow and wide, and parseHandle() must read it back, in either
+//            case, and reject texts that are not 1 to 16 hex digits
+//   time     adds, finds of handles that are there and of handles that are
+//            not, against std::unordered_map<uint64_t, uint32_t>, and
+//            formatHandle() against snprintf(), in ns per handle, each
+//            repeated for at least 50 ms
+//
+// The first line says whether the probes compare control bytes with SSE2.
+// This is a standalone program; it does not link against ObjectARX:
+//
+//     g++ -std=c++17 -O2 handlebench.cpp handle_index.cpp -o handlebench
+//
+// and, to exercise the probe without SSE2 (handle_index.cpp does no
+// floating point, so it can be built without SSE on x86-64):
+//
+//     g++ -std=c++17 -O2 -mno-sse2 -c handle_index.cpp -o handle_index_nosse2.o
+//     g++ -std=c++17 -O2 handlebench.cpp handle_index_nosse2.o -o handlebench_nosse2
+//
+// usage: handlebench [--step check|time]
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "handle_index.h"
+
+
+static const size_t handleCounts[] = { 50000, 1000000 };
+
+struct HandleSet {
+    const char* pattern;
+    std::vector<uint64_t> handles; // distinct
+    std::vector<uint64_t> absent;  // as many, none of them in handles
+};
+
+static HandleSet makeHandles(size_t count, bool consecutive)
+{
+    HandleSet set;
+    set.pattern = consecutive ? "consecutive" : "random";
+    std::mt19937_64 random(24);
+    if (consecutive) {
+        for (size_t i = 0; i < count; i++) {
+            set.handles.push_back(0x2A0 + i);
+            set.absent.push_back(0x2A0 + count + i);
+        }
+        return set;
+    }
+    std::unordered_map<uint64_t, uint32_t> seen;
+    while (set.handles.size() < count) {
+        uint64_t handle = random();
+        if (seen.emplace(handle, 0).second) {
+            set.handles.push_back(handle);
+        }
+    }
+    while (set.absent.size() < count) {
+        uint64_t handle = random();
+        if (seen.emplace(handle, 0).second) {
+            set.absent.push_back(handle);
+        }
+    }
+    return set;
+}
+
+// Adds the handles to index and checks it against reference as it goes.
+static bool addAndCompare(const HandleSet& set, HandleIndex& index, const char* what)
+{
+    std::unordered_map<uint64_t, uint32_t> reference;
+    size_t slotCount = index.slotCount();
+    bool reserved = slotCount > 0;
+    for (size_t i = 0; i < set.handles.size(); i++) {
+        uint64_t handle = set.handles[i];
+        auto inserted = reference.emplace(handle, (uint32_t)reference.size());
+        bool added;
+        uint32_t entry = index.findOrAdd(handle, added);
+        if (added != inserted.second || entry != inserted.first->second) {
+            fprintf(stderr, "handlebench: %s, %s: handle %llX is entry %u (added %d), expected %u (added %d)\n", set.pattern, what,
+                (unsigned long long)handle, entry, (int)added, inserted.first->second, (int)inserted.second);
+            return false;
+        }
+        // a handle from earlier on, again.
+        if (i % 3 == 2) {
+            uint64_t again = set.handles[i / 2];
+            if (index.findOrAdd(again, added) != reference[again] || added) {
+                fprintf(stderr, "handlebench: %s, %s: adding handle %llX again adds it\n", set.pattern, what, (unsigned long long)again);
+                return false;
+            }
+        }
+    }
+    if (reserved && index.slotCount() != slotCount) {
+        fprintf(stderr, "handlebench: %s, %s: the reserved index grew from %zu to %zu slots\n", set.pattern, what, slotCount, index.slotCount());
+        return false;
+    }
+    if (index.count() != reference.size()) {
+        fprintf(stderr, "handlebench: %s, %s: %zu entries, expected %zu\n", set.pattern, what, index.count(), reference.size());
+        return false;
+    }
+    for (uint64_t handle : set.handles) {
+        uint32_t entry = index.find(handle);
+        if (entry != reference[handle] || index.handle(entry) != handle) {
+            fprintf(stderr, "handlebench: %s, %s: handle %llX is not found as entry %u\n", set.pattern, what, (unsigned long long)handle, reference[handle]);
+            return false;
+        }
+    }
+    for (uint64_t handle : set.absent) {
+        if (index.find(handle) != HandleIndex::npos) {
+            fprintf(stderr, "handlebench: %s, %s: handle %llX is found, but was never added\n", set.pattern, what, (unsigned long long)handle);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool checkFormatting(const std::vector<uint64_t>& handles)
+{
+    std::vector<uint64_t> values(handles.begin(), handles.begin() + std::min(handles.size(), (size_t)10000));
+    values.push_back(0);
+    values.push_back(0xF);
+    values.push_back(0x10);
+    values.push_back(0xFFFFFFFFFFFFFFFFull);
+    for (uint64_t handle : values) {
+        char expected[32];
+        snprintf(expected, sizeof(expected), "%llX", (unsigned long long)handle);
+        char text[handleTextSize];
+        wchar_t wideText[handleTextSize];
+        size_t length = formatHandle(handle, text);
+        size_t wideLength = formatHandle(handle, wideText);
+        bool sameWide = wideLength == length;
+        for (size_t i = 0; sameWide && i <= length; i++) {
+            sameWide = wideText[i] == (wchar_t)text[i];
+        }
+        if (strcmp(text, expected) != 0 || length != strlen(expected) || !sameWide || HandleText(handle).length() != length) {
+            fprintf(stderr, "handlebench: handle %s is formatted as %s\n", expected, text);
+            return false;
+        }
+        std::string lowerCase(text);
+        for (char& c : lowerCase) {
+            c = (char)tolower((unsigned char)c);
+        }
+        uint64_t parsed = handle + 1;
+        uint64_t parsedLowerCase = handle + 1;
+        if (!parseHandle(text, parsed) || parsed != handle || !parseHandle(lowerCase, parsedLowerCase) || parsedLowerCase != handle) {
+            fprintf(stderr, "handlebench: handle %s does not parse back\n", expected);
+            return false;
+        }
+    }
+    static const char* const rejected[] = { "", "10000000000000000", "G", "-1", " 1", "1 ", "0x1F", "2A0g" };
+    for (const char* text : rejected) {
+        uint64_t handle;
+        if (parseHandle(text, handle)) {
+            fprintf(stderr, "handlebench: \"%s\" is parsed as a handle\n", text);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool runChecks()
+{
+    for (size_t count : handleCounts) {
+        for (bool consecutive : { true, false }) {
+            HandleSet set = makeHandles(count, consecutive);
+            HandleIndex growing;
+            HandleIndex reserved;
+            reserved.reserve(count);
+            if (!addAndCompare(set, growing, "growing") || !addAndCompare(set, reserved, "reserved") || !checkFormatting(set.handles)) {
+                return false;
+            }
+            growing.clear();
+            bool added;
+            if (growing.count() != 0 || growing.find(set.handles[0]) != HandleIndex::npos
+                || growing.findOrAdd(set.handles[1], added) != 0 || !added) {
+                fprintf(stderr, "handlebench: %s: the index is not empty after clear()\n", set.pattern);
+                return false;
+            }
+            printf("%zu %s handles: the same entries as std::unordered_map, growing and reserved (%zu slots), hits and misses\n",
+                count, set.pattern, reserved.slotCount());
+        }
+    }
+    return true;
+}
+
+
+typedef std::chrono::steady_clock Clock;
+
+// keeps the results of the timed loops alive.
+static volatile size_t sink;
+
+// Runs step (which handles count handles) until 50 ms have passed, and
+// returns the time per handle in ns.
+static double nanosecondsPerHandle(size_t count, const std::function<size_t()>& step)
+{
+    size_t repetitions = 0;
+    Clock::time_point startTime = Clock::now();
+    double seconds;
+    do {
+        sink = sink + step();
+        repetitions++;
+        seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    } while (seconds < 0.05);
+    return seconds * 1.0e9 / repetitions / count;
+}
+
+static bool timeIndexes()
+{
+    printf("%-8s %-12s %-10s %10s %10s %10s\n", "handles", "pattern", "table", "add ns", "hit ns", "miss ns");
+    for (size_t count : handleCounts) {
+        for (bool consecutive : { true, false }) {
+            HandleSet set = makeHandles(count, consecutive);
+
+            HandleIndex index;
+            double indexAdd = nanosecondsPerHandle(count, [&]() {
+                HandleIndex fresh;
+                bool added;
+                for (uint64_t handle : set.handles) {
+                    fresh.findOrAdd(handle, added);
+                }
+                return fresh.count();
+            });
+            bool added;
+            for (uint64_t handle : set.handles) {
+                index.findOrAdd(handle, added);
+            }
+            double indexHit = nanosecondsPerHandle(count, [&]() {
+                size_t sum = 0;
+                for (uint64_t handle : set.handles) {
+                    sum += index.find(handle);
+                }
+                return sum;
+            });
+            double indexMiss = nanosecondsPerHandle(count, [&]() {
+                size_t misses = 0;
+                for (uint64_t handle : set.absent) {
+                    misses += index.find(handle) == HandleIndex::npos;
+                }
+                return misses;
+            });
+            printf("%-8zu %-12s %-10s %10.1f %10.1f %10.1f\n", count, set.pattern, "HandleIndex", indexAdd, indexHit, indexMiss);
+
+            std::unordered_map<uint64_t, uint32_t> map;
+            double mapAdd = nanosecondsPerHandle(count, [&]() {
+                std::unordered_map<uint64_t, uint32_t> fresh;
+                for (uint64_t handle : set.handles) {
+                    fresh.emplace(handle, (uint32_t)fresh.size());
+                }
+                return fresh.size();
+            });
+            for (uint64_t handle : set.handles) {
+                map.emplace(handle, (uint32_t)map.size());
+            }
+            double mapHit = nanosecondsPerHandle(count, [&]() {
+                size_t sum = 0;
+                for (uint64_t handle : set.handles) {
+                    sum += map.find(handle)->second;
+                }
+                return sum;
+            });
+            double mapMiss = nanosecondsPerHandle(count, [&]() {
+                size_t misses = 0;
+                for (uint64_t handle : set.absent) {
+                    misses += map.find(handle) == map.end();
+                }
+                return misses;
+            });
+            printf("%-8zu %-12s %-10s %10.1f %10.1f %10.1f\n", count, set.pattern, "unordered", mapAdd, mapHit, mapMiss);
+            fflush(stdout);
+        }
+    }
+
+    HandleSet set = makeHandles(handleCounts[0], true);
+    double formatted = nanosecondsPerHandle(set.handles.size(), [&]() {
+        size_t length = 0;
+        char text[handleTextSize];
+        for (uint64_t handle : set.handles) {
+            length += formatHandle(handle, text);
+        }
+        return length;
+    });
+    double printed = nanosecondsPerHandle(set.handles.size(), [&]() {
+        size_t length = 0;
+        char text[handleTextSize];
+        for (uint64_t handle : set.handles) {
+            length += (size_t)snprintf(text, sizeof(text), "%llX", (unsigned long long)handle);
+        }
+        return length;
+    });
+    printf("formatHandle %.1f ns, snprintf %.1f ns per handle\n", formatted, printed);
+    return true;
+}
+
+struct Step {
+    const char* name;
+    bool (*run)();
+};
+
+static const Step steps[] = {
+    { "check", runChecks },
+    { "time", timeIndexes },
+};
+
+int main(int argc, char** argv)
+{
+    const char* stepName = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--step") == 0 && i + 1 < argc) {
+            stepName = argv[++i];
+        } else {
+            fprintf(stderr, "usage: handlebench [--step check|time]\n");
+            return 2;
+        }
+    }
+
+    printf("probes with %s\n", HandleIndex::simdProbe ? "SSE2" : "a byte loop (no SSE2)");
+    bool found = false;
+    for (const Step& step : steps) {
+        if (stepName != NULL && strcmp(stepName, step.name) != 0) {
+            continue;
+        }
+        found = true;
+        if (!step.run()) {
+            return 1;
+        }
+    }
+    if (!found) {
+        fprintf(stderr, "handlebench: unknown step %s\n", stepName);
+        return 2;
+    }
+    return 0;
+}
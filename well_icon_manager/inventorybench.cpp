@@ -0,0 +1,279 @@
+// inventorybench: analyzeWellInventory() (see well_inventory.h) on synthetic
+// inventories of 50k and 200k well icons, as WELLSCAN gathers them.
+//
+// The icons are of six well types, four of them dynamic with a visibility
+// state (8 values) and a size (4 values), in model space and two layouts,
+// each with WELL_ID, DEPTH and DATE attributes.  Every 97th icon has an
+// empty DEPTH, every 131st has no DATE, and every 500th is put at the
+// position of the icon 250 before it, off by far less than the tolerance.
+//
+//   check    the analysis with one batch on one thread must find exactly
+//            those issues, and a group per state; the analyses with batches
+//            of 1, 7, 1000, 4096 (the default) and 65536 icons on the pool
+//            must give the same well types, groups, group of every icon and
+//            issues, in the same order
+//   time     the analysis with the default batch size on the pool, and the
+//            formatting of its report, repeated for at least 50 ms
+//
+// --threads sets the size of the pool (0, the default, for one thread per
+// core).  WELLSCAN's scan of the drawing is not covered: it needs AutoCAD,
+// and the command prints its own times.
+//
+// This is a standalone program; it does not link against ObjectARX:
+//
+//     g++ -std=c++17 -O2 inventorybench.cpp well_inventory.cpp work_stealing_pool.cpp handle_index.cpp -pthread -o inventorybench
+//
+// usage: inventorybench [--step check|time] [--threads <n>]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+#include "well_inventory.h"
+#include "work_stealing_pool.h"
+
+
+static const uint32_t iconCounts[] = { 50000, 200000 };
+
+struct ExpectedIssues {
+    size_t emptyAttributes;
+    size_t missingAttributes;
+    size_t coincidentIcons;
+};
+
+static void makeInventory(uint32_t iconCount, WellInventory& inventory, ExpectedIssues& expected)
+{
+    static const wchar_t* const wellTypes[] = {
+        L"injectionWell", L"monitoringWell", L"remediationWell", L"extractionWell", // dynamic
+        L"abandonedWell", L"piezometer",
+    };
+    static const wchar_t* const spaces[] = { L"*Model_Space", L"*Paper_Space", L"*Paper_Space0" };
+    std::mt19937 random(23);
+    inventory.clear();
+    inventory.reserve(iconCount, 5 * (size_t)iconCount);
+    inventory.blockCount = 9;
+    inventory.layoutCount = 3;
+    expected = ExpectedIssues{ 0, 0, 0 };
+    wchar_t text[32];
+    for (uint32_t i = 0; i < iconCount; i++) {
+        uint32_t type = random() % 6;
+        uint32_t space = i % 3;
+        double position[3] = { (i % 1000) * 5.0, (i / 1000) * 5.0, 0.0 };
+        if (i % 500 == 0 && i > 0) {
+            const WellIcon& earlier = inventory.icons[i - 250];
+            space = (i - 250) % 3;
+            position[0] = earlier.position[0] + 1e-9;
+            position[1] = earlier.position[1];
+            expected.coincidentIcons++;
+        }
+        inventory.addIcon(0x1000 + i, inventory.intern(spaces[space]), inventory.intern(wellTypes[type]), position, 0.0);
+
+        swprintf(text, sizeof(text) / sizeof(text[0]), L"W%u", i);
+        inventory.addAttribute(L"WELL_ID", text);
+        if (i % 97 == 0) {
+            inventory.addAttribute(L"DEPTH", L"");
+            expected.emptyAttributes++;
+        } else {
+            swprintf(text, sizeof(text) / sizeof(text[0]), L"%u.5", 10 + random() % 90);
+            inventory.addAttribute(L"DEPTH", text);
+        }
+        if (i % 131 == 0) {
+            expected.missingAttributes++;
+        } else {
+            swprintf(text, sizeof(text) / sizeof(text[0]), L"2024-%02u-01", 1 + random() % 12);
+            inventory.addAttribute(L"DATE", text);
+        }
+        if (type < 4) {
+            swprintf(text, sizeof(text) / sizeof(text[0]), L"state %u", random() % 8);
+            inventory.addProperty(L"Visibility", text);
+            swprintf(text, sizeof(text) / sizeof(text[0]), L"%u", random() % 4);
+            inventory.addProperty(L"Size", text);
+        }
+    }
+}
+
+static bool sameAnalysis(const WellInventoryAnalysis& a, const WellInventoryAnalysis& b)
+{
+    if (a.wellTypes.size() != b.wellTypes.size() || a.groups.size() != b.groups.size()
+        || a.groupOfIcon != b.groupOfIcon || a.issues.size() != b.issues.size()) {
+        return false;
+    }
+    for (size_t t = 0; t < a.wellTypes.size(); t++) {
+        const WellTypeSummary& x = a.wellTypes[t];
+        const WellTypeSummary& y = b.wellTypes[t];
+        if (x.wellType != y.wellType || x.icons != y.icons || x.groups != y.groups) {
+            return false;
+        }
+    }
+    for (size_t g = 0; g < a.groups.size(); g++) {
+        const WellIconGroup& x = a.groups[g];
+        const WellIconGroup& y = b.groups[g];
+        if (x.wellType != y.wellType || x.firstIcon != y.firstIcon || x.icons != y.icons) {
+            return false;
+        }
+    }
+    for (size_t k = 0; k < a.issues.size(); k++) {
+        const WellIconIssue& x = a.issues[k];
+        const WellIconIssue& y = b.issues[k];
+        if (x.kind != y.kind || x.icon != y.icon || x.detail != y.detail) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool expectCount(uint32_t iconCount, const char* what, size_t count, size_t expected)
+{
+    if (count != expected) {
+        fprintf(stderr, "inventorybench: %u icons: %s: %zu, expected %zu\n", iconCount, what, count, expected);
+        return false;
+    }
+    return true;
+}
+
+static bool checkAnalysis(uint32_t iconCount, WorkStealingPool& pool)
+{
+    WellInventory inventory;
+    ExpectedIssues expected;
+    makeInventory(iconCount, inventory, expected);
+
+    WorkStealingPool serialPool(1);
+    WellInventoryAnalysis reference;
+    analyzeWellInventory(inventory, serialPool, reference, iconCount);
+    size_t counts[3] = { 0, 0, 0 };
+    for (const WellIconIssue& issue : reference.issues) {
+        counts[issue.kind]++;
+    }
+    size_t groupedIcons = 0;
+    for (const WellIconGroup& group : reference.groups) {
+        groupedIcons += group.icons;
+    }
+    // 8 x 4 states of each dynamic type, one of each other.
+    bool passed = expectCount(iconCount, "empty attributes", counts[kEmptyAttribute], expected.emptyAttributes)
+        && expectCount(iconCount, "missing attributes", counts[kMissingAttribute], expected.missingAttributes)
+        && expectCount(iconCount, "coincident icons", counts[kCoincidentIcon], expected.coincidentIcons)
+        && expectCount(iconCount, "well types", reference.wellTypes.size(), 6)
+        && expectCount(iconCount, "groups", reference.groups.size(), 4 * 32 + 2)
+        && expectCount(iconCount, "icons in the groups", groupedIcons, iconCount);
+    for (const WellIconIssue& issue : reference.issues) {
+        if (issue.kind == kCoincidentIcon && (issue.detail != issue.icon - 250 || issue.icon % 500 != 0)) {
+            fprintf(stderr, "inventorybench: %u icons: icon %u is reported at the position of icon %u\n", iconCount, issue.icon, issue.detail);
+            return false;
+        }
+    }
+    if (!passed) {
+        return false;
+    }
+
+    static const size_t batchSizes[] = { 1, 7, 1000, 4096, 65536 };
+    for (size_t batchSize : batchSizes) {
+        WellInventoryAnalysis analysis;
+        analyzeWellInventory(inventory, pool, analysis, batchSize);
+        if (!sameAnalysis(analysis, reference)) {
+            fprintf(stderr, "inventorybench: %u icons: the analysis in batches of %zu on %u threads differs from the serial one\n",
+                iconCount, batchSize, pool.threadCount());
+            return false;
+        }
+    }
+    printf("%u icons: %zu groups, %zu empty, %zu missing and %zu coincident; the same in batches of 1 to 65536 on %u threads\n",
+        iconCount, reference.groups.size(), counts[kEmptyAttribute], counts[kMissingAttribute], counts[kCoincidentIcon], pool.threadCount());
+    return true;
+}
+
+static bool runChecks(WorkStealingPool& pool)
+{
+    for (uint32_t iconCount : iconCounts) {
+        if (!checkAnalysis(iconCount, pool)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+typedef std::chrono::steady_clock Clock;
+
+// Runs step at least once and until 50 ms have passed, and returns the time
+// per run in seconds.
+static double secondsPerRun(const std::function<void()>& step)
+{
+    size_t repetitions = 0;
+    Clock::time_point startTime = Clock::now();
+    double seconds;
+    do {
+        step();
+        repetitions++;
+        seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    } while (seconds < 0.05);
+    return seconds / repetitions;
+}
+
+static bool timeAnalysis(WorkStealingPool& pool)
+{
+    printf("%-8s %8s %12s %12s %10s\n", "icons", "threads", "analysis ms", "report ms", "ns/icon");
+    for (uint32_t iconCount : iconCounts) {
+        WellInventory inventory;
+        ExpectedIssues expected;
+        makeInventory(iconCount, inventory, expected);
+        WellInventoryAnalysis analysis;
+        double analysisSeconds = secondsPerRun([&]() {
+            analyzeWellInventory(inventory, pool, analysis);
+        });
+        std::wstring text;
+        double reportSeconds = secondsPerRun([&]() {
+            text.clear();
+            formatWellInventory(inventory, analysis, 50, text);
+        });
+        printf("%-8u %8u %12.2f %12.2f %10.1f\n", iconCount, pool.threadCount(),
+            analysisSeconds * 1.0e3, reportSeconds * 1.0e3, analysisSeconds * 1.0e9 / iconCount);
+        fflush(stdout);
+    }
+    return true;
+}
+
+struct Step {
+    const char* name;
+    bool (*run)(WorkStealingPool& pool);
+};
+
+static const Step steps[] = {
+    { "check", runChecks },
+    { "time", timeAnalysis },
+};
+
+int main(int argc, char** argv)
+{
+    const char* stepName = NULL;
+    unsigned threadCount = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--step") == 0 && i + 1 < argc) {
+            stepName = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threadCount = (unsigned)atol(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: inventorybench [--step check|time] [--threads <n>]\n");
+            return 2;
+        }
+    }
+
+    WorkStealingPool pool(threadCount);
+    bool found = false;
+    for (const Step& step : steps) {
+        if (stepName != NULL && strcmp(stepName, step.name) != 0) {
+            continue;
+        }
+        found = true;
+        if (!step.run(pool)) {
+            return 1;
+        }
+    }
+    if (!found) {
+        fprintf(stderr, "inventorybench: unknown step %s\n", stepName);
+        return 2;
+    }
+    return 0;
+}
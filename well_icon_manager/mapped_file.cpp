@@ -0,0 +1,118 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+#ifdef _WIN32
+
+MappedFile::MappedFile() : pData(NULL), length(0), fileHandle(INVALID_HANDLE_VALUE), mappingHandle(NULL) {}
+
+bool MappedFile::open(const char* path)
+{
+    close();
+    fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize)) {
+        close();
+        return false;
+    }
+    length = (size_t)fileSize.QuadPart;
+    if (length == 0) {
+        // CreateFileMapping refuses to map an empty file.
+        return true;
+    }
+    mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mappingHandle == NULL) {
+        close();
+        return false;
+    }
+    pData = (const char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if (pData == NULL) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (pData != NULL) { UnmapViewOfFile(pData); }
+    if (mappingHandle != NULL) { CloseHandle(mappingHandle); }
+    if (fileHandle != INVALID_HANDLE_VALUE) { CloseHandle(fileHandle); }
+    pData = NULL;
+    length = 0;
+    mappingHandle = NULL;
+    fileHandle = INVALID_HANDLE_VALUE;
+}
+
+bool MappedFile::isOpen() const
+{
+    return fileHandle != INVALID_HANDLE_VALUE;
+}
+
+#else
+
+MappedFile::MappedFile() : pData(NULL), length(0), fileDescriptor(-1) {}
+
+bool MappedFile::open(const char* path)
+{
+    close();
+    fileDescriptor = ::open(path, O_RDONLY);
+    if (fileDescriptor < 0) {
+        return false;
+    }
+    struct stat fileStatus;
+    if (fstat(fileDescriptor, &fileStatus) != 0) {
+        close();
+        return false;
+    }
+    length = (size_t)fileStatus.st_size;
+    if (length == 0) {
+        // mmap refuses to map an empty file.
+        return true;
+    }
+    void* mapping = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    if (mapping == MAP_FAILED) {
+        close();
+        return false;
+    }
+    // we always scan front to back, so let the kernel read ahead aggressively.
+    madvise(mapping, length, MADV_SEQUENTIAL);
+    pData = (const char*)mapping;
+    // the mapping outlives the descriptor; closing it lets a tool keep
+    // thousands of files mapped without running out of descriptors.
+    ::close(fileDescriptor);
+    fileDescriptor = -1;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (pData != NULL) { munmap((void*)pData, length); }
+    if (fileDescriptor >= 0) { ::close(fileDescriptor); }
+    pData = NULL;
+    length = 0;
+    fileDescriptor = -1;
+}
+
+bool MappedFile::isOpen() const
+{
+    return pData != NULL || fileDescriptor >= 0;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
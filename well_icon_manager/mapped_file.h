@@ -0,0 +1,37 @@
+#pragma once
+
+// Read-only memory mapping of a whole file.  Used by the headless tools to
+// scan large drawings without copying them into memory first.
+
+#include <stddef.h>
+#include <string_view>
+
+class MappedFile {
+    private:
+        const char* pData;
+        size_t length;
+#ifdef _WIN32
+        void* fileHandle;
+        void* mappingHandle;
+#else
+        int fileDescriptor;
+#endif
+
+    public:
+        MappedFile();
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // Maps the file at path.  Returns false (and leaves the object
+        // closed) if the file cannot be opened or mapped.  An empty file
+        // maps successfully to an empty view.
+        bool open(const char* path);
+        void close();
+
+        bool isOpen() const;
+        const char* data() const { return pData; }
+        size_t size() const { return length; }
+        std::string_view view() const { return std::string_view(pData, length); }
+};
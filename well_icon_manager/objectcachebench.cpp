@@ -0,0 +1,223 @@
+// objectcachebench: OpenObjectCache (see open_object_cache.h) over the
+// stand-in object store (see open_object_cache_standin.h).
+//
+//   check    the walk initApp() does of a block's extension dictionary: 200
+//            items, each opened and then followed up its chain of ownership
+//            (the dictionary, the block table record, the block table), with
+//            the block table record already open for read by the caller.
+//            The 800 requests must reach the store for the 200 items and the
+//            dictionary and block table only, the record being shared (203
+//            host opens, 597 avoided), and when the cache goes out of scope
+//            every object it opened must be closed again, leaving only the
+//            caller's record open.  closeAll() must close the same way in
+//            mid-scope, and an id that cannot be opened must be asked of the
+//            store once
+//   time     random requests for --objects objects, all of them held by the
+//            cache, in ns per request, repeated for at least 50 ms
+//
+// This is a standalone program; it does not link against ObjectARX:
+//
+//     g++ -std=c++17 -O2 objectcachebench.cpp open_object_cache_standin.cpp -o objectcachebench
+//
+// usage: objectcachebench [--step check|time] [--objects <n>]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <vector>
+#include "open_object_cache_standin.h"
+
+
+static bool expectCount(const char* what, size_t count, size_t expected)
+{
+    if (count != expected) {
+        fprintf(stderr, "objectcachebench: %s: %zu, expected %zu\n", what, count, expected);
+        return false;
+    }
+    return true;
+}
+
+static const uint64_t blockTableId = 1;
+static const uint64_t blockTableRecordId = 2;
+static const uint64_t dictionaryId = 3;
+static const uint64_t firstItemId = 100;
+
+// Opens every item and the owners up its chain through cache, as initApp()
+// does; returns the number of requests.
+static size_t walkItems(StandInObjectCache& cache, size_t itemCount)
+{
+    size_t requests = 0;
+    for (size_t i = 0; i < itemCount; i++) {
+        StandInObject* pObject = cache.open(firstItemId + i);
+        requests++;
+        while (pObject != NULL && pObject->ownerId != 0) {
+            pObject = cache.open(pObject->ownerId);
+            requests++;
+        }
+    }
+    return requests;
+}
+
+static bool runChecks(size_t)
+{
+    const size_t itemCount = 200;
+    StandInObjectStore store;
+    store.add(blockTableId, 0, "AcDbBlockTable");
+    store.add(blockTableRecordId, blockTableId, "AcDbBlockTableRecord");
+    store.add(dictionaryId, blockTableRecordId, "AcDbDictionary");
+    for (size_t i = 0; i < itemCount; i++) {
+        store.add(firstItemId + i, dictionaryId, "AcDbXrecord");
+    }
+
+    // the caller's own open of the record, as initApp() holds it.
+    StandInObject* pRecord = store.open(blockTableRecordId);
+    size_t requests;
+    {
+        StandInObjectCache cache(&store);
+        requests = walkItems(cache, itemCount);
+        bool passed = expectCount("requests", cache.requests(), requests)
+            && expectCount("requests of the walk", requests, 4 * itemCount)
+            && expectCount("host opens", cache.hostOpens(), itemCount + 3)
+            && expectCount("opens avoided", cache.opensAvoided(), 3 * itemCount - 3)
+            && expectCount("objects held", cache.openCount(), itemCount + 3)
+            // the record is shared, not opened again.
+            && expectCount("opens of the store", store.opens(), 1 + itemCount + 2)
+            && expectCount("objects open in the store", store.openObjectCount(), itemCount + 3)
+            && expectCount("readers of the record", (size_t)pRecord->readerCount, 1);
+        if (!passed) {
+            return false;
+        }
+
+        // closeAll() in mid-scope, then the walk again: everything is
+        // opened anew, and the counters go on.
+        cache.closeAll();
+        passed = expectCount("objects open after closeAll()", store.openObjectCount(), 1)
+            && expectCount("closes after closeAll()", store.closes(), itemCount + 2)
+            && expectCount("objects held after closeAll()", cache.openCount(), 0);
+        walkItems(cache, itemCount);
+        passed = passed
+            && expectCount("host opens after a second walk", cache.hostOpens(), 2 * (itemCount + 3))
+            && expectCount("opens of the store after a second walk", store.opens(), 1 + 2 * (itemCount + 2));
+
+        // an id that cannot be opened is not retried.
+        size_t hostOpens = cache.hostOpens();
+        for (int i = 0; i < 3; i++) {
+            if (cache.open(999999) != NULL) {
+                fprintf(stderr, "objectcachebench: a missing object is opened\n");
+                return false;
+            }
+        }
+        passed = passed && expectCount("host opens of a missing object", cache.hostOpens() - hostOpens, 1);
+        if (!passed) {
+            return false;
+        }
+    }
+
+    // out of scope: only the caller's record is still open.
+    bool passed = expectCount("objects open after the scope", store.openObjectCount(), 1)
+        && expectCount("readers of the record after the scope", (size_t)pRecord->readerCount, 1)
+        && expectCount("unclosed opens of the store after the scope", store.opens() - store.closes(), 1);
+    if (!passed) {
+        return false;
+    }
+    store.close(pRecord);
+    printf("%zu items: %zu requests, %zu host opens, %zu avoided (%zu opens without the cache); what the cache opened is closed at the end of the scope\n",
+        itemCount, requests, itemCount + 3, requests - (itemCount + 3), requests);
+    return true;
+}
+
+
+typedef std::chrono::steady_clock Clock;
+
+// Runs step at least once and until 50 ms have passed, and returns the time
+// per run in seconds.
+static double secondsPerRun(const std::function<void()>& step)
+{
+    size_t repetitions = 0;
+    Clock::time_point startTime = Clock::now();
+    double seconds;
+    do {
+        step();
+        repetitions++;
+        seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    } while (seconds < 0.05);
+    return seconds / repetitions;
+}
+
+static bool timeRequests(size_t objectCount)
+{
+    StandInObjectStore store;
+    for (size_t i = 0; i < objectCount; i++) {
+        store.add(firstItemId + i, 0, "AcDbXrecord");
+    }
+    StandInObjectCache cache(&store);
+    for (size_t i = 0; i < objectCount; i++) {
+        cache.open(firstItemId + i);
+    }
+    std::mt19937 random(22);
+    std::vector<uint64_t> ids(1 << 16);
+    for (uint64_t& id : ids) {
+        id = firstItemId + random() % objectCount;
+    }
+    size_t found = 0;
+    double seconds = secondsPerRun([&]() {
+        for (uint64_t id : ids) {
+            found += cache.open(id) != NULL;
+        }
+    });
+    if (found == 0 || store.opens() != objectCount) {
+        fprintf(stderr, "objectcachebench: the requests reached the store\n");
+        return false;
+    }
+    printf("%zu objects held: %.1f ns per request\n", objectCount, seconds * 1.0e9 / ids.size());
+    return true;
+}
+
+struct Step {
+    const char* name;
+    bool (*run)(size_t objectCount);
+};
+
+static const Step steps[] = {
+    { "check", runChecks },
+    { "time", timeRequests },
+};
+
+int main(int argc, char** argv)
+{
+    const char* stepName = NULL;
+    size_t objectCount = 100000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--step") == 0 && i + 1 < argc) {
+            stepName = argv[++i];
+        } else if (strcmp(argv[i], "--objects") == 0 && i + 1 < argc) {
+            objectCount = (size_t)atol(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: objectcachebench [--step check|time] [--objects <n>]\n");
+            return 2;
+        }
+    }
+    if (objectCount == 0) {
+        fprintf(stderr, "objectcachebench: --objects must be at least 1\n");
+        return 2;
+    }
+
+    bool found = false;
+    for (const Step& step : steps) {
+        if (stepName != NULL && strcmp(stepName, step.name) != 0) {
+            continue;
+        }
+        found = true;
+        if (!step.run(objectCount)) {
+            return 1;
+        }
+    }
+    if (!found) {
+        fprintf(stderr, "objectcachebench: unknown step %s\n", stepName);
+        return 2;
+    }
+    return 0;
+}
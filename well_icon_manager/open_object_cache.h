@@ -0,0 +1,87 @@
+#pragma once
+
+// Opening objects for read at most once within a scope, typically a command:
+// every object asked for is opened the first time and then kept open, and
+// the objects are closed together when the cache goes out of scope.  Code
+// that comes back to the same objects (the endpoints of eval-graph edges,
+// the owners up a chain of ownership) then opens each of them once, however
+// often it asks.
+//
+// Modelled on AcDbSmartObjectPointer (dbobjptr2.h): an object that is
+// already open for read when it is asked for is used as it is, and is not
+// closed by the cache.  Only what the cache opened itself is closed.
+//
+// The opening and closing are left to a Host, so that the same cache serves
+// database objects and eval-graph nodes inside AutoCAD (see
+// open_object_cache_arx.h) and a stand-in elsewhere (see
+// open_object_cache_standin.h).  A Host has
+//
+//     typedef ... Id;      // what objects are asked for by
+//     typedef ... Key;     // a hashable form of an Id
+//     typedef ... Object;
+//     Key keyOf(Id id) const;
+//     // NULL if the object cannot be opened; opened tells whether this
+//     // call opened it, i.e. whether it has to be closed.
+//     Object* open(Id id, bool& opened);
+//     void close(Object* pObject);
+
+#include <stddef.h>
+#include <unordered_map>
+
+template <typename Host>
+class OpenObjectCache {
+    public:
+        typedef typename Host::Id Id;
+        typedef typename Host::Key Key;
+        typedef typename Host::Object Object;
+
+    private:
+        struct Entry {
+            Object* pObject; // NULL if the object failed to open
+            bool opened;     // by the cache, which is to close it
+        };
+
+        Host host;
+        std::unordered_map<Key, Entry> entries;
+        size_t requestCount;
+        size_t hostOpenCount;
+
+    public:
+        explicit OpenObjectCache(const Host& host = Host()) : host(host), requestCount(0), hostOpenCount(0) {}
+        ~OpenObjectCache() {
+            closeAll();
+        }
+        OpenObjectCache(const OpenObjectCache&) = delete;
+        OpenObjectCache& operator=(const OpenObjectCache&) = delete;
+
+        // NULL if the object cannot be opened (which is not retried).
+        Object* open(Id id) {
+            requestCount++;
+            auto inserted = entries.emplace(host.keyOf(id), Entry{ NULL, false });
+            if (inserted.second) {
+                hostOpenCount++;
+                inserted.first->second.pObject = host.open(id, inserted.first->second.opened);
+            }
+            return inserted.first->second.pObject;
+        }
+
+        // Closes what the cache opened and forgets everything, e.g. before
+        // some of the objects are to be opened for write.  The counters are
+        // kept.
+        void closeAll() {
+            for (auto& entry : entries) {
+                if (entry.second.pObject != NULL && entry.second.opened) {
+                    host.close(entry.second.pObject);
+                }
+            }
+            entries.clear();
+        }
+
+        // Objects currently held.
+        size_t openCount() const { return entries.size(); }
+        // Calls of open().
+        size_t requests() const { return requestCount; }
+        // Calls of open() that went to the host, and those that did not.
+        size_t hostOpens() const { return hostOpenCount; }
+        size_t opensAvoided() const { return requestCount - hostOpenCount; }
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+// OpenObjectCache (see open_object_cache.h) for the objects of a drawing.
+// Only available inside AutoCAD; see open_object_cache_standin.h elsewhere.
+
+#include <dbmain.h>
+#include <dbobjptr2.h>
+#include "open_object_cache.h"
+
+// Opens database objects for read the way AcDbSmartObjectPointer does, so
+// that an object the caller already has open for read is shared rather than
+// opened again.
+class DatabaseObjectHost {
+    public:
+        typedef AcDbObjectId Id;
+        typedef Adesk::IntDbId Key;
+        typedef AcDbObject Object;
+
+        Key keyOf(AcDbObjectId id) const { return id.asOldId(); }
+        AcDbObject* open(AcDbObjectId id, bool& opened) {
+            AcDbObject* pObject = NULL;
+            opened = false;
+            if (id.isNull() || accessAcDbObjectForRead(pObject, id, opened) != Acad::eOk) {
+                return NULL;
+            }
+            return pObject;
+        }
+        void close(AcDbObject* pObject) { pObject->close(); }
+};
+
+typedef OpenObjectCache<DatabaseObjectHost> DatabaseObjectCache;
@@ -0,0 +1,59 @@
+#include "open_object_cache_standin.h"
+
+
+StandInObjectStore::StandInObjectStore()
+{
+    openCalls = 0;
+    closeCalls = 0;
+}
+
+StandInObject& StandInObjectStore::add(uint64_t id, uint64_t ownerId, const std::string& className)
+{
+    StandInObject& object = objects[id];
+    object.id = id;
+    object.ownerId = ownerId;
+    object.className = className;
+    object.readerCount = 0;
+    return object;
+}
+
+StandInObject* StandInObjectStore::find(uint64_t id)
+{
+    auto found = objects.find(id);
+    return found == objects.end() ? NULL : &found->second;
+}
+
+StandInObject* StandInObjectStore::open(uint64_t id)
+{
+    StandInObject* pObject = find(id);
+    if (pObject != NULL) {
+        openCalls++;
+        pObject->readerCount++;
+    }
+    return pObject;
+}
+
+void StandInObjectStore::close(StandInObject* pObject)
+{
+    closeCalls++;
+    pObject->readerCount--;
+}
+
+size_t StandInObjectStore::openObjectCount() const
+{
+    size_t count = 0;
+    for (const auto& object : objects) {
+        count += object.second.readerCount > 0;
+    }
+    return count;
+}
+
+
+StandInObject* StandInObjectHost::open(uint64_t id, bool& opened)
+{
+    StandInObject* pObject = pStore->find(id);
+    // an object that is already open for read is shared, as
+    // accessAcDbObjectForRead() does.
+    opened = pObject != NULL && pObject->readerCount == 0;
+    return opened ? pStore->open(id) : pObject;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+// A stand-in for the objects of a drawing, for exercising OpenObjectCache
+// (see open_object_cache.h) outside of AutoCAD.  It keeps count of the
+// opens and closes, so that objectcachebench can check that they pair up
+// and see how many opens a cache saved.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include "open_object_cache.h"
+
+struct StandInObject {
+    uint64_t id;
+    uint64_t ownerId; // 0 for none, as AcDbObjectId::kNull
+    std::string className;
+    int readerCount;  // how often it is open for read
+};
+
+class StandInObjectStore {
+    private:
+        std::unordered_map<uint64_t, StandInObject> objects;
+        size_t openCalls;
+        size_t closeCalls;
+
+    public:
+        StandInObjectStore();
+
+        // Adding an id again replaces the object.
+        StandInObject& add(uint64_t id, uint64_t ownerId, const std::string& className);
+
+        // NULL if there is no such object; does not open it.
+        StandInObject* find(uint64_t id);
+        // As acdbOpenObject() for read: NULL if there is no such object.
+        StandInObject* open(uint64_t id);
+        void close(StandInObject* pObject);
+
+        size_t opens() const { return openCalls; }
+        size_t closes() const { return closeCalls; }
+        // Objects that are open at the moment.
+        size_t openObjectCount() const;
+};
+
+// Opens objects of a StandInObjectStore like DatabaseObjectHost (see
+// open_object_cache_arx.h) opens those of a drawing: an object that is
+// already open is shared rather than opened again.
+class StandInObjectHost {
+    private:
+        StandInObjectStore* pStore;
+
+    public:
+        typedef uint64_t Id;
+        typedef uint64_t Key;
+        typedef StandInObject Object;
+
+        explicit StandInObjectHost(StandInObjectStore* pStore) : pStore(pStore) {}
+
+        Key keyOf(uint64_t id) const { return id; }
+        StandInObject* open(uint64_t id, bool& opened);
+        void close(StandInObject* pObject) { pStore->close(pObject); }
+};
+
+class StandInObjectCache : public OpenObjectCache<StandInObjectHost> {
+    public:
+        explicit StandInObjectCache(StandInObjectStore* pStore) : OpenObjectCache<StandInObjectHost>(StandInObjectHost(pStore)) {}
+};
@@ -0,0 +1,46 @@
+#include "polyline_vertices.h"
+#include <wchar.h>
+
+
+void PolylineVertices::clear()
+{
+    x.clear();
+    y.clear();
+    z.clear();
+    bulge.clear();
+    startWidth.clear();
+    endWidth.clear();
+}
+
+void PolylineVertices::reserve(size_t vertexCount)
+{
+    x.reserve(vertexCount);
+    y.reserve(vertexCount);
+    z.reserve(vertexCount);
+    if (hasBulgesAndWidths()) {
+        bulge.reserve(vertexCount);
+        startWidth.reserve(vertexCount);
+        endWidth.reserve(vertexCount);
+    }
+}
+
+void formatPolylineVertices(const PolylineVertices& vertices, std::wstring& out)
+{
+    // a line is about 90 characters for coordinates of a few thousand units.
+    out.reserve(out.size() + 96 * vertices.count());
+    // "%f" of the largest double is 316 characters, six of them make a line.
+    wchar_t line[2048];
+    for (size_t i = 0; i < vertices.count(); i++) {
+        int length;
+        if (vertices.hasBulgesAndWidths()) {
+            length = swprintf(line, sizeof(line) / sizeof(line[0]), L"\nVertex #%zu's location is : %0.3f, %0.3f, %0.3f, bulge %0.3f, widths %0.3f, %0.3f",
+                i, vertices.x[i], vertices.y[i], vertices.z[i], vertices.bulge[i], vertices.startWidth[i], vertices.endWidth[i]);
+        } else {
+            length = swprintf(line, sizeof(line) / sizeof(line[0]), L"\nVertex #%zu's location is : %0.3f, %0.3f, %0.3f",
+                i, vertices.x[i], vertices.y[i], vertices.z[i]);
+        }
+        if (length > 0) {
+            out.append(line, (size_t)length);
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+// The vertices of a polyline (well-field boundaries run to tens of thousands
+// of them), read in one pass into contiguous arrays, one per coordinate --
+// see polyline_vertices_arx.h for reading them out of a drawing.
+//
+// Positions are as the polyline stores them: in the polyline's OCS for
+// AcDbPolyline (with its elevation as z) and AcDb2dPolyline, in WCS for
+// AcDb3dPolyline.  3d polylines have neither bulges nor widths; their
+// bulge and width arrays stay empty.
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+enum PolylineKind {
+    kLightweightPolyline, // AcDbPolyline
+    k2dPolyline,          // AcDb2dPolyline
+    k3dPolyline           // AcDb3dPolyline
+};
+
+struct PolylineVertices {
+    PolylineKind kind = kLightweightPolyline;
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> z;
+    std::vector<double> bulge;
+    std::vector<double> startWidth;
+    std::vector<double> endWidth;
+
+    size_t count() const { return x.size(); }
+    bool hasBulgesAndWidths() const { return kind != k3dPolyline; }
+
+    // Empties the arrays, keeping their capacity.
+    void clear();
+    void reserve(size_t vertexCount);
+    void add(double vertexX, double vertexY, double vertexZ) {
+        x.push_back(vertexX);
+        y.push_back(vertexY);
+        z.push_back(vertexZ);
+    }
+    void add(double vertexX, double vertexY, double vertexZ, double vertexBulge, double vertexStartWidth, double vertexEndWidth) {
+        add(vertexX, vertexY, vertexZ);
+        bulge.push_back(vertexBulge);
+        startWidth.push_back(vertexStartWidth);
+        endWidth.push_back(vertexEndWidth);
+    }
+};
+
+// Appends a line per vertex to out, for printing all of them with a single
+// acutPrintf():
+//
+//     Vertex #0's location is : 1.000, 2.000, 0.000, bulge 0.000, widths 0.000, 0.000
+//
+// (without bulge and widths for 3d polylines).  Each line starts with a
+// newline, as ITERATE has always printed them.
+void formatPolylineVertices(const PolylineVertices& vertices, std::wstring& out);
@@ -0,0 +1,83 @@
+#include "polyline_vertices_arx.h"
+#include <actrans.h>
+#include <dbents.h>
+#include <dbpl.h>
+
+
+static Acad::ErrorStatus readLightweightPolyline(const AcDbPolyline* pPolyline, PolylineVertices& vertices)
+{
+    // the vertices are part of the polyline itself; nothing else is opened.
+    unsigned int vertexCount = pPolyline->numVerts();
+    double elevation = pPolyline->elevation();
+    vertices.kind = kLightweightPolyline;
+    vertices.reserve(vertexCount);
+    for (unsigned int i = 0; i < vertexCount; i++) {
+        AcGePoint2d point;
+        double bulge = 0.0;
+        double startWidth = 0.0;
+        double endWidth = 0.0;
+        pPolyline->getPointAt(i, point);
+        pPolyline->getBulgeAt(i, bulge);
+        pPolyline->getWidthsAt(i, startWidth, endWidth);
+        vertices.add(point.x, point.y, elevation, bulge, startWidth, endWidth);
+    }
+    return Acad::eOk;
+}
+
+static Acad::ErrorStatus read2dPolyline(AcTransaction* pTransaction, const AcDb2dPolyline* pPolyline, PolylineVertices& vertices)
+{
+    vertices.kind = k2dPolyline;
+    AcDbObjectIterator* pVertexIterator = pPolyline->vertexIterator();
+    Acad::ErrorStatus es = Acad::eOk;
+    for (; es == Acad::eOk && !pVertexIterator->done(); pVertexIterator->step()) {
+        AcDbObject* pObject;
+        es = pTransaction->getObject(pObject, pVertexIterator->objectId(), AcDb::kForRead);
+        AcDb2dVertex* pVertex = (es == Acad::eOk) ? AcDb2dVertex::cast(pObject) : NULL;
+        if (pVertex != NULL) {
+            AcGePoint3d position = pVertex->position();
+            vertices.add(position.x, position.y, position.z, pVertex->bulge(), pVertex->startWidth(), pVertex->endWidth());
+        }
+    }
+    delete pVertexIterator;
+    return es;
+}
+
+static Acad::ErrorStatus read3dPolyline(AcTransaction* pTransaction, const AcDb3dPolyline* pPolyline, PolylineVertices& vertices)
+{
+    vertices.kind = k3dPolyline;
+    AcDbObjectIterator* pVertexIterator = pPolyline->vertexIterator();
+    Acad::ErrorStatus es = Acad::eOk;
+    for (; es == Acad::eOk && !pVertexIterator->done(); pVertexIterator->step()) {
+        AcDbObject* pObject;
+        es = pTransaction->getObject(pObject, pVertexIterator->objectId(), AcDb::kForRead);
+        AcDb3dPolylineVertex* pVertex = (es == Acad::eOk) ? AcDb3dPolylineVertex::cast(pObject) : NULL;
+        if (pVertex != NULL) {
+            AcGePoint3d position = pVertex->position();
+            vertices.add(position.x, position.y, position.z);
+        }
+    }
+    delete pVertexIterator;
+    return es;
+}
+
+Acad::ErrorStatus extractPolylineVertices(AcDbObjectId polylineId, PolylineVertices& vertices)
+{
+    vertices.clear();
+    AcTransaction* pTransaction = actrTransactionManager->startTransaction();
+    AcDbObject* pObject;
+    Acad::ErrorStatus es = pTransaction->getObject(pObject, polylineId, AcDb::kForRead);
+    if (es == Acad::eOk) {
+        if (AcDbPolyline::cast(pObject) != NULL) {
+            es = readLightweightPolyline(AcDbPolyline::cast(pObject), vertices);
+        } else if (AcDb2dPolyline::cast(pObject) != NULL) {
+            es = read2dPolyline(pTransaction, AcDb2dPolyline::cast(pObject), vertices);
+        } else if (AcDb3dPolyline::cast(pObject) != NULL) {
+            es = read3dPolyline(pTransaction, AcDb3dPolyline::cast(pObject), vertices);
+        } else {
+            es = Acad::eWrongObjectType;
+        }
+    }
+    // nothing was modified; ending the transaction closes everything it opened.
+    actrTransactionManager->endTransaction();
+    return es;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+// Reading the vertices of a polyline of the drawing into a PolylineVertices
+// (see polyline_vertices.h).  Only available inside AutoCAD.
+
+#include <dbmain.h>
+#include "polyline_vertices.h"
+
+// Reads every vertex of an AcDbPolyline, AcDb2dPolyline or AcDb3dPolyline in
+// a single pass, within one transaction: the vertices of the old-style
+// polylines are opened through the transaction and stay open until it ends,
+// rather than being opened and closed one by one.  Returns
+// Acad::eWrongObjectType if the object is no polyline; vertices is cleared
+// first in any case.
+Acad::ErrorStatus extractPolylineVertices(AcDbObjectId polylineId, PolylineVertices& vertices);
@@ -0,0 +1,297 @@
+#include "resbuf_arena.h"
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <algorithm>
+
+
+ResbufArena::ResbufArena(size_t blockSize)
+{
+    this->blockSize = blockSize;
+    pFirst = NULL;
+    pCurrent = NULL;
+    pCursor = NULL;
+    pEnd = NULL;
+}
+
+ResbufArena::~ResbufArena()
+{
+    Block* pBlock = pFirst;
+    while (pBlock != NULL) {
+        Block* pNext = pBlock->next;
+        free(pBlock);
+        pBlock = pNext;
+    }
+}
+
+// Makes pCurrent a block with at least size bytes of room: the next of the
+// blocks kept by reset() if it is large enough, otherwise a new one.
+bool ResbufArena::advanceToBlockOfSize(size_t size)
+{
+    Block* pNext = (pCurrent != NULL) ? pCurrent->next : pFirst;
+    if (pNext == NULL || pNext->size < size) {
+        size_t dataSize = std::max(blockSize, size);
+        Block* pBlock = (Block*)malloc(sizeof(Block) + dataSize);
+        if (pBlock == NULL) {
+            return false;
+        }
+        pBlock->size = dataSize;
+        pBlock->next = pNext;
+        if (pCurrent != NULL) {
+            pCurrent->next = pBlock;
+        } else {
+            pFirst = pBlock;
+        }
+        pNext = pBlock;
+    }
+    pCurrent = pNext;
+    pCursor = (char*)(pCurrent + 1);
+    pEnd = pCursor + pCurrent->size;
+    return true;
+}
+
+void* ResbufArena::allocate(size_t size, size_t alignment)
+{
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (pCursor != NULL) {
+            uintptr_t address = ((uintptr_t)pCursor + alignment - 1) & ~(uintptr_t)(alignment - 1);
+            if (address + size <= (uintptr_t)pEnd) {
+                pCursor = (char*)address + size;
+                return (void*)address;
+            }
+        }
+        if (!advanceToBlockOfSize(size + alignment)) {
+            return NULL;
+        }
+    }
+    return NULL;
+}
+
+resbuf* ResbufArena::newRb(short restype)
+{
+    resbuf* rb = (resbuf*)allocate(sizeof(resbuf), alignof(resbuf));
+    if (rb != NULL) {
+        memset(rb, 0, sizeof(resbuf));
+        rb->restype = restype;
+    }
+    return rb;
+}
+
+ACHAR* ResbufArena::newString(const ACHAR* text, size_t length)
+{
+    ACHAR* pString = (ACHAR*)allocate((length + 1) * sizeof(ACHAR), alignof(ACHAR));
+    if (pString != NULL) {
+        memcpy(pString, text, length * sizeof(ACHAR));
+        pString[length] = 0;
+    }
+    return pString;
+}
+
+ACHAR* ResbufArena::newString(const ACHAR* text)
+{
+    return newString(text, wcslen(text));
+}
+
+char* ResbufArena::newBinary(const char* bytes, size_t length)
+{
+    char* pBuffer = (char*)allocate(length, 1);
+    if (pBuffer != NULL) {
+        memcpy(pBuffer, bytes, length);
+    }
+    return pBuffer;
+}
+
+resbuf* ResbufArena::copyChain(const resbuf* pChain)
+{
+    resbuf* pHead = NULL;
+    resbuf* pTail = NULL;
+    for (const resbuf* rb = pChain; rb != NULL; rb = rb->rbnext) {
+        resbuf* pCopy = newRb(rb->restype);
+        if (pCopy == NULL) {
+            return NULL;
+        }
+        pCopy->resval = rb->resval;
+        if (resbufHoldsString(rb->restype) && rb->resval.rstring != NULL) {
+            pCopy->resval.rstring = newString(rb->resval.rstring);
+            if (pCopy->resval.rstring == NULL) {
+                return NULL;
+            }
+        } else if (resbufHoldsBinary(rb->restype) && rb->resval.rbinary.buf != NULL) {
+            pCopy->resval.rbinary.buf = newBinary(rb->resval.rbinary.buf, (size_t)std::max<int>(rb->resval.rbinary.clen, 0));
+            if (pCopy->resval.rbinary.buf == NULL) {
+                return NULL;
+            }
+        } else if (rb->restype == RTRESBUF && rb->resval.mnLongPtr != 0) {
+            resbuf* pNested = copyChain((const resbuf*)rb->resval.mnLongPtr);
+            if (pNested == NULL) {
+                return NULL;
+            }
+            pCopy->resval.mnLongPtr = (decltype(pCopy->resval.mnLongPtr))pNested;
+        }
+        if (pTail != NULL) {
+            pTail->rbnext = pCopy;
+        } else {
+            pHead = pCopy;
+        }
+        pTail = pCopy;
+    }
+    return pHead;
+}
+
+resbuf* ResbufArena::toHeapChain(const resbuf* pChain)
+{
+    resbuf* pHead = NULL;
+    resbuf* pTail = NULL;
+    for (const resbuf* rb = pChain; rb != NULL; rb = rb->rbnext) {
+        resbuf* pCopy = acutNewRb(rb->restype);
+        if (pCopy == NULL) {
+            releaseHeapChain(pHead);
+            return NULL;
+        }
+        if (pTail != NULL) {
+            pTail->rbnext = pCopy;
+        } else {
+            pHead = pCopy;
+        }
+        pTail = pCopy;
+
+        if (resbufHoldsString(rb->restype)) {
+            if (rb->resval.rstring != NULL) {
+                pCopy->resval.rstring = resbufNewString(rb->resval.rstring, wcslen(rb->resval.rstring));
+                if (pCopy->resval.rstring == NULL) {
+                    releaseHeapChain(pHead);
+                    return NULL;
+                }
+            }
+        } else if (resbufHoldsBinary(rb->restype)) {
+            pCopy->resval.rbinary.clen = rb->resval.rbinary.clen;
+            if (rb->resval.rbinary.buf != NULL) {
+                pCopy->resval.rbinary.buf = resbufNewBinary(rb->resval.rbinary.buf, (size_t)std::max<int>(rb->resval.rbinary.clen, 0));
+                if (pCopy->resval.rbinary.buf == NULL) {
+                    releaseHeapChain(pHead);
+                    return NULL;
+                }
+            }
+        } else if (rb->restype == RTRESBUF) {
+            if (rb->resval.mnLongPtr != 0) {
+                resbuf* pNested = toHeapChain((const resbuf*)rb->resval.mnLongPtr);
+                if (pNested == NULL) {
+                    releaseHeapChain(pHead);
+                    return NULL;
+                }
+                pCopy->resval.mnLongPtr = (decltype(pCopy->resval.mnLongPtr))pNested;
+            }
+        } else {
+            pCopy->resval = rb->resval;
+        }
+    }
+    return pHead;
+}
+
+void ResbufArena::releaseHeapChain(resbuf* pChain)
+{
+    for (resbuf* rb = pChain; rb != NULL; rb = rb->rbnext) {
+        if (rb->restype == RTRESBUF && rb->resval.mnLongPtr != 0) {
+            releaseHeapChain((resbuf*)rb->resval.mnLongPtr);
+            rb->resval.mnLongPtr = 0;
+        }
+    }
+    acutRelRb(pChain);
+}
+
+void ResbufArena::reset()
+{
+    pCurrent = pFirst;
+    if (pFirst != NULL) {
+        pCursor = (char*)(pFirst + 1);
+        pEnd = pCursor + pFirst->size;
+    } else {
+        pCursor = NULL;
+        pEnd = NULL;
+    }
+}
+
+size_t ResbufArena::bytesReserved() const
+{
+    size_t total = 0;
+    for (const Block* pBlock = pFirst; pBlock != NULL; pBlock = pBlock->next) {
+        total += pBlock->size;
+    }
+    return total;
+}
+
+
+ResbufChainBuilder::ResbufChainBuilder(ResbufArena& arena) : arena(arena)
+{
+    pHead = NULL;
+    pTail = NULL;
+    outOfMemory = false;
+}
+
+resbuf* ResbufChainBuilder::append(short restype)
+{
+    resbuf* rb = arena.newRb(restype);
+    if (rb == NULL) {
+        outOfMemory = true;
+        return NULL;
+    }
+    if (pTail != NULL) {
+        pTail->rbnext = rb;
+    } else {
+        pHead = rb;
+    }
+    pTail = rb;
+    return rb;
+}
+
+resbuf* ResbufChainBuilder::appendString(short restype, const ACHAR* text)
+{
+    ACHAR* pString = arena.newString(text);
+    if (pString == NULL) {
+        outOfMemory = true;
+        return NULL;
+    }
+    resbuf* rb = append(restype);
+    if (rb != NULL) {
+        rb->resval.rstring = pString;
+    }
+    return rb;
+}
+
+resbuf* ResbufChainBuilder::appendReal(short restype, double value)
+{
+    resbuf* rb = append(restype);
+    if (rb != NULL) {
+        rb->resval.rreal = value;
+    }
+    return rb;
+}
+
+resbuf* ResbufChainBuilder::appendPoint(short restype, const double point[3])
+{
+    resbuf* rb = append(restype);
+    if (rb != NULL) {
+        rb->resval.rpoint[0] = point[0];
+        rb->resval.rpoint[1] = point[1];
+        rb->resval.rpoint[2] = point[2];
+    }
+    return rb;
+}
+
+resbuf* ResbufChainBuilder::appendShort(short restype, short value)
+{
+    resbuf* rb = append(restype);
+    if (rb != NULL) {
+        rb->resval.rint = value;
+    }
+    return rb;
+}
+
+resbuf* ResbufChainBuilder::appendLong(short restype, int32_t value)
+{
+    resbuf* rb = append(restype);
+    if (rb != NULL) {
+        rb->resval.rlong = value;
+    }
+    return rb;
+}
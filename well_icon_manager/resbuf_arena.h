@@ -0,0 +1,91 @@
+#pragma once
+
+// Arena allocation of resbuf chains.
+//
+// Chains built with acutNewRb() cost one heap allocation per node and per
+// string, and as many frees again in acutRelRb().  A ResbufArena instead
+// carves nodes and their string and binary values out of large contiguous
+// blocks, and releases everything it handed out at once: reset() rewinds the
+// arena in O(1) and keeps its blocks for the next chain.
+//
+// Arena chains must never be passed to acutRelRb() (or a ResbufWrapper),
+// nor to an API that takes ownership of a chain.  Use toHeapChain() at such
+// a boundary; copyChain() brings a chain returned by the API into the arena.
+
+#include <stddef.h>
+#include <stdint.h>
+#include "arx_host.h"
+
+class ResbufArena {
+    private:
+        struct Block {
+            Block* next;
+            size_t size; // of the data that follows the header
+        };
+
+        size_t blockSize;
+        Block* pFirst;
+        Block* pCurrent;
+        char* pCursor;
+        char* pEnd;
+
+        void* allocate(size_t size, size_t alignment);
+        bool advanceToBlockOfSize(size_t size);
+
+    public:
+        explicit ResbufArena(size_t blockSize = 64 * 1024);
+        ~ResbufArena();
+
+        ResbufArena(const ResbufArena&) = delete;
+        ResbufArena& operator=(const ResbufArena&) = delete;
+
+        // A zeroed node of the given type.  NULL if out of memory, as with
+        // acutNewRb().
+        resbuf* newRb(short restype);
+        ACHAR* newString(const ACHAR* text, size_t length);
+        ACHAR* newString(const ACHAR* text);
+        char* newBinary(const char* bytes, size_t length);
+
+        // Copies a chain, including its strings and binary chunks and the
+        // chains nested in its RTRESBUF nodes, into the arena.  The original
+        // is left alone (release it as usual).
+        resbuf* copyChain(const resbuf* pChain);
+
+        // Copies a chain, nested chains included, into newly allocated heap
+        // nodes that can be handed to the API.  NULL if out of memory.
+        // acutRelRb() does not follow RTRESBUF values, so release the copy
+        // with releaseHeapChain().
+        static resbuf* toHeapChain(const resbuf* pChain);
+        // acutRelRb() of a heap chain and of the chains nested in it.
+        static void releaseHeapChain(resbuf* pChain);
+
+        // Releases every node and value handed out so far.  The blocks are
+        // kept for reuse; nothing is freed before the destructor.
+        void reset();
+
+        size_t bytesReserved() const;
+};
+
+// Appends nodes to a chain allocated in an arena.
+class ResbufChainBuilder {
+    private:
+        ResbufArena& arena;
+        resbuf* pHead;
+        resbuf* pTail;
+        bool outOfMemory;
+
+    public:
+        explicit ResbufChainBuilder(ResbufArena& arena);
+
+        // Each returns the new node, or NULL if out of memory.
+        resbuf* append(short restype);
+        resbuf* appendString(short restype, const ACHAR* text);
+        resbuf* appendReal(short restype, double value);
+        resbuf* appendPoint(short restype, const double point[3]);
+        resbuf* appendShort(short restype, short value);
+        resbuf* appendLong(short restype, int32_t value);
+
+        resbuf* head() const { return pHead; }
+        // Whether an append has failed, leaving the chain incomplete.
+        bool failed() const { return outOfMemory; }
+};
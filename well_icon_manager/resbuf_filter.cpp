@@ -0,0 +1,621 @@
+#include "resbuf_filter.h"
+#include <string.h>
+#include <wchar.h>
+#include <wctype.h>
+
+
+static wchar_t upperOf(wchar_t c)
+{
+    return (wchar_t)towupper((wint_t)c);
+}
+
+// Only for ASCII text; other text is decoded first (see decodeUtf8()).
+static wchar_t upperOf(char c)
+{
+    return (wchar_t)towupper((wint_t)(unsigned char)c);
+}
+
+static bool isAscii(std::string_view text)
+{
+    for (char c : text) {
+        if ((unsigned char)c >= 0x80) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Decodes the UTF-8 text of a DXF file (the encoding since AutoCAD 2007)
+// into wide characters, with surrogate pairs where wchar_t is 16 bits.
+// Malformed sequences decode to U+FFFD.
+static void decodeUtf8(std::string_view text, std::wstring& result)
+{
+    result.clear();
+    const unsigned char* p = (const unsigned char*)text.data();
+    const unsigned char* pEnd = p + text.size();
+    while (p < pEnd) {
+        unsigned long c = *p++;
+        int continuationCount = 0;
+        unsigned long minimum = 0;
+        if (c >= 0xF0 && c <= 0xF4) {
+            c &= 0x07;
+            continuationCount = 3;
+            minimum = 0x10000;
+        } else if (c >= 0xE0 && c <= 0xEF) {
+            c &= 0x0F;
+            continuationCount = 2;
+            minimum = 0x800;
+        } else if (c >= 0xC2 && c <= 0xDF) {
+            c &= 0x1F;
+            continuationCount = 1;
+            minimum = 0x80;
+        } else if (c >= 0x80) {
+            result += (wchar_t)0xFFFD;
+            continue;
+        }
+        int i = 0;
+        for (; i < continuationCount && p < pEnd && (*p & 0xC0) == 0x80; i++) {
+            c = (c << 6) | (*p++ & 0x3F);
+        }
+        if (i < continuationCount || c < minimum || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) {
+            result += (wchar_t)0xFFFD;
+        } else if (sizeof(wchar_t) == 2 && c >= 0x10000) {
+            result += (wchar_t)(0xD800 + ((c - 0x10000) >> 10));
+            result += (wchar_t)(0xDC00 + ((c - 0x10000) & 0x3FF));
+        } else {
+            result += (wchar_t)c;
+        }
+    }
+}
+
+static std::wstring trimmedUpper(const ACHAR* text)
+{
+    std::wstring result;
+    for (const ACHAR* p = text; *p != 0; p++) {
+        if (*p != L' ' && *p != L'\t') {
+            result += upperOf(*p);
+        }
+    }
+    return result;
+}
+
+static std::string narrow(const std::wstring& text)
+{
+    return std::string(text.begin(), text.end());
+}
+
+// Whether the character c (already in upper case) matches the wildcard
+// element at p, which is length characters long.  '*' is handled by the
+// caller.
+static bool elementMatches(const wchar_t* p, const wchar_t* pEnd, wchar_t c, size_t& length)
+{
+    switch (*p) {
+    case L'`':
+        if (p + 1 < pEnd) {
+            length = 2;
+            return c == p[1];
+        }
+        length = 1;
+        return c == L'`';
+    case L'?':
+        length = 1;
+        return true;
+    case L'#':
+        length = 1;
+        return iswdigit((wint_t)c) != 0;
+    case L'@':
+        length = 1;
+        return iswalpha((wint_t)c) != 0;
+    case L'.':
+        length = 1;
+        return iswalnum((wint_t)c) == 0;
+    case L'[': {
+        const wchar_t* q = p + 1;
+        bool negated = (q < pEnd && *q == L'~');
+        if (negated) { q++; }
+        const wchar_t* pClose = q;
+        if (pClose < pEnd) { pClose++; } // a ] right after [ or [~ is a member
+        while (pClose < pEnd && *pClose != L']') { pClose++; }
+        if (pClose == pEnd) {
+            length = 1; // no closing ]: a literal [
+            return c == L'[';
+        }
+        bool member = false;
+        for (; q < pClose; q++) {
+            if (q + 2 < pClose && q[1] == L'-') {
+                member = member || (c >= q[0] && c <= q[2]);
+                q += 2;
+            } else {
+                member = member || (c == *q);
+            }
+        }
+        length = (size_t)(pClose - p) + 1;
+        return member != negated;
+    }
+    default:
+        length = 1;
+        return c == *p;
+    }
+}
+
+template <typename Char>
+static bool wildcardMatch(const wchar_t* p, const wchar_t* pEnd, const Char* t, const Char* tEnd)
+{
+    const wchar_t* pAfterStar = NULL;
+    const Char* tAtStar = NULL;
+    while (t < tEnd) {
+        if (p < pEnd && *p == L'*') {
+            pAfterStar = ++p;
+            tAtStar = t;
+            continue;
+        }
+        size_t length;
+        if (p < pEnd && elementMatches(p, pEnd, upperOf(*t), length)) {
+            p += length;
+            t++;
+            continue;
+        }
+        if (pAfterStar == NULL) {
+            return false;
+        }
+        // let the last * swallow one more character.
+        p = pAfterStar;
+        t = ++tAtStar;
+    }
+    while (p < pEnd && *p == L'*') { p++; }
+    return p == pEnd;
+}
+
+template <typename Char>
+bool ResbufFilter::matchesString(const Test& test, const Char* text, size_t length)
+{
+    if (test.ops[0] == kAny) {
+        return true;
+    }
+    bool matched = false;
+    for (const Pattern& pattern : test.patterns) {
+        bool result;
+        if (pattern.literal) {
+            result = (pattern.text.size() == length);
+            for (size_t i = 0; result && i < length; i++) {
+                result = (upperOf(text[i]) == pattern.text[i]);
+            }
+        } else {
+            const wchar_t* p = pattern.text.data();
+            result = wildcardMatch(p, p + pattern.text.size(), text, text + length);
+        }
+        if (result != pattern.negated) {
+            matched = true;
+            break;
+        }
+    }
+    return (test.ops[0] == kNotEqual) ? !matched : matched;
+}
+
+bool ResbufFilter::compareReal(CompareOp op, double value, double reference)
+{
+    switch (op) {
+    case kAny:          return true;
+    case kEqual:        return value == reference;
+    case kNotEqual:     return value != reference;
+    case kLess:         return value < reference;
+    case kLessEqual:    return value <= reference;
+    case kGreater:      return value > reference;
+    case kGreaterEqual: return value >= reference;
+    default:            return false;
+    }
+}
+
+bool ResbufFilter::compareInteger(CompareOp op, long long value, long long reference)
+{
+    switch (op) {
+    case kBitAnd:       return (value & reference) != 0;
+    case kBitEqual:     return (value & reference) == reference;
+    case kAny:          return true;
+    case kEqual:        return value == reference;
+    case kNotEqual:     return value != reference;
+    case kLess:         return value < reference;
+    case kLessEqual:    return value <= reference;
+    case kGreater:      return value > reference;
+    case kGreaterEqual: return value >= reference;
+    default:            return false;
+    }
+}
+
+ResbufFilter::ResbufFilter()
+{
+}
+
+bool ResbufFilter::fail(const std::string& message)
+{
+    errorMessage = message;
+    tests.clear();
+    program.clear();
+    return false;
+}
+
+bool ResbufFilter::compile(const resbuf* pFilter)
+{
+    tests.clear();
+    program.clear();
+    errorMessage.clear();
+
+    const resbuf* rb = pFilter;
+    uint32_t operandCount;
+    if (!compileOperands(rb, NULL, operandCount)) {
+        return false;
+    }
+    if (operandCount == 0) {
+        program.push_back(Instruction{ kOpTrue, 0 });
+    } else if (operandCount > 1) {
+        program.push_back(Instruction{ kOpAnd, operandCount });
+    }
+    buildIndex();
+    return true;
+}
+
+// Compiles the operands up to closingOperator (e.g. "AND>"), or up to the
+// end of the list if it is NULL, and leaves rb after them.
+bool ResbufFilter::compileOperands(const resbuf*& rb, const char* closingOperator, uint32_t& operandCount)
+{
+    operandCount = 0;
+    const ACHAR* relationalOperator = NULL;
+    while (rb != NULL) {
+        if (rb->restype == -3) {
+            rb = rb->rbnext;
+            continue;
+        }
+        if (rb->restype != -4) {
+            if (tests.size() == maxTests) {
+                return fail("too many groups in the filter");
+            }
+            if (!compileTest(rb, relationalOperator)) {
+                return false;
+            }
+            program.push_back(Instruction{ kOpTest, (uint32_t)(tests.size() - 1) });
+            operandCount++;
+            relationalOperator = NULL;
+            rb = rb->rbnext;
+            continue;
+        }
+
+        if (rb->resval.rstring == NULL) {
+            return fail("-4 group without an operator");
+        }
+        std::wstring op = trimmedUpper(rb->resval.rstring);
+        if (op == L"<AND" || op == L"<OR" || op == L"<XOR" || op == L"<NOT") {
+            if (relationalOperator != NULL) {
+                return fail("relational operator before " + narrow(op));
+            }
+            std::string closing = narrow(op.substr(1)) + ">";
+            rb = rb->rbnext;
+            uint32_t count;
+            if (!compileOperands(rb, closing.c_str(), count)) {
+                return false;
+            }
+            if (count == 0) {
+                return fail("empty " + narrow(op) + " group");
+            }
+            if (op == L"<AND") {
+                program.push_back(Instruction{ kOpAnd, count });
+            } else if (op == L"<OR") {
+                program.push_back(Instruction{ kOpOr, count });
+            } else if (op == L"<XOR") {
+                if (count != 2) {
+                    return fail("<XOR takes exactly two operands");
+                }
+                program.push_back(Instruction{ kOpXor, count });
+            } else {
+                if (count != 1) {
+                    return fail("<NOT takes exactly one operand");
+                }
+                program.push_back(Instruction{ kOpNot, count });
+            }
+            operandCount++;
+        } else if (op == L"AND>" || op == L"OR>" || op == L"XOR>" || op == L"NOT>") {
+            if (closingOperator == NULL || narrow(op) != closingOperator) {
+                return fail("unexpected " + narrow(op));
+            }
+            if (relationalOperator != NULL) {
+                return fail("relational operator before " + narrow(op));
+            }
+            rb = rb->rbnext;
+            return true;
+        } else {
+            if (relationalOperator != NULL) {
+                return fail("two relational operators in a row");
+            }
+            relationalOperator = rb->resval.rstring;
+            rb = rb->rbnext;
+        }
+    }
+    if (closingOperator != NULL) {
+        return fail(std::string("missing ") + closingOperator);
+    }
+    if (relationalOperator != NULL) {
+        return fail("relational operator at the end of the filter");
+    }
+    return true;
+}
+
+bool ResbufFilter::parseCompareOp(const std::wstring& text, CompareOp& op)
+{
+    static const struct { const wchar_t* text; CompareOp op; } ops[] = {
+        { L"*", kAny }, { L"=", kEqual }, { L"!=", kNotEqual }, { L"/=", kNotEqual }, { L"<>", kNotEqual },
+        { L"<", kLess }, { L"<=", kLessEqual }, { L">", kGreater }, { L">=", kGreaterEqual },
+        { L"&", kBitAnd }, { L"&=", kBitEqual }
+    };
+    for (const auto& entry : ops) {
+        if (text == entry.text) {
+            op = entry.op;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ResbufFilter::compileTest(const resbuf* rb, const ACHAR* relationalOperator)
+{
+    Test test;
+    test.groupCode = rb->restype;
+    test.longInteger = false;
+    test.coordinates = 1;
+    test.integer = 0;
+    test.reals[0] = test.reals[1] = test.reals[2] = 0.0;
+
+    int inxdata;
+    short resultTypeCode = dxftype(rb->restype, ET_NORM, &inxdata);
+    switch (resultTypeCode) {
+    case RTSTR:
+        if (resbufHoldsBinary(rb->restype) || rb->restype >= RTNONE) {
+            return fail("group " + std::to_string(rb->restype) + " cannot be tested");
+        }
+        test.kind = kTestString;
+        break;
+    case RTREAL:
+    case RTANG:
+        test.kind = kTestReal;
+        test.reals[0] = rb->resval.rreal;
+        break;
+    case RTSHORT:
+    case RTORINT:
+    case RTLONG:
+        test.kind = kTestInteger;
+        test.longInteger = (resultTypeCode == RTLONG);
+        test.integer = test.longInteger ? (long long)rb->resval.rlong : (long long)rb->resval.rint;
+        break;
+    case RTPOINT:
+    case RT3DPOINT:
+        test.kind = kTestPoint;
+        test.coordinates = (resultTypeCode == RTPOINT) ? 2 : 3;
+        for (int i = 0; i < 3; i++) {
+            test.reals[i] = rb->resval.rpoint[i];
+        }
+        break;
+    default:
+        return fail("group " + std::to_string(rb->restype) + " cannot be tested");
+    }
+
+    // the relational operator: one, or one per coordinate of a point.
+    std::wstring operatorText = (relationalOperator != NULL) ? trimmedUpper(relationalOperator) : L"=";
+    std::vector<std::wstring> parts;
+    for (size_t start = 0;;) {
+        size_t comma = operatorText.find(L',', start);
+        parts.push_back(operatorText.substr(start, comma == std::wstring::npos ? std::wstring::npos : comma - start));
+        if (comma == std::wstring::npos) { break; }
+        start = comma + 1;
+    }
+    if (parts.size() != 1 && !(test.kind == kTestPoint && (int)parts.size() == test.coordinates)) {
+        return fail("bad relational operator for group " + std::to_string(rb->restype) + ": " + narrow(operatorText));
+    }
+    for (int i = 0; i < 3; i++) {
+        if (!parseCompareOp(parts[(size_t)i < parts.size() ? i : 0], test.ops[i])) {
+            return fail("unknown relational operator " + narrow(operatorText));
+        }
+    }
+    bool bitwise = (test.ops[0] == kBitAnd || test.ops[0] == kBitEqual);
+    if ((bitwise && test.kind != kTestInteger)
+        || (test.kind == kTestString && test.ops[0] != kEqual && test.ops[0] != kNotEqual && test.ops[0] != kAny)) {
+        return fail("relational operator " + narrow(operatorText) + " does not apply to group " + std::to_string(rb->restype));
+    }
+    for (size_t i = 1; i < parts.size(); i++) {
+        if (test.ops[i] == kBitAnd || test.ops[i] == kBitEqual) {
+            return fail("relational operator " + narrow(operatorText) + " does not apply to group " + std::to_string(rb->restype));
+        }
+    }
+
+    if (test.kind == kTestString) {
+        // split the pattern into its comma-separated alternatives.
+        std::wstring pattern = (rb->resval.rstring != NULL) ? rb->resval.rstring : L"";
+        std::wstring alternative;
+        bool inBrackets = false;
+        for (size_t i = 0; i <= pattern.size(); i++) {
+            wchar_t c = (i < pattern.size()) ? pattern[i] : L',';
+            if (c == L'`' && i + 1 < pattern.size()) {
+                alternative += c;
+                alternative += upperOf(pattern[++i]);
+                continue;
+            }
+            if (c == L',' && !inBrackets) {
+                Pattern compiled;
+                compiled.negated = (alternative.size() > 1 && alternative[0] == L'~');
+                compiled.text = compiled.negated ? alternative.substr(1) : alternative;
+                compiled.literal = (compiled.text.find_first_of(L"*?#@.[`") == std::wstring::npos);
+                test.patterns.push_back(compiled);
+                alternative.clear();
+                continue;
+            }
+            if (c == L'[') { inBrackets = true; }
+            if (c == L']') { inBrackets = false; }
+            alternative += upperOf(c);
+        }
+    }
+    tests.push_back(test);
+    return true;
+}
+
+void ResbufFilter::buildIndex()
+{
+    size_t codeCount = (size_t)(lastIndexedCode - firstIndexedCode + 1);
+    firstTestOfCode.assign(codeCount + 1, 0);
+    unindexedTests.clear();
+    for (const Test& test : tests) {
+        if (test.groupCode >= firstIndexedCode && test.groupCode <= lastIndexedCode) {
+            firstTestOfCode[(size_t)(test.groupCode - firstIndexedCode) + 1]++;
+        }
+    }
+    for (size_t i = 0; i < codeCount; i++) {
+        firstTestOfCode[i + 1] += firstTestOfCode[i];
+    }
+    testOrder.assign(firstTestOfCode[codeCount], 0);
+    std::vector<uint32_t> filled(firstTestOfCode.begin(), firstTestOfCode.end() - 1);
+    for (size_t i = 0; i < tests.size(); i++) {
+        short groupCode = tests[i].groupCode;
+        if (groupCode >= firstIndexedCode && groupCode <= lastIndexedCode) {
+            testOrder[filled[(size_t)(groupCode - firstIndexedCode)]++] = (uint16_t)i;
+        } else {
+            unindexedTests.push_back((uint16_t)i);
+        }
+    }
+}
+
+template <typename Visit>
+void ResbufFilter::forEachTestOf(short groupCode, Visit visit) const
+{
+    if (groupCode >= firstIndexedCode && groupCode <= lastIndexedCode) {
+        size_t code = (size_t)(groupCode - firstIndexedCode);
+        for (uint32_t i = firstTestOfCode[code]; i < firstTestOfCode[code + 1]; i++) {
+            visit(testOrder[i]);
+        }
+    } else {
+        for (uint16_t i : unindexedTests) {
+            if (tests[i].groupCode == groupCode) {
+                visit(i);
+            }
+        }
+    }
+}
+
+bool ResbufFilter::runProgram(const bool* satisfied) const
+{
+    bool stack[maxTests + 1];
+    size_t depth = 0;
+    for (const Instruction& instruction : program) {
+        switch (instruction.opcode) {
+        case kOpTest:
+            stack[depth++] = satisfied[instruction.operand];
+            break;
+        case kOpTrue:
+            stack[depth++] = true;
+            break;
+        case kOpAnd:
+        case kOpOr: {
+            // the operands are the top instruction.operand entries.
+            depth -= instruction.operand;
+            bool result = (instruction.opcode == kOpAnd);
+            for (uint32_t i = 0; i < instruction.operand; i++) {
+                if (stack[depth + i] != result) {
+                    result = !result;
+                    break;
+                }
+            }
+            stack[depth++] = result;
+            break;
+        }
+        case kOpXor:
+            depth--;
+            stack[depth - 1] = (stack[depth - 1] != stack[depth]);
+            break;
+        case kOpNot:
+            stack[depth - 1] = !stack[depth - 1];
+            break;
+        }
+    }
+    return depth == 1 && stack[0];
+}
+
+bool ResbufFilter::matches(const resbuf* pChain) const
+{
+    if (program.empty()) {
+        return false;
+    }
+    bool satisfied[maxTests];
+    memset(satisfied, 0, tests.size() * sizeof(bool));
+    for (const resbuf* rb = pChain; rb != NULL; rb = rb->rbnext) {
+        forEachTestOf(rb->restype, [&](uint16_t index) {
+            if (satisfied[index]) {
+                return;
+            }
+            const Test& test = tests[index];
+            bool result = false;
+            switch (test.kind) {
+            case kTestString:
+                if (!resbufHoldsBinary(rb->restype) && rb->resval.rstring != NULL) {
+                    result = matchesString(test, rb->resval.rstring, wcslen(rb->resval.rstring));
+                }
+                break;
+            case kTestReal:
+                result = compareReal(test.ops[0], rb->resval.rreal, test.reals[0]);
+                break;
+            case kTestInteger:
+                result = compareInteger(test.ops[0], test.longInteger ? (long long)rb->resval.rlong : (long long)rb->resval.rint, test.integer);
+                break;
+            case kTestPoint:
+                result = true;
+                for (int i = 0; result && i < test.coordinates; i++) {
+                    result = compareReal(test.ops[i], rb->resval.rpoint[i], test.reals[i]);
+                }
+                break;
+            }
+            satisfied[index] = result;
+        });
+    }
+    return runProgram(satisfied);
+}
+
+bool ResbufFilter::matches(const DxfRecord* records, size_t count) const
+{
+    if (program.empty()) {
+        return false;
+    }
+    bool satisfied[maxTests];
+    memset(satisfied, 0, tests.size() * sizeof(bool));
+    std::wstring decoded; // the values that are not ASCII, which are folded to upper case as characters, not bytes
+    for (size_t r = 0; r < count; r++) {
+        const DxfRecord& record = records[r];
+        forEachTestOf(record.groupCode, [&](uint16_t index) {
+            if (satisfied[index]) {
+                return;
+            }
+            const Test& test = tests[index];
+            bool result = false;
+            double real;
+            long long integer;
+            switch (test.kind) {
+            case kTestString:
+                if (isAscii(record.value())) {
+                    result = matchesString(test, record.value().data(), record.value().size());
+                } else {
+                    decodeUtf8(record.value(), decoded);
+                    result = matchesString(test, decoded.data(), decoded.size());
+                }
+                break;
+            case kTestReal:
+                result = record.real(0, real) && compareReal(test.ops[0], real, test.reals[0]);
+                break;
+            case kTestInteger:
+                result = record.integer(integer) && compareInteger(test.ops[0], integer, test.integer);
+                break;
+            case kTestPoint:
+                result = true;
+                for (int i = 0; result && i < test.coordinates; i++) {
+                    real = 0.0; // a missing Z is 0
+                    result = (i >= record.valueCount || record.real(i, real)) && compareReal(test.ops[i], real, test.reals[i]);
+                }
+                break;
+            }
+            satisfied[index] = result;
+        });
+    }
+    return runProgram(satisfied);
+}
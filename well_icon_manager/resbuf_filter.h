@@ -0,0 +1,106 @@
+#pragma once
+
+// Compiled selection filters.
+//
+// A ResbufFilter is compiled from a filter list in the form acedSSGet()
+// takes: groups whose values the entity must match, optionally preceded by a
+// -4 relational operator ("=", "!=", "/=", "<>", "<", "<=", ">", ">=", "*",
+// "&", "&="; points take one operator per coordinate, e.g. "<,>,*"), and
+// grouped by the -4 logical operators "<AND" .. "AND>", "<OR" .. "OR>",
+// "<XOR" .. "XOR>" and "<NOT" .. "NOT>".  The groups of the top level are
+// ANDed.  String values are case-insensitive wildcard patterns as in
+// acutWcMatch() (* ? # @ . ~ [...] ` and commas between alternatives).
+//
+// Unlike acedSSGet(), any group can be tested, including XDATA groups (a -3
+// group in the filter is ignored; test the 1001 application name instead).
+// A group test holds if any group of that code in the entity data satisfies
+// it.  Groups are typed with dxftype() (ET_NORM).
+//
+// compile() turns the list into a table of group tests, indexed by group
+// code, and a small postfix program over their results.  Matching then takes
+// a single pass over the entity data, in which every group is only compared
+// against the tests of its own code, followed by running the program.  The
+// entity data can be a resbuf chain (e.g. from acdbEntGet()) or the records
+// of one entity read by DxfReader, whose strings are UTF-8 and are decoded
+// before they are compared.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "arx_host.h"
+#include "dxf_reader.h"
+
+class ResbufFilter {
+    private:
+        enum TestKind : unsigned char { kTestString, kTestReal, kTestInteger, kTestPoint };
+        enum CompareOp : unsigned char { kAny, kEqual, kNotEqual, kLess, kLessEqual, kGreater, kGreaterEqual, kBitAnd, kBitEqual };
+        enum Opcode : unsigned char { kOpTest, kOpTrue, kOpAnd, kOpOr, kOpXor, kOpNot };
+
+        struct Pattern {
+            std::wstring text;  // upper case, without the leading ~
+            bool negated;
+            bool literal;       // no wildcard characters
+        };
+
+        struct Test {
+            short groupCode;
+            TestKind kind;
+            bool longInteger;   // the value is in resval.rlong, not rint
+            int coordinates;    // 2 or 3 for points
+            CompareOp ops[3];   // one per coordinate for points
+            double reals[3];
+            long long integer;
+            std::vector<Pattern> patterns;
+        };
+
+        struct Instruction {
+            Opcode opcode;
+            uint32_t operand;   // test index, or the operand count of AND/OR
+        };
+
+        static const size_t maxTests = 256;
+        static const short firstIndexedCode = -5;
+        static const short lastIndexedCode = 1071;
+
+        std::vector<Test> tests;
+        std::vector<Instruction> program;
+        // tests of the group codes firstIndexedCode..lastIndexedCode, as
+        // ranges of testOrder; other codes are looked up in unindexedTests.
+        std::vector<uint16_t> testOrder;
+        std::vector<uint32_t> firstTestOfCode;
+        std::vector<uint16_t> unindexedTests;
+        std::string errorMessage;
+
+        bool compileOperands(const resbuf*& rb, const char* closingOperator, uint32_t& operandCount);
+        bool compileTest(const resbuf* rb, const ACHAR* relationalOperator);
+        void buildIndex();
+        bool fail(const std::string& message);
+
+        template <typename Visit>
+        void forEachTestOf(short groupCode, Visit visit) const;
+        bool runProgram(const bool* satisfied) const;
+
+        static bool parseCompareOp(const std::wstring& text, CompareOp& op);
+        static bool compareReal(CompareOp op, double value, double reference);
+        static bool compareInteger(CompareOp op, long long value, long long reference);
+        template <typename Char>
+        static bool matchesString(const Test& test, const Char* text, size_t length);
+
+    public:
+        ResbufFilter();
+
+        // Compiles a filter list.  Returns false, with error() describing
+        // the problem, if the list is malformed; the filter then matches
+        // nothing.
+        bool compile(const resbuf* pFilter);
+        const std::string& error() const { return errorMessage; }
+        bool isCompiled() const { return !program.empty(); }
+
+        // Whether the entity data matches the filter.
+        bool matches(const resbuf* pChain) const;
+        bool matches(const DxfRecord* records, size_t count) const;
+
+        size_t testCount() const { return tests.size(); }
+        size_t instructionCount() const { return program.size(); }
+};
@@ -0,0 +1,104 @@
+#include "resbuf_filter_arx.h"
+#include <tchar.h>
+#include <adslib.h>
+#include <aced.h>
+#include <dbapserv.h>
+#include <dbents.h>
+#include <dbsymtb.h>
+#include <dbsymutl.h>
+#include "class_ancestry_arx.h"
+#include "handle_index_arx.h"
+#include "resbuf_arena.h"
+#include "resbuf_filter.h"
+
+
+// Asks for a wildcard pattern; an empty answer is "*".  False if the user
+// cancels.
+static bool getPattern(const ACHAR* prompt, AcString& pattern)
+{
+    if (acedGetString(1, prompt, pattern) != RTNORM) {
+        return false;
+    }
+    if (pattern.isEmpty()) {
+        pattern = _T("*");
+    }
+    return true;
+}
+
+void findWellIcons()
+{
+    AcString blockPattern;
+    AcString layerPattern;
+    AcString xDataPattern;
+    if (!getPattern(_T("\nBlock name pattern <*>: "), blockPattern)
+        || !getPattern(_T("\nLayer pattern <*>: "), layerPattern)
+        || !getPattern(_T("\nXDATA string pattern <*>: "), xDataPattern)) {
+        return;
+    }
+
+    ResbufArena arena;
+    ResbufChainBuilder builder(arena);
+    builder.appendString(0, _T("INSERT"));
+    builder.appendString(2, blockPattern.kwszPtr());
+    builder.appendString(8, layerPattern.kwszPtr());
+    if (xDataPattern != _T("*")) {
+        builder.appendString(1000, xDataPattern.kwszPtr());
+    }
+    // the builder only fails for want of memory; the filter says what is
+    // wrong with a pattern.
+    if (builder.failed()) {
+        acutPrintf(_T("\nOut of memory while building the filter.\n"));
+        return;
+    }
+    ResbufFilter filter;
+    if (!filter.compile(builder.head())) {
+        acutPrintf(_T("\nInvalid pattern: %hs\n"), filter.error().c_str());
+        return;
+    }
+
+    AcDbBlockTableRecord* pModelSpace;
+    if (acdbOpenObject(pModelSpace, acdbSymUtil()->blockModelSpaceId(acdbHostApplicationServices()->workingDatabase()), AcDb::kForRead) != Acad::eOk) {
+        acutPrintf(_T("\nUnable to open model space.\n"));
+        return;
+    }
+    AcDbBlockTableRecordIterator* pIterator;
+    if (pModelSpace->newIterator(pIterator) != Acad::eOk) {
+        pModelSpace->close();
+        return;
+    }
+    // the XDATA of every application.
+    resbuf applications;
+    applications.restype = RTSTR;
+    applications.resval.rstring = (ACHAR*)_T("*");
+    applications.rbnext = NULL;
+
+    size_t referenceCount = 0;
+    size_t matchCount = 0;
+    const size_t maxListed = 50;
+    for (; !pIterator->done(); pIterator->step()) {
+        AcDbObjectId entityId;
+        ads_name eName;
+        // other entities are told apart by their class, without reading their data.
+        if (pIterator->getEntityId(entityId) != Acad::eOk
+            || !sessionClassAncestry().isKindOf(entityId.objectClass(), AcDbBlockReference::desc())
+            || acdbGetAdsName(eName, entityId) != Acad::eOk) {
+            continue;
+        }
+        resbuf* pData = acdbEntGetX(eName, &applications);
+        referenceCount++;
+        if (pData != NULL && filter.matches(pData)) {
+            if (matchCount < maxListed) {
+                acutPrintf(_T("\n%s"), HandleText(handleOf(entityId)).c_str());
+            }
+            matchCount++;
+        }
+        acutRelRb(pData);
+    }
+    delete pIterator;
+    pModelSpace->close();
+
+    if (matchCount > maxListed) {
+        acutPrintf(_T("\n... and %d more."), (int)(matchCount - maxListed));
+    }
+    acutPrintf(_T("\n%d of %d block references match.\n"), (int)matchCount, (int)referenceCount);
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+// The WELLFIND command: lists the block references of model space whose
+// block name, layer and XDATA strings (groups 1000) match the wildcard
+// patterns the user gives.  The patterns are compiled into a ResbufFilter
+// (see resbuf_filter.h), which unlike acedSSGet() can test the strings of
+// the XDATA.  Only available inside AutoCAD.
+
+void findWellIcons();
@@ -0,0 +1,272 @@
+#include "resbuf_flat.h"
+#include <string.h>
+#include <wchar.h>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FLAT_RESBUF_SSE2 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+
+static FlatResbufKind kindOf(short restype)
+{
+    if (resbufHoldsString(restype)) {
+        return kFlatString;
+    }
+    if (resbufHoldsBinary(restype)) {
+        return kFlatBinary;
+    }
+    int inxdata;
+    switch (dxftype(restype, ET_NORM, &inxdata)) {
+    case RTREAL:
+    case RTANG:
+        return kFlatReal;
+    case RTPOINT:
+    case RT3DPOINT:
+        return kFlatPoint;
+    case RTSHORT:
+    case RTORINT:
+    case RTLONG:
+        return kFlatInteger;
+    case RTVOID:
+    case RTLB:
+    case RTLE:
+    case RTDOTE:
+    case RTNIL:
+    case RTDXF0:
+    case RTT:
+        return kFlatNoValue;
+    default:
+        return kFlatOther;
+    }
+}
+
+// Whether an integer node keeps its value in rlong rather than rint.
+static bool isLongInteger(short restype)
+{
+    int inxdata;
+    return dxftype(restype, ET_NORM, &inxdata) == RTLONG;
+}
+
+FlatResbufChain::FlatResbufChain()
+{
+    binaryStarts.push_back(0);
+}
+
+void FlatResbufChain::clear()
+{
+    restypes.clear();
+    kinds.clear();
+    slots.clear();
+    reals.clear();
+    points.clear();
+    integers.clear();
+    stringCharacters.clear();
+    stringStarts.clear();
+    binaryBytes.clear();
+    binaryStarts.assign(1, 0);
+    others.clear();
+}
+
+void FlatResbufChain::assign(const resbuf* pChain)
+{
+    clear();
+    for (const resbuf* rb = pChain; rb != NULL; rb = rb->rbnext) {
+        FlatResbufKind kind = kindOf(rb->restype);
+        uint32_t slot = 0;
+        switch (kind) {
+        case kFlatNoValue:
+            break;
+        case kFlatReal:
+            slot = (uint32_t)reals.size();
+            reals.push_back(rb->resval.rreal);
+            break;
+        case kFlatPoint:
+            slot = (uint32_t)(points.size() / 3);
+            points.insert(points.end(), rb->resval.rpoint, rb->resval.rpoint + 3);
+            break;
+        case kFlatInteger:
+            slot = (uint32_t)integers.size();
+            integers.push_back(isLongInteger(rb->restype) ? (int32_t)rb->resval.rlong : (int32_t)rb->resval.rint);
+            break;
+        case kFlatString: {
+            slot = (uint32_t)stringStarts.size();
+            stringStarts.push_back((uint32_t)stringCharacters.size());
+            const ACHAR* text = (rb->resval.rstring != NULL) ? rb->resval.rstring : L"";
+            stringCharacters.insert(stringCharacters.end(), text, text + wcslen(text) + 1);
+            break;
+        }
+        case kFlatBinary: {
+            slot = (uint32_t)(binaryStarts.size() - 1);
+            if (rb->resval.rbinary.buf != NULL && rb->resval.rbinary.clen > 0) {
+                binaryBytes.insert(binaryBytes.end(), rb->resval.rbinary.buf, rb->resval.rbinary.buf + rb->resval.rbinary.clen);
+            }
+            binaryStarts.push_back((uint32_t)binaryBytes.size());
+            break;
+        }
+        case kFlatOther:
+            slot = (uint32_t)others.size();
+            others.push_back(rb->resval);
+            break;
+        }
+        restypes.push_back(rb->restype);
+        kinds.push_back(kind);
+        slots.push_back(slot);
+    }
+}
+
+std::basic_string_view<ACHAR> FlatResbufChain::stringView(size_t index) const
+{
+    uint32_t slot = slots[index];
+    size_t end = (slot + 1 < stringStarts.size()) ? stringStarts[slot + 1] : stringCharacters.size();
+    return std::basic_string_view<ACHAR>(&stringCharacters[stringStarts[slot]], end - stringStarts[slot] - 1);
+}
+
+std::string_view FlatResbufChain::binary(size_t index) const
+{
+    uint32_t slot = slots[index];
+    return std::string_view(binaryBytes.data() + binaryStarts[slot], binaryStarts[slot + 1] - binaryStarts[slot]);
+}
+
+// Sets the value of rb (a zeroed node of restypes[index]) for every kind but
+// strings and binary chunks, which the callers allocate.
+void FlatResbufChain::fillValue(resbuf* rb, size_t index) const
+{
+    switch (kinds[index]) {
+    case kFlatReal:
+        rb->resval.rreal = real(index);
+        break;
+    case kFlatPoint:
+        memcpy(rb->resval.rpoint, point(index), 3 * sizeof(double));
+        break;
+    case kFlatInteger:
+        if (isLongInteger(restypes[index])) {
+            rb->resval.rlong = integer(index);
+        } else {
+            rb->resval.rint = (short)integer(index);
+        }
+        break;
+    case kFlatOther:
+        rb->resval = other(index);
+        break;
+    default:
+        break;
+    }
+}
+
+resbuf* FlatResbufChain::toHeapChain() const
+{
+    resbuf* pHead = NULL;
+    resbuf* pTail = NULL;
+    for (size_t i = 0; i < restypes.size(); i++) {
+        resbuf* rb = acutNewRb(restypes[i]);
+        if (rb == NULL) {
+            acutRelRb(pHead);
+            return NULL;
+        }
+        if (pTail != NULL) {
+            pTail->rbnext = rb;
+        } else {
+            pHead = rb;
+        }
+        pTail = rb;
+
+        bool allocated = true;
+        if (kinds[i] == kFlatString) {
+            std::basic_string_view<ACHAR> text = stringView(i);
+            allocated = (rb->resval.rstring = resbufNewString(text.data(), text.size())) != NULL;
+        } else if (kinds[i] == kFlatBinary) {
+            std::string_view bytes = binary(i);
+            rb->resval.rbinary.clen = (short)bytes.size();
+            allocated = (rb->resval.rbinary.buf = resbufNewBinary(bytes.data(), bytes.size())) != NULL;
+        } else {
+            fillValue(rb, i);
+        }
+        if (!allocated) {
+            acutRelRb(pHead);
+            return NULL;
+        }
+    }
+    return pHead;
+}
+
+resbuf* FlatResbufChain::toChain(ResbufArena& arena) const
+{
+    resbuf* pHead = NULL;
+    resbuf* pTail = NULL;
+    for (size_t i = 0; i < restypes.size(); i++) {
+        resbuf* rb = arena.newRb(restypes[i]);
+        if (rb == NULL) {
+            return NULL;
+        }
+        if (kinds[i] == kFlatString) {
+            std::basic_string_view<ACHAR> text = stringView(i);
+            if ((rb->resval.rstring = arena.newString(text.data(), text.size())) == NULL) {
+                return NULL;
+            }
+        } else if (kinds[i] == kFlatBinary) {
+            std::string_view bytes = binary(i);
+            rb->resval.rbinary.clen = (short)bytes.size();
+            if ((rb->resval.rbinary.buf = arena.newBinary(bytes.data(), bytes.size())) == NULL) {
+                return NULL;
+            }
+        } else {
+            fillValue(rb, i);
+        }
+        if (pTail != NULL) {
+            pTail->rbnext = rb;
+        } else {
+            pHead = rb;
+        }
+        pTail = rb;
+    }
+    return pHead;
+}
+
+size_t FlatResbufChain::findRestype(short restype, std::vector<size_t>& indexes) const
+{
+    const short* pRestypes = restypes.data();
+    size_t count = restypes.size();
+    size_t found = 0;
+    size_t i = 0;
+#ifdef FLAT_RESBUF_SSE2
+    // compare 8 restypes at a time; each match sets 2 bits of the mask.
+    __m128i wanted = _mm_set1_epi16(restype);
+    for (; i + 8 <= count; i += 8) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(pRestypes + i));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi16(block, wanted)) & 0x5555u;
+        while (mask != 0) {
+#ifdef _MSC_VER
+            unsigned long bit;
+            _BitScanForward(&bit, mask);
+#else
+            unsigned bit = (unsigned)__builtin_ctz(mask);
+#endif
+            indexes.push_back(i + bit / 2);
+            found++;
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        if (pRestypes[i] == restype) {
+            indexes.push_back(i);
+            found++;
+        }
+    }
+    return found;
+}
+
+size_t FlatResbufChain::countRestype(short restype) const
+{
+    // a plain loop; compilers vectorize it.
+    size_t found = 0;
+    for (short code : restypes) {
+        found += (code == restype);
+    }
+    return found;
+}
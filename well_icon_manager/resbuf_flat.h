@@ -0,0 +1,84 @@
+#pragma once
+
+// A flat, structure-of-arrays copy of a resbuf chain.
+//
+// Walking rbnext visits one scattered heap node per group; for the large
+// chains returned by acdbEntGet() and xData() that is mostly cache misses.
+// A FlatResbufChain keeps the restypes of all nodes in one contiguous array
+// and the values in one array per kind (reals, points, integers, string
+// characters, ...), with a per-node slot index into the array of its kind.
+// Nodes can be accessed by index, and scans such as "all groups 1000" run
+// over the restype array only (see findRestype()).
+//
+// Values are classified the way ResbufWrapper does (dxftype() with ET_NORM).
+// Values of any other kind (entity names, 64-bit integers, nested chains) are
+// kept verbatim, so converting a chain to the flat form and back is lossless.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string_view>
+#include <vector>
+#include "arx_host.h"
+#include "resbuf_arena.h"
+
+enum FlatResbufKind : unsigned char {
+    kFlatNoValue,  // RTNONE, RTLB, RTLE, ... (resval is zero)
+    kFlatReal,
+    kFlatPoint,
+    kFlatInteger,  // rint or rlong, depending on the restype
+    kFlatString,
+    kFlatBinary,
+    kFlatOther     // the whole resval, copied as is
+};
+
+class FlatResbufChain {
+    private:
+        std::vector<short> restypes;
+        std::vector<FlatResbufKind> kinds;
+        std::vector<uint32_t> slots;
+
+        std::vector<double> reals;
+        std::vector<double> points; // 3 per point
+        std::vector<int32_t> integers;
+        std::vector<ACHAR> stringCharacters; // each string is NUL-terminated
+        std::vector<uint32_t> stringStarts;
+        std::vector<char> binaryBytes;
+        std::vector<uint32_t> binaryStarts;  // one more than there are chunks
+        std::vector<ads_u_val> others;
+
+        void fillValue(resbuf* rb, size_t index) const;
+
+    public:
+        FlatResbufChain();
+
+        // Replaces the contents with a copy of the chain (which is left
+        // alone).  O(n) in the length of the chain.
+        void assign(const resbuf* pChain);
+        void clear();
+
+        // Rebuilds the chain: in newly allocated heap nodes (release with
+        // acutRelRb(); NULL if out of memory), or in an arena.
+        resbuf* toHeapChain() const;
+        resbuf* toChain(ResbufArena& arena) const;
+
+        size_t size() const { return restypes.size(); }
+        const short* restypeData() const { return restypes.data(); }
+
+        short restype(size_t index) const { return restypes[index]; }
+        FlatResbufKind kind(size_t index) const { return kinds[index]; }
+
+        // The value of the node at index; only valid for a node of the
+        // matching kind.
+        double real(size_t index) const { return reals[slots[index]]; }
+        const double* point(size_t index) const { return &points[3 * (size_t)slots[index]]; }
+        int32_t integer(size_t index) const { return integers[slots[index]]; }
+        const ACHAR* string(size_t index) const { return &stringCharacters[stringStarts[slots[index]]]; }
+        std::basic_string_view<ACHAR> stringView(size_t index) const;
+        std::string_view binary(size_t index) const;
+        const ads_u_val& other(size_t index) const { return others[slots[index]]; }
+
+        // Appends the indexes of all nodes of the given restype, in order,
+        // and returns how many were found.
+        size_t findRestype(short restype, std::vector<size_t>& indexes) const;
+        size_t countRestype(short restype) const;
+};
@@ -0,0 +1,448 @@
+#include "resbuf_snapshot.h"
+#include <string.h>
+#include <wchar.h>
+#include "dxf_reader.h"
+
+
+enum SnapshotValue {
+    kSnapshotNoValue,
+    kSnapshotReal,
+    kSnapshotPoint,
+    kSnapshotShort,
+    kSnapshotLong,
+    kSnapshotInt64,
+    kSnapshotString,
+    kSnapshotBinary,
+    kSnapshotChain,
+    kSnapshotEntityName,
+    kSnapshotOther
+};
+
+// Nested chains deeper than this are rejected when decoding.
+static const int maxChainDepth = 32;
+
+static SnapshotValue snapshotValueOf(short restype)
+{
+    if (restype >= RTNONE) {
+        // an RT* code rather than a group code.
+        switch (restype) {
+        case RTREAL:
+        case RTANG:
+            return kSnapshotReal;
+        case RTPOINT:
+        case RT3DPOINT:
+            return kSnapshotPoint;
+        case RTSHORT:
+        case RTORINT:
+            return kSnapshotShort;
+        case RTLONG:
+            return kSnapshotLong;
+        case RTSTR:
+            return kSnapshotString;
+        case RTRESBUF:
+            return kSnapshotChain;
+        case RTENAME:
+        case RTPICKS:
+            return kSnapshotEntityName;
+        case RTLONG_PTR:
+        case RTINT64:
+            return kSnapshotInt64;
+        default:
+            return kSnapshotNoValue;
+        }
+    }
+    if (restype == -1 || restype == -2 || (restype >= 330 && restype <= 369) || (restype >= 390 && restype <= 399) || restype == 480 || restype == 481) {
+        return kSnapshotEntityName;
+    }
+    if (resbufHoldsBinary(restype)) {
+        return kSnapshotBinary;
+    }
+    if (resbufHoldsString(restype)) {
+        return kSnapshotString;
+    }
+    // the X groups of the UCS origin and axes hold whole points, as 10 does;
+    // dxftype() does not type them.
+    int inxdata;
+    short resultType = dxftype(restype, ET_NORM, &inxdata);
+    if (resultType == RTPOINT || resultType == RT3DPOINT || (restype >= 110 && restype <= 112)) {
+        return kSnapshotPoint;
+    }
+    // dxftype() leaves many groups (90-99, 160-179, 270-299, ...) as RTNONE;
+    // the group-code table has them all.  Booleans are held in rint.
+    switch (dxfValueKind(restype)) {
+    case kDxfDouble:
+        return kSnapshotReal;
+    case kDxfInt16:
+    case kDxfBoolean:
+        return kSnapshotShort;
+    case kDxfInt32:
+        return kSnapshotLong;
+    case kDxfInt64:
+        return kSnapshotInt64;
+    default:
+        return kSnapshotOther;
+    }
+}
+
+static void putVarint(std::string& out, unsigned long long value)
+{
+    while (value >= 0x80) {
+        out += (char)(unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    out += (char)(unsigned char)value;
+}
+
+static void putSigned(std::string& out, long long value)
+{
+    putVarint(out, ((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63));
+}
+
+static void putDouble(std::string& out, double value)
+{
+    // the hosts (x86, x64, ARM) are little-endian.
+    char bytes[8];
+    memcpy(bytes, &value, 8);
+    out.append(bytes, 8);
+}
+
+// Reads one code point of a NUL-terminated string and advances past it.
+static unsigned long nextCodePoint(const ACHAR*& p)
+{
+    unsigned long c = (unsigned long)*p++;
+    if (sizeof(ACHAR) == 2 && c >= 0xD800 && c <= 0xDBFF && (unsigned long)*p >= 0xDC00 && (unsigned long)*p <= 0xDFFF) {
+        c = 0x10000 + ((c - 0xD800) << 10) + ((unsigned long)*p++ - 0xDC00);
+    }
+    return c;
+}
+
+static void putUtf8(std::string& out, const ACHAR* text)
+{
+    size_t length = 0;
+    for (const ACHAR* p = text; *p != 0;) {
+        unsigned long c = nextCodePoint(p);
+        length += (c < 0x80) ? 1 : (c < 0x800) ? 2 : (c < 0x10000) ? 3 : 4;
+    }
+    putVarint(out, length);
+    for (const ACHAR* p = text; *p != 0;) {
+        unsigned long c = nextCodePoint(p);
+        if (c < 0x80) {
+            out += (char)c;
+        } else if (c < 0x800) {
+            out += (char)(0xC0 | (c >> 6));
+            out += (char)(0x80 | (c & 0x3F));
+        } else if (c < 0x10000) {
+            out += (char)(0xE0 | (c >> 12));
+            out += (char)(0x80 | ((c >> 6) & 0x3F));
+            out += (char)(0x80 | (c & 0x3F));
+        } else {
+            out += (char)(0xF0 | (c >> 18));
+            out += (char)(0x80 | ((c >> 12) & 0x3F));
+            out += (char)(0x80 | ((c >> 6) & 0x3F));
+            out += (char)(0x80 | (c & 0x3F));
+        }
+    }
+}
+
+void encodeResbufChain(const resbuf* pChain, bool keepEntityNames, std::string& out)
+{
+    size_t nodeCount = 0;
+    for (const resbuf* rb = pChain; rb != NULL; rb = rb->rbnext) {
+        nodeCount++;
+    }
+    putVarint(out, nodeCount);
+
+    for (const resbuf* rb = pChain; rb != NULL; rb = rb->rbnext) {
+        putSigned(out, rb->restype);
+        switch (snapshotValueOf(rb->restype)) {
+        case kSnapshotNoValue:
+            break;
+        case kSnapshotReal:
+            putDouble(out, rb->resval.rreal);
+            break;
+        case kSnapshotPoint:
+            putDouble(out, rb->resval.rpoint[0]);
+            putDouble(out, rb->resval.rpoint[1]);
+            putDouble(out, rb->resval.rpoint[2]);
+            break;
+        case kSnapshotShort:
+            putSigned(out, rb->resval.rint);
+            break;
+        case kSnapshotLong:
+            putSigned(out, rb->resval.rlong);
+            break;
+        case kSnapshotInt64:
+            putSigned(out, rb->resval.mnInt64);
+            break;
+        case kSnapshotString:
+            putUtf8(out, (rb->resval.rstring != NULL) ? rb->resval.rstring : L"");
+            break;
+        case kSnapshotBinary: {
+            size_t length = (rb->resval.rbinary.buf != NULL && rb->resval.rbinary.clen > 0) ? (size_t)rb->resval.rbinary.clen : 0;
+            putVarint(out, length);
+            out.append(rb->resval.rbinary.buf, length);
+            break;
+        }
+        case kSnapshotChain:
+            encodeResbufChain((const resbuf*)rb->resval.mnLongPtr, keepEntityNames, out);
+            break;
+        case kSnapshotEntityName:
+            putSigned(out, keepEntityNames ? (long long)rb->resval.rlname[0] : 0);
+            putSigned(out, keepEntityNames ? (long long)rb->resval.rlname[1] : 0);
+            break;
+        case kSnapshotOther:
+            putSigned(out, (long long)rb->resval.rlname[0]);
+            putSigned(out, (long long)rb->resval.rlname[1]);
+            break;
+        }
+    }
+}
+
+
+// Reads the fields of an encoding; every getter returns false when the
+// input is exhausted or malformed.
+class SnapshotDecoder {
+    private:
+        const char* pCursor;
+        const char* pEnd;
+
+    public:
+        SnapshotDecoder(const char* pBegin, const char* pEnd) : pCursor(pBegin), pEnd(pEnd) {}
+
+        const char* cursor() const { return pCursor; }
+        bool atEnd() const { return pCursor == pEnd; }
+
+        bool getVarint(unsigned long long& value) {
+            value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                if (pCursor == pEnd) {
+                    return false;
+                }
+                unsigned char byte = (unsigned char)*pCursor++;
+                value |= (unsigned long long)(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool getSigned(long long& value) {
+            unsigned long long zigzag;
+            if (!getVarint(zigzag)) {
+                return false;
+            }
+            value = (long long)(zigzag >> 1) ^ -(long long)(zigzag & 1);
+            return true;
+        }
+
+        bool getDouble(double& value) {
+            if (pEnd - pCursor < 8) {
+                return false;
+            }
+            memcpy(&value, pCursor, 8);
+            pCursor += 8;
+            return true;
+        }
+
+        bool getBytes(std::string_view& bytes) {
+            unsigned long long length;
+            if (!getVarint(length) || length > (unsigned long long)(pEnd - pCursor)) {
+                return false;
+            }
+            bytes = std::string_view(pCursor, (size_t)length);
+            pCursor += length;
+            return true;
+        }
+};
+
+// Decodes UTF-8 into an arena string.  Invalid sequences decode to U+FFFD.
+static ACHAR* arenaStringFromUtf8(std::string_view utf8, ResbufArena& arena)
+{
+    std::basic_string<ACHAR> text;
+    text.reserve(utf8.size());
+    for (size_t i = 0; i < utf8.size();) {
+        unsigned char lead = (unsigned char)utf8[i];
+        int extra = (lead < 0x80) ? 0 : (lead >= 0xF0) ? 3 : (lead >= 0xE0) ? 2 : (lead >= 0xC0) ? 1 : -1;
+        unsigned long c = (extra == 0) ? lead : (extra == 1) ? (lead & 0x1F) : (extra == 2) ? (lead & 0x0F) : (lead & 0x07);
+        bool valid = (extra >= 0 && i + (size_t)extra < utf8.size());
+        for (int k = 1; valid && k <= extra; k++) {
+            unsigned char continuation = (unsigned char)utf8[i + (size_t)k];
+            valid = ((continuation & 0xC0) == 0x80);
+            c = (c << 6) | (continuation & 0x3F);
+        }
+        if (!valid) {
+            c = 0xFFFD;
+            extra = 0;
+        }
+        i += (size_t)extra + 1;
+        if (sizeof(ACHAR) == 2 && c >= 0x10000) {
+            text += (ACHAR)(0xD800 + ((c - 0x10000) >> 10));
+            text += (ACHAR)(0xDC00 + ((c - 0x10000) & 0x3FF));
+        } else {
+            text += (ACHAR)c;
+        }
+    }
+    return arena.newString(text.data(), text.size());
+}
+
+static bool decodeChain(SnapshotDecoder& decoder, ResbufArena& arena, int depth, resbuf*& pChain)
+{
+    pChain = NULL;
+    unsigned long long nodeCount;
+    if (depth > maxChainDepth || !decoder.getVarint(nodeCount)) {
+        return false;
+    }
+    resbuf* pTail = NULL;
+    for (unsigned long long i = 0; i < nodeCount; i++) {
+        long long restype;
+        if (!decoder.getSigned(restype) || restype < -32768 || restype > 32767) {
+            return false;
+        }
+        resbuf* rb = arena.newRb((short)restype);
+        if (rb == NULL) {
+            return false;
+        }
+        if (pTail != NULL) {
+            pTail->rbnext = rb;
+        } else {
+            pChain = rb;
+        }
+        pTail = rb;
+
+        bool decoded = true;
+        long long integers[2] = { 0, 0 };
+        std::string_view bytes;
+        resbuf* pNested;
+        switch (snapshotValueOf(rb->restype)) {
+        case kSnapshotNoValue:
+            break;
+        case kSnapshotReal:
+            decoded = decoder.getDouble(rb->resval.rreal);
+            break;
+        case kSnapshotPoint:
+            decoded = decoder.getDouble(rb->resval.rpoint[0]) && decoder.getDouble(rb->resval.rpoint[1]) && decoder.getDouble(rb->resval.rpoint[2]);
+            break;
+        case kSnapshotShort:
+            decoded = decoder.getSigned(integers[0]);
+            rb->resval.rint = (short)integers[0];
+            break;
+        case kSnapshotLong:
+            decoded = decoder.getSigned(integers[0]);
+            rb->resval.rlong = (int32_t)integers[0];
+            break;
+        case kSnapshotInt64:
+            decoded = decoder.getSigned(integers[0]);
+            rb->resval.mnInt64 = integers[0];
+            break;
+        case kSnapshotString:
+            decoded = decoder.getBytes(bytes) && (rb->resval.rstring = arenaStringFromUtf8(bytes, arena)) != NULL;
+            break;
+        case kSnapshotBinary:
+            decoded = decoder.getBytes(bytes) && bytes.size() <= 32767 && (rb->resval.rbinary.buf = arena.newBinary(bytes.data(), bytes.size())) != NULL;
+            rb->resval.rbinary.clen = (short)bytes.size();
+            break;
+        case kSnapshotChain:
+            decoded = decodeChain(decoder, arena, depth + 1, pNested);
+            rb->resval.mnLongPtr = (decltype(rb->resval.mnLongPtr))pNested;
+            break;
+        case kSnapshotEntityName:
+        case kSnapshotOther:
+            decoded = decoder.getSigned(integers[0]) && decoder.getSigned(integers[1]);
+            rb->resval.rlname[0] = integers[0];
+            rb->resval.rlname[1] = integers[1];
+            break;
+        }
+        if (!decoded) {
+            pChain = NULL;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool decodeResbufChain(std::string_view encoded, ResbufArena& arena, resbuf*& pChain)
+{
+    SnapshotDecoder decoder(encoded.data(), encoded.data() + encoded.size());
+    if (!decodeChain(decoder, arena, 0, pChain) || !decoder.atEnd()) {
+        pChain = NULL;
+        return false;
+    }
+    return true;
+}
+
+
+ResbufSnapshotWriter::ResbufSnapshotWriter(FILE* out, bool keepEntityNames)
+{
+    this->out = out;
+    this->keepEntityNames = keepEntityNames;
+    std::string header(resbufSnapshotMagic);
+    putVarint(header, resbufSnapshotVersion);
+    putVarint(header, keepEntityNames ? kSnapshotEntityNamesKept : 0);
+    fwrite(header.data(), 1, header.size(), out);
+}
+
+bool ResbufSnapshotWriter::write(std::string_view key, const resbuf* pChain)
+{
+    std::string encoded;
+    encodeResbufChain(pChain, keepEntityNames, encoded);
+    return writeEncoded(key, encoded);
+}
+
+bool ResbufSnapshotWriter::writeEncoded(std::string_view key, std::string_view encodedChain)
+{
+    buffer.clear();
+    putVarint(buffer, key.size());
+    buffer += key;
+    putVarint(buffer, encodedChain.size());
+    buffer += encodedChain;
+    return fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size();
+}
+
+
+ResbufSnapshotReader::ResbufSnapshotReader(std::string_view data)
+{
+    pCursor = data.data();
+    pEnd = data.data() + data.size();
+    formatVersion = 0;
+    headerFlags = 0;
+    errorMessage = NULL;
+
+    if (data.substr(0, resbufSnapshotMagic.size()) != resbufSnapshotMagic) {
+        fail("not a resbuf snapshot");
+        return;
+    }
+    SnapshotDecoder decoder(pCursor + resbufSnapshotMagic.size(), pEnd);
+    unsigned long long version, flags;
+    if (!decoder.getVarint(version) || !decoder.getVarint(flags)) {
+        fail("truncated snapshot header");
+        return;
+    }
+    if (version != resbufSnapshotVersion) {
+        fail("unsupported snapshot version");
+        return;
+    }
+    formatVersion = (unsigned)version;
+    headerFlags = (unsigned)flags;
+    pCursor = decoder.cursor();
+}
+
+bool ResbufSnapshotReader::fail(const char* message)
+{
+    errorMessage = message;
+    pCursor = pEnd;
+    return false;
+}
+
+bool ResbufSnapshotReader::next(ResbufSnapshotEntry& entry)
+{
+    if (pCursor == pEnd) {
+        return false;
+    }
+    SnapshotDecoder decoder(pCursor, pEnd);
+    if (!decoder.getBytes(entry.key) || !decoder.getBytes(entry.chain)) {
+        return fail("truncated snapshot entry");
+    }
+    pCursor = decoder.cursor();
+    return true;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+// Compact binary snapshots of resbuf chains (acdbEntGet() results, XDATA).
+//
+// A snapshot file holds a sequence of keyed chains, so that the entity data
+// seen in one session can be written to disk, mapped back (see
+// mapped_file.h) in a later session or on Linux, and compared with the
+// current data without going back to the database.
+//
+// Format, version 2.  Integers are LEB128 varints; signed ones are zigzag
+// encoded first.  Doubles are raw little-endian IEEE 754.
+//
+//   file  := magic "RBSNAP\r\n\x1a" (9 bytes), varint version, varint flags,
+//            then entries up to the end of the file
+//   entry := varint key length, key bytes, varint chain length, chain
+//   chain := varint node count, nodes
+//   node  := zigzag restype, value
+//
+// The value is implied by the restype, typed by dxftype() and, for the
+// groups it does not type, by dxfValueKind() (dxf_reader.h): nothing (RTNONE,
+// RTLB, ...), 8 bytes for a real, 24 for a point, a zigzag integer of
+// exactly the value's width (16-bit, boolean, 32-bit and 64-bit values), a
+// varint length and the UTF-8 bytes of a string, a varint length and the
+// bytes of a binary chunk, a nested chain (RTRESBUF), or two zigzag
+// integers for entity names and for group codes no table types.  Version 1
+// wrote two integers for every untyped group, padding included.
+//
+// The encoding of a chain is canonical, so two chains are equal exactly if
+// their encodings are.  Entity names differ from session to session; with
+// keepEntityNames false they are encoded as zeros, so that snapshots of
+// different sessions compare equal if nothing else changed.
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string>
+#include <string_view>
+#include "arx_host.h"
+#include "resbuf_arena.h"
+
+constexpr std::string_view resbufSnapshotMagic("RBSNAP\r\n\x1a", 9);
+const unsigned resbufSnapshotVersion = 2;
+const unsigned kSnapshotEntityNamesKept = 1; // header flag
+
+// Appends the encoding of a chain to out.
+void encodeResbufChain(const resbuf* pChain, bool keepEntityNames, std::string& out);
+
+// Decodes a chain into an arena.  Returns false if the encoding is
+// malformed; pChain is then NULL.  An encoded empty chain decodes to NULL.
+bool decodeResbufChain(std::string_view encoded, ResbufArena& arena, resbuf*& pChain);
+
+class ResbufSnapshotWriter {
+    private:
+        FILE* out;
+        bool keepEntityNames;
+        std::string buffer;
+
+    public:
+        // The header is written immediately.
+        ResbufSnapshotWriter(FILE* out, bool keepEntityNames);
+
+        // Return false if the file cannot be written.
+        bool write(std::string_view key, const resbuf* pChain);
+        bool writeEncoded(std::string_view key, std::string_view encodedChain);
+};
+
+struct ResbufSnapshotEntry {
+    std::string_view key;
+    std::string_view chain; // encoded; see decodeResbufChain()
+};
+
+// Reads the entries of a snapshot, typically a mapped file.  Nothing is
+// copied; the entries are views into data.
+class ResbufSnapshotReader {
+    private:
+        const char* pCursor;
+        const char* pEnd;
+        unsigned formatVersion;
+        unsigned headerFlags;
+        const char* errorMessage;
+
+        bool fail(const char* message);
+
+    public:
+        explicit ResbufSnapshotReader(std::string_view data);
+
+        // Reads the next entry.  Returns false at the end of the snapshot, or
+        // if it is malformed (in which case failed() is true).
+        bool next(ResbufSnapshotEntry& entry);
+
+        unsigned version() const { return formatVersion; }
+        bool keepsEntityNames() const { return (headerFlags & kSnapshotEntityNamesKept) != 0; }
+        bool failed() const { return errorMessage != NULL; }
+        const char* error() const { return errorMessage; }
+};
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+#include <wchar.h>
+#include <string>
+#include "arx_host.h"
+#include "dxftype.h"
+
+// Owns a resbuf chain (releasing it with acutRelRb) and formats it for
+// printing.
+//
+// writeTo() formats into any sink that has an append(const wchar_t*, size_t)
+// member -- a std::wstring works, and a std::wstring that is clear()ed and
+// reused between calls keeps its capacity, so formatting a chain then does
+// no heap allocation at all.  Numbers are formatted into stack buffers with
+// the same conversions std::to_wstring uses.
+class ResbufWrapper {
+    private:
+       resbuf* pResbuf;
+
+       template <typename Sink, size_t length>
+       static void writeLiteral(Sink& sink, const wchar_t (&text)[length]) {
+           sink.append(text, length - 1);
+       }
+
+       template <typename Sink, typename Number>
+       static void writeNumber(Sink& sink, const wchar_t* format, Number value) {
+           // "%f" of the largest double is 316 characters.
+           wchar_t text[320];
+           int length = swprintf(text, sizeof(text) / sizeof(text[0]), format, value);
+           if (length > 0) {
+               sink.append(text, (size_t)length);
+           }
+       }
+
+       template <typename Sink>
+       static void writeResultTypeCode(Sink& sink, short resultTypeCode) {
+           const char* name = resultTypeCodeName(resultTypeCode);
+           if (name == NULL) {
+               writeLiteral(sink, L"UNKNOWN_RETURN_TYPE_CODE:");
+               writeNumber(sink, L"%d", (int)resultTypeCode);
+               return;
+           }
+           wchar_t text[32];
+           size_t length = 0;
+           for (; name[length] != '\0' && length < sizeof(text) / sizeof(text[0]); length++) {
+               text[length] = (wchar_t)name[length];
+           }
+           sink.append(text, length);
+       }
+
+       // Formats the chain starting at pHead; does not take ownership of it.
+       template <typename Sink>
+       static void writeChain(Sink& sink, const resbuf* pHead) {
+           writeLiteral(sink, L"resbuf:\n");
+           if (pHead == NULL) {
+               writeLiteral(sink, L"\tNULL");
+               return;
+           }
+           for (const resbuf* head = pHead; head != NULL; head = head->rbnext) {
+               int inxdata;
+               short resultTypeCode;
+               resultTypeCode = dxftype(head->restype, ET_NORM, &inxdata);
+               writeLiteral(sink, L"\ttype: ");
+               writeNumber(sink, L"%d", (int)head->restype);
+               writeLiteral(sink, L"(");
+               writeResultTypeCode(sink, resultTypeCode);
+               writeLiteral(sink, L"), value: ");
+
+               switch (resultTypeCode) {
+               case RTNONE:
+                   writeLiteral(sink, L"(none)");
+                   break;
+               case RTREAL:
+               case RTANG:
+                   writeNumber(sink, L"%f", head->resval.rreal);
+                   break;
+               case RTPOINT:
+               case RT3DPOINT:
+                   writeNumber(sink, L"%f", head->resval.rpoint[0]);
+                   writeLiteral(sink, L", ");
+                   writeNumber(sink, L"%f", head->resval.rpoint[1]);
+                   writeLiteral(sink, L", ");
+                   writeNumber(sink, L"%f", head->resval.rpoint[2]);
+                   break;
+               case RTSHORT:
+               case RTORINT:
+                   writeNumber(sink, L"%d", (int)head->resval.rint);
+                   break;
+               case RTSTR:
+                   if (resbufHoldsBinary(head->restype)) {
+                       // dxftype() types group 1004 as a string, but it holds a binary chunk.
+                       writeLiteral(sink, L"<binary chunk of ");
+                       writeNumber(sink, L"%d", (int)head->resval.rbinary.clen);
+                       writeLiteral(sink, L" bytes>");
+                   } else if (head->resval.rstring != NULL) {
+                       sink.append(head->resval.rstring, wcslen(head->resval.rstring));
+                   }
+                   break;
+               case RTENAME:
+               case RTPICKS:
+                   writeNumber(sink, L"%lld", (long long)head->resval.rlname[0]);
+                   writeLiteral(sink, L" ");
+                   writeNumber(sink, L"%lld", (long long)head->resval.rlname[1]);
+                   break;
+               case RTLONG:
+                   writeNumber(sink, L"%d", (int)head->resval.rlong);
+                   break;
+               case RTVOID:
+                   writeLiteral(sink, L"<void>");
+                   break;
+               case RTLB:
+                   writeLiteral(sink, L"<list begin>");
+                   break;
+               case RTLE:
+                   writeLiteral(sink, L"<list end>");
+                   break;
+               case RTDOTE:
+                   writeLiteral(sink, L"<dot>");
+                   break;
+               case RTNIL:
+                   writeLiteral(sink, L"<nil>");
+                   break;
+               case RTDXF0:
+                   writeLiteral(sink, L"<dxf0>");
+                   break;
+               case RTT:
+                   writeLiteral(sink, L"<t>");
+                   break;
+               case RTRESBUF:
+                   writeChain(sink, (const resbuf*)head->resval.mnLongPtr);
+                   break;
+               case RTMODELESS:
+                   writeLiteral(sink, L"<rtmodeless>");
+                   break;
+               default:
+                   writeLiteral(sink, L"value of resbuf of unknown type.");
+                   break;
+               }
+               writeLiteral(sink, L"\n");
+           }
+       }
+
+    public:
+        ResbufWrapper(resbuf* pResbuf) {
+            this->pResbuf = pResbuf;
+        }
+
+        ~ResbufWrapper() {
+            acutRelRb(pResbuf);
+        }
+
+        static std::wstring resultTypeCodeToString(short resultTypeCode) {
+            std::wstring returnValue;
+            writeResultTypeCode(returnValue, resultTypeCode);
+            return returnValue;
+        }
+
+        template <typename Sink>
+        void writeTo(Sink& sink) const {
+            writeChain(sink, pResbuf);
+        }
+
+        // Formats a chain that is not owned by a wrapper, e.g. one decoded
+        // into a ResbufArena.
+        template <typename Sink>
+        static void writeChainTo(Sink& sink, const resbuf* pChain) {
+            writeChain(sink, pChain);
+        }
+
+        std::wstring toString() const {
+            std::wstring returnValue;
+            writeTo(returnValue);
+            return returnValue;
+        }
+};
@@ -0,0 +1,762 @@
+// resbufbench: the resbuf chain code measured on long synthetic chains, in
+// the stand-in resbuf API (see arx_host.h).
+//
+// The chain is acdbEntGet()-like entity data followed by XDATA, with every
+// kind of value: strings, reals, angles, points, 16- and 32-bit integers,
+// entity names and binary chunks.  Each step checks its result before it is
+// timed, and is repeated for at least 50 ms:
+//
+//   format   ResbufWrapper::toString() and writeTo() into a reused buffer,
+//            against the concatenation of std::to_wstring() pieces that
+//            toString() used to be; all three must give the same text
+//   arena    ResbufArena::toHeapChain() and releaseHeapChain() against
+//            copyChain() into an arena that is reset() between chains; both
+//            must copy the chains nested in RTRESBUF nodes, so that the
+//            copies outlive the original
+//   flat     finding the strings of all groups 1000 by walking the chain,
+//            against FlatResbufChain::findRestype() on the flat form of it,
+//            and the cost of FlatResbufChain::assign(); the flat form must
+//            give the same strings, and convert back (toHeapChain() and
+//            toChain()) to a chain equal to the original
+//   filter   ResbufFilter::matches() of a compiled 9-group filter (block
+//            name wildcard, an OR of layers, >= on group 41, NOT & on group
+//            70, a per-coordinate point test, XDATA 1001/1000) against a
+//            naive interpretation of the filter list, which walks the list
+//            and the whole chain for every test, on --nodes block reference
+//            chains; both must agree on every chain.  The DxfRecord form is
+//            checked to fold the case of UTF-8 text by character.
+//   snapshot encodeResbufChain() and decodeResbufChain(); the chain must
+//            round-trip, and so must the groups dxftype() does not type
+//            (90, 110, 160, 280, 290, ...), whose encoding must not depend
+//            on the padding bytes of their values.
+//
+// Times are per run: one chain of --nodes nodes, or for the filter step,
+// --nodes chains.  Each comes with the heap allocations per run (counted by
+// the operator new of this program and the stand-in acutNewRb()).
+//
+// This is a standalone program; it does not link against ObjectARX:
+//
+//     g++ -std=c++17 -O2 -I ObjectARX_for_AutoCAD_2021_Win_64bit/inc resbufbench.cpp arx_host.cpp resbuf_arena.cpp resbuf_flat.cpp resbuf_filter.cpp resbuf_snapshot.cpp dxf_reader.cpp dxf_number.cpp -o resbufbench
+//
+// usage: resbufbench [--step format|arena|flat|filter|snapshot] [--nodes <n>]
+
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <functional>
+#include <wctype.h>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include "arx_host.h"
+#include "dxf_reader.h"
+#include "resbuf_arena.h"
+#include "resbuf_filter.h"
+#include "resbuf_flat.h"
+#include "resbuf_snapshot.h"
+#include "resbuf_wrapper.h"
+
+
+// Heap accounting: the number of blocks allocated with operator new.
+static size_t allocationCount = 0;
+
+void* operator new(size_t size)
+{
+    void* p = malloc(size > 0 ? size : 1);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    allocationCount++;
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+static size_t heapAllocationCount()
+{
+    ArxHostAllocationCounts counts = arxHostAllocationCounts();
+    return allocationCount + counts.nodesAllocated + counts.payloadsAllocated;
+}
+
+
+// Entity data of a block reference, then XDATA, repeated up to nodeCount
+// nodes.
+static resbuf* makeChain(size_t nodeCount)
+{
+    static const ACHAR* const strings[] = { L"INSERT", L"2A0", L"WELLS", L"WELL_ICON", L"WELL_MANAGER", L"Pump station 12" };
+    static const char binary[] = { 0x01, 0x02, 0x7F, (char)0x80, (char)0xFF };
+    resbuf head = {};
+    resbuf* pTail = &head;
+    for (size_t i = 0; i < nodeCount; i++) {
+        int step = (int)(i % 16);
+        double number = (double)i * 0.125;
+        switch (step) {
+        case 0:  pTail = pTail->rbnext = acutNewRb(-1); pTail->resval.rlname[0] = 0x7FF6A000 + (int64_t)i; break;
+        case 1:  pTail = pTail->rbnext = acutNewRb(0); pTail->resval.rstring = resbufNewString(strings[0], wcslen(strings[0])); break;
+        case 2:  pTail = pTail->rbnext = acutNewRb(5); pTail->resval.rstring = resbufNewString(strings[1], wcslen(strings[1])); break;
+        case 3:  pTail = pTail->rbnext = acutNewRb(8); pTail->resval.rstring = resbufNewString(strings[2], wcslen(strings[2])); break;
+        case 4:  pTail = pTail->rbnext = acutNewRb(2); pTail->resval.rstring = resbufNewString(strings[3], wcslen(strings[3])); break;
+        case 5:  pTail = pTail->rbnext = acutNewRb(10); pTail->resval.rpoint[0] = number; pTail->resval.rpoint[1] = -number; pTail->resval.rpoint[2] = 0.5; break;
+        case 6:  pTail = pTail->rbnext = acutNewRb(41); pTail->resval.rreal = 1.0 + number; break;
+        case 7:  pTail = pTail->rbnext = acutNewRb(50); pTail->resval.rreal = 0.785398; break;
+        case 8:  pTail = pTail->rbnext = acutNewRb(62); pTail->resval.rint = (short)(i % 256); break;
+        case 9:  pTail = pTail->rbnext = acutNewRb(1001); pTail->resval.rstring = resbufNewString(strings[4], wcslen(strings[4])); break;
+        case 10: pTail = pTail->rbnext = acutNewRb(1000); pTail->resval.rstring = resbufNewString(strings[5], wcslen(strings[5])); break;
+        case 11: pTail = pTail->rbnext = acutNewRb(1010); pTail->resval.rpoint[0] = number; pTail->resval.rpoint[1] = 2.0; pTail->resval.rpoint[2] = -3.0; break;
+        case 12: pTail = pTail->rbnext = acutNewRb(1040); pTail->resval.rreal = -number; break;
+        case 13: pTail = pTail->rbnext = acutNewRb(1070); pTail->resval.rint = (short)-(int)(i % 1000); break;
+        case 14: pTail = pTail->rbnext = acutNewRb(1071); pTail->resval.rlong = (int32_t)(i * 7919); break;
+        default:
+            pTail = pTail->rbnext = acutNewRb(1004);
+            pTail->resval.rbinary.clen = (short)sizeof(binary);
+            pTail->resval.rbinary.buf = resbufNewBinary(binary, sizeof(binary));
+            break;
+        }
+    }
+    return head.rbnext;
+}
+
+// A chain with two others nested in it.  Release with
+// ResbufArena::releaseHeapChain().
+static resbuf* makeNestingChain(size_t nodeCount)
+{
+    resbuf* pChain = acutNewRb(RTLB);
+    resbuf* pTail = pChain->rbnext = acutNewRb(RTRESBUF);
+    pTail->resval.mnLongPtr = (decltype(pTail->resval.mnLongPtr))makeChain(nodeCount / 2);
+    pTail = pTail->rbnext = acutNewRb(RTRESBUF);
+    resbuf* pInner = acutNewRb(RTRESBUF);
+    pInner->resval.mnLongPtr = (decltype(pInner->resval.mnLongPtr))makeChain(nodeCount / 2);
+    pTail->resval.mnLongPtr = (decltype(pTail->resval.mnLongPtr))pInner;
+    pTail->rbnext = acutNewRb(RTLE);
+    return pChain;
+}
+
+static std::wstring formatChain(const resbuf* pChain)
+{
+    std::wstring text;
+    ResbufWrapper::writeChainTo(text, pChain);
+    return text;
+}
+
+// Whether two chains of makeChain() (whose nodes are zeroed before their
+// values are set) hold the same groups and values.
+static bool chainsEqual(const resbuf* pChain, const resbuf* pOther)
+{
+    for (; pChain != NULL && pOther != NULL; pChain = pChain->rbnext, pOther = pOther->rbnext) {
+        if (pChain->restype != pOther->restype) {
+            return false;
+        }
+        if (resbufHoldsString(pChain->restype)) {
+            if (wcscmp(pChain->resval.rstring, pOther->resval.rstring) != 0) {
+                return false;
+            }
+        } else if (resbufHoldsBinary(pChain->restype)) {
+            if (pChain->resval.rbinary.clen != pOther->resval.rbinary.clen
+                || memcmp(pChain->resval.rbinary.buf, pOther->resval.rbinary.buf, (size_t)pChain->resval.rbinary.clen) != 0) {
+                return false;
+            }
+        } else if (memcmp(&pChain->resval, &pOther->resval, sizeof(pChain->resval)) != 0) {
+            return false;
+        }
+    }
+    return pChain == NULL && pOther == NULL;
+}
+
+
+typedef std::chrono::steady_clock Clock;
+
+// Runs step at least once and until 50 ms have passed, and prints its time
+// and allocations per run.
+static void measure(const char* stepName, size_t nodeCount, const char* variant, const std::function<void()>& step)
+{
+    size_t baseAllocations = heapAllocationCount();
+    size_t repetitions = 0;
+    Clock::time_point startTime = Clock::now();
+    double seconds;
+    do {
+        step();
+        repetitions++;
+        seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    } while (seconds < 0.05);
+    printf("%-8s %7zu  %-22s %7zu %10.3f %12.1f\n",
+        stepName, nodeCount, variant, repetitions, seconds * 1.0e3 / repetitions,
+        (double)(heapAllocationCount() - baseAllocations) / repetitions);
+    fflush(stdout);
+}
+
+
+// What ResbufWrapper::toString() was before writeTo(), for the value kinds
+// of the benchmark chain.
+static std::wstring formatByConcatenation(const resbuf* pChain)
+{
+    std::wstring returnValue;
+    returnValue += L"resbuf:\n";
+    for (const resbuf* head = pChain; head != NULL; head = head->rbnext) {
+        int inxdata;
+        short resultTypeCode = dxftype(head->restype, ET_NORM, &inxdata);
+        returnValue += std::wstring(L"\t") + L"type: " + std::to_wstring(head->restype) + L"(" + ResbufWrapper::resultTypeCodeToString(resultTypeCode) + L")" + L", ";
+        returnValue += std::wstring(L"value: ");
+        switch (resultTypeCode) {
+        case RTREAL:
+        case RTANG:
+            returnValue += std::to_wstring(head->resval.rreal);
+            break;
+        case RTPOINT:
+        case RT3DPOINT:
+            returnValue += std::to_wstring(head->resval.rpoint[0]) + L", " + std::to_wstring(head->resval.rpoint[1]) + L", " + std::to_wstring(head->resval.rpoint[2]) + L"";
+            break;
+        case RTSHORT:
+            returnValue += std::to_wstring(head->resval.rint);
+            break;
+        case RTSTR:
+            if (resbufHoldsBinary(head->restype)) {
+                returnValue += L"<binary chunk of " + std::to_wstring(head->resval.rbinary.clen) + L" bytes>";
+            } else {
+                returnValue += head->resval.rstring;
+            }
+            break;
+        case RTENAME:
+            returnValue += std::to_wstring(head->resval.rlname[0]) + L" " + std::to_wstring(head->resval.rlname[1]) + L"";
+            break;
+        case RTLONG:
+            returnValue += std::to_wstring(head->resval.rlong);
+            break;
+        default:
+            returnValue += L"(none)";
+            break;
+        }
+        returnValue += L"\n";
+    }
+    return returnValue;
+}
+
+static bool benchmarkFormat(size_t nodeCount)
+{
+    resbuf* pChain = makeChain(nodeCount);
+    ResbufWrapper chain(pChain);
+    std::wstring buffer;
+    chain.writeTo(buffer);
+    if (buffer != chain.toString() || buffer != formatByConcatenation(pChain)) {
+        fprintf(stderr, "resbufbench: the formats of the chain differ\n");
+        return false;
+    }
+
+    measure("format", nodeCount, "concatenation", [&]() {
+        formatByConcatenation(pChain);
+    });
+    measure("format", nodeCount, "toString", [&]() {
+        chain.toString();
+    });
+    measure("format", nodeCount, "writeTo reused buffer", [&]() {
+        buffer.clear();
+        chain.writeTo(buffer);
+    });
+    return true;
+}
+
+static bool benchmarkArena(size_t nodeCount)
+{
+    ResbufArena arena;
+    resbuf* pNesting = makeNestingChain(nodeCount);
+    std::wstring expected = formatChain(pNesting);
+    resbuf* pArenaCopy = arena.copyChain(pNesting);
+    resbuf* pHeapCopy = ResbufArena::toHeapChain(pNesting);
+    ResbufArena::releaseHeapChain(pNesting);
+    bool copied = formatChain(pArenaCopy) == expected && formatChain(pHeapCopy) == expected;
+    ResbufArena::releaseHeapChain(pHeapCopy);
+    if (!copied) {
+        fprintf(stderr, "resbufbench: a copy of the nesting chain differs from the original\n");
+        return false;
+    }
+
+    arena.reset();
+    resbuf* pChain = makeChain(nodeCount);
+    measure("arena", nodeCount, "heap copy and release", [&]() {
+        ResbufArena::releaseHeapChain(ResbufArena::toHeapChain(pChain));
+    });
+    measure("arena", nodeCount, "arena copy and reset", [&]() {
+        arena.copyChain(pChain);
+        arena.reset();
+    });
+    printf("%-8s %7zu  %zu KB of arena blocks, kept between chains\n", "arena", nodeCount, arena.bytesReserved() / 1024);
+    acutRelRb(pChain);
+    return true;
+}
+
+static bool benchmarkFlat(size_t nodeCount)
+{
+    const short stringGroup = 1000;
+    resbuf* pChain = makeChain(nodeCount);
+    FlatResbufChain flat;
+    flat.assign(pChain);
+
+    ResbufArena arena;
+    resbuf* pHeapChain = flat.toHeapChain();
+    bool roundTripped = chainsEqual(pChain, pHeapChain) && chainsEqual(pChain, flat.toChain(arena));
+    acutRelRb(pHeapChain);
+    if (!roundTripped) {
+        fprintf(stderr, "resbufbench: the chain converted to the flat form and back differs\n");
+        acutRelRb(pChain);
+        return false;
+    }
+
+    std::vector<const ACHAR*> strings;
+    std::vector<const ACHAR*> flatStrings;
+    std::vector<size_t> indexes;
+    auto findInChain = [&]() {
+        strings.clear();
+        for (const resbuf* rb = pChain; rb != NULL; rb = rb->rbnext) {
+            if (rb->restype == stringGroup) {
+                strings.push_back(rb->resval.rstring);
+            }
+        }
+    };
+    auto findInFlat = [&]() {
+        flatStrings.clear();
+        indexes.clear();
+        flat.findRestype(stringGroup, indexes);
+        for (size_t index : indexes) {
+            flatStrings.push_back(flat.string(index));
+        }
+    };
+    findInChain();
+    findInFlat();
+    bool found = strings.size() == flatStrings.size();
+    for (size_t i = 0; found && i < strings.size(); i++) {
+        found = wcscmp(strings[i], flatStrings[i]) == 0;
+    }
+    if (!found) {
+        fprintf(stderr, "resbufbench: the flat form finds other groups %d than the chain\n", (int)stringGroup);
+        acutRelRb(pChain);
+        return false;
+    }
+
+    measure("flat", nodeCount, "find 1000s in chain", findInChain);
+    measure("flat", nodeCount, "find 1000s in flat", findInFlat);
+    measure("flat", nodeCount, "assign", [&]() {
+        flat.assign(pChain);
+    });
+    printf("%-8s %7zu  %zu groups %d found\n", "flat", nodeCount, strings.size(), (int)stringGroup);
+    acutRelRb(pChain);
+    return true;
+}
+
+
+// The filter list, interpreted as it stands: every test walks the whole
+// chain.  Strings take the * and ? wildcards only, which is all the filter
+// of the benchmark uses.
+static std::wstring upperCase(const ACHAR* text)
+{
+    std::wstring result;
+    for (; *text != 0; text++) {
+        result += (wchar_t)towupper((wint_t)*text);
+    }
+    return result;
+}
+
+static bool naiveWildcardMatch(const wchar_t* pattern, const wchar_t* text)
+{
+    if (*pattern == 0) {
+        return *text == 0;
+    }
+    if (*pattern == L'*') {
+        return naiveWildcardMatch(pattern + 1, text) || (*text != 0 && naiveWildcardMatch(pattern, text + 1));
+    }
+    return *text != 0 && (*pattern == L'?' || *pattern == *text) && naiveWildcardMatch(pattern + 1, text + 1);
+}
+
+static bool naiveCompare(const std::wstring& op, double value, double reference)
+{
+    if (op == L"*")  { return true; }
+    if (op == L"!=" || op == L"/=" || op == L"<>") { return value != reference; }
+    if (op == L"<")  { return value < reference; }
+    if (op == L"<=") { return value <= reference; }
+    if (op == L">")  { return value > reference; }
+    if (op == L">=") { return value >= reference; }
+    if (op == L"&")  { return ((long long)value & (long long)reference) != 0; }
+    return value == reference;
+}
+
+static bool naiveTest(const resbuf* pTest, const ACHAR* relationalOperator, const resbuf* pChain)
+{
+    std::wstring op = relationalOperator != NULL ? upperCase(relationalOperator) : L"=";
+    int inxdata;
+    short resultTypeCode = dxftype(pTest->restype, ET_NORM, &inxdata);
+    for (const resbuf* rb = pChain; rb != NULL; rb = rb->rbnext) {
+        if (rb->restype != pTest->restype) {
+            continue;
+        }
+        bool result = false;
+        switch (resultTypeCode) {
+        case RTSTR: {
+            bool matched = naiveWildcardMatch(upperCase(pTest->resval.rstring).c_str(), upperCase(rb->resval.rstring).c_str());
+            result = (op == L"=") ? matched : !matched;
+            break;
+        }
+        case RTREAL:
+        case RTANG:
+            result = naiveCompare(op, rb->resval.rreal, pTest->resval.rreal);
+            break;
+        case RTSHORT:
+            result = naiveCompare(op, rb->resval.rint, pTest->resval.rint);
+            break;
+        case RTLONG:
+            result = naiveCompare(op, rb->resval.rlong, pTest->resval.rlong);
+            break;
+        case RT3DPOINT: {
+            // one operator per coordinate, or one for all three.
+            std::wstring ops[3] = { op, op, op };
+            if (op.find(L',') != std::wstring::npos) {
+                size_t first = op.find(L',');
+                size_t second = op.find(L',', first + 1);
+                ops[0] = op.substr(0, first);
+                ops[1] = op.substr(first + 1, second - first - 1);
+                ops[2] = op.substr(second + 1);
+            }
+            result = true;
+            for (int i = 0; i < 3; i++) {
+                result = result && naiveCompare(ops[i], rb->resval.rpoint[i], pTest->resval.rpoint[i]);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+        if (result) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Evaluates the operands up to closingOperator, or to the end of the list,
+// and leaves pFilter after them.
+static void naiveOperands(const resbuf*& pFilter, const resbuf* pChain, const wchar_t* closingOperator, std::vector<bool>& results)
+{
+    const ACHAR* relationalOperator = NULL;
+    while (pFilter != NULL) {
+        if (pFilter->restype != -4) {
+            results.push_back(naiveTest(pFilter, relationalOperator, pChain));
+            relationalOperator = NULL;
+            pFilter = pFilter->rbnext;
+            continue;
+        }
+        const ACHAR* operatorText = pFilter->resval.rstring;
+        std::wstring op = upperCase(operatorText);
+        pFilter = pFilter->rbnext;
+        if (op == L"<AND" || op == L"<OR" || op == L"<XOR" || op == L"<NOT") {
+            std::vector<bool> operands;
+            naiveOperands(pFilter, pChain, (op.substr(1) + L">").c_str(), operands);
+            bool result = (op == L"<AND");
+            for (bool operand : operands) {
+                result = (op == L"<AND") ? result && operand : result || operand;
+            }
+            if (op == L"<XOR") {
+                result = operands[0] != operands[1];
+            } else if (op == L"<NOT") {
+                result = !operands[0];
+            }
+            results.push_back(result);
+        } else if (closingOperator != NULL && op == closingOperator) {
+            return;
+        } else {
+            relationalOperator = operatorText;
+        }
+    }
+}
+
+static bool naiveMatches(const resbuf* pFilter, const resbuf* pChain)
+{
+    std::vector<bool> results;
+    naiveOperands(pFilter, pChain, NULL, results);
+    for (bool result : results) {
+        if (!result) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Block references with XDATA, with the values the filter tests drawn at
+// random.
+static std::vector<resbuf*> makeBlockReferences(ResbufArena& arena, size_t count)
+{
+    static const ACHAR* const types[] = { L"INSERT", L"LINE", L"CIRCLE", L"INSERT" };
+    static const ACHAR* const blocks[] = { L"injectionWellWithNoConstituentsOfConcernInPerchedGroundwater", L"monitoringWell", L"INJECTIONWELL_B", L"tree" };
+    static const ACHAR* const layers[] = { L"WELLS", L"0", L"Wells-Proposed", L"ROADS" };
+    static const ACHAR* const states[] = { L"ACTIVE", L"PLUGGED" };
+    std::mt19937 random(7);
+    std::vector<resbuf*> chains;
+    for (size_t i = 0; i < count; i++) {
+        ResbufChainBuilder builder(arena);
+        double position[3] = { (double)(random() % 1000), (double)(random() % 1000), 0.0 };
+        double normal[3] = { 0.0, 0.0, 1.0 };
+        builder.appendString(0, types[random() % 4]);
+        builder.appendString(5, L"1F3A");
+        builder.appendString(100, L"AcDbEntity");
+        builder.appendString(8, layers[random() % 4]);
+        builder.appendString(100, L"AcDbBlockReference");
+        builder.appendString(2, blocks[random() % 4]);
+        builder.appendPoint(10, position);
+        builder.appendReal(41, (random() % 4) * 0.75);
+        builder.appendReal(42, 1.0);
+        builder.appendReal(43, 1.0);
+        builder.appendReal(50, 0.0);
+        builder.appendShort(70, (short)(random() % 8));
+        builder.appendPoint(210, normal);
+        builder.append(-3);
+        builder.appendString(1001, L"WELLTAG");
+        builder.appendString(1000, states[random() % 2]);
+        builder.appendString(1000, L"note");
+        builder.appendLong(1071, (int32_t)i);
+        chains.push_back(builder.head());
+    }
+    return chains;
+}
+
+// Whether the filter folds the case of the UTF-8 text of DXF records
+// character by character: "brunnen-ä" must match "BRUNNEN-Ä".
+static bool checkUtf8Records()
+{
+    static const char dxf[] = "  0\nINSERT\n  8\nBRUNNEN-\xC3\x84\n  2\nQuelle-\xF0\x9D\x94\x9A\n  0\nEOF\n";
+    DxfReader reader{ std::string_view(dxf, sizeof(dxf) - 1) };
+    std::vector<DxfRecord> records;
+    DxfRecord record;
+    while (reader.next(record) && !(record.groupCode == 0 && record.value() == "EOF")) {
+        records.push_back(record);
+    }
+    ResbufArena arena;
+    static const struct { const ACHAR* layer; const ACHAR* block; bool expected; } cases[] = {
+        { L"brunnen-\u00E4", L"*", true },
+        { L"BRUNNEN-?", L"quelle-?", true },
+        { L"brunnen-a", L"*", false },
+        { L"brunnen-\u00C3*", L"*", false },
+    };
+    for (const auto& check : cases) {
+        ResbufChainBuilder builder(arena);
+        builder.appendString(8, check.layer);
+        builder.appendString(2, check.block);
+        ResbufFilter filter;
+        if (!filter.compile(builder.head()) || filter.matches(records.data(), records.size()) != check.expected) {
+            fprintf(stderr, "resbufbench: layer %ls, block %ls does not %s the UTF-8 records\n", check.layer, check.block, check.expected ? "match" : "reject");
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool benchmarkFilter(size_t nodeCount)
+{
+    if (!checkUtf8Records()) {
+        return false;
+    }
+
+    ResbufArena filterArena;
+    ResbufChainBuilder builder(filterArena);
+    double corner[3] = { 500.0, 200.0, 0.0 };
+    builder.appendString(-4, L"<AND");
+    builder.appendString(0, L"INSERT");
+    builder.appendString(2, L"injectionWell*");
+    builder.appendString(-4, L"<OR");
+    builder.appendString(8, L"WELLS");
+    builder.appendString(8, L"wells-proposed");
+    builder.appendString(-4, L"OR>");
+    builder.appendString(-4, L">=");
+    builder.appendReal(41, 1.5);
+    builder.appendString(-4, L"<NOT");
+    builder.appendString(-4, L"&");
+    builder.appendShort(70, 4);
+    builder.appendString(-4, L"NOT>");
+    builder.appendString(-4, L"<,>,*");
+    builder.appendPoint(10, corner);
+    builder.appendString(1001, L"WELLTAG");
+    builder.appendString(1000, L"ACTIVE");
+    builder.appendString(-4, L"AND>");
+    ResbufFilter filter;
+    if (!filter.compile(builder.head())) {
+        fprintf(stderr, "resbufbench: the filter does not compile: %s\n", filter.error().c_str());
+        return false;
+    }
+
+    ResbufArena arena;
+    std::vector<resbuf*> chains = makeBlockReferences(arena, nodeCount);
+    size_t matchCount = 0;
+    for (const resbuf* pChain : chains) {
+        bool matched = filter.matches(pChain);
+        if (matched != naiveMatches(builder.head(), pChain)) {
+            fprintf(stderr, "resbufbench: the compiled filter and the interpretation of the list disagree\n");
+            return false;
+        }
+        matchCount += matched;
+    }
+
+    measure("filter", nodeCount, "compiled", [&]() {
+        for (const resbuf* pChain : chains) {
+            filter.matches(pChain);
+        }
+    });
+    measure("filter", nodeCount, "naive interpretation", [&]() {
+        for (const resbuf* pChain : chains) {
+            naiveMatches(builder.head(), pChain);
+        }
+    });
+    printf("%-8s %7zu  %zu of the chains match\n", "filter", nodeCount, matchCount);
+    return true;
+}
+
+
+// Groups that dxftype() leaves as RTNONE, one of each value width, in nodes
+// whose every byte is set to padding before the value is: an uninitialized
+// resbuf holds whatever was there.
+static resbuf* makeUntypedGroups(ResbufArena& arena, unsigned char padding)
+{
+    static const short groups[] = { 90, 110, 160, 280, 290, 370, 420, 460 };
+    resbuf head = {};
+    resbuf* pTail = &head;
+    for (short group : groups) {
+        pTail = pTail->rbnext = arena.newRb(group);
+        memset(&pTail->resval, padding, sizeof(pTail->resval));
+        switch (group) {
+        case 90:  pTail->resval.rlong = -123456; break;
+        case 110: pTail->resval.rpoint[0] = 1.5; pTail->resval.rpoint[1] = -2.5; pTail->resval.rpoint[2] = 3.25; break;
+        case 160: pTail->resval.mnInt64 = -0x123456789A; break;
+        case 280: pTail->resval.rint = 7; break;
+        case 290: pTail->resval.rint = 1; break;
+        case 370: pTail->resval.rint = -3; break;
+        case 420: pTail->resval.rlong = 0x00C0FFEE; break;
+        default:  pTail->resval.rreal = 0.1; break;
+        }
+    }
+    return head.rbnext;
+}
+
+// Whether the values of makeUntypedGroups() are equal, at their widths.
+static bool untypedGroupsEqual(const resbuf* pChain, const resbuf* pOther)
+{
+    for (; pChain != NULL && pOther != NULL; pChain = pChain->rbnext, pOther = pOther->rbnext) {
+        bool equal = pChain->restype == pOther->restype;
+        switch (pChain->restype) {
+        case 90:
+        case 420:
+            equal = equal && pChain->resval.rlong == pOther->resval.rlong;
+            break;
+        case 110:
+            equal = equal && memcmp(pChain->resval.rpoint, pOther->resval.rpoint, sizeof(pChain->resval.rpoint)) == 0;
+            break;
+        case 160:
+            equal = equal && pChain->resval.mnInt64 == pOther->resval.mnInt64;
+            break;
+        case 460:
+            equal = equal && pChain->resval.rreal == pOther->resval.rreal;
+            break;
+        default:
+            equal = equal && pChain->resval.rint == pOther->resval.rint;
+            break;
+        }
+        if (!equal) {
+            return false;
+        }
+    }
+    return pChain == NULL && pOther == NULL;
+}
+
+static bool benchmarkSnapshot(size_t nodeCount)
+{
+    ResbufArena arena;
+    std::string encoded;
+    std::string encodedPadded;
+    resbuf* pUntyped = makeUntypedGroups(arena, 0x00);
+    encodeResbufChain(pUntyped, true, encoded);
+    encodeResbufChain(makeUntypedGroups(arena, 0xA5), true, encodedPadded);
+    if (encoded != encodedPadded) {
+        fprintf(stderr, "resbufbench: the encoding of groups 90-460 depends on the padding of their values\n");
+        return false;
+    }
+    resbuf* pDecoded;
+    if (!decodeResbufChain(encoded, arena, pDecoded) || !untypedGroupsEqual(pUntyped, pDecoded)) {
+        fprintf(stderr, "resbufbench: groups 90-460 do not survive a snapshot round trip\n");
+        return false;
+    }
+
+    resbuf* pChain = makeChain(nodeCount);
+    encoded.clear();
+    encodeResbufChain(pChain, true, encoded);
+    if (!decodeResbufChain(encoded, arena, pDecoded) || !chainsEqual(pChain, pDecoded)) {
+        fprintf(stderr, "resbufbench: the chain does not survive a snapshot round trip\n");
+        acutRelRb(pChain);
+        return false;
+    }
+    arena.reset();
+
+    measure("snapshot", nodeCount, "encode", [&]() {
+        encoded.clear();
+        encodeResbufChain(pChain, true, encoded);
+    });
+    measure("snapshot", nodeCount, "decode", [&]() {
+        decodeResbufChain(encoded, arena, pDecoded);
+        arena.reset();
+    });
+    printf("%-8s %7zu  %zu bytes encoded\n", "snapshot", nodeCount, encoded.size());
+    acutRelRb(pChain);
+    return true;
+}
+
+
+struct Step {
+    const char* name;
+    bool (*run)(size_t nodeCount);
+};
+
+static const Step steps[] = {
+    { "format", benchmarkFormat },
+    { "arena", benchmarkArena },
+    { "flat", benchmarkFlat },
+    { "filter", benchmarkFilter },
+    { "snapshot", benchmarkSnapshot },
+};
+
+int main(int argc, char** argv)
+{
+    const char* stepName = NULL;
+    size_t nodeCount = 10000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--step") == 0 && i + 1 < argc) {
+            stepName = argv[++i];
+        } else if (strcmp(argv[i], "--nodes") == 0 && i + 1 < argc) {
+            nodeCount = (size_t)atol(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: resbufbench [--step format|arena|flat|filter|snapshot] [--nodes <n>]\n");
+            return 2;
+        }
+    }
+
+    // towupper() folds only ASCII letters in the C locale.
+    setlocale(LC_CTYPE, "C.UTF-8");
+    printf("%-8s %7s  %-22s %7s %10s %12s\n", "step", "nodes", "variant", "reps", "ms/run", "allocs/run");
+    bool found = false;
+    for (const Step& step : steps) {
+        if (stepName != NULL && strcmp(stepName, step.name) != 0) {
+            continue;
+        }
+        found = true;
+        if (!step.run(nodeCount)) {
+            return 1;
+        }
+    }
+    if (!found) {
+        fprintf(stderr, "resbufbench: unknown step %s\n", stepName);
+        return 2;
+    }
+    return 0;
+}
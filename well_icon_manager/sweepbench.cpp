@@ -0,0 +1,215 @@
+// sweepbench: DynBlockSweep (see dynblock_sweep.h) run against the stand-in
+// dynamic block reference (see dynblock_sweep_standin.h).
+//
+//   check    a stand-in well icon of 8 visibility states x 5 sizes x 4 label
+//            positions x 2 flips, whose flip draws nothing different, so
+//            that the 320 combinations have 160 distinct outcomes.  The
+//            sweep must evaluate each combination once with one setValue()
+//            each, describe each anonymous block once (160 times if the
+//            stand-in shares anonymous blocks, 320 if not), evaluate nothing
+//            when run again, and only the 64 new combinations when a sixth
+//            size is added; and the outcome of every combination must be
+//            the geometry the stand-in drew for it
+//   time     fresh sweeps of icons with 2 to --max-properties properties of
+//            4 values each (the geometry depends on the first three), with
+//            shared anonymous blocks, and a run again of each (which only
+//            looks up what is memoized); the times are per combination, each
+//            sweep repeated for at least 50 ms
+//
+// This is a standalone program; it does not link against ObjectARX:
+//
+//     g++ -std=c++17 -O2 sweepbench.cpp dynblock_sweep.cpp dynblock_sweep_standin.cpp -o sweepbench
+//
+// usage: sweepbench [--step check|time] [--max-properties <n>]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include "dynblock_sweep.h"
+#include "dynblock_sweep_standin.h"
+
+
+// The geometry of the stand-in well icon; the flip (property 3) is
+// symmetric, so it makes no difference.
+static std::string wellIconGeometry(const std::vector<uint32_t>& values)
+{
+    std::string geometry = "visibility " + std::to_string(values[0]) + ", size " + std::to_string(values[1]);
+    if (values.size() > 2) {
+        geometry += ", label " + std::to_string(values[2]);
+    }
+    return geometry;
+}
+
+static std::vector<std::string> valueLabels(uint32_t count)
+{
+    std::vector<std::string> labels;
+    for (uint32_t i = 0; i < count; i++) {
+        labels.push_back(std::to_string(i));
+    }
+    return labels;
+}
+
+static void addWellIconProperties(DynBlockSweep& sweep)
+{
+    sweep.addProperty("Visibility", valueLabels(8));
+    sweep.addProperty("Size", valueLabels(5));
+    sweep.addProperty("Label position", valueLabels(4));
+    sweep.addProperty("Flip", valueLabels(2));
+}
+
+// Whether the outcome of every combination of the sweep describes the
+// geometry of that combination.
+static bool outcomesMatchGeometry(const DynBlockSweep& sweep)
+{
+    const std::vector<DynBlockSweepProperty>& properties = sweep.sweptProperties();
+    std::vector<uint32_t> values(properties.size(), 0);
+    for (uint64_t combination = 0; combination < sweep.combinationCount(); combination++) {
+        uint64_t rest = combination;
+        for (size_t p = 0; p < properties.size(); p++) {
+            values[p] = (uint32_t)(rest % properties[p].values.size());
+            rest /= properties[p].values.size();
+        }
+        uint32_t outcome = sweep.outcomeOf(values);
+        if (outcome == DynBlockSweep::npos || sweep.outcomeDescription(outcome) != wellIconGeometry(values)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool expectCount(const char* what, size_t count, size_t expected)
+{
+    if (count != expected) {
+        fprintf(stderr, "sweepbench: %s: %zu, expected %zu\n", what, count, expected);
+        return false;
+    }
+    return true;
+}
+
+static bool checkWellIcon(bool shareAnonymousBlocks)
+{
+    DynBlockSweep sweep;
+    addWellIconProperties(sweep);
+    StandInDynBlockTarget target(4, wellIconGeometry, shareAnonymousBlocks);
+    if (!sweep.run(target)) {
+        fprintf(stderr, "sweepbench: the sweep failed: %s\n", sweep.error());
+        return false;
+    }
+    bool passed = expectCount("evaluations", sweep.evaluations, 320)
+        && expectCount("values set", sweep.valuesSet, 319)
+        && expectCount("outcomes", sweep.outcomeCount(), 160)
+        && expectCount("descriptions", sweep.descriptions, shareAnonymousBlocks ? 160 : 320);
+    printf("%s anonymous blocks: %zu evaluations, %zu values set, %zu descriptions, %zu outcomes\n",
+        shareAnonymousBlocks ? "shared" : "unshared", sweep.evaluations, sweep.valuesSet, sweep.descriptions, sweep.outcomeCount());
+
+    passed = passed && sweep.run(target) && expectCount("evaluations of a run again", sweep.evaluations, 320);
+    sweep.addValue(1, "5");
+    passed = passed && sweep.run(target) && expectCount("evaluations after a sixth size", sweep.evaluations - 320, 64);
+    if (passed && !outcomesMatchGeometry(sweep)) {
+        fprintf(stderr, "sweepbench: an outcome differs from the geometry of its combination\n");
+        passed = false;
+    }
+    return passed;
+}
+
+static bool runChecks(uint32_t)
+{
+    return checkWellIcon(true) && checkWellIcon(false);
+}
+
+
+typedef std::chrono::steady_clock Clock;
+
+// Runs step at least once and until 50 ms have passed, and returns the time
+// per run in seconds.
+static double secondsPerRun(const std::function<void()>& step)
+{
+    size_t repetitions = 0;
+    Clock::time_point startTime = Clock::now();
+    double seconds;
+    do {
+        step();
+        repetitions++;
+        seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    } while (seconds < 0.05);
+    return seconds / repetitions;
+}
+
+static bool timeSweeps(uint32_t maxPropertyCount)
+{
+    printf("%-10s %12s %10s %12s %12s\n", "properties", "combinations", "outcomes", "sweep ns", "run again ns");
+    for (uint32_t propertyCount = 2; propertyCount <= maxPropertyCount; propertyCount++) {
+        auto addProperties = [&](DynBlockSweep& sweep) {
+            for (uint32_t p = 0; p < propertyCount; p++) {
+                sweep.addProperty("Property" + std::to_string(p), valueLabels(4));
+            }
+        };
+        DynBlockSweep sweep;
+        addProperties(sweep);
+        StandInDynBlockTarget target(propertyCount, wellIconGeometry, true);
+        if (!sweep.run(target)) {
+            fprintf(stderr, "sweepbench: the sweep failed: %s\n", sweep.error());
+            return false;
+        }
+        double combinations = (double)sweep.combinationCount();
+        double sweepSeconds = secondsPerRun([&]() {
+            DynBlockSweep fresh;
+            addProperties(fresh);
+            StandInDynBlockTarget freshTarget(propertyCount, wellIconGeometry, true);
+            fresh.run(freshTarget);
+        });
+        double runAgainSeconds = secondsPerRun([&]() {
+            sweep.run(target);
+        });
+        printf("%-10u %12.0f %10zu %12.1f %12.1f\n", propertyCount, combinations, sweep.outcomeCount(),
+            sweepSeconds * 1.0e9 / combinations, runAgainSeconds * 1.0e9 / combinations);
+        fflush(stdout);
+    }
+    return true;
+}
+
+struct Step {
+    const char* name;
+    bool (*run)(uint32_t maxPropertyCount);
+};
+
+static const Step steps[] = {
+    { "check", runChecks },
+    { "time", timeSweeps },
+};
+
+int main(int argc, char** argv)
+{
+    const char* stepName = NULL;
+    uint32_t maxPropertyCount = 8;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--step") == 0 && i + 1 < argc) {
+            stepName = argv[++i];
+        } else if (strcmp(argv[i], "--max-properties") == 0 && i + 1 < argc) {
+            maxPropertyCount = (uint32_t)atol(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: sweepbench [--step check|time] [--max-properties <n>]\n");
+            return 2;
+        }
+    }
+
+    bool found = false;
+    for (const Step& step : steps) {
+        if (stepName != NULL && strcmp(stepName, step.name) != 0) {
+            continue;
+        }
+        found = true;
+        if (!step.run(maxPropertyCount)) {
+            return 1;
+        }
+    }
+    if (!found) {
+        fprintf(stderr, "sweepbench: unknown step %s\n", stepName);
+        return 2;
+    }
+    return 0;
+}
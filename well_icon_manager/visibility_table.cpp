@@ -0,0 +1,191 @@
+#include "visibility_table.h"
+#include <string.h>
+
+
+VisibilityTable::VisibilityTable()
+{
+    wordsPerEntity = 0;
+}
+
+void VisibilityTable::clear()
+{
+    states.clear();
+    entities.clear();
+    wordsPerEntity = 0;
+    bits.clear();
+}
+
+void VisibilityTable::resize(size_t stateCount)
+{
+    states.resize(stateCount);
+    wordsPerEntity = (stateCount + 63) / 64;
+    bits.assign(entities.size() * wordsPerEntity, 0);
+}
+
+uint32_t VisibilityTable::addEntity(const ads_name name)
+{
+    uint32_t entity = entityIndex(name);
+    if (entity == npos) {
+        EntityName entityName;
+        entityName.name[0] = name[0];
+        entityName.name[1] = name[1];
+        entities.push_back(entityName);
+        bits.resize(entities.size() * wordsPerEntity, 0);
+        entity = (uint32_t)entities.size() - 1;
+    }
+    return entity;
+}
+
+bool VisibilityTable::assignFromParameter(const resbuf* pParameterData)
+{
+    clear();
+    const resbuf* rb = pParameterData;
+    for (; rb != NULL && rb->restype != 93; rb = rb->rbnext) {}
+    if (rb == NULL) {
+        return false;
+    }
+    for (rb = rb->rbnext; rb != NULL && rb->restype == 331; rb = rb->rbnext) {
+        addEntity(rb->resval.rlname);
+    }
+    for (; rb != NULL && rb->restype != 92; rb = rb->rbnext) {}
+    if (rb == NULL) {
+        return false;
+    }
+    resize((size_t)(rb->resval.rlong < 0 ? 0 : rb->resval.rlong));
+
+    uint32_t state = 0;
+    for (rb = rb->rbnext; rb != NULL; rb = rb->rbnext) {
+        if (rb->restype == 303) {
+            if (state >= states.size()) {
+                return false;
+            }
+            states[state++] = rb->resval.rstring != NULL ? rb->resval.rstring : L"";
+        }
+        else if (rb->restype == 332 && state > 0) {
+            // an entity the parameter does not list is taken on as well.
+            uint32_t entity = addEntity(rb->resval.rlname);
+            bits[entity * wordsPerEntity + (state - 1) / 64] |= 1ull << ((state - 1) % 64);
+        }
+    }
+    return state == states.size();
+}
+
+bool VisibilityTable::assignFromXrecord(const resbuf* pXrecordData)
+{
+    clear();
+    const resbuf* rb = pXrecordData;
+    if (rb == NULL || rb->restype != 70 || rb->resval.rint != visibilityTableVersion) {
+        return false;
+    }
+    rb = rb->rbnext;
+    if (rb == NULL || rb->restype != 90 || rb->resval.rlong < 0) {
+        return false;
+    }
+    size_t stateCount = (size_t)rb->resval.rlong;
+    std::vector<std::wstring> names;
+    for (rb = rb->rbnext; rb != NULL && rb->restype == 1; rb = rb->rbnext) {
+        names.push_back(rb->resval.rstring != NULL ? rb->resval.rstring : L"");
+    }
+    if (names.size() != stateCount || rb == NULL || rb->restype != 91 || rb->resval.rlong < 0) {
+        return false;
+    }
+    size_t entityCount = (size_t)rb->resval.rlong;
+    for (rb = rb->rbnext; rb != NULL && rb->restype == 331; rb = rb->rbnext) {
+        EntityName entityName;
+        entityName.name[0] = rb->resval.rlname[0];
+        entityName.name[1] = rb->resval.rlname[1];
+        entities.push_back(entityName);
+    }
+    if (entities.size() != entityCount) {
+        clear();
+        return false;
+    }
+    resize(stateCount);
+    states.swap(names);
+
+    size_t byteCount = bits.size() * 8;
+    size_t filled = 0;
+    for (; rb != NULL && rb->restype == 310; rb = rb->rbnext) {
+        size_t length = (size_t)rb->resval.rbinary.clen;
+        if (filled + length > byteCount) {
+            clear();
+            return false;
+        }
+        for (size_t i = 0; i < length; i++, filled++) {
+            bits[filled / 8] |= (uint64_t)(unsigned char)rb->resval.rbinary.buf[i] << (8 * (filled % 8));
+        }
+    }
+    if (filled != byteCount || rb != NULL) {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+resbuf* VisibilityTable::toXrecordChain(ResbufArena& arena) const
+{
+    ResbufChainBuilder builder(arena);
+    builder.appendShort(70, visibilityTableVersion);
+    builder.appendLong(90, (int32_t)states.size());
+    for (const std::wstring& state : states) {
+        builder.appendString(1, state.c_str());
+    }
+    builder.appendLong(91, (int32_t)entities.size());
+    for (const EntityName& entity : entities) {
+        resbuf* rb = builder.append(331);
+        if (rb != NULL) {
+            rb->resval.rlname[0] = entity.name[0];
+            rb->resval.rlname[1] = entity.name[1];
+        }
+    }
+
+    // little-endian, whatever the host.
+    std::vector<char> bytes(bits.size() * 8);
+    for (size_t i = 0; i < bytes.size(); i++) {
+        bytes[i] = (char)(bits[i / 8] >> (8 * (i % 8)));
+    }
+    for (size_t first = 0; first < bytes.size(); first += 127) {
+        size_t length = bytes.size() - first < 127 ? bytes.size() - first : 127;
+        resbuf* rb = builder.append(310);
+        char* pChunk = arena.newBinary(bytes.data() + first, length);
+        if (rb == NULL || pChunk == NULL) {
+            return NULL;
+        }
+        rb->resval.rbinary.clen = (short)length;
+        rb->resval.rbinary.buf = pChunk;
+    }
+    return builder.failed() ? NULL : builder.head();
+}
+
+uint32_t VisibilityTable::stateIndex(const std::wstring& name) const
+{
+    for (uint32_t state = 0; state < states.size(); state++) {
+        if (states[state] == name) {
+            return state;
+        }
+    }
+    return npos;
+}
+
+uint32_t VisibilityTable::entityIndex(const ads_name name) const
+{
+    for (uint32_t entity = 0; entity < entities.size(); entity++) {
+        if (entities[entity].name[0] == name[0] && entities[entity].name[1] == name[1]) {
+            return entity;
+        }
+    }
+    return npos;
+}
+
+bool VisibilityTable::operator==(const VisibilityTable& other) const
+{
+    if (states != other.states || entities.size() != other.entities.size() || bits != other.bits) {
+        return false;
+    }
+    for (size_t i = 0; i < entities.size(); i++) {
+        if (memcmp(entities[i].name, other.entities[i].name, sizeof(entities[i].name)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
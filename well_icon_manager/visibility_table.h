@@ -0,0 +1,80 @@
+#pragma once
+
+// Which entities of a dynamic block definition are visible in which of its
+// visibility states, as a bit matrix: one row of state bits per entity, so
+// that a lookup is a single bit test and nothing has to be evaluated.
+//
+// The table is read off the acdbEntGet() data of the definition's
+// AcDbBlockVisibilityParameter node (see eval_graph.h):
+//
+//   93  number of entities the parameter controls, then that many
+//   331 entity names
+//   92  number of states, then for each state
+//   303 state name
+//   94  number of entities visible in the state, then that many
+//   332 entity names
+//   95  number of other objects (grips, parameters) in the state, then
+//   333 object names
+//
+// and cached in an Xrecord on the block table record (see
+// visibility_table_arx.h) in this form:
+//
+//   70  format version (1)
+//   90  number of states, then that many
+//   1   state names
+//   91  number of entities, then that many
+//   331 entity names (soft pointers, so AutoCAD keeps them valid)
+//   310 the bit matrix, row after row, in binary chunks of up to 127 bytes
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "arx_host.h"
+#include "resbuf_arena.h"
+
+const short visibilityTableVersion = 1;
+
+class VisibilityTable {
+    private:
+        struct EntityName {
+            int64_t name[2];
+        };
+
+        std::vector<std::wstring> states;
+        std::vector<EntityName> entities;
+        size_t wordsPerEntity;
+        std::vector<uint64_t> bits; // entity-major
+
+        uint32_t addEntity(const ads_name name);
+        void resize(size_t stateCount);
+
+    public:
+        static const uint32_t npos = 0xFFFFFFFF;
+
+        VisibilityTable();
+
+        void clear();
+        // From the data of a visibility parameter.  False if it is malformed.
+        bool assignFromParameter(const resbuf* pParameterData);
+        // From the data of an Xrecord written by toXrecordChain().  False if
+        // it is malformed or of another format version.
+        bool assignFromXrecord(const resbuf* pXrecordData);
+        // NULL if out of memory.
+        resbuf* toXrecordChain(ResbufArena& arena) const;
+
+        uint32_t stateCount() const { return (uint32_t)states.size(); }
+        uint32_t entityCount() const { return (uint32_t)entities.size(); }
+        const std::wstring& stateName(uint32_t state) const { return states[state]; }
+        uint32_t stateIndex(const std::wstring& name) const;
+        // Linear in the number of entities; look an entity up once, then
+        // test its bits.
+        uint32_t entityIndex(const ads_name name) const;
+
+        bool isVisible(uint32_t entity, uint32_t state) const {
+            return ((bits[entity * wordsPerEntity + state / 64] >> (state % 64)) & 1) != 0;
+        }
+
+        bool operator==(const VisibilityTable& other) const;
+        bool operator!=(const VisibilityTable& other) const { return !(*this == other); }
+};
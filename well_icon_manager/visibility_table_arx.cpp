@@ -0,0 +1,201 @@
+#include "visibility_table_arx.h"
+#include <tchar.h>
+#include <aced.h>
+#include <dbdict.h>
+#include <dbdynblk.h>
+#include <dbents.h>
+#include <dbsymtb.h>
+#include <dbxrecrd.h>
+#include "class_ancestry_arx.h"
+#include "eval_graph_arx.h"
+#include "handle_index_arx.h"
+#include "resbuf_snapshot.h"
+
+
+bool loadVisibilityTable(AcDbObjectId blockTableRecordId, VisibilityTable& table)
+{
+    table.clear();
+    AcDbBlockTableRecord* pBlockTableRecord;
+    if (acdbOpenObject(pBlockTableRecord, blockTableRecordId, AcDb::kForRead) != Acad::eOk) {
+        return false;
+    }
+    AcDbObjectId extensionDictionaryId = pBlockTableRecord->extensionDictionary();
+    pBlockTableRecord->close();
+
+    AcDbDictionary* pExtensionDictionary;
+    if (extensionDictionaryId.isNull() || acdbOpenObject(pExtensionDictionary, extensionDictionaryId, AcDb::kForRead) != Acad::eOk) {
+        return false;
+    }
+    AcDbObjectId xrecordId;
+    Acad::ErrorStatus errorStatus = pExtensionDictionary->getAt(VISIBILITY_TABLE_KEY, xrecordId);
+    pExtensionDictionary->close();
+    AcDbXrecord* pXrecord;
+    if (errorStatus != Acad::eOk || acdbOpenObject(pXrecord, xrecordId, AcDb::kForRead) != Acad::eOk) {
+        return false;
+    }
+    resbuf* pData = NULL;
+    errorStatus = pXrecord->rbChain(&pData);
+    pXrecord->close();
+    bool loaded = errorStatus == Acad::eOk && table.assignFromXrecord(pData);
+    acutRelRb(pData);
+    return loaded;
+}
+
+bool storeVisibilityTable(AcDbObjectId blockTableRecordId, const VisibilityTable& table)
+{
+    ResbufArena arena;
+    resbuf* pData = table.toXrecordChain(arena);
+    if (pData == NULL) {
+        return false;
+    }
+
+    AcDbBlockTableRecord* pBlockTableRecord;
+    if (acdbOpenObject(pBlockTableRecord, blockTableRecordId, AcDb::kForRead) != Acad::eOk) {
+        return false;
+    }
+    if (pBlockTableRecord->extensionDictionary().isNull()
+        && (pBlockTableRecord->upgradeOpen() != Acad::eOk || pBlockTableRecord->createExtensionDictionary() != Acad::eOk)) {
+        pBlockTableRecord->close();
+        return false;
+    }
+    AcDbObjectId extensionDictionaryId = pBlockTableRecord->extensionDictionary();
+    pBlockTableRecord->close();
+
+    AcDbDictionary* pExtensionDictionary;
+    if (acdbOpenObject(pExtensionDictionary, extensionDictionaryId, AcDb::kForWrite) != Acad::eOk) {
+        return false;
+    }
+    AcDbXrecord* pXrecord = NULL;
+    AcDbObjectId xrecordId;
+    bool stored;
+    if (pExtensionDictionary->getAt(VISIBILITY_TABLE_KEY, xrecordId) == Acad::eOk) {
+        stored = acdbOpenObject(pXrecord, xrecordId, AcDb::kForWrite) == Acad::eOk;
+    }
+    else {
+        pXrecord = new AcDbXrecord();
+        stored = pExtensionDictionary->setAt(VISIBILITY_TABLE_KEY, pXrecord, xrecordId) == Acad::eOk;
+        if (!stored) {
+            delete pXrecord;
+        }
+    }
+    pExtensionDictionary->close();
+    if (!stored) {
+        return false;
+    }
+    // the Xrecord copies the chain.
+    stored = pXrecord->setFromRbChain(*pData) == Acad::eOk;
+    pXrecord->close();
+    return stored;
+}
+
+bool readVisibilityTable(AcDbObjectId blockTableRecordId, VisibilityTable& table)
+{
+    table.clear();
+    EvalGraph graph;
+    if (!extractBlockEvalGraph(blockTableRecordId, graph)) {
+        return false;
+    }
+
+    // the node data keeps its entity names, see extractEvalGraph().
+    ResbufArena arena;
+    for (uint32_t i = 0; i < graph.nodeCount(); i++) {
+        resbuf* pNodeData;
+        if (graph.node(i).className == "AcDbBlockVisibilityParameter" && decodeResbufChain(graph.node(i).data, arena, pNodeData)) {
+            return table.assignFromParameter(pNodeData);
+        }
+    }
+    return false;
+}
+
+// The index of the state a reference is in: the value of the property whose
+// value is one of the table's state names.
+static uint32_t currentVisibilityState(AcDbDynBlockReference& reference, const VisibilityTable& table)
+{
+    AcDbDynBlockReferencePropertyArray properties;
+    reference.getBlockProperties(properties);
+    for (int i = 0; i < properties.length(); i++) {
+        AcDbEvalVariant value = properties.at(i).value();
+        AcString name;
+        if (value.getType() == AcDb::kDwgText && value.getValue(name) == Acad::eOk) {
+            uint32_t state = table.stateIndex(name.kwszPtr());
+            if (state != VisibilityTable::npos) {
+                return state;
+            }
+        }
+    }
+    return VisibilityTable::npos;
+}
+
+void showWellVisibility()
+{
+    ads_name name;
+    ads_point point;
+    if (acedEntSel(_T("\nSelect a dynamic block reference: "), name, point) != RTNORM) {
+        return;
+    }
+    AcDbObjectId referenceId;
+    if (acdbGetObjectId(referenceId, name) != Acad::eOk
+        || !sessionClassAncestry().isKindOf(referenceId.objectClass(), AcDbBlockReference::desc())) {
+        acutPrintf(_T("\nThe selected entity is not a block reference.\n"));
+        return;
+    }
+    AcDbDynBlockReference reference(referenceId);
+    if (!reference.isDynamicBlock()) {
+        acutPrintf(_T("\nThe selected block reference is not dynamic.\n"));
+        return;
+    }
+    AcDbObjectId blockId = reference.dynamicBlockTableRecord();
+
+    // the cached table first; the definition only on a miss, and the table
+    // is stored with nothing else open.
+    VisibilityTable table;
+    bool cached = loadVisibilityTable(blockId, table);
+    if (!cached) {
+        if (!readVisibilityTable(blockId, table)) {
+            acutPrintf(_T("\nThe dynamic block has no visibility parameter.\n"));
+            return;
+        }
+        if (!storeVisibilityTable(blockId, table)) {
+            acutPrintf(_T("\nUnable to cache the visibility table.\n"));
+        }
+    }
+    uint32_t state = currentVisibilityState(reference, table);
+    if (state == VisibilityTable::npos) {
+        acutPrintf(_T("\nThe reference is in none of the %d visibility states.\n"), (int)table.stateCount());
+        return;
+    }
+    acutPrintf(_T("\nVisibility state \"%s\" (%d of %d), %s table.\n"),
+        table.stateName(state).c_str(), (int)state + 1, (int)table.stateCount(), cached ? _T("cached") : _T("newly cached"));
+
+    AcDbBlockTableRecord* pBlockTableRecord;
+    if (acdbOpenObject(pBlockTableRecord, blockId, AcDb::kForRead) != Acad::eOk) {
+        return;
+    }
+    AcDbBlockTableRecordIterator* pIterator;
+    if (pBlockTableRecord->newIterator(pIterator) != Acad::eOk) {
+        pBlockTableRecord->close();
+        return;
+    }
+    size_t visible = 0;
+    size_t hidden = 0;
+    size_t uncontrolled = 0;
+    for (; !pIterator->done(); pIterator->step()) {
+        AcDbObjectId entityId;
+        ads_name entityName;
+        if (pIterator->getEntityId(entityId) != Acad::eOk || acdbGetAdsName(entityName, entityId) != Acad::eOk) {
+            continue;
+        }
+        uint32_t entity = table.entityIndex(entityName);
+        if (entity == VisibilityTable::npos) {
+            uncontrolled++;
+        } else if (!table.isVisible(entity, state)) {
+            hidden++;
+        } else if (visible++ < 50) {
+            acutPrintf(_T("\t%s %s\n"), entityId.objectClass()->name(), HandleText(handleOf(entityId)).c_str());
+        }
+    }
+    delete pIterator;
+    pBlockTableRecord->close();
+    acutPrintf(_T("%d entities visible, %d hidden, %d not controlled by the visibility parameter.\n"),
+        (int)visible, (int)hidden, (int)uncontrolled);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+// Caching of VisibilityTables (see visibility_table.h) in an Xrecord in the
+// extension dictionary of their block table record, and the WELLVISIBILITY
+// command, which looks entities up in the cached table.  Only available
+// inside AutoCAD.
+
+#include <dbmain.h>
+#include "visibility_table.h"
+
+#define VISIBILITY_TABLE_KEY _T("WELL_VISIBILITY_TABLE")
+
+// False if the block has no (well-formed) cached table.
+bool loadVisibilityTable(AcDbObjectId blockTableRecordId, VisibilityTable& table);
+// Creates the extension dictionary and the Xrecord as needed.
+bool storeVisibilityTable(AcDbObjectId blockTableRecordId, const VisibilityTable& table);
+// Reads the table off the visibility parameter in the eval graph of a
+// dynamic block definition.  False if it has none.
+bool readVisibilityTable(AcDbObjectId blockTableRecordId, VisibilityTable& table);
+
+// The WELLVISIBILITY command: for a selected dynamic block reference, lists
+// the entities of its definition that are visible in its current visibility
+// state, from the cached table.  The table is read off the definition and
+// cached on its first use.
+void showWellVisibility();
@@ -0,0 +1,371 @@
+// visibilitybench: VisibilityTable (see visibility_table.h) on synthetic
+// visibility parameters.
+//
+//   check    a parameter of --entities entities (the last of them not in the
+//            parameter's own list, only in its states) and --states states.
+//            The table read off it must have every entity visible in exactly
+//            the states that list it; the Xrecord chain written from it must
+//            read back into an equal table; and assignFromXrecord() must
+//            reject, leaving the table empty, the chain cut short after
+//            each of its nodes, a chain with a node too many, another format
+//            version, and wrong or negative state and entity counts.
+//            assignFromParameter() must reject a parameter with more states
+//            than it says, and one without a state count
+//   time     assignFromParameter(), toXrecordChain() and assignFromXrecord()
+//            of the same table, in us per table, and isVisible() in ns per
+//            lookup, each repeated for at least 50 ms
+//
+// This is a standalone program; it does not link against ObjectARX:
+//
+//     g++ -std=c++17 -O2 -I ObjectARX_for_AutoCAD_2021_Win_64bit/inc visibilitybench.cpp visibility_table.cpp resbuf_arena.cpp arx_host.cpp -o visibilitybench
+//
+// usage: visibilitybench [--step check|time] [--entities <n>] [--states <n>]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include "resbuf_arena.h"
+#include "visibility_table.h"
+
+
+// Whether entity is visible in state in the synthetic parameter: most
+// entities are visible in most states, in a pattern that differs from
+// entity to entity.
+static bool syntheticVisibility(uint32_t entity, uint32_t state)
+{
+    return (entity * 7 + state * 3) % 5 != 0;
+}
+
+static void entityName(uint32_t entity, ads_name name)
+{
+    name[0] = 0x7FF612340000 + 16 * (int64_t)entity;
+    name[1] = 0x7FF612300000;
+}
+
+static std::wstring stateName(uint32_t state)
+{
+    return L"State " + std::to_wstring(state);
+}
+
+static resbuf* appendEntityName(ResbufChainBuilder& builder, short restype, uint32_t entity)
+{
+    resbuf* rb = builder.append(restype);
+    if (rb != NULL) {
+        entityName(entity, rb->resval.rlname);
+    }
+    return rb;
+}
+
+// The acdbEntGet() data of an AcDbBlockVisibilityParameter, in the layout
+// visibility_table.h describes.  With extraState, it has a state more than
+// its state count says.
+static resbuf* makeParameterData(ResbufArena& arena, uint32_t entityCount, uint32_t stateCount, bool extraState)
+{
+    ResbufChainBuilder builder(arena);
+    builder.appendString(0, L"BLOCKVISIBILITYPARAMETER");
+    builder.appendString(301, L"Visibility1");
+    uint32_t listedCount = entityCount > 0 ? entityCount - 1 : 0;
+    builder.appendLong(93, (int32_t)listedCount);
+    for (uint32_t entity = 0; entity < listedCount; entity++) {
+        appendEntityName(builder, 331, entity);
+    }
+    builder.appendLong(92, (int32_t)stateCount);
+    for (uint32_t state = 0; state < stateCount + (extraState ? 1 : 0); state++) {
+        builder.appendString(303, stateName(state).c_str());
+        uint32_t visibleCount = 0;
+        for (uint32_t entity = 0; entity < entityCount; entity++) {
+            visibleCount += syntheticVisibility(entity, state) ? 1 : 0;
+        }
+        builder.appendLong(94, (int32_t)visibleCount);
+        for (uint32_t entity = 0; entity < entityCount; entity++) {
+            if (syntheticVisibility(entity, state)) {
+                appendEntityName(builder, 332, entity);
+            }
+        }
+        builder.appendLong(95, 1);
+        appendEntityName(builder, 333, entityCount + state);
+    }
+    return builder.failed() ? NULL : builder.head();
+}
+
+static bool isEmpty(const VisibilityTable& table)
+{
+    return table.stateCount() == 0 && table.entityCount() == 0;
+}
+
+// Whether the table has the synthetic parameter's states and visibility.
+static bool matchesParameter(const VisibilityTable& table, uint32_t entityCount, uint32_t stateCount)
+{
+    if (table.stateCount() != stateCount || table.entityCount() != entityCount) {
+        fprintf(stderr, "visibilitybench: %u states and %u entities, expected %u and %u\n",
+            table.stateCount(), table.entityCount(), stateCount, entityCount);
+        return false;
+    }
+    for (uint32_t state = 0; state < stateCount; state++) {
+        if (table.stateName(state) != stateName(state) || table.stateIndex(stateName(state)) != state) {
+            fprintf(stderr, "visibilitybench: state %u is misnamed\n", state);
+            return false;
+        }
+    }
+    for (uint32_t e = 0; e < entityCount; e++) {
+        ads_name name;
+        entityName(e, name);
+        uint32_t entity = table.entityIndex(name);
+        if (entity == VisibilityTable::npos) {
+            fprintf(stderr, "visibilitybench: entity %u is missing\n", e);
+            return false;
+        }
+        for (uint32_t state = 0; state < stateCount; state++) {
+            if (table.isVisible(entity, state) != syntheticVisibility(e, state)) {
+                fprintf(stderr, "visibilitybench: entity %u is %s in state %u\n", e, table.isVisible(entity, state) ? "visible" : "hidden", state);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Reading pChain must fail and leave the table empty.
+static bool expectRejected(VisibilityTable& table, const resbuf* pChain, const char* what)
+{
+    if (table.assignFromXrecord(pChain) || !isEmpty(table)) {
+        fprintf(stderr, "visibilitybench: an Xrecord chain with %s is accepted\n", what);
+        return false;
+    }
+    return true;
+}
+
+static bool runChecks(uint32_t entityCount, uint32_t stateCount)
+{
+    ResbufArena arena;
+    resbuf* pParameterData = makeParameterData(arena, entityCount, stateCount, false);
+    VisibilityTable table;
+    if (pParameterData == NULL || !table.assignFromParameter(pParameterData)) {
+        fprintf(stderr, "visibilitybench: the parameter data is rejected\n");
+        return false;
+    }
+    if (!matchesParameter(table, entityCount, stateCount)) {
+        return false;
+    }
+
+    resbuf* pXrecordData = table.toXrecordChain(arena);
+    VisibilityTable readBack;
+    if (pXrecordData == NULL || !readBack.assignFromXrecord(pXrecordData) || readBack != table) {
+        fprintf(stderr, "visibilitybench: the Xrecord chain does not read back into the same table\n");
+        return false;
+    }
+
+    // cut short after each node: the counts, names or bits fall short.
+    size_t nodeCount = 0;
+    for (const resbuf* rb = pXrecordData; rb != NULL; rb = rb->rbnext) {
+        nodeCount++;
+    }
+    size_t truncations = 0;
+    if (!expectRejected(readBack, NULL, "no nodes")) {
+        return false;
+    }
+    truncations++;
+    resbuf* pLast = NULL;
+    for (resbuf* rb = pXrecordData; rb->rbnext != NULL; rb = rb->rbnext) {
+        resbuf* pNext = rb->rbnext;
+        rb->rbnext = NULL;
+        bool rejected = expectRejected(readBack, pXrecordData, "its last nodes cut off");
+        rb->rbnext = pNext;
+        if (!rejected) {
+            return false;
+        }
+        truncations++;
+        pLast = pNext;
+    }
+
+    // a node too many: a bit chunk past the matrix, then anything else.
+    ResbufChainBuilder extra(arena);
+    static const char oneByte = 1;
+    resbuf* pExtra = extra.append(310);
+    pExtra->resval.rbinary.clen = 1;
+    pExtra->resval.rbinary.buf = arena.newBinary(&oneByte, 1);
+    pLast->rbnext = pExtra;
+    bool rejected = expectRejected(readBack, pXrecordData, "a bit chunk too many");
+    pExtra->restype = 1;
+    pExtra->resval.rstring = arena.newString(L"extra", 5);
+    rejected = rejected && expectRejected(readBack, pXrecordData, "a trailing node");
+    pLast->rbnext = NULL;
+    if (!rejected) {
+        return false;
+    }
+
+    // the counts and version, one at a time.
+    resbuf* pVersion = pXrecordData;
+    resbuf* pStateCount = pVersion->rbnext;
+    resbuf* pEntityCount = pStateCount;
+    for (uint32_t state = 0; state <= stateCount; state++) {
+        pEntityCount = pEntityCount->rbnext;
+    }
+    struct Corruption {
+        const char* what;
+        resbuf* pNode;
+        int32_t value;
+    };
+    const Corruption corruptions[] = {
+        { "another format version", pVersion, visibilityTableVersion + 1 },
+        { "a state too many", pStateCount, (int32_t)stateCount + 1 },
+        { "a state too few", pStateCount, (int32_t)stateCount - 1 },
+        { "a negative state count", pStateCount, -1 },
+        { "an entity too many", pEntityCount, (int32_t)entityCount + 1 },
+        { "an entity too few", pEntityCount, (int32_t)entityCount - 1 },
+        { "a negative entity count", pEntityCount, -1 },
+    };
+    for (const Corruption& corruption : corruptions) {
+        ads_u_val value = corruption.pNode->resval;
+        if (corruption.pNode->restype == 70) {
+            corruption.pNode->resval.rint = (short)corruption.value;
+        } else {
+            corruption.pNode->resval.rlong = corruption.value;
+        }
+        rejected = expectRejected(readBack, pXrecordData, corruption.what);
+        corruption.pNode->resval = value;
+        if (!rejected) {
+            return false;
+        }
+    }
+    if (!readBack.assignFromXrecord(pXrecordData) || readBack != table) {
+        fprintf(stderr, "visibilitybench: the restored Xrecord chain does not read back\n");
+        return false;
+    }
+
+    // and the parameter data.
+    VisibilityTable fromParameter;
+    if (fromParameter.assignFromParameter(makeParameterData(arena, entityCount, stateCount, true))) {
+        fprintf(stderr, "visibilitybench: a parameter with more states than its count is accepted\n");
+        return false;
+    }
+    resbuf* pNoStateCount = makeParameterData(arena, entityCount, stateCount, false);
+    for (resbuf* rb = pNoStateCount; rb != NULL; rb = rb->rbnext) {
+        if (rb->restype == 92) {
+            rb->restype = 90;
+        }
+    }
+    if (fromParameter.assignFromParameter(pNoStateCount)) {
+        fprintf(stderr, "visibilitybench: a parameter without a state count is accepted\n");
+        return false;
+    }
+
+    printf("%u entities x %u states: %zu Xrecord nodes, %zu truncations and %zu corruptions rejected\n",
+        entityCount, stateCount, nodeCount, truncations, sizeof(corruptions) / sizeof(corruptions[0]) + 2);
+    return true;
+}
+
+
+typedef std::chrono::steady_clock Clock;
+
+// keeps the results of the timed loops alive.
+static volatile size_t sink;
+
+// Runs step at least once and until 50 ms have passed, and returns the time
+// per run in seconds.
+static double secondsPerRun(const std::function<void()>& step)
+{
+    size_t repetitions = 0;
+    Clock::time_point startTime = Clock::now();
+    double seconds;
+    do {
+        step();
+        repetitions++;
+        seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    } while (seconds < 0.05);
+    return seconds / repetitions;
+}
+
+static bool timeTable(uint32_t entityCount, uint32_t stateCount)
+{
+    ResbufArena parameterArena;
+    resbuf* pParameterData = makeParameterData(parameterArena, entityCount, stateCount, false);
+    VisibilityTable table;
+    if (pParameterData == NULL || !table.assignFromParameter(pParameterData)) {
+        fprintf(stderr, "visibilitybench: the parameter data is rejected\n");
+        return false;
+    }
+    ResbufArena arena;
+    resbuf* pXrecordData = table.toXrecordChain(arena);
+
+    VisibilityTable scratch;
+    double fromParameter = secondsPerRun([&]() {
+        scratch.assignFromParameter(pParameterData);
+    });
+    ResbufArena scratchArena;
+    double toXrecord = secondsPerRun([&]() {
+        scratchArena.reset();
+        table.toXrecordChain(scratchArena);
+    });
+    double fromXrecord = secondsPerRun([&]() {
+        scratch.assignFromXrecord(pXrecordData);
+    });
+    double lookups = secondsPerRun([&]() {
+        size_t visible = 0;
+        for (uint32_t entity = 0; entity < entityCount; entity++) {
+            for (uint32_t state = 0; state < stateCount; state++) {
+                visible += table.isVisible(entity, state) ? 1 : 0;
+            }
+        }
+        sink = sink + visible;
+    });
+    printf("%u entities x %u states\n", entityCount, stateCount);
+    printf("%-20s %10.2f us\n", "assignFromParameter", fromParameter * 1.0e6);
+    printf("%-20s %10.2f us\n", "toXrecordChain", toXrecord * 1.0e6);
+    printf("%-20s %10.2f us\n", "assignFromXrecord", fromXrecord * 1.0e6);
+    printf("%-20s %10.2f ns\n", "isVisible", lookups * 1.0e9 / ((double)entityCount * stateCount));
+    return true;
+}
+
+struct Step {
+    const char* name;
+    bool (*run)(uint32_t entityCount, uint32_t stateCount);
+};
+
+static const Step steps[] = {
+    { "check", runChecks },
+    { "time", timeTable },
+};
+
+int main(int argc, char** argv)
+{
+    const char* stepName = NULL;
+    uint32_t entityCount = 120;
+    uint32_t stateCount = 70;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--step") == 0 && i + 1 < argc) {
+            stepName = argv[++i];
+        } else if (strcmp(argv[i], "--entities") == 0 && i + 1 < argc) {
+            entityCount = (uint32_t)atol(argv[++i]);
+        } else if (strcmp(argv[i], "--states") == 0 && i + 1 < argc) {
+            stateCount = (uint32_t)atol(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: visibilitybench [--step check|time] [--entities <n>] [--states <n>]\n");
+            return 2;
+        }
+    }
+    if (entityCount < 2 || stateCount < 2) {
+        fprintf(stderr, "visibilitybench: the parameter needs at least 2 entities and 2 states\n");
+        return 2;
+    }
+
+    bool found = false;
+    for (const Step& step : steps) {
+        if (stepName != NULL && strcmp(stepName, step.name) != 0) {
+            continue;
+        }
+        found = true;
+        if (!step.run(entityCount, stateCount)) {
+            return 1;
+        }
+    }
+    if (!found) {
+        fprintf(stderr, "visibilitybench: unknown step %s\n", stepName);
+        return 2;
+    }
+    return 0;
+}
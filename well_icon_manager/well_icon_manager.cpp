@@ -4,7 +4,10 @@
 #endif
 
 #include <Windows.h>
+#include <errno.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <rxobject.h>
 #include <rxregsvc.h>
 #include <aced.h>
@@ -13,219 +16,43 @@
 #include <geassign.h>
 #include <dbapserv.h>
 #include <dbmain.h>
+#include <dbdynblk.h>
 #include <dbeval.h>
 #include "tchar.h"
-#include <list>
+#include <string_view>
+#include <unordered_map>
 #include <rxclass.h>
+#include <rxdict.h>
 #include <rxmember.h>
+#include "anon_block_compaction_arx.h"
+#include "class_ancestry_arx.h"
+#include "dxftype.h"
+#include "dynblock_sweep_arx.h"
+#include "eval_graph_arx.h"
+#include "eval_graph_file.h"
+#include "eval_graph_hash.h"
+#include "handle_index_arx.h"
+#include "mapped_file.h"
+#include "open_object_cache_arx.h"
+#include "polyline_vertices_arx.h"
+#include "resbuf_arena.h"
+#include "resbuf_filter_arx.h"
+#include "resbuf_flat.h"
+#include "resbuf_snapshot.h"
+#include "resbuf_wrapper.h"
+#include "visibility_table_arx.h"
+#include "well_inventory_arx.h"
 
 
 
 
-#define ET_NORM 1 // Normal entity  
-#define ET_TBL  2 // Table  
-#define ET_VPORT  3 // Table numbers  
-#define ET_LTYPE  4 
-#define ET_LAYER  5 
-#define ET_STYLE  6 
-#define ET_VIEW   7 
-#define ET_UCS    8 
-#define ET_BLOCK  9 
-// Get basic C-language type from AutoCAD DXF group code (RTREAL,
-// RTANG are doubles, RTPOINT double[2], RT3DPOINT double[3], 
-// RTENAME long[2]). The etype argument is one of the ET_
-// definitions. 
-//
-// Returns RTNONE if grpcode isn't one of the known group codes. 
-// Also, sets "inxdata" argument to TRUE if DXF group is in XDATA.  
-//
-short dxftype(short grpcode, short etype, int* inxdata)
-{
-    short rbtype = RTNONE;
-    *inxdata = FALSE;
-    if (grpcode >= 1000) {  // Extended data (XDATA) groups
-        *inxdata = TRUE;
-        if (grpcode == 1071)
-            rbtype = RTLONG; // Special XDATA case  
-        else
-            grpcode %= 1000; // All other XDATA groups match.  
-    } // regular DXF code ranges  
-    if (grpcode <= 49) {
-        if (grpcode >= 20) // 20 to 49  
-            rbtype = RTREAL;
-        else if (grpcode >= 10) { // 10 to 19  
-            if (etype == ET_VIEW) // Special table cases
-                rbtype = RTPOINT;
-            else if (etype == ET_VPORT && grpcode <= 15)
-                rbtype = RTPOINT;
-            else // Normal point  
-                rbtype = RT3DPOINT; // 10: start point, 11: endpoint
-        }
-        else if (grpcode >= 0) // 0 to 9  
-            rbtype = RTSTR; // Group 1004 in XDATA is binary
-        else if (grpcode >= -2)
-            // -1 = start of normal entity -2 = sequence end, etc.  
-            rbtype = RTENAME;
-        else if (grpcode == -3)
-            rbtype = RTSHORT; // Extended data (XDATA) sentinel 
-    }
-    else {
-        if (grpcode <= 59) // 50 to 59  
-            rbtype = RTANG; // double  
-        else if (grpcode <= 79) // 60 to 79  
-            rbtype = RTSHORT;
-        else if (grpcode < 210)
-            ;
-        else if (grpcode <= 239) // 210 to 239  
-            rbtype = RT3DPOINT;
-        else if (grpcode == 999) // Comment  
-            rbtype = RTSTR;
-    }
-    return rbtype;
-}
-
-
 void listPline();
+void exportEvalGraph();
 void iterate(AcDbObjectId id);
 void initApp();
 void unloadApp();
 extern "C" AcRx::AppRetCode acrxEntryPoint(AcRx::AppMsgCode, void*);
 
-class ResbufWrapper {
-    private:
-       resbuf* pResbuf;
-
-    public:
-        ResbufWrapper(resbuf* pResbuf) {
-            this->pResbuf = pResbuf;
-        }
-
-        ~ResbufWrapper() {
-            acutRelRb(pResbuf);
-        }
-
-        static std::wstring resultTypeCodeToString(short resultTypeCode) {
-            std::wstring returnValue;
-            switch(resultTypeCode){
-                case RTNONE       : returnValue = L"RTNONE";      break;
-                case RTREAL       : returnValue = L"RTREAL";      break;
-                case RTPOINT      : returnValue = L"RTPOINT";     break;
-                case RTSHORT      : returnValue = L"RTSHORT";     break;
-                case RTANG        : returnValue = L"RTANG";       break;
-                case RTSTR        : returnValue = L"RTSTR";       break;
-                case RTENAME      : returnValue = L"RTENAME";     break;
-                case RTPICKS      : returnValue = L"RTPICKS";     break;
-                case RTORINT      : returnValue = L"RTORINT";     break;
-                case RT3DPOINT    : returnValue = L"RT3DPOINT";   break;
-                case RTLONG       : returnValue = L"RTLONG";      break;
-                case RTVOID       : returnValue = L"RTVOID";      break;
-                case RTLB         : returnValue = L"RTLB";        break;
-                case RTLE         : returnValue = L"RTLE";        break;
-                case RTDOTE       : returnValue = L"RTDOTE";      break;
-                case RTNIL        : returnValue = L"RTNIL";       break;
-                case RTDXF0       : returnValue = L"RTDXF0";      break;
-                case RTT          : returnValue = L"RTT";         break;
-                case RTRESBUF     : returnValue = L"RTRESBUF";    break;
-                case RTMODELESS   : returnValue = L"RTMODELESS";  break;
-                default           : returnValue = std::wstring(L"UNKNOWN_RETURN_TYPE_CODE:") + std::to_wstring(resultTypeCode);
-            };
-            return returnValue;
-        }
-
-        std::wstring toString() {
-            std::wstring returnValue;
-            returnValue += L"resbuf:\n";
-            if (pResbuf == NULL) {
-                returnValue += std::wstring(_T("\t")) + _T("NULL");
-            } else {
-                for (resbuf* head = pResbuf; head != NULL; head = head->rbnext) {
-                    int inxdata;
-                    short resultTypeCode;
-                    resultTypeCode = dxftype(head->restype, ET_NORM, &inxdata);
-                    returnValue += std::wstring(_T("\t")) + _T("type: ") + std::to_wstring(head->restype) + L"(" + ResbufWrapper::resultTypeCodeToString(resultTypeCode) + L")" + L", ";
-                    returnValue += std::wstring(_T("value: "));
-
-                    switch (resultTypeCode) {
-                    case RTNONE:
-                        returnValue += L"(none)";
-                        break;
-                    case RTREAL:
-                    case RTANG:
-                        returnValue += std::to_wstring(head->resval.rreal);
-                        break;
-                    case RTPOINT:
-                    case RT3DPOINT:
-                        returnValue += 
-                           std::to_wstring(head->resval.rpoint[0])
-                           + L", "
-                           + std::to_wstring(head->resval.rpoint[1])
-                           + L", "
-                           + std::to_wstring(head->resval.rpoint[2])
-                           + L"";
-                        break;
-                    case RTSHORT:
-                    case RTORINT:
-                        returnValue += std::to_wstring(head->resval.rint);
-                        break;
-                    case RTSTR:
-                        returnValue += head->resval.rstring;
-                        break;
-                    case RTENAME:
-                    case RTPICKS:
-                        returnValue += 
-                            std::to_wstring(head->resval.rlname[0])
-                            + L" "
-                            + std::to_wstring(head->resval.rlname[1])
-                            + L"";
-                        break;
-                    case RTLONG:
-                        returnValue += std::to_wstring(head->resval.rlong);
-                        break;
-                    case RTVOID:
-                        returnValue += L"<void>";
-                        break;
-                    case RTLB:
-                        returnValue += L"<list begin>";
-                        break;
-                    case RTLE:
-                        returnValue += L"<list end>";
-                        break;
-                    case RTDOTE:
-                        returnValue += L"<dot>";
-                        break;
-                    case RTNIL:
-                        returnValue += L"<nil>";
-                        break;
-                    case RTDXF0:
-                        returnValue += L"<dxf0>";
-                        break;
-                    case RTT:
-                        returnValue += L"<t>";
-                        break;
-                    case RTRESBUF:
-                        returnValue += ResbufWrapper((resbuf*) head->resval.mnLongPtr).toString();
-                        break;
-                    case RTMODELESS:
-                        returnValue += L"<rtmodeless>";
-                        break;
-                    default: 
-                        returnValue += L"value of resbuf of unknown type.";
-                        break;
-                    }
-                    returnValue += L"\n";
-                }
-            }
-            return returnValue;
-        }
-};
-
-
-std::wstring handleToString(AcDbHandle handle) {
-    ACHAR sHandle[17];
-    //lstrcpy(sHandle, _T(""));
-    handle.getIntoAsciiBuffer(sHandle, (size_t)17);
-    return std::wstring(sHandle);
-}
 
 std::wstring objectIdToString(AcDbObjectId objectId) {
     if (objectId == AcDbObjectId::kNull) {
@@ -233,32 +60,31 @@ std::wstring objectIdToString(AcDbObjectId objectId) {
     }
     else {
         //to do : catch some exceptions that might arise here.
-        return std::wstring(objectId.objectClass()->name()) + L" (" + handleToString(objectId.handle()) + L")";
+        return std::wstring(objectId.objectClass()->name()) + L" (" + HandleText(handleOf(objectId)).c_str() + L")";
     }
 }
 
-std::vector<AcRxClass*> getAncestry(AcRxClass *x) {
-    std::vector<AcRxClass*> ancestry = std::vector<AcRxClass*>();
-    AcRxClass* ancestor;
-    ancestor = x;
-    while (true) {
-        ancestry.push_back(ancestor);
-        if (ancestor == AcRxObject::desc()) { break; }
-        ancestor = ancestor->myParent();
-    }
-    return ancestry;
-}
-
-std::wstring ancestryToString(std::vector<AcRxClass*> ancestry) {
-    std::wstring returnValue;
-    for (int i = 0; i < ancestry.size();  i++) {
-        returnValue += std::wstring(ancestry.at(i)->name()) + (i < ancestry.size() - 1 ? L", ": L"");
-    }
+std::wstring fromUtf8(const std::string& text) {
+    std::wstring returnValue(text.size(), L'\0');
+    int length = MultiByteToWideChar(CP_UTF8, 0, text.data(), (int)text.size(), &returnValue[0], (int)returnValue.size());
+    returnValue.resize(length > 0 ? length : 0);
     return returnValue;
 }
 
-std::vector<AcRxClass*> getAncestry(const AcRxObject * const x) {
-    return getAncestry(x->isA());
+// Where the files that WELLEXPORT writes about a drawing go: next to the
+// drawing, named after it with suffix appended -- the snapshot of the data of
+// the eval-graph nodes (see resbuf_snapshot.h), and the exported eval graph
+// (see eval_graph_file.h).  Empty if the drawing has not been saved yet.
+std::string drawingSidecarPath(AcDbDatabase* pDb, const char* suffix) {
+    const ACHAR* pFileName = NULL;
+    if (pDb->getFilename(pFileName) != Acad::eOk || pFileName == NULL || pFileName[0] == 0) {
+        return std::string();
+    }
+    char path[2 * MAX_PATH];
+    if (WideCharToMultiByte(CP_ACP, 0, pFileName, -1, path, sizeof(path), NULL, NULL) <= 0) {
+        return std::string();
+    }
+    return std::string(path) + suffix;
 }
 
 
@@ -271,10 +97,23 @@ void myAcutPrintLine(std::wstring x, int tabLevel = 0) {
     myAcutPrint(std::wstring(tabLevel, L'\t') + x + L"\n");
 }
 
+// Prints the ancestors of a class, AcRxObject first; the chain comes from
+// the session's ancestry table (see class_ancestry_arx.h).
+void printAncestors(AcRxClass* pClass, int tabLevel, bool numbered) {
+    const ClassAncestryTable& classes = sessionClassAncestry().table();
+    uint32_t id = sessionClassAncestry().idOf(pClass);
+    if (id == ClassAncestryTable::npos) {
+        return;
+    }
+    for (uint32_t depth = 0; depth <= classes.depth(id); depth++) {
+        std::wstring name = fromUtf8(classes.name(classes.ancestorAt(id, depth)));
+        myAcutPrintLine(numbered ? std::wstring(L"ancestor ") + std::to_wstring(depth) + L" class: " + name : name, tabLevel);
+    }
+}
+
 // This is the main function of this app.  It allows the
-// user to select an entity.  It then checks to see if the
-// entity is a 2d-polyline.  If so, then it calls iterate
-// passing in the objectId of the pline.
+// user to select an entity, and calls iterate passing in
+// the objectId of it.
 // 
 void listPline()
 {
@@ -291,48 +130,128 @@ void listPline()
 
     AcDbObjectId eId;
     acdbGetObjectId(eId, en);
+    iterate(eId);
+}
 
-    AcDbObject *pObj;
-    acdbOpenObject(pObj, eId, AcDb::kForRead);
-    if (pObj->isKindOf(AcDb2dPolyline::desc())) {
-        pObj->close();
-        iterate(eId);
-    } else {
-        pObj->close();
-        acutPrintf(_T("\nSelected entity is not an AcDb2dPolyline. \nMake sure the setvar PLINETYPE is set to 0 before createing a polyline"));
+
+// Accepts the object ID of a polyline (AcDbPolyline, AcDb2dPolyline or
+// AcDb3dPolyline), reads all of its vertices in one pass (see
+// polyline_vertices_arx.h), and prints their locations, bulges and
+// widths with a single acutPrintf.
+// 
+void iterate(AcDbObjectId plineId)
+{
+    PolylineVertices vertices;
+    Acad::ErrorStatus es = extractPolylineVertices(plineId, vertices);
+    if (es == Acad::eWrongObjectType) {
+        acutPrintf(_T("\nSelected entity is not a polyline."));
+        return;
     }
+    if (es != Acad::eOk) {
+        acutPrintf(_T("\nUnable to read the vertices of the polyline."));
+        return;
+    }
+
+    std::wstring text;
+    formatPolylineVertices(vertices, text);
+    acutPrintf(_T("%s"), text.c_str());
 }
 
 
-// Accepts the object ID of an AcDb2dPolyline, opens it, and gets
-// a vertex iterator. It then iterates through the vertices,
-// printing out the vertex location.
+// Writes data to path, and reports the path written or why it could not
+// be written.
+static bool writeSidecarFile(const std::string& path, std::string_view data)
+{
+    FILE* pFile = fopen(path.c_str(), "wb");
+    bool written = pFile != NULL && fwrite(data.data(), 1, data.size(), pFile) == data.size();
+    int error = errno;
+    if (pFile != NULL && fclose(pFile) != 0 && written) {
+        written = false;
+        error = errno;
+    }
+    if (!written) {
+        acutPrintf(_T("\nUnable to write %hs: %hs.\n"), path.c_str(), strerror(error));
+        return false;
+    }
+    acutPrintf(_T("\nWrote %hs.\n"), path.c_str());
+    return true;
+}
+
+// The WELLEXPORT command: writes the eval graph of the selected dynamic
+// block reference's definition next to the drawing, for offline analysis
+// (see eval_graph_file.h), as a Graphviz file, and the snapshot of its
+// nodes' data (see resbuf_snapshot.h) that the next load compares with.
 // 
-void iterate(AcDbObjectId plineId)
+void exportEvalGraph()
 {
-    AcDb2dPolyline *pPline;
-    acdbOpenObject(pPline, plineId, AcDb::kForRead);
-
-    AcDbObjectIterator *pVertIter= pPline->vertexIterator();
-    pPline->close();  // Finished with the pline header.
-
-    AcDb2dVertex *pVertex;
-    AcGePoint3d location;
-    AcDbObjectId vertexObjId;
-    for (int vertexNumber = 0; !pVertIter->done();
-        vertexNumber++, pVertIter->step())
-    {
-        vertexObjId = pVertIter->objectId();
-        acdbOpenObject(pVertex, vertexObjId,
-            AcDb::kForRead);
-        location = pVertex->position();
-        pVertex->close();
-
-        acutPrintf(_T("\nVertex #%d's location is")
-            _T(" : %0.3f, %0.3f, %0.3f"), vertexNumber,
-            location[X], location[Y], location[Z]);
+    AcDbDatabase* pDb = acdbHostApplicationServices()->workingDatabase();
+    std::string graphPath = drawingSidecarPath(pDb, ".evalgraph");
+    if (graphPath.empty()) {
+        acutPrintf(_T("\nThe drawing has not been saved yet; there is nowhere to export to.\n"));
+        return;
     }
-    delete pVertIter;
+
+    ads_name name;
+    ads_point point;
+    if (acedEntSel(_T("\nSelect a dynamic block reference: "), name, point) != RTNORM) {
+        return;
+    }
+    AcDbObjectId referenceId;
+    if (acdbGetObjectId(referenceId, name) != Acad::eOk
+        || !sessionClassAncestry().isKindOf(referenceId.objectClass(), AcDbBlockReference::desc())) {
+        acutPrintf(_T("\nThe selected entity is not a block reference.\n"));
+        return;
+    }
+    AcDbDynBlockReference reference(referenceId);
+    if (!reference.isDynamicBlock()) {
+        acutPrintf(_T("\nThe selected block reference is not dynamic.\n"));
+        return;
+    }
+    EvalGraph graph;
+    if (!extractBlockEvalGraph(reference.dynamicBlockTableRecord(), graph)) {
+        acutPrintf(_T("\nUnable to read the eval graph of the dynamic block.\n"));
+        return;
+    }
+
+    std::string encoded;
+    encodeEvalGraph(graph, encoded);
+    if (!writeSidecarFile(graphPath, encoded)) {
+        return;
+    }
+    std::string dot;
+    writeEvalGraphDot(graph, dot);
+    if (!writeSidecarFile(graphPath + ".dot", dot)) {
+        return;
+    }
+
+    std::string snapshotPath = drawingSidecarPath(pDb, ".nodes.rbsnap");
+    FILE* pSnapshotFile = fopen(snapshotPath.c_str(), "wb");
+    bool written = pSnapshotFile != NULL;
+    if (written) {
+        ResbufSnapshotWriter writer(pSnapshotFile, false);
+        ResbufArena arena;
+        std::string encodedData;
+        for (uint32_t i = 0; i < graph.nodeCount() && written; i++) {
+            arena.reset();
+            resbuf* pNodeData = NULL;
+            decodeResbufChain(graph.node(i).data, arena, pNodeData);
+            encodedData.clear();
+            encodeResbufChain(pNodeData, false, encodedData);
+            written = writer.writeEncoded(graph.node(i).handle, encodedData);
+        }
+        // the header, written by the constructor, is only checked here.
+        written = written && ferror(pSnapshotFile) == 0;
+    }
+    int error = errno;
+    if (pSnapshotFile != NULL && fclose(pSnapshotFile) != 0 && written) {
+        written = false;
+        error = errno;
+    }
+    if (!written) {
+        acutPrintf(_T("\nUnable to write %hs: %hs.\n"), snapshotPath.c_str(), strerror(error));
+        return;
+    }
+    acutPrintf(_T("\nWrote %hs (%d nodes).\n"), snapshotPath.c_str(), (int)graph.nodeCount());
 }
 
 
@@ -349,6 +268,48 @@ void initApp()
         ACRX_CMD_MODAL,
         listPline
     );
+    acedRegCmds->addCommand(
+        _T("ASDK_PLINETEST_COMMANDS"),
+        _T("ASDK_WELLCOMPACT"), 
+        _T("WELLCOMPACT"), 
+        ACRX_CMD_MODAL,
+        compactAnonymousBlocks
+    );
+    acedRegCmds->addCommand(
+        _T("ASDK_PLINETEST_COMMANDS"),
+        _T("ASDK_WELLSCAN"), 
+        _T("WELLSCAN"), 
+        ACRX_CMD_MODAL,
+        inventoryWellIcons
+    );
+    acedRegCmds->addCommand(
+        _T("ASDK_PLINETEST_COMMANDS"),
+        _T("ASDK_WELLFIND"), 
+        _T("WELLFIND"), 
+        ACRX_CMD_MODAL,
+        findWellIcons
+    );
+    acedRegCmds->addCommand(
+        _T("ASDK_PLINETEST_COMMANDS"),
+        _T("ASDK_WELLSWEEP"), 
+        _T("WELLSWEEP"), 
+        ACRX_CMD_MODAL,
+        sweepWellIcon
+    );
+    acedRegCmds->addCommand(
+        _T("ASDK_PLINETEST_COMMANDS"),
+        _T("ASDK_WELLVISIBILITY"), 
+        _T("WELLVISIBILITY"), 
+        ACRX_CMD_MODAL,
+        showWellVisibility
+    );
+    acedRegCmds->addCommand(
+        _T("ASDK_PLINETEST_COMMANDS"),
+        _T("ASDK_WELLEXPORT"), 
+        _T("WELLEXPORT"), 
+        ACRX_CMD_MODAL,
+        exportEvalGraph
+    );
 
     acutPrintf(_T("\nHello World6.\n"));
     //listPline();
@@ -362,9 +323,23 @@ void initApp()
     pBlockTable->getAt(_T("injectionWellWithNoConstituentsOfConcernInPerchedGroundwater"), pBlockTableRecord, AcDb::kForRead);
     pBlockTable->close();
     //inspect any xdata that the block table record  might own:
-    acutPrintf((std::wstring(L"xData attached to the block table record: ") + ResbufWrapper(pBlockTableRecord->xData()).toString() + L"\n").c_str());
+    resbuf* pXData = pBlockTableRecord->xData();
+    std::wstring xDataText;
+    ResbufWrapper::writeChainTo(xDataText, pXData);
+    acutPrintf((std::wstring(L"xData attached to the block table record: ") + xDataText + L"\n").c_str());
+    // its strings (groups 1000), found in the flat form of the chain (see resbuf_flat.h).
+    FlatResbufChain flatXData;
+    flatXData.assign(pXData);
+    acutRelRb(pXData);
+    std::vector<size_t> xDataStrings;
+    flatXData.findRestype(1000, xDataStrings);
+    for (size_t index : xDataStrings) {
+        myAcutPrintLine(std::wstring(L"xData string: ") + flatXData.string(index), 1);
+    }
 
     int tabLevel = 0;
+    VisibilityTable visibilityTable; // filled from the visibility parameter, if the walk below finds one
+    bool foundVisibilityParameter = false;
 
     //inspect any extension dictionary that the block table record might own:
     AcDbDictionary* pExtensionDictionary;
@@ -386,6 +361,9 @@ void initApp()
             tabLevel
         );
         tabLevel++;
+        // the items and the owners up their chains of ownership, each opened
+        // once however many items share them; closed when the walk is done.
+        DatabaseObjectCache openObjects;
         
         for (AcDbDictionaryIterator* pDictionaryIterator = pExtensionDictionary->newIterator();
             !pDictionaryIterator->done();
@@ -395,84 +373,90 @@ void initApp()
             std::wstring name = pDictionaryIterator->name();
             myAcutPrintLine(name + L": " + objectIdToString(pDictionaryIterator->objectId()), tabLevel);
             tabLevel++;
-            AcDbObject* item;
+            AcDbObject* item = openObjects.open(pDictionaryIterator->objectId());
 
-            if (acdbOpenObject(item, pDictionaryIterator->objectId(), AcDb::kForRead) != Acad::eOk) 
+            if (item == NULL) 
             {
                 myAcutPrintLine(L"unable to open the object.", tabLevel);
             }
-            else if (name == std::wstring(L"ACAD_ENHANCEDBLOCK") && item->isKindOf( AcDbEvalGraph::desc())) 
+            else if (name == std::wstring(L"ACAD_ENHANCEDBLOCK") && sessionClassAncestry().isKindOf(item, AcDbEvalGraph::desc())) 
             {
                     myAcutPrintLine(L"found an enhanced (aka dynamic ?) block.", tabLevel);
                     tabLevel++;
                     AcDbEvalGraph* evalGraphP = (AcDbEvalGraph*) item;
-                    AcDbEvalNodeIdArray nodeIds;
-                    Acad::ErrorStatus errorStatus = evalGraphP->getAllNodes(nodeIds);
-                    if (errorStatus != Acad::ErrorStatus::eOk) 
+                    EvalGraph graph; // everything below works on this model; the graph is not read again.
+                    if (!extractEvalGraph(evalGraphP, graph))
                     {
                         myAcutPrintLine(L"encountered an error while attempting to get the nodes.", tabLevel);
                     }
                     else 
                     {
-                        myAcutPrintLine(std::wstring(L"hooray we got the nodes.  There are ") + std::to_wstring(nodeIds.length()) + L" nodes.", tabLevel);
-                        AcDbEvalEdgeInfoArray edges;
-                        //AcDbEvalEdgeInfoArray incomingEdges;
-
-                        //for (int i = 0; i < nodeIds.length(); i++) {
-                        for (int i = nodeIds.length() - 1; i >= 0; i--) {
-
-                            AcDbEvalNodeId nodeId = nodeIds.at(i);
-                            AcDbObject* nodeP;
-                            Acad::ErrorStatus errorStatus;
-                            errorStatus = evalGraphP->getNode(nodeId, AcDb::kForRead, &nodeP);
-                            ads_name eNameOfTheNode;
-                            acdbGetAdsName(eNameOfTheNode, nodeP->objectId());
-                            if (errorStatus != Acad::eOk) {
-                                myAcutPrintLine(std::wstring(L"failed to open node ") + std::to_wstring(i) + L", whose id is " + std::to_wstring(nodeId), tabLevel);
+                        myAcutPrintLine(std::wstring(L"hooray we got the nodes.  There are ") + std::to_wstring(graph.nodeCount()) + L" nodes.", tabLevel);
+                        wchar_t graphHash[17];
+                        swprintf(graphHash, 17, L"%016llx", (unsigned long long)canonicalEvalGraphHash(graph));
+                        myAcutPrintLine(std::wstring(L"canonical hash of the graph: ") + graphHash, tabLevel);
+                        std::wstring nodeText; // reused, so that formatting a node allocates nothing once it has grown.
+                        ResbufArena arena;
+
+                        // each node's data is compared with the snapshot that WELLEXPORT last wrote; nothing is written here.
+                        std::string snapshotPath = drawingSidecarPath(pDb, ".nodes.rbsnap");
+                        MappedFile lastSnapshot;
+                        std::unordered_map<std::string_view, std::string_view> lastNodeData;
+                        if (!snapshotPath.empty() && lastSnapshot.open(snapshotPath.c_str())) {
+                            ResbufSnapshotReader reader(lastSnapshot.view());
+                            ResbufSnapshotEntry entry;
+                            while (reader.next(entry)) {
+                                lastNodeData[entry.key] = entry.chain;
+                            }
+                        }
+                        std::string encodedData;
+
+                        for (int i = (int)graph.nodeCount() - 1; i >= 0; i--) {
+                            const EvalGraphNode& node = graph.node((uint32_t)i);
+                            myAcutPrintLine(std::wstring(L"node ") + std::to_wstring(i) 
+                                + L" (" + fromUtf8(node.className) + L" (" + fromUtf8(node.handle) + L"))"
+                                + L", whose nodeId is " + std::to_wstring(node.id)
+                                + L" and whose class ancestry is " + fromUtf8(node.ancestry), 
+                                tabLevel
+                            );  
+
+                            arena.reset();
+                            resbuf* pNodeData = NULL;
+                            decodeResbufChain(node.data, arena, pNodeData);
+                            auto lastData = lastNodeData.find(node.handle);
+                            if (lastData != lastNodeData.end()) {
+                                encodedData.clear();
+                                encodeResbufChain(pNodeData, false, encodedData);
+                                myAcutPrintLine(lastData->second == encodedData ? L"unchanged since the last export." : L"changed since the last export.", tabLevel);
+                            }
+
+                            if (node.className == "AcDbBlockVisibilityParameter") {
+                                foundVisibilityParameter = visibilityTable.assignFromParameter(pNodeData);
                             }
-                            else {
-                                myAcutPrintLine(std::wstring(L"succesfully opened node ") + std::to_wstring(i) 
-                                    +L" (" + objectIdToString(nodeP->objectId()) + L")"
-                                    + L" (" + L"ename: " + std::to_wstring(eNameOfTheNode[0]) + L" " + std::to_wstring(eNameOfTheNode[1]) + L")"
-                                    + L", whose nodeId is " + std::to_wstring(nodeId)
-                                    + L" and whose class ancestry is "
-                                    + ancestryToString(getAncestry(nodeP->isA())), 
-                                    tabLevel
-                                );  
-                                
-                                myAcutPrintLine(ResbufWrapper(acdbEntGet(eNameOfTheNode)).toString(),tabLevel );
-                                evalGraphP->getOutgoingEdges(nodeId, edges);
-                                //evalGraphP->getIncomingEdges(nodeId, incomingEdges);
-                                //myAcutPrintLine(std::wstring(L"edges.length(): ") + std::to_wstring(edges.length()), tabLevel);
-                                //myAcutPrintLine(std::wstring(L"incomingEdges.length(): ") + std::to_wstring(incomingEdges.length()), tabLevel);
-                                
-                                
-                                
-                                nodeP->close();
-                            }      
+
+                            nodeText.clear();
+                            ResbufWrapper::writeChainTo(nodeText, pNodeData);
+                            myAcutPrintLine(nodeText, tabLevel);
                         }
                         
+                        lastSnapshot.close();
+
                         myAcutPrintLine(std::wstring(L"edges:"), tabLevel);
                         tabLevel++;
-                        for (int i = 0; i < edges.length(); i++)
+                        for (uint32_t i = 0; i < graph.edgeCount(); i++)
                         {
-                            AcDbObject* fromNode;
-                            AcDbObject* toNode;
-                            
-                            evalGraphP->getNode(edges.at(i)->from(), AcDb::kForRead, &fromNode);
-                            evalGraphP->getNode(edges.at(i)->to(), AcDb::kForRead, &toNode);
+                            const EvalGraphEdge& edge = graph.edge(i);
+                            const EvalGraphNode& fromNode = graph.node(edge.from);
+                            const EvalGraphNode& toNode = graph.node(edge.to);
 
                             myAcutPrintLine(
-                                std::to_wstring(edges.at(i)->from()) + L" (" + objectIdToString(fromNode->objectId()) + L")"
+                                std::to_wstring(fromNode.id) + L" (" + fromUtf8(fromNode.className) + L" (" + fromUtf8(fromNode.handle) + L"))"
                                 + L" --> " 
-                                + std::to_wstring(edges.at(i)->to()) + L" (" + objectIdToString(toNode->objectId()) + L")"
-                                + (edges.at(i)->isInvertible() ? L" invertible " : L"") 
-                                + (edges.at(i)->isSuppressed() ? L" suppressed " : L"") 
+                                + std::to_wstring(toNode.id) + L" (" + fromUtf8(toNode.className) + L" (" + fromUtf8(toNode.handle) + L"))"
+                                + (edge.isInvertible() ? L" invertible " : L"") 
+                                + (edge.isSuppressed() ? L" suppressed " : L"") 
                                 , tabLevel
                             );
-                            
-                            fromNode->close();
-                            toNode->close();
                         }
                         tabLevel--;
                         
@@ -482,28 +466,14 @@ void initApp()
 
                 tabLevel--;
             } 
-            else if (name == std::wstring(L"AcDbDynamicBlockRoundTripPurgePreventer") && std::wstring(item->isA()->name()) == std::wstring(L"AcDbDynamicBlockPurgePreventer")) 
+            else if (name == std::wstring(L"AcDbDynamicBlockRoundTripPurgePreventer") && sessionClassAncestry().name(item->isA()) == "AcDbDynamicBlockPurgePreventer") 
             {
                 myAcutPrintLine(L"found a purge preventer (what the hell is that?).", tabLevel);
                 tabLevel++;
 
                 myAcutPrintLine(std::wstring(L"ancestors of item->isA(): "), tabLevel);
                 tabLevel++;
-                std::list<AcRxClass*> ancestryList;
-
-                AcRxClass* ancestor = item->isA();
-                while (true) {
-                    ancestryList.push_front(ancestor);
-                    if (ancestor == AcRxObject::desc()) { break; }
-
-                    ancestor = ancestor->myParent();
-                }
-
-                    
-                for (decltype(ancestryList)::iterator it = ancestryList.begin(); it != ancestryList.end(); ++it) {
-                    //myAcutPrintLine(std::wstring(L"ancestor ") + std::to_wstring(i) + L" class: " + (*it)->name() , tabLevel);
-                    myAcutPrintLine((*it)->name(), tabLevel);
-                }
+                printAncestors(item->isA(), tabLevel, false);
                 tabLevel--;
 
                 if (false) {
@@ -516,20 +486,7 @@ void initApp()
                     myAcutPrintLine(std::wstring(L"ancestors of item->isA()->myParent()->descendants()->isA(): "), tabLevel);
 
                     tabLevel++;
-                    std::list<AcRxClass*> ancestryList;
-                    ancestryList = std::list<AcRxClass*>();
-                    ancestor = ((AcRxObject*)item->isA()->myParent()->descendants())->isA();
-                    while (true) {
-                        ancestryList.push_front(ancestor);
-                        if (ancestor == AcRxObject::desc()) { break; }
-                        ancestor = ancestor->myParent();
-                    }
-
-                    int i = 0;
-                    for (decltype(ancestryList)::iterator it = ancestryList.begin(); it != ancestryList.end(); ++it) {
-                        myAcutPrintLine(std::wstring(L"ancestor ") + std::to_wstring(i) + L" class: " + (*it)->name(), tabLevel);
-                        i++;
-                    }
+                    printAncestors(((AcRxObject*)item->isA()->myParent()->descendants())->isA(), tabLevel, true);
 
                     /* ancestors of item->isA()->myParent()->descendants()->isA() :
                             ancestor 0 class : AcRxObject
@@ -571,8 +528,8 @@ void initApp()
                 while (true) {
                     myAcutPrintLine(L"is owned by " + objectIdToString(ownerId), tabLevel);
                     if (ownerId == AcDbObjectId::kNull) { break; }
-                    AcDbObject* owner;
-                    if( acdbOpenObject(owner, ownerId, AcDb::kForRead) != Acad::eOk) {
+                    AcDbObject* owner = openObjects.open(ownerId);
+                    if (owner == NULL) {
                         myAcutPrintLine(L"unable to open owner.", tabLevel);
                         break;
                     }
@@ -589,9 +546,28 @@ void initApp()
             tabLevel--;
         }
         tabLevel--;
+        myAcutPrintLine(
+            std::to_wstring(openObjects.hostOpens()) + L" objects opened for the walk, "
+            + std::to_wstring(openObjects.opensAvoided()) + L" opens avoided.",
+            tabLevel
+        );
+        openObjects.closeAll();
         pExtensionDictionary->close();
     }
 
+    // the table cached on the block table record (by WELLVISIBILITY) is only
+    // compared here: the record is still open, and loading writes nothing.
+    if (foundVisibilityParameter) {
+        VisibilityTable cachedTable;
+        bool cached = loadVisibilityTable(pBlockTableRecord->objectId(), cachedTable) && cachedTable == visibilityTable;
+        myAcutPrintLine(
+            std::wstring(L"visibility table: ") + std::to_wstring(visibilityTable.entityCount()) + L" entities, "
+            + std::to_wstring(visibilityTable.stateCount()) + L" states"
+            + (cached ? L", cached" : L", not cached (see WELLVISIBILITY)"),
+            tabLevel
+        );
+    }
+
     
     
 
@@ -610,7 +586,7 @@ void initApp()
         acutPrintf(
             _T("classname: %s, handle: %s\n"), 
             pEntity->isA()->name(),
-            handleToString(handle)
+            HandleText((Adesk::UInt64)handle).c_str()
         );
         pEntity->close();
     }
@@ -626,6 +602,7 @@ void initApp()
 void unloadApp()
 {
     acedRegCmds->removeGroup(_T("ASDK_PLINETEST_COMMANDS"));
+    sessionClassAncestry().clear();
     acutPrintf(_T("\nGoodbye.\n"));
 }
 
@@ -0,0 +1,397 @@
+#include "well_inventory.h"
+#include <math.h>
+#include <stdarg.h>
+#include <wchar.h>
+#include <algorithm>
+#include "handle_index.h"
+
+
+WellInventory::WellInventory()
+{
+    blockCount = 0;
+    layoutCount = 0;
+}
+
+void WellInventory::clear()
+{
+    strings.clear();
+    indexOfString.clear();
+    icons.clear();
+    fields.clear();
+    blockCount = 0;
+    layoutCount = 0;
+}
+
+void WellInventory::reserve(size_t iconCount, size_t fieldCount)
+{
+    icons.reserve(iconCount);
+    fields.reserve(fieldCount);
+}
+
+uint32_t WellInventory::intern(std::wstring_view text)
+{
+    auto found = indexOfString.find(text);
+    if (found != indexOfString.end()) {
+        return found->second;
+    }
+    uint32_t index = (uint32_t)strings.size();
+    strings.emplace_back(text);
+    indexOfString.emplace(strings.back(), index);
+    return index;
+}
+
+WellIcon& WellInventory::addIcon(uint64_t handle, uint32_t space, uint32_t wellType, const double position[3], double rotation)
+{
+    WellIcon icon;
+    icon.handle = handle;
+    icon.position[0] = position[0];
+    icon.position[1] = position[1];
+    icon.position[2] = position[2];
+    icon.rotation = rotation;
+    icon.space = space;
+    icon.wellType = wellType;
+    icon.firstField = (uint32_t)fields.size();
+    icon.attributeCount = 0;
+    icon.propertyCount = 0;
+    icons.push_back(icon);
+    return icons.back();
+}
+
+void WellInventory::addAttribute(std::wstring_view tag, std::wstring_view value)
+{
+    fields.push_back(WellIconField{ intern(tag), intern(value) });
+    icons.back().attributeCount++;
+}
+
+void WellInventory::addProperty(std::wstring_view name, std::wstring_view value)
+{
+    fields.push_back(WellIconField{ intern(name), intern(value) });
+    icons.back().propertyCount++;
+}
+
+
+static uint64_t mixBits(uint64_t x)
+{
+    // the splitmix64 finalizer.
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return x;
+}
+
+static uint64_t combine(uint64_t hash, uint64_t value)
+{
+    return mixBits(hash + 0x9E3779B97F4A7C15ull + mixBits(value));
+}
+
+static uint64_t stateKeyOf(const WellInventory& inventory, const WellIcon& icon)
+{
+    uint64_t key = mixBits(icon.wellType);
+    const WellIconField* pProperties = inventory.propertiesOf(icon);
+    for (uint32_t p = 0; p < icon.propertyCount; p++) {
+        key = combine(key, (uint64_t)pProperties[p].name << 32 | pProperties[p].value);
+    }
+    return key;
+}
+
+// Whether two icons are of the same type with the same property values,
+// which come in the same order for references of the same dynamic block.
+static bool sameState(const WellInventory& inventory, const WellIcon& a, const WellIcon& b)
+{
+    if (a.wellType != b.wellType || a.propertyCount != b.propertyCount) {
+        return false;
+    }
+    const WellIconField* pA = inventory.propertiesOf(a);
+    const WellIconField* pB = inventory.propertiesOf(b);
+    for (uint32_t p = 0; p < a.propertyCount; p++) {
+        if (pA[p].name != pB[p].name || pA[p].value != pB[p].value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct GridPosition {
+    int64_t cell[3];
+    uint32_t space;
+
+    bool operator==(const GridPosition& other) const {
+        return space == other.space && cell[0] == other.cell[0] && cell[1] == other.cell[1] && cell[2] == other.cell[2];
+    }
+};
+
+static GridPosition gridPositionOf(const WellIcon& icon)
+{
+    GridPosition position;
+    for (int k = 0; k < 3; k++) {
+        position.cell[k] = llround(icon.position[k] / wellIconCoincidenceTolerance);
+    }
+    position.space = icon.space;
+    return position;
+}
+
+static uint64_t positionKeyOf(const GridPosition& position)
+{
+    uint64_t key = mixBits(position.space);
+    for (int k = 0; k < 3; k++) {
+        key = combine(key, (uint64_t)position.cell[k]);
+    }
+    return key;
+}
+
+static const uint32_t noGroup = 0xFFFFFFFF;
+
+// What the first pass finds in a batch of icons.
+struct WellInventoryBatch {
+    std::vector<WellIconGroup> groups;  // firstIcon is the icon the group is known by
+    std::vector<uint64_t> groupKeys;
+    std::vector<uint32_t> groupOfIcon; // in groups
+    std::vector<uint64_t> tags;        // well type << 32 | tag; sorted and unique
+    std::vector<WellIconIssue> issues; // of the second pass
+};
+
+// Groups by key, telling apart different states that share a key.
+class WellIconGroupIndex {
+    private:
+        const WellInventory& inventory;
+        std::unordered_map<uint64_t, uint32_t> firstWithKey;
+        std::vector<uint32_t> nextWithKey;
+
+    public:
+        explicit WellIconGroupIndex(const WellInventory& inventory) : inventory(inventory) {}
+
+        // Adds a group for the icon if there is none with its state yet.
+        uint32_t findOrAdd(std::vector<WellIconGroup>& groups, uint64_t key, uint32_t icon) {
+            auto inserted = firstWithKey.emplace(key, (uint32_t)groups.size());
+            uint32_t group = inserted.first->second;
+            if (!inserted.second) {
+                uint32_t last = group;
+                for (; group != noGroup; group = nextWithKey[group]) {
+                    if (sameState(inventory, inventory.icons[icon], inventory.icons[groups[group].firstIcon])) {
+                        return group;
+                    }
+                    last = group;
+                }
+                group = (uint32_t)groups.size();
+                nextWithKey[last] = group;
+            }
+            groups.push_back(WellIconGroup{ inventory.icons[icon].wellType, icon, 0 });
+            nextWithKey.push_back(noGroup);
+            return group;
+        }
+};
+
+void analyzeWellInventory(const WellInventory& inventory, WorkStealingPool& pool, WellInventoryAnalysis& analysis, size_t batchSize)
+{
+    uint32_t iconCount = (uint32_t)inventory.icons.size();
+    if (batchSize == 0) {
+        batchSize = 1;
+    }
+    size_t batchCount = (iconCount + batchSize - 1) / batchSize;
+    std::vector<WellInventoryBatch> batches(batchCount);
+    std::vector<uint64_t> positionKeys(iconCount);
+
+    // the first pass groups the icons of each batch by state, and gathers
+    // the tags of each well type and the keys of the positions.
+    pool.parallelFor(batchCount, [&](size_t b) {
+        WellInventoryBatch& batch = batches[b];
+        uint32_t begin = (uint32_t)(b * batchSize);
+        uint32_t end = (uint32_t)std::min((size_t)iconCount, (b + 1) * batchSize);
+        WellIconGroupIndex groupIndex(inventory);
+        batch.groupOfIcon.resize(end - begin);
+        for (uint32_t i = begin; i < end; i++) {
+            const WellIcon& icon = inventory.icons[i];
+            uint64_t key = stateKeyOf(inventory, icon);
+            uint32_t group = groupIndex.findOrAdd(batch.groups, key, i);
+            if (group == batch.groupKeys.size()) {
+                batch.groupKeys.push_back(key);
+            }
+            batch.groups[group].icons++;
+            batch.groupOfIcon[i - begin] = group;
+
+            const WellIconField* pAttributes = inventory.attributesOf(icon);
+            for (uint32_t a = 0; a < icon.attributeCount; a++) {
+                batch.tags.push_back((uint64_t)icon.wellType << 32 | pAttributes[a].name);
+            }
+            positionKeys[i] = positionKeyOf(gridPositionOf(icon));
+        }
+        std::sort(batch.tags.begin(), batch.tags.end());
+        batch.tags.erase(std::unique(batch.tags.begin(), batch.tags.end()), batch.tags.end());
+    });
+
+    // the batches are merged on the calling thread; that is linear in the
+    // number of groups and tags found per batch, which are few, and in the
+    // number of icons only for the positions.
+    std::vector<WellIconGroup> groups;
+    WellIconGroupIndex groupIndex(inventory);
+    std::vector<std::vector<uint32_t>> groupOfBatchGroup(batchCount);
+    std::vector<uint64_t> tags;
+    for (size_t b = 0; b < batchCount; b++) {
+        WellInventoryBatch& batch = batches[b];
+        groupOfBatchGroup[b].resize(batch.groups.size());
+        for (size_t g = 0; g < batch.groups.size(); g++) {
+            uint32_t group = groupIndex.findOrAdd(groups, batch.groupKeys[g], batch.groups[g].firstIcon);
+            groups[group].icons += batch.groups[g].icons;
+            groupOfBatchGroup[b][g] = group;
+        }
+        tags.insert(tags.end(), batch.tags.begin(), batch.tags.end());
+    }
+    std::sort(tags.begin(), tags.end());
+    tags.erase(std::unique(tags.begin(), tags.end()), tags.end());
+
+    std::unordered_map<uint64_t, uint32_t> firstIconAt;
+    firstIconAt.reserve(iconCount);
+    for (uint32_t i = 0; i < iconCount; i++) {
+        firstIconAt.emplace(positionKeys[i], i);
+    }
+
+    // well types by number of icons, groups by well type and then by number
+    // of icons; ties go by first appearance.
+    std::unordered_map<uint32_t, uint32_t> summaryOfType;
+    analysis.wellTypes.clear();
+    for (const WellIconGroup& group : groups) {
+        auto inserted = summaryOfType.emplace(group.wellType, (uint32_t)analysis.wellTypes.size());
+        if (inserted.second) {
+            analysis.wellTypes.push_back(WellTypeSummary{ group.wellType, 0, 0 });
+        }
+        analysis.wellTypes[inserted.first->second].icons += group.icons;
+        analysis.wellTypes[inserted.first->second].groups++;
+    }
+    std::stable_sort(analysis.wellTypes.begin(), analysis.wellTypes.end(), [](const WellTypeSummary& a, const WellTypeSummary& b) {
+        return a.icons > b.icons;
+    });
+    for (uint32_t t = 0; t < analysis.wellTypes.size(); t++) {
+        summaryOfType[analysis.wellTypes[t].wellType] = t;
+    }
+    std::vector<uint32_t> order(groups.size());
+    for (uint32_t g = 0; g < groups.size(); g++) {
+        order[g] = g;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        uint32_t typeA = summaryOfType[groups[a].wellType];
+        uint32_t typeB = summaryOfType[groups[b].wellType];
+        return typeA != typeB ? typeA < typeB : groups[a].icons > groups[b].icons;
+    });
+    std::vector<uint32_t> sortedGroupOf(groups.size());
+    analysis.groups.resize(groups.size());
+    for (uint32_t g = 0; g < groups.size(); g++) {
+        analysis.groups[g] = groups[order[g]];
+        sortedGroupOf[order[g]] = g;
+    }
+
+    // the second pass numbers the groups of the icons and validates them.
+    analysis.groupOfIcon.resize(iconCount);
+    pool.parallelFor(batchCount, [&](size_t b) {
+        WellInventoryBatch& batch = batches[b];
+        uint32_t begin = (uint32_t)(b * batchSize);
+        uint32_t end = (uint32_t)std::min((size_t)iconCount, (b + 1) * batchSize);
+        for (uint32_t i = begin; i < end; i++) {
+            const WellIcon& icon = inventory.icons[i];
+            analysis.groupOfIcon[i] = sortedGroupOf[groupOfBatchGroup[b][batch.groupOfIcon[i - begin]]];
+
+            const WellIconField* pAttributes = inventory.attributesOf(icon);
+            for (uint32_t a = 0; a < icon.attributeCount; a++) {
+                if (inventory.string(pAttributes[a].value).empty()) {
+                    batch.issues.push_back(WellIconIssue{ kEmptyAttribute, i, pAttributes[a].name });
+                }
+            }
+            auto typeTags = std::lower_bound(tags.begin(), tags.end(), (uint64_t)icon.wellType << 32);
+            for (; typeTags != tags.end() && (uint32_t)(*typeTags >> 32) == icon.wellType; ++typeTags) {
+                uint32_t tag = (uint32_t)*typeTags;
+                uint32_t a = 0;
+                while (a < icon.attributeCount && pAttributes[a].name != tag) {
+                    a++;
+                }
+                if (a == icon.attributeCount) {
+                    batch.issues.push_back(WellIconIssue{ kMissingAttribute, i, tag });
+                }
+            }
+            uint32_t first = firstIconAt.find(positionKeys[i])->second;
+            if (first != i && gridPositionOf(inventory.icons[first]) == gridPositionOf(icon)) {
+                batch.issues.push_back(WellIconIssue{ kCoincidentIcon, i, first });
+            }
+        }
+    });
+
+    analysis.issues.clear();
+    for (const WellInventoryBatch& batch : batches) {
+        analysis.issues.insert(analysis.issues.end(), batch.issues.begin(), batch.issues.end());
+    }
+}
+
+
+static void appendFormatted(std::wstring& out, const wchar_t* format, ...)
+{
+    wchar_t text[256];
+    va_list arguments;
+    va_start(arguments, format);
+    int length = vswprintf(text, sizeof(text) / sizeof(text[0]), format, arguments);
+    va_end(arguments);
+    if (length > 0) {
+        out.append(text, (size_t)length);
+    }
+}
+
+static void appendFields(std::wstring& out, const WellInventory& inventory, const WellIconField* pFields, uint32_t count)
+{
+    for (uint32_t f = 0; f < count; f++) {
+        out += f == 0 ? L"" : L", ";
+        out += inventory.string(pFields[f].name);
+        out += L'=';
+        out += inventory.string(pFields[f].value);
+    }
+}
+
+void formatWellInventory(const WellInventory& inventory, const WellInventoryAnalysis& analysis, size_t maxIssues, std::wstring& out)
+{
+    appendFormatted(out, L"\n%zu well icons in %zu spaces (%zu block table records).", inventory.icons.size(), inventory.layoutCount, inventory.blockCount);
+    for (const WellTypeSummary& summary : analysis.wellTypes) {
+        appendFormatted(out, L"\n%8u  ", summary.icons);
+        out += inventory.string(summary.wellType);
+        appendFormatted(out, summary.groups == 1 ? L" (%u state)" : L" (%u states)", summary.groups);
+    }
+    for (const WellIconGroup& group : analysis.groups) {
+        const WellIcon& icon = inventory.icons[group.firstIcon];
+        if (icon.propertyCount == 0) {
+            continue;
+        }
+        appendFormatted(out, L"\n%8u  ", group.icons);
+        out += inventory.string(group.wellType);
+        out += L": ";
+        appendFields(out, inventory, inventory.propertiesOf(icon), icon.propertyCount);
+    }
+
+    appendFormatted(out, L"\n%zu issues.", analysis.issues.size());
+    for (size_t k = 0; k < analysis.issues.size() && k < maxIssues; k++) {
+        const WellIconIssue& issue = analysis.issues[k];
+        const WellIcon& icon = inventory.icons[issue.icon];
+        HandleText handle(icon.handle);
+        out += L'\n';
+        out.append(8 - std::min((size_t)8, handle.length()), L' ');
+        out.append(handle.c_str(), handle.length());
+        out += L"  ";
+        switch (issue.kind) {
+        case kEmptyAttribute:
+            out += L"empty attribute ";
+            out += inventory.string(issue.detail);
+            break;
+        case kMissingAttribute:
+            out += L"no attribute ";
+            out += inventory.string(issue.detail);
+            out += L", which other ";
+            out += inventory.string(icon.wellType);
+            out += L" icons have";
+            break;
+        case kCoincidentIcon:
+            out += L"at the same position as ";
+            out += HandleText(inventory.icons[issue.detail].handle).c_str();
+            appendFormatted(out, L" (%.3f, %.3f, %.3f)", icon.position[0], icon.position[1], icon.position[2]);
+            break;
+        }
+    }
+    if (analysis.issues.size() > maxIssues) {
+        appendFormatted(out, L"\n... and %zu more.", analysis.issues.size() - maxIssues);
+    }
+}
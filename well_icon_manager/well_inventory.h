@@ -0,0 +1,116 @@
+#pragma once
+
+// An inventory of the well icons of a drawing: every block reference in
+// model and paper space, with its handle, position, attributes and dynamic
+// property values.  The records are gathered in one pass over the drawing
+// (see well_inventory_arx.h for the WELLSCAN command that does so) and
+// analysed afterwards on a WorkStealingPool: counted by well type, grouped
+// by the state of their dynamic properties, and validated.
+//
+// The records are kept compact for drawings with tens of thousands of
+// icons.  An icon is a fixed-size record, and its attributes and properties
+// are a run of (name, value) pairs in one shared array.  Names, values, well
+// types and spaces are interned strings, referred to by index.  A drawing
+// has only a handful of distinct tags, types and states, so the strings take
+// little room and the analysis compares integers, not text.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "work_stealing_pool.h"
+
+struct WellIconField {
+    uint32_t name;  // the attribute tag or property name
+    uint32_t value;
+};
+
+struct WellIcon {
+    uint64_t handle;
+    double position[3]; // WCS
+    double rotation;
+    uint32_t space;     // the name of the layout block, e.g. "*Model_Space"
+    uint32_t wellType;  // the name of the block; of the dynamic block for a dynamic reference
+    uint32_t firstField;     // in WellInventory::fields: the attributes, then the properties
+    uint32_t attributeCount;
+    uint32_t propertyCount;
+};
+
+// 60 bytes of fields, padded to 64: one cache line per icon.
+static_assert(sizeof(WellIcon) == 64, "WellIcon is meant to be 64 bytes");
+
+class WellInventory {
+    private:
+        std::deque<std::wstring> strings; // a deque, so that indexOfString's keys stay put
+        std::unordered_map<std::wstring_view, uint32_t> indexOfString;
+
+    public:
+        std::vector<WellIcon> icons;
+        std::vector<WellIconField> fields;
+        size_t blockCount;  // block table records walked
+        size_t layoutCount; // of them, model and paper spaces
+
+        WellInventory();
+
+        void clear();
+        void reserve(size_t iconCount, size_t fieldCount);
+
+        uint32_t intern(std::wstring_view text);
+        const std::wstring& string(uint32_t index) const { return strings[index]; }
+        size_t stringCount() const { return strings.size(); }
+
+        // Starts the record of an icon.  Its attributes and then its
+        // properties are added after it, before the next icon is started.
+        WellIcon& addIcon(uint64_t handle, uint32_t space, uint32_t wellType, const double position[3], double rotation);
+        void addAttribute(std::wstring_view tag, std::wstring_view value);
+        void addProperty(std::wstring_view name, std::wstring_view value);
+
+        const WellIconField* attributesOf(const WellIcon& icon) const { return fields.data() + icon.firstField; }
+        const WellIconField* propertiesOf(const WellIcon& icon) const { return fields.data() + icon.firstField + icon.attributeCount; }
+};
+
+struct WellTypeSummary {
+    uint32_t wellType;
+    uint32_t icons;
+    uint32_t groups;
+};
+
+// The icons of one well type whose dynamic properties have the same values.
+struct WellIconGroup {
+    uint32_t wellType;
+    uint32_t firstIcon; // the values are those of this icon
+    uint32_t icons;
+};
+
+enum WellIconIssueKind {
+    kEmptyAttribute,   // detail: the tag
+    kMissingAttribute, // detail: the tag, which other icons of the type have
+    kCoincidentIcon    // detail: the index of an earlier icon at the same position in the same space
+};
+
+struct WellIconIssue {
+    WellIconIssueKind kind;
+    uint32_t icon;
+    uint32_t detail;
+};
+
+struct WellInventoryAnalysis {
+    std::vector<WellTypeSummary> wellTypes; // most icons first
+    std::vector<WellIconGroup> groups;      // by well type as above, then most icons first
+    std::vector<uint32_t> groupOfIcon;
+    std::vector<WellIconIssue> issues;      // by icon, then kind
+};
+
+// Positions that round to the same multiples of this in every coordinate
+// count as the same.
+const double wellIconCoincidenceTolerance = 1e-6;
+
+// Runs the analysis on pool.  Icons are handled in batches of batchSize.
+void analyzeWellInventory(const WellInventory& inventory, WorkStealingPool& pool, WellInventoryAnalysis& analysis, size_t batchSize = 4096);
+
+// Appends a printable report: the counts by well type, the groups, and the
+// first maxIssues issues (and how many more there are).
+void formatWellInventory(const WellInventory& inventory, const WellInventoryAnalysis& analysis, size_t maxIssues, std::wstring& out);
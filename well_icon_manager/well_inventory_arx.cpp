@@ -0,0 +1,204 @@
+#include "well_inventory_arx.h"
+#include <tchar.h>
+#include <wchar.h>
+#include <chrono>
+#include <unordered_map>
+#include <aced.h>
+#include <dbapserv.h>
+#include <dbdynblk.h>
+#include <dbents.h>
+#include <dbeval.h>
+#include <dbsymtb.h>
+#include "class_ancestry_arx.h"
+#include "handle_index_arx.h"
+
+
+// What the scan needs to know of a block table record.
+struct ScannedBlock {
+    uint32_t name;
+    bool dynamic; // a dynamic block, or an anonymous block drawing a reference of one
+};
+
+static void appendEvalVariantText(const AcDbEvalVariant& value, std::wstring& text)
+{
+    wchar_t number[64];
+    int length = 0;
+    switch (value.getType()) {
+    case AcDb::kDwgReal: {
+        double real = 0.0;
+        value.getValue(real);
+        length = swprintf(number, sizeof(number) / sizeof(number[0]), L"%g", real);
+        break;
+    }
+    case AcDb::kDwgInt16: {
+        short integer = 0;
+        value.getValue(integer);
+        length = swprintf(number, sizeof(number) / sizeof(number[0]), L"%d", (int)integer);
+        break;
+    }
+    case AcDb::kDwgInt32: {
+        Adesk::Int32 integer = 0;
+        value.getValue(integer);
+        length = swprintf(number, sizeof(number) / sizeof(number[0]), L"%ld", (long)integer);
+        break;
+    }
+    case AcDb::kDwg3Real: {
+        AcGePoint3d point;
+        value.getValue(point);
+        length = swprintf(number, sizeof(number) / sizeof(number[0]), L"%g,%g,%g", point.x, point.y, point.z);
+        break;
+    }
+    case AcDb::kDwgText: {
+        AcString string;
+        value.getValue(string);
+        text += string.kwszPtr();
+        break;
+    }
+    default:
+        text += L"?";
+        break;
+    }
+    if (length > 0) {
+        text.append(number, (size_t)length);
+    }
+}
+
+static void scanBlockReference(const std::unordered_map<Adesk::IntDbId, ScannedBlock>& blocks, uint32_t space, AcDbObjectId referenceId, WellInventory& inventory, std::wstring& text)
+{
+    AcDbBlockReference* pReference;
+    if (acdbOpenObject(pReference, referenceId, AcDb::kForRead) != Acad::eOk) {
+        return;
+    }
+    auto block = blocks.find(pReference->blockTableRecord().asOldId());
+    if (block == blocks.end()) {
+        pReference->close();
+        return;
+    }
+    AcGePoint3d position = pReference->position();
+    double coordinates[3] = { position.x, position.y, position.z };
+
+    AcDbDynBlockReferencePropertyArray properties;
+    uint32_t wellType = block->second.name;
+    if (block->second.dynamic) {
+        AcDbDynBlockReference dynamicReference(referenceId);
+        auto dynamicBlock = blocks.find(dynamicReference.dynamicBlockTableRecord().asOldId());
+        if (dynamicBlock != blocks.end()) {
+            wellType = dynamicBlock->second.name;
+        }
+        dynamicReference.getBlockProperties(properties);
+    }
+    inventory.addIcon(handleOf(referenceId), space, wellType, coordinates, pReference->rotation());
+
+    AcDbObjectIterator* pAttributeIterator = pReference->attributeIterator();
+    for (; !pAttributeIterator->done(); pAttributeIterator->step()) {
+        AcDbAttribute* pAttribute;
+        if (acdbOpenObject(pAttribute, pAttributeIterator->objectId(), AcDb::kForRead) != Acad::eOk) {
+            continue;
+        }
+        const ACHAR* pTextString = pAttribute->textStringConst();
+        inventory.addAttribute(pAttribute->tagConst(), pTextString != NULL ? pTextString : L"");
+        pAttribute->close();
+    }
+    delete pAttributeIterator;
+    pReference->close();
+
+    for (int i = 0; i < properties.length(); i++) {
+        const AcDbDynBlockReferenceProperty& property = properties.at(i);
+        if (property.readOnly()) {
+            continue;
+        }
+        text.clear();
+        appendEvalVariantText(property.value(), text);
+        inventory.addProperty(property.propertyName().kwszPtr(), text);
+    }
+}
+
+Acad::ErrorStatus scanWellIcons(AcDbDatabase* pDb, WellInventory& inventory)
+{
+    inventory.clear();
+    AcDbBlockTable* pBlockTable;
+    Acad::ErrorStatus es = pDb->getSymbolTable(pBlockTable, AcDb::kForRead);
+    if (es != Acad::eOk) {
+        return es;
+    }
+    AcDbBlockTableIterator* pBlockTableIterator;
+    es = pBlockTable->newIterator(pBlockTableIterator);
+    if (es != Acad::eOk) {
+        pBlockTable->close();
+        return es;
+    }
+    std::unordered_map<Adesk::IntDbId, ScannedBlock> blocks;
+    std::vector<std::pair<uint32_t, AcDbObjectId>> layouts;
+    for (; !pBlockTableIterator->done(); pBlockTableIterator->step()) {
+        AcDbBlockTableRecord* pBlockTableRecord;
+        if (pBlockTableIterator->getRecord(pBlockTableRecord, AcDb::kForRead) != Acad::eOk) {
+            continue;
+        }
+        const ACHAR* pName = NULL;
+        pBlockTableRecord->getName(pName);
+        ScannedBlock block;
+        block.name = inventory.intern(pName != NULL ? pName : L"");
+        block.dynamic = AcDbDynBlockReference::isDynamicBlock(pBlockTableRecord->objectId());
+        blocks.emplace(pBlockTableRecord->objectId().asOldId(), block);
+        if (pBlockTableRecord->isLayout()) {
+            layouts.push_back(std::make_pair(block.name, pBlockTableRecord->objectId()));
+        }
+        pBlockTableRecord->close();
+    }
+    delete pBlockTableIterator;
+    pBlockTable->close();
+    inventory.blockCount = blocks.size();
+    inventory.layoutCount = layouts.size();
+
+    // the references of the spaces are told apart by their class alone,
+    // without opening the other entities.
+    std::wstring text;
+    for (const auto& layout : layouts) {
+        AcDbBlockTableRecord* pBlockTableRecord;
+        if (acdbOpenObject(pBlockTableRecord, layout.second, AcDb::kForRead) != Acad::eOk) {
+            continue;
+        }
+        AcDbBlockTableRecordIterator* pBlockTableRecordIterator;
+        if (pBlockTableRecord->newIterator(pBlockTableRecordIterator) == Acad::eOk) {
+            for (; !pBlockTableRecordIterator->done(); pBlockTableRecordIterator->step()) {
+                AcDbObjectId entityId;
+                if (pBlockTableRecordIterator->getEntityId(entityId) == Acad::eOk
+                    && sessionClassAncestry().isKindOf(entityId.objectClass(), AcDbBlockReference::desc())) {
+                    scanBlockReference(blocks, layout.first, entityId, inventory, text);
+                }
+            }
+            delete pBlockTableRecordIterator;
+        }
+        pBlockTableRecord->close();
+    }
+    return Acad::eOk;
+}
+
+void inventoryWellIcons()
+{
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point startTime = Clock::now();
+    WellInventory inventory;
+    if (scanWellIcons(acdbHostApplicationServices()->workingDatabase(), inventory) != Acad::eOk) {
+        acutPrintf(_T("\nUnable to read the block table."));
+        return;
+    }
+    Clock::time_point scannedTime = Clock::now();
+
+    // the pool is the command's own: its threads are joined before the
+    // command returns, never while the application is being unloaded.  The
+    // command thread works on the analysis too, and waits for it; see
+    // well_inventory_arx.h.
+    WorkStealingPool pool;
+    WellInventoryAnalysis analysis;
+    analyzeWellInventory(inventory, pool, analysis);
+    Clock::time_point analysedTime = Clock::now();
+
+    std::wstring text;
+    formatWellInventory(inventory, analysis, 50, text);
+    acutPrintf(_T("%s"), text.c_str());
+    acutPrintf(_T("\nScanned in %.3f s, analysed in %.3f s on %u threads.\n"),
+        std::chrono::duration<double>(scannedTime - startTime).count(),
+        std::chrono::duration<double>(analysedTime - scannedTime).count(),
+        pool.threadCount());
+}
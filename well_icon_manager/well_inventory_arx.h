@@ -0,0 +1,28 @@
+#pragma once
+
+// The WELLSCAN command: inventories the well icons of the working drawing
+// (see well_inventory.h) and prints the counts by well type, the states and
+// the issues found.  Only available inside AutoCAD.
+//
+// The analysis is spread over a pool of threads, but the command waits for
+// it: the calling thread is one of the pool's and joins the rest before it
+// prints.  It does not run in the background while the user goes on
+// working.  The scan has to run on the command thread to open the
+// objects, and acutPrintf() may only be called from that thread, so a
+// background analysis would have to post its report back to it.  The
+// command prints the times of the scan and of the analysis, which show on
+// real drawings whether that would be worth it (inventorybench times the
+// analysis alone).
+
+#include <dbmain.h>
+#include "well_inventory.h"
+
+// Gathers every block reference in model and paper space in one pass over
+// the block table: each block table record and each reference is opened
+// once, for read, and closed again straight away.  The well type of a
+// dynamic block reference is its dynamic block, and its properties are the
+// ones that can be set (the read-only ones, such as the origin, are left
+// out).
+Acad::ErrorStatus scanWellIcons(AcDbDatabase* pDb, WellInventory& inventory);
+
+void inventoryWellIcons();
@@ -0,0 +1,137 @@
+#include "work_stealing_pool.h"
+
+static uint64_t packShare(uint32_t begin, uint32_t end)
+{
+    return (uint64_t)begin | ((uint64_t)end << 32);
+}
+
+
+WorkStealingPool::WorkStealingPool(unsigned threadCount)
+{
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+    }
+    threads = threadCount < 1 ? 1 : threadCount;
+    shares.reset(new Share[threads]);
+    for (unsigned i = 0; i < threads; i++) {
+        shares[i].bounds.store(0);
+    }
+    generation = 0;
+    stopping = false;
+    busyWorkers.store(0);
+    pTask = NULL;
+    for (unsigned i = 1; i < threads; i++) {
+        workers.emplace_back(&WorkStealingPool::run, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void WorkStealingPool::run(unsigned self)
+{
+    uint64_t seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeUp.wait(lock, [&]() { return stopping || generation != seenGeneration; });
+            if (stopping) {
+                return;
+            }
+            seenGeneration = generation;
+        }
+        workOn(self);
+        busyWorkers--;
+    }
+}
+
+bool WorkStealingPool::takeFront(unsigned self, uint32_t& index)
+{
+    std::atomic<uint64_t>& bounds = shares[self].bounds;
+    uint64_t current = bounds.load(std::memory_order_acquire);
+    while (true) {
+        uint32_t begin = (uint32_t)current;
+        uint32_t end = (uint32_t)(current >> 32);
+        if (begin >= end) {
+            return false;
+        }
+        if (bounds.compare_exchange_weak(current, packShare(begin + 1, end), std::memory_order_acq_rel)) {
+            index = begin;
+            return true;
+        }
+    }
+}
+
+// Moves the back half of another thread's share into our own (empty) one.
+bool WorkStealingPool::steal(unsigned self)
+{
+    for (unsigned k = 1; k < threads; k++) {
+        std::atomic<uint64_t>& victim = shares[(self + k) % threads].bounds;
+        uint64_t current = victim.load(std::memory_order_acquire);
+        while (true) {
+            uint32_t begin = (uint32_t)current;
+            uint32_t end = (uint32_t)(current >> 32);
+            if (begin >= end) {
+                break;
+            }
+            uint32_t middle = end - (end - begin + 1) / 2;
+            if (victim.compare_exchange_weak(current, packShare(begin, middle), std::memory_order_acq_rel)) {
+                shares[self].bounds.store(packShare(middle, end), std::memory_order_release);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::workOn(unsigned self)
+{
+    const std::function<void(size_t)>& task = *pTask;
+    do {
+        uint32_t index;
+        while (takeFront(self, index)) {
+            task(index);
+        }
+    } while (steal(self));
+}
+
+void WorkStealingPool::parallelFor(size_t count, const std::function<void(size_t)>& task, size_t serialBelow)
+{
+    if (threads == 1 || count < serialBelow || count < 2) {
+        for (size_t i = 0; i < count; i++) {
+            task(i);
+        }
+        return;
+    }
+    // shares are indexed with 32 bits.
+    for (size_t first = 0; first < count; first += 0xFFFFFFFF) {
+        uint32_t part = (uint32_t)(count - first < 0xFFFFFFFF ? count - first : 0xFFFFFFFF);
+        std::function<void(size_t)> partTask = [&](size_t i) { task(first + i); };
+        for (unsigned i = 0; i < threads; i++) {
+            shares[i].bounds.store(packShare((uint32_t)((uint64_t)part * i / threads), (uint32_t)((uint64_t)part * (i + 1) / threads)), std::memory_order_relaxed);
+        }
+        pTask = first == 0 && part == count ? &task : &partTask;
+        busyWorkers.store(threads - 1);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            generation++;
+        }
+        wakeUp.notify_all();
+
+        workOn(0);
+        // every index has been taken once our own stealing fails; wait for
+        // the workers to finish the ones they hold.
+        while (busyWorkers.load() != 0) {
+            std::this_thread::yield();
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+// A fixed set of worker threads for data-parallel loops.
+//
+// parallelFor(count, task) hands every thread (the calling thread included)
+// a contiguous share of the indexes [0, count).  A thread takes indexes from
+// the front of its own share one at a time; once it runs dry it steals the
+// back half of whatever is left of another thread's share.  So uneven tasks
+// even out without a shared counter being hit for every index, and the
+// threads are kept between calls, which matters for loops that are run many
+// times over small counts (e.g. once per level of a graph).
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool {
+    private:
+        // [begin, end) packed as begin | end << 32, so that the owner and the
+        // thieves can update it with a single compare-and-swap.
+        struct alignas(64) Share {
+            std::atomic<uint64_t> bounds;
+        };
+
+        std::vector<std::thread> workers;
+        std::unique_ptr<Share[]> shares; // one per thread; the calling thread's is shares[0]
+        unsigned threads;
+
+        std::mutex mutex;
+        std::condition_variable wakeUp;
+        uint64_t generation;             // of the current parallelFor(), guarded by mutex
+        bool stopping;
+        std::atomic<unsigned> busyWorkers;
+        const std::function<void(size_t)>* pTask;
+
+        void run(unsigned self);
+        void workOn(unsigned self);
+        bool takeFront(unsigned self, uint32_t& index);
+        bool steal(unsigned self);
+
+    public:
+        // threadCount counts the calling thread, so threadCount - 1 workers
+        // are started; 0 means std::thread::hardware_concurrency().
+        explicit WorkStealingPool(unsigned threadCount = 0);
+        ~WorkStealingPool();
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+        unsigned threadCount() const { return threads; }
+
+        // Calls task(i) for every i in [0, count) and returns once all calls
+        // have returned.  task must be safe to call concurrently and must not
+        // throw, nor call parallelFor() on the same pool.  Counts below
+        // serialBelow are run on the calling thread alone.
+        void parallelFor(size_t count, const std::function<void(size_t)>& task, size_t serialBelow = 2);
+};